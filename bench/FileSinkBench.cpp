@@ -0,0 +1,84 @@
+/**
+ * @file FileSinkBench.cpp
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Throughput of log file output modes for pre-rendered records
+ *
+ * @version 0.1
+ * @date 2023-09-16
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#include <chrono>
+#include <cstdio>
+#include <unistd.h>
+
+#include "mklog/LogMessage.h"
+#include "mklog/writers/BufferedFileSink.h"
+
+static constexpr size_t ITERATIONS = 1000000;
+static constexpr size_t RECORD_LEN = 256;
+
+static const char BENCH_FILE[] = "/tmp/mklog_file_sink_bench.log";
+
+int main()
+{
+  using mklog::BufferedFileSink;
+  using mklog::LogMessage;
+  using Clock      = std::chrono::steady_clock;
+  using OutputMode = BufferedFileSink::OutputMode;
+
+  static constexpr BufferedFileSink::FlushPolicy UNBUFFERED = {
+      .bufferSize = 0, .maxAgeMs = 0, .flushSeverity = LogMessage::Severity::TRACE};
+
+  static constexpr struct
+  {
+    OutputMode                    mode;
+    BufferedFileSink::FlushPolicy policy;
+    const char*                   name;
+  } CONFIGS[] = {
+      {OutputMode::WRITE, UNBUFFERED, "write per record"},
+      {OutputMode::WRITE, BufferedFileSink::FLUSH_POLICY_DEFAULT, "write"},
+      {OutputMode::MAPPED, BufferedFileSink::FLUSH_POLICY_DEFAULT, "mapped"},
+      {OutputMode::URING, BufferedFileSink::FLUSH_POLICY_DEFAULT, "io_uring"},
+      {OutputMode::URING_POLLED, BufferedFileSink::FLUSH_POLICY_DEFAULT,
+       "io_uring, sqpoll"},
+  };
+
+  char record[RECORD_LEN];
+  for (size_t i = 0; i < RECORD_LEN - 1; ++i)
+  {
+    record[i] = (char)('a' + i % 26);
+  }
+  record[RECORD_LEN - 1] = '\n';
+
+  for (const auto& config : CONFIGS)
+  {
+    unlink(BENCH_FILE);
+
+    Clock::time_point start = Clock::now();
+    {
+      BufferedFileSink sink;
+      if (!sink.open(BENCH_FILE, config.mode))
+      {
+        printf("%-20s cannot open file\n", config.name);
+        continue;
+      }
+      sink.setFlushPolicy(config.policy);
+
+      for (size_t i = 0; i < ITERATIONS; ++i)
+      {
+        sink.beginRecord().append(record, RECORD_LEN);
+        sink.endRecord(LogMessage::Severity::INFO);
+      }
+    }
+    Clock::time_point end = Clock::now();
+
+    double totalNs = std::chrono::duration<double, std::nano>(end - start).count();
+    printf("%-20s %8.1f ns/record %8.1f MB/s\n", config.name,
+           totalNs / ITERATIONS, (double)(ITERATIONS * RECORD_LEN) / totalNs * 1e3);
+  }
+
+  unlink(BENCH_FILE);
+  return 0;
+}
@@ -0,0 +1,115 @@
+/**
+ * @file FileWriterBench.cpp
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Cost and size of log records written by each file writer and
+ * output mode
+ *
+ * @version 0.1
+ * @date 2023-09-16
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#include <chrono>
+#include <cstdio>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mklog/LogMessage.h"
+#include "mklog/utils/LogClock.h"
+#include "mklog/writers/BinaryLogWriter.h"
+#include "mklog/writers/BufferedFileSink.h"
+#include "mklog/writers/TextLogWriter.h"
+
+static constexpr size_t ITERATIONS = 1000000;
+
+static const char BENCH_FILE[] = "/tmp/mklog_file_writer_bench.log";
+
+/**
+ * @brief Write message repeatedly with fresh timestamps and report time and
+ * file size per message
+ */
+template <typename TWriter>
+static void runBenchmark(const char*                          name,
+                         mklog::BufferedFileSink::OutputMode  mode,
+                         const mklog::BufferedFileSink::FlushPolicy& policy,
+                         mklog::LogMessage&                   message)
+{
+  using Clock = std::chrono::steady_clock;
+
+  unlink(BENCH_FILE);
+
+  Clock::time_point start = Clock::now();
+  {
+    TWriter writer;
+    writer.setFile(BENCH_FILE, mode).setFlushPolicy(policy);
+    for (size_t i = 0; i < ITERATIONS; ++i)
+    {
+      message.timestamp = mklog::utils::LogClock::now();
+      writer.tryWriteMessage(message);
+    }
+  }
+  Clock::time_point end = Clock::now();
+
+  struct stat fileStat = {};
+  stat(BENCH_FILE, &fileStat);
+
+  double totalNs = std::chrono::duration<double, std::nano>(end - start).count();
+  printf("%-20s %8.1f ns/message %8.1f bytes/message\n", name,
+         totalNs / ITERATIONS, (double)fileStat.st_size / ITERATIONS);
+}
+
+int main()
+{
+  using mklog::BinaryLogWriter;
+  using mklog::BufferedFileSink;
+  using mklog::LogMessage;
+  using mklog::TextLogWriter;
+
+  static constexpr struct
+  {
+    BufferedFileSink::OutputMode mode;
+    BufferedFileSink::FlushPolicy policy;
+    const char*                   name;
+  } CONFIGS[] = {
+      {BufferedFileSink::OutputMode::WRITE,
+       BufferedFileSink::FLUSH_POLICY_DEFAULT, "text, buffered"},
+      {BufferedFileSink::OutputMode::WRITE,
+       {.bufferSize    = 0,
+        .maxAgeMs      = 0,
+        .flushSeverity = LogMessage::Severity::TRACE},
+       "text, unbuffered"},
+      {BufferedFileSink::OutputMode::MAPPED,
+       BufferedFileSink::FLUSH_POLICY_DEFAULT, "text, mapped"},
+  };
+
+  static const char CONTENT[] =
+      "Processed batch of 4096 records, 17 rejected, checksum 0x5f3759df";
+
+  LogMessage message = {
+      .severity      = LogMessage::Severity::INFO,
+      .source        = {.file     = __FILE__,
+                        .function = __func__,
+                        .line     = __LINE__,
+                        .logger   = "bench"},
+      .contentType   = LogMessage::ContentType::TEXT,
+      .content       = CONTENT,
+      .contentLen    = sizeof(CONTENT),
+      .timestamp     = 0,
+      .siteId        = 0,
+      .part          = LogMessage::Part::WHOLE,
+      .longMessageId = 0,
+  };
+
+  for (const auto& config : CONFIGS)
+  {
+    runBenchmark<TextLogWriter>(config.name, config.mode, config.policy,
+                                message);
+  }
+  runBenchmark<BinaryLogWriter>("binary", BufferedFileSink::OutputMode::WRITE,
+                                BufferedFileSink::FLUSH_POLICY_DEFAULT,
+                                message);
+
+  unlink(BENCH_FILE);
+  return 0;
+}
@@ -0,0 +1,95 @@
+/**
+ * @file FormatBench.cpp
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Cost of issuing a log message with typical content length
+ *
+ * @version 0.1
+ * @date 2023-09-03
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#include <chrono>
+#include <cstdio>
+
+#include "mklog/LogManager.h"
+#include "mklog/LogMessage.h"
+#include "mklog/LogWriter.h"
+#include "mklog/Logger.h"
+
+/**
+ * @brief Accept all text messages and discard them
+ */
+class NullLogWriter : public mklog::LogWriter
+{
+public:
+  size_t totalLen = 0;
+
+protected:
+  bool canAcceptContentType(mklog::MessageContentType contentType) const override
+  {
+    return contentType == mklog::MessageContentType::TEXT;
+  }
+
+  Status writeMessage(const mklog::LogMessage& message) override
+  {
+    totalLen += message.contentLen;
+    return Status::OK;
+  }
+};
+
+static constexpr size_t ITERATIONS = 1000000;
+
+template <typename TCall>
+static void runBenchmark(const char* name, TCall call)
+{
+  using Clock = std::chrono::steady_clock;
+
+  Clock::time_point start = Clock::now();
+  for (size_t i = 0; i < ITERATIONS; ++i)
+  {
+    call(i);
+  }
+  Clock::time_point end = Clock::now();
+
+  double totalNs = std::chrono::duration<double, std::nano>(end - start).count();
+  printf("%-24s %8.1f ns/call\n", name, totalNs / ITERATIONS);
+}
+
+int main()
+{
+  using mklog::Logger;
+  using mklog::LogManager;
+  using mklog::MessageContentType;
+
+  NullLogWriter& writer = LogManager::addWriter<NullLogWriter>();
+  LogManager::initLogs();
+
+  Logger logger("bench");
+
+  runBenchmark("40 byte message", [&](size_t i) {
+    logger.LOG_INFO(MessageContentType::TEXT, "Request %zu finished in %d ms", i,
+                    42);
+  });
+
+  runBenchmark("100 byte message", [&](size_t i) {
+    logger.LOG_INFO(MessageContentType::TEXT,
+                    "Connection %zu from %s:%d accepted, worker %d, queue "
+                    "depth %d, state '%s'",
+                    i, "192.168.100.200", 8080, 3, 17, "handshake");
+  });
+
+  runBenchmark("200 byte message", [&](size_t i) {
+    logger.LOG_INFO(MessageContentType::TEXT,
+                    "Transaction %zu committed: table '%s', %d rows inserted, "
+                    "%d rows updated, %d rows deleted, elapsed %.3f s, lock "
+                    "wait %.3f s, redo log %zu bytes, replica lag %d ms, "
+                    "checkpoint '%s'",
+                    i, "customer_orders", 128, 64, 3, 0.125, 0.004, i * 512,
+                    12, "ckpt-00042");
+  });
+
+  fprintf(stderr, "Total content length: %zu\n", writer.totalLen);
+
+  return 0;
+}
@@ -0,0 +1,91 @@
+/**
+ * @file HtmlEscapeBench.cpp
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Throughput of HTML escaping for multi-kilobyte CODE content
+ *
+ * @version 0.1
+ * @date 2023-09-09
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include "mklog/utils/HtmlEscaper.h"
+#include "mklog/utils/TextBuffer.h"
+
+static constexpr size_t ITERATIONS  = 100000;
+static constexpr size_t CONTENT_LEN = 8192;
+
+/**
+ * @brief Fill buffer with C++-like code dump
+ */
+static void makeCodeDump(char* content, size_t length)
+{
+  static constexpr char CODE_LINE[] =
+      "  for (size_t i = 0; i < count && items[i] != nullptr; ++i) "
+      "{ total += items[i]->size(); }\n"
+      "  std::vector<std::pair<int, int>> ranges = getRanges(config);\n"
+      "  const char* name = entry->name; // raw pointer, no ownership\n";
+
+  for (size_t i = 0; i < length; ++i)
+  {
+    content[i] = CODE_LINE[i % (sizeof(CODE_LINE) - 1)];
+  }
+}
+
+int main()
+{
+  using mklog::utils::HtmlEscaper;
+  using mklog::utils::TextBuffer;
+  using Clock          = std::chrono::steady_clock;
+  using Implementation = HtmlEscaper::Implementation;
+
+  static constexpr struct
+  {
+    Implementation implementation;
+    const char*    name;
+  } IMPLEMENTATIONS[] = {
+      {Implementation::SCALAR, "scalar"},
+      {Implementation::SSE42, "sse4.2"},
+      {Implementation::AVX2, "avx2"},
+      {Implementation::AVX512, "avx512"},
+  };
+
+  static char content[CONTENT_LEN];
+  makeCodeDump(content, CONTENT_LEN);
+
+  TextBuffer output;
+  size_t     totalLen = 0;
+
+  for (const auto& entry : IMPLEMENTATIONS)
+  {
+    if (!HtmlEscaper::isSupported(entry.implementation))
+    {
+      printf("%-8s not supported\n", entry.name);
+      continue;
+    }
+    HtmlEscaper::useImplementation(entry.implementation);
+
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < ITERATIONS; ++i)
+    {
+      output.clear();
+      HtmlEscaper::append(output, content, CONTENT_LEN);
+      totalLen += output.length();
+    }
+    Clock::time_point end = Clock::now();
+
+    double totalNs =
+        std::chrono::duration<double, std::nano>(end - start).count();
+    printf("%-8s %8.1f ns/message %6.2f GB/s\n", entry.name,
+           totalNs / ITERATIONS,
+           (double)(CONTENT_LEN * ITERATIONS) / totalNs);
+  }
+
+  fprintf(stderr, "Total escaped length: %zu\n", totalLen);
+
+  return 0;
+}
@@ -0,0 +1,197 @@
+/**
+ * @file RouteBench.cpp
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Cost of routing a message through many writers with deep routes
+ *
+ * @version 0.1
+ * @date 2023-09-07
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#include <chrono>
+#include <cstdio>
+
+#include "mklog/LogManager.h"
+#include "mklog/LogMessage.h"
+#include "mklog/LogRoute.h"
+#include "mklog/LogWriter.h"
+#include "mklog/RouteCompiler.h"
+
+/**
+ * @brief Accept all messages and discard them
+ */
+class NullLogWriter : public mklog::LogWriter
+{
+public:
+  size_t messageCount = 0;
+
+protected:
+  bool canAcceptContentType(mklog::MessageContentType) const override
+  {
+    return true;
+  }
+
+  Status writeMessage(const mklog::LogMessage&) override
+  {
+    ++messageCount;
+    return Status::OK;
+  }
+};
+
+/**
+ * @brief Custom rule which cannot be compiled into attribute set
+ */
+class OddLineRoutingRule : public mklog::LogRoutingRule
+{
+public:
+  bool matchMessage(const mklog::LogMessage& message) const override
+  {
+    return message.source.line % 2 == 1;
+  }
+};
+
+static constexpr size_t ITERATIONS   = 1000000;
+static constexpr size_t WRITER_COUNT = 24;
+static constexpr size_t ROUTE_DEPTH  = 16;
+
+template <typename TCall>
+static void runBenchmark(const char* name, TCall call)
+{
+  using Clock = std::chrono::steady_clock;
+
+  Clock::time_point start = Clock::now();
+  for (size_t i = 0; i < ITERATIONS; ++i)
+  {
+    call(i);
+  }
+  Clock::time_point end = Clock::now();
+
+  double totalNs = std::chrono::duration<double, std::nano>(end - start).count();
+  printf("%-24s %8.1f ns/message\n", name, totalNs / ITERATIONS);
+}
+
+/**
+ * @brief Build deep route mixing severity and content type checks. Every
+ * fourth route also depends on custom rule.
+ */
+static mklog::LogRoute makeDeepRoute(size_t index)
+{
+  using mklog::ContentTypeRoutingRule;
+  using mklog::LogRoute;
+  using mklog::MessageContentType;
+  using mklog::MessageSeverity;
+  using mklog::SeverityRoutingRule;
+
+  LogRoute route = LogRoute::makeRoute<SeverityRoutingRule>(
+      (MessageSeverity)(index % ((size_t)MessageSeverity::MAX_LEVEL + 1)));
+
+  for (size_t level = 0; level < ROUTE_DEPTH; ++level)
+  {
+    const LogRoute severity = LogRoute::makeRoute<SeverityRoutingRule>(
+        (MessageSeverity)((index + level) % 4));
+    const LogRoute type = LogRoute::makeRoute<ContentTypeRoutingRule>(
+        (MessageContentType)((index + level) %
+                             ((size_t)MessageContentType::MAX_TYPE + 1)));
+
+    switch (level % 3)
+    {
+    case 0:
+      route = route || (severity && type);
+      break;
+    case 1:
+      route = route && !(type && !severity);
+      break;
+    default:
+      route = (route && severity) || (route && !type);
+      break;
+    }
+  }
+
+  if (index % 4 == 0)
+  {
+    route = route && LogRoute::makeRoute<OddLineRoutingRule>();
+  }
+
+  return route;
+}
+
+int main()
+{
+  using mklog::CompiledRoute;
+  using mklog::LogManager;
+  using mklog::LogMessage;
+  using mklog::LogRoute;
+  using mklog::MessageContentType;
+  using mklog::MessageSeverity;
+
+  LogRoute*      routes[WRITER_COUNT] = {};
+  CompiledRoute  compiledRoutes[WRITER_COUNT];
+  NullLogWriter* writers[WRITER_COUNT] = {};
+
+  size_t programLen = 0;
+  for (size_t i = 0; i < WRITER_COUNT; ++i)
+  {
+    routes[i] = new LogRoute(makeDeepRoute(i));
+    compiledRoutes[i].compile(*routes[i]);
+    programLen += compiledRoutes[i].getProgramLen();
+
+    writers[i] = &LogManager::addWriter<NullLogWriter>();
+    writers[i]->setRoute(*routes[i]);
+  }
+  LogManager::initLogs();
+
+  printf("%zu writers, average program length %.1f nodes\n", WRITER_COUNT,
+         (double)programLen / WRITER_COUNT);
+
+  LogMessage message = {};
+  message.source     = {.file     = __FILE__,
+                        .function = __PRETTY_FUNCTION__,
+                        .line     = 0,
+                        .logger   = "bench"};
+  message.content    = "Routed message";
+  message.contentLen = sizeof("Routed message");
+
+  auto setAttributes = [&message](size_t i) {
+    message.severity =
+        (MessageSeverity)(i % ((size_t)MessageSeverity::MAX_LEVEL + 1));
+    message.contentType =
+        (MessageContentType)(i % ((size_t)MessageContentType::MAX_TYPE + 1));
+    message.source.line = i;
+  };
+
+  size_t treeMatches = 0;
+  runBenchmark("Route tree walk", [&](size_t i) {
+    setAttributes(i);
+    for (size_t w = 0; w < WRITER_COUNT; ++w)
+    {
+      treeMatches += routes[w]->matchMessage(message);
+    }
+  });
+
+  size_t compiledMatches = 0;
+  runBenchmark("Compiled route", [&](size_t i) {
+    setAttributes(i);
+    for (size_t w = 0; w < WRITER_COUNT; ++w)
+    {
+      compiledMatches += compiledRoutes[w].matchMessage(message);
+    }
+  });
+
+  runBenchmark("LogManager dispatch", [&](size_t i) {
+    setAttributes(i);
+    LogManager::logMessage(message);
+  });
+
+  size_t written = 0;
+  for (size_t i = 0; i < WRITER_COUNT; ++i)
+  {
+    written += writers[i]->messageCount;
+    delete routes[i];
+  }
+
+  fprintf(stderr, "Matches: tree %zu, compiled %zu, written %zu\n",
+          treeMatches, compiledMatches, written);
+
+  return treeMatches == compiledMatches && written == treeMatches ? 0 : 1;
+}
@@ -0,0 +1,90 @@
+/**
+ * @file SubstringSearchBench.cpp
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Throughput of substring search in rendered log text
+ *
+ * @version 0.1
+ * @date 2023-09-19
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include "mklog/utils/SubstringSearch.h"
+
+static constexpr size_t ITERATIONS = 200;
+static constexpr size_t TEXT_LEN   = 4 * 1024 * 1024;
+
+/**
+ * @brief Fill buffer with text log records, none of which contains searched
+ * pattern
+ */
+static void makeLogText(char* text, size_t length)
+{
+  static constexpr char RECORD[] =
+      "<2023-09-19 12:00:00.123456+0300> [ INFO  ] 'net' in "
+      "'void Connection::receive(Packet&)' at 'src/net/Connection.cpp:120':\n"
+      "\treceived packet of 1440 bytes from 10.0.0.1:443, queue length 17\n";
+
+  for (size_t i = 0; i < length; ++i)
+  {
+    text[i] = RECORD[i % (sizeof(RECORD) - 1)];
+  }
+}
+
+int main()
+{
+  using mklog::utils::SubstringSearch;
+  using Clock          = std::chrono::steady_clock;
+  using Implementation = SubstringSearch::Implementation;
+
+  static constexpr struct
+  {
+    Implementation implementation;
+    const char*    name;
+  } IMPLEMENTATIONS[] = {
+      {Implementation::SCALAR, "scalar"},
+      {Implementation::SSE2, "sse2"},
+      {Implementation::AVX2, "avx2"},
+      {Implementation::AVX512, "avx512"},
+  };
+
+  // Pattern shares prefix with frequent text
+  static constexpr char PATTERN[] = "received packet of 9000 bytes";
+
+  static char text[TEXT_LEN];
+  makeLogText(text, TEXT_LEN);
+
+  size_t foundCount = 0;
+
+  for (const auto& entry : IMPLEMENTATIONS)
+  {
+    if (!SubstringSearch::isSupported(entry.implementation))
+    {
+      printf("%-8s not supported\n", entry.name);
+      continue;
+    }
+    SubstringSearch::useImplementation(entry.implementation);
+
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < ITERATIONS; ++i)
+    {
+      const size_t found = SubstringSearch::find(text, TEXT_LEN, PATTERN,
+                                                 sizeof(PATTERN) - 1);
+      foundCount += found != SubstringSearch::NOT_FOUND ? 1 : 0;
+    }
+    Clock::time_point end = Clock::now();
+
+    double totalNs =
+        std::chrono::duration<double, std::nano>(end - start).count();
+    printf("%-8s %6.2f GB/s\n", entry.name,
+           (double)(TEXT_LEN * ITERATIONS) / totalNs);
+  }
+
+  fprintf(stderr, "Total found: %zu\n", foundCount);
+
+  return 0;
+}
@@ -84,6 +84,10 @@ int main()
   dprintf(longMsgFd, "Long message ends here\n");
 
   logger.endLongMessage(longMsgFd);
+
+  logger.LOG_LONG_INFO(MessageContentType::TEXT, "Long message built in memory")
+          .printf("Answer is %d\n", 42)
+      << "Pi is about " << 3.14159 << '\n';
   LogMessageFd emptyMsgFd =
       logger.LOG_BEGIN_FATAL(MessageContentType::TEXT, "This won't be printed");
 
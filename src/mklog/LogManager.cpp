@@ -7,11 +7,24 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <chrono>
 #include <fcntl.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
 #include <unistd.h>
 
 #include "mklog/LogWriter.h"
+#include "mklog/RateLimiter.h"
+#include "mklog/utils/DeferredArgs.h"
+#include "mklog/utils/EpochReclaimer.h"
+#include "mklog/utils/LogClock.h"
+#include "mklog/utils/SignalSafeWriter.h"
 #include "mklog/utils/SimpleList.h"
+#include "mklog/utils/TextBuffer.h"
+#include "mklog/utils/TimestampFormatter.h"
 
 namespace mklog
 {
@@ -19,36 +32,107 @@ namespace mklog
 utils::SimpleList<LogWriter*> LogManager::s_writerList =
     utils::SimpleList<LogWriter*>();
 
-utils::SimpleList<LogManager::LongMessageInfo> LogManager::s_longMsgList =
-    utils::SimpleList<LogManager::LongMessageInfo>();
+std::mutex LogManager::s_configMutex;
+
+LogManager::MessageHandle* LogManager::s_fdHandles = nullptr;
+
+size_t LogManager::s_fdHandleCapacity = 0;
+
+std::mutex LogManager::s_fdHandleMutex;
+
+std::thread LogManager::s_pipeDrainerThread = std::thread();
+
+int LogManager::s_pipeEpollFd = -1;
+
+int LogManager::s_pipeWakeFd = -1;
 
 utils::SimpleList<LogManager::HandledSignal> LogManager::s_handledSignals =
     utils::SimpleList<LogManager::HandledSignal>();
 
-LogManager::Status LogManager::s_currentStatus =
-    LogManager::Status::UNINITIALIZED;
+char LogManager::s_crashRecordBuffer[CRASH_BUFFER_SIZE] = {};
+
+char LogManager::s_crashContentBuffer[CRASH_BUFFER_SIZE] = {};
+
+alignas(16) char LogManager::s_crashStack[CRASH_STACK_SIZE] = {};
+
+std::atomic<LogManager::Status> LogManager::s_currentStatus(
+    LogManager::Status::UNINITIALIZED);
+
+size_t LogManager::s_asyncQueueCapacity = 0;
+
+utils::MpscRingBuffer<LogManager::QueuedMessage>* LogManager::s_asyncQueue =
+    nullptr;
+
+std::thread LogManager::s_dispatcherThread = std::thread();
+
+std::atomic<bool> LogManager::s_dispatcherStop(false);
+
+std::atomic<size_t> LogManager::s_dispatchedCount(0);
+
+std::atomic<bool> LogManager::s_isQueueClosed(false);
+
+std::atomic<size_t> LogManager::s_pushingCount(0);
+
+std::atomic<pid_t> LogManager::s_crashingThread(0);
+
+bool LogManager::s_deferFormatting = false;
+
+std::atomic<RouteCompiler::AttributeSet> LogManager::s_acceptMask(
+    RouteCompiler::ATTRIBUTES_NONE);
+
+std::atomic<const LogManager::WriterSnapshot*> LogManager::s_writerSnapshot(
+    nullptr);
+
+uint32_t LogManager::s_configEpoch = LogSiteState::RouteCache::EPOCH_NONE;
 
 void LogManager::handleSignal(int signumber)
 {
-  // Try to send all messages
-  for (LongMessageInfo& messageInfo : s_longMsgList)
+  const int savedErrno = errno;
+
+  // Process ends with old handler, so messages are written now. Otherwise
+  // they reach writers as usual once handler returns
+  if (isTerminatingSignal(signumber))
   {
-    size_t appendedLen = appendPipeContent(&messageInfo);
-    if (appendedLen > 0)
+    pid_t crashingThread = 0;
+    if (s_crashingThread.compare_exchange_strong(
+            crashingThread, (pid_t)syscall(SYS_gettid),
+            std::memory_order_seq_cst))
     {
-      // Send message
-      logMessage(messageInfo.message);
+      flushOnCrash();
+    }
+  }
 
-      // Make empty content
-      char* newContent = new char[2];
-      newContent[0]    = '\n';
-      newContent[1]    = '\0';
-      delete[] messageInfo.message.content;
-      messageInfo.message.content    = newContent;
-      messageInfo.message.contentLen = 2;
+  errno = savedErrno;
+  raiseWithPrevHandler(signumber);
+}
+
+void LogManager::handleCrashSignal(int signumber)
+{
+  const int   savedErrno = errno;
+  const pid_t thread     = (pid_t)syscall(SYS_gettid);
+
+  pid_t crashingThread = 0;
+  if (s_crashingThread.compare_exchange_strong(crashingThread, thread,
+                                               std::memory_order_seq_cst))
+  {
+    flushOnCrash();
+  }
+  else if (crashingThread != thread)
+  {
+    // First crashing thread writes messages and terminates process
+    while (true)
+    {
+      pause();
     }
   }
+  // Otherwise crash handler itself crashed, messages are not retried
 
+  errno = savedErrno;
+  raiseWithPrevHandler(signumber);
+}
+
+void LogManager::raiseWithPrevHandler(int signumber)
+{
   // Find old handler
   const struct sigaction* oldHandler = nullptr;
   for (const HandledSignal& handledSignal : s_handledSignals)
@@ -78,213 +162,1483 @@ void LogManager::handleSignal(int signumber)
   }
 }
 
-size_t LogManager::appendPipeContent(LogManager::LongMessageInfo* messageInfo)
+bool LogManager::isTerminatingSignal(int signumber)
 {
-  LogMessage& curMessage = messageInfo->message;
-  MessageFd   readFd     = messageInfo->contentReadFd;
+  for (const HandledSignal& handledSignal : s_handledSignals)
+  {
+    if (handledSignal.signal == signumber)
+    {
+      const struct sigaction& prevAction = handledSignal.prevAction;
+      return (prevAction.sa_flags & SA_SIGINFO) == 0 &&
+             prevAction.sa_handler == SIG_DFL;
+    }
+  }
+  return false;
+}
 
-  errno = 0;
+void LogManager::flushOnCrash()
+{
+  // Read guard may allocate reader slot, so snapshot is used without it.
+  // It can only be freed if writers are reconfigured during crash
+  const WriterSnapshot* snapshot =
+      s_writerSnapshot.load(std::memory_order_acquire);
+  if (snapshot == nullptr)
+  {
+    return;
+  }
 
-  // Read all pipe content
-  const size_t maxContentSize = curMessage.contentLen + LONG_MESSAGE_LEN_MAX;
-  char*        fullContent    = new char[maxContentSize];
-  char*        appendStart    = fullContent + curMessage.contentLen - 1;
-  ssize_t      appendSize     = read(readFd, appendStart, LONG_MESSAGE_LEN_MAX);
-  assert((appendSize != -1 || errno == EAGAIN) && "Read from pipe failed");
+  // Completed buffered records precede queued ones
+  for (size_t i = 0; i < snapshot->writerCount; ++i)
+  {
+    snapshot->writers[i]->flushSignalSafe();
+  }
+
+  // Messages left in dispatch queue
+  if (s_asyncQueue != nullptr)
+  {
+    s_asyncQueue->forEachPending([snapshot](const QueuedMessage& queued) {
+      LogMessage message = restoreQueuedMessage(queued);
+
+      if (queued.format != nullptr)
+      {
+        utils::SignalSafeWriter content(s_crashContentBuffer,
+                                        CRASH_BUFFER_SIZE - 1, -1);
+        utils::DeferredArgs::render(content, queued.format,
+                                    queued.inlineContent, queued.contentLen);
+        s_crashContentBuffer[content.length()] = '\0';
+
+        message.content    = s_crashContentBuffer;
+        message.contentLen = content.length() + 1;
+      }
+
+      writeCrashMessage(*snapshot, message);
+    });
+  }
+
+  // Unfinished long messages
+  LongMessageTable::forEachOpen([snapshot](LongMessageTable::Slot& slot,
+                                           MessageHandle) {
+    // Skip messages modified by interrupted thread
+    if (slot.isBusy.exchange(true, std::memory_order_acquire))
+    {
+      return;
+    }
+
+    if (slot.isOpen.load(std::memory_order_acquire))
+    {
+      writeCrashLongMessage(*snapshot, slot);
+    }
+    unlockLongMessage(slot);
+  });
+}
+
+void LogManager::writeCrashMessage(const WriterSnapshot& snapshot,
+                                   const LogMessage&     message)
+{
+  for (size_t i = 0; i < snapshot.writerCount; ++i)
+  {
+    snapshot.writers[i]->tryWriteMessageSignalSafe(
+        message, s_crashRecordBuffer, CRASH_BUFFER_SIZE);
+  }
+}
+
+void LogManager::writeCrashLongMessage(const WriterSnapshot&   snapshot,
+                                       LongMessageTable::Slot& slot)
+{
+  LogMessage message   = slot.message;
+  uint32_t   partCount = slot.partCount;
 
-  // If nothing is read
-  if (appendSize <= 0)
+  // Pipe is blocking, so only content which is already there is read
+  int pipeLen = 0;
+  if (slot.contentReadFd < 0 ||
+      ioctl(slot.contentReadFd, FIONREAD, &pipeLen) != 0 || pipeLen < 0)
   {
-    delete[] fullContent;
-    return 0;
+    pipeLen = 0;
   }
 
-  // Prepend template content to pipe content
-  strncpy(fullContent, curMessage.content, curMessage.contentLen - 1);
+  // Content collected in memory goes first, then pipe content in parts
+  // which fit into crash buffer
+  const char* data     = slot.content.data();
+  size_t      dataLen  = slot.content.length();
+  size_t      pipeLeft = (size_t)pipeLen;
+  while (true)
+  {
+    const bool isLast = pipeLeft == 0;
+    if (dataLen > 0 || isLast)
+    {
+      if (partCount == 0)
+      {
+        message.part = isLast ? LogMessage::Part::WHOLE
+                              : LogMessage::Part::BEGIN;
+      }
+      else
+      {
+        message.part = isLast ? LogMessage::Part::END
+                              : LogMessage::Part::CONTINUE;
+      }
+      message.longMessageId = message.part == LogMessage::Part::WHOLE
+                                  ? 0
+                                  : slot.message.longMessageId;
+      message.content       = data;
+      message.contentLen    = dataLen;
+
+      writeCrashMessage(snapshot, message);
+      ++partCount;
+      dataLen = 0;
+    }
+
+    if (isLast)
+    {
+      break;
+    }
 
-  // Replace old content with new
-  delete[] curMessage.content;
-  curMessage.content = fullContent;
+    const size_t chunkLen =
+        pipeLeft < CRASH_BUFFER_SIZE ? pipeLeft : CRASH_BUFFER_SIZE;
+    ssize_t readLen = 0;
+    do
+    {
+      readLen = read(slot.contentReadFd, s_crashContentBuffer, chunkLen);
+    } while (readLen < 0 && errno == EINTR);
 
-  // Adjust contentLen
-  curMessage.contentLen += appendSize - 1;
+    if (readLen <= 0)
+    {
+      pipeLeft = 0;
+      continue;
+    }
 
-  return appendSize;
+    pipeLeft -= (size_t)readLen;
+    data    = s_crashContentBuffer;
+    dataLen = (size_t)readLen;
+  }
 }
 
-void LogManager::endLogs()
+LogManager::SpliceStatus
+LogManager::splicePipeContent(LongMessageTable::Slot& slot, bool canDefer)
 {
-  // Check that logs are started
-  assert(s_currentStatus == Status::READY &&
-         "Cannot end logs: logs not started");
+  // Spliced content cannot wait in dispatch queue
+  if (s_asyncQueue != nullptr ||
+      s_currentStatus.load(std::memory_order_acquire) != Status::READY)
+  {
+    return SpliceStatus::UNSUPPORTED;
+  }
+
+  int pipedLen = 0;
+  if (ioctl(slot.contentReadFd, FIONREAD, &pipedLen) != 0 || pipedLen <= 0)
+  {
+    return SpliceStatus::UNSUPPORTED;
+  }
+
+  utils::EpochReclaimer::ReadGuard guard;
+  const WriterSnapshot* snapshot =
+      s_writerSnapshot.load(std::memory_order_acquire);
+  if (snapshot == nullptr || snapshot->writerCount > ROUTE_CACHE_WRITERS_MAX)
+  {
+    return SpliceStatus::UNSUPPORTED;
+  }
 
-  // For all registered long messages
-  for (LongMessageInfo& messageInfo : s_longMsgList)
+  // Content in memory precedes piped content
+  LogMessage message = slot.message;
+  message.content    = slot.content.data();
+  message.contentLen = slot.content.length();
+  message.part       = slot.partCount == 0 ? LogMessage::Part::BEGIN
+                                           : LogMessage::Part::CONTINUE;
+
+  // Find writers accepting message
+  uint64_t acceptedWriters = 0;
+  uint64_t matchedWriters  = 0;
+  getMessageRoutes(*snapshot, message, &acceptedWriters, &matchedWriters);
+
+  uint64_t spliceWriters = 0;
+  uint64_t copyWriters   = 0;
+  uint64_t writers       = acceptedWriters | matchedWriters;
+  while (writers != 0)
   {
-    // Read all pipe content
-    size_t appendedLen = appendPipeContent(&messageInfo);
-    if (appendedLen)
+    const size_t   index = __builtin_ctzll(writers);
+    const uint64_t bit   = uint64_t{1} << index;
+    writers &= writers - 1;
+
+    const LogWriter* writer = snapshot->writers[index];
+    if ((matchedWriters & bit) && !writer->acceptsMessage(message))
     {
-      // Send message to all writers
-      logMessage(messageInfo.message);
+      continue;
     }
 
-    // Dispose message content
-    delete[] messageInfo.message.content;
+    if (writer->maySpliceContent())
+      spliceWriters |= bit;
+    else
+      copyWriters |= bit;
   }
-  s_longMsgList.clear();
 
-  // For all writers
-  for (LogWriter* writer : s_writerList)
+  if (spliceWriters == 0)
   {
-    // Delete writer
-    delete writer;
+    return SpliceStatus::UNSUPPORTED;
   }
-  // Clear list of writers
-  s_writerList.clear();
 
-  // Mark LogManager as deinitialized
-  s_currentStatus = Status::UNINITIALIZED;
-} // namespace mklog
+  // Wait for more content, so that parts are not too small
+  if (canDefer && (size_t)pipedLen < LONG_MESSAGE_PART_LEN)
+  {
+    return SpliceStatus::DEFERRED;
+  }
 
-void LogManager::initLogs()
+  // The last writer takes content out of pipe, others leave it there
+  LogWriter::PipedContent piped = {.fd      = slot.contentReadFd,
+                                   .length  = (size_t)pipedLen,
+                                   .consume = false};
+  while (spliceWriters != 0)
+  {
+    const size_t index = __builtin_ctzll(spliceWriters);
+    spliceWriters &= spliceWriters - 1;
+
+    piped.consume = spliceWriters == 0 && copyWriters == 0;
+    snapshot->writers[index]->writeAcceptedSplicedMessage(message, piped);
+  }
+
+  if (copyWriters != 0)
+  {
+    // Read exactly the content which was spliced
+    size_t readTotal = 0;
+    slot.content.reserve((size_t)pipedLen);
+    while (readTotal < (size_t)pipedLen)
+    {
+      const ssize_t readLen =
+          read(slot.contentReadFd, slot.content.tail(),
+               (size_t)pipedLen - readTotal);
+      if (readLen < 0 && errno == EINTR)
+        continue;
+      if (readLen <= 0)
+        break;
+
+      slot.content.extend((size_t)readLen);
+      readTotal += (size_t)readLen;
+    }
+
+    message.content    = slot.content.data();
+    message.contentLen = slot.content.length();
+    while (copyWriters != 0)
+    {
+      const size_t index = __builtin_ctzll(copyWriters);
+      copyWriters &= copyWriters - 1;
+
+      snapshot->writers[index]->writeAcceptedMessage(message);
+    }
+  }
+
+  slot.content.clear();
+  slot.headerLen = 0;
+  ++slot.partCount;
+
+  return SpliceStatus::SPLICED;
+}
+
+bool LogManager::appendPipeContent(LongMessageTable::Slot& slot,
+                                   bool                    canDefer)
 {
-  // Check that logs are not started
-  assert(s_currentStatus == Status::UNINITIALIZED &&
-         "Cannot start logs: logs already started");
+  if (slot.contentReadFd < 0)
+  {
+    return true;
+  }
 
-  // Register exit callbacks
-  atexit(&LogManager::endLogs);
+  // Move content directly to writers if they can take it from pipe
+  switch (splicePipeContent(slot, canDefer))
+  {
+  case SpliceStatus::SPLICED:     return true;
+  case SpliceStatus::DEFERRED:    return false;
+  case SpliceStatus::UNSUPPORTED:
+  default:                        break;
+  }
 
-  // Register signal handlers
-  for (int signum : SIGNALS_TO_HANDLE)
+  // Read all pipe content
+  while (true)
   {
-    struct sigaction prevAction = {}, newAction = {};
+    sendFullParts(slot);
 
-    newAction.sa_handler = &handleSignal;
-    sigemptyset(&newAction.sa_mask);
-    newAction.sa_flags = 0;
+    const size_t freeLen = LONG_MESSAGE_PART_LEN - slot.content.length();
+    slot.content.reserve(freeLen);
 
-    sigaction(signum, &newAction, &prevAction);
-    s_handledSignals.pushFront({.signal = signum, .prevAction = prevAction});
+    errno                 = 0;
+    const ssize_t readLen = read(slot.contentReadFd, slot.content.tail(),
+                                 freeLen);
+    assert((readLen != -1 || errno == EAGAIN || errno == EINTR) &&
+           "Read from pipe failed");
+
+    if (readLen <= 0)
+    {
+      if (readLen < 0 && errno == EINTR)
+        continue;
+      break;
+    }
+    slot.content.extend((size_t)readLen);
   }
 
-  // Mark LogManager as ready
-  s_currentStatus = Status::READY;
+  return true;
 }
 
-void LogManager::logMessage(const LogMessage& message)
+void LogManager::appendContent(LongMessageTable::Slot& slot, const char* text,
+                               size_t length)
 {
-  // Check that LogManager is ready
-  if (s_currentStatus != Status::READY)
+  // Copy content part by part, so that pending content stays bounded
+  while (length > 0)
   {
-    return;
+    sendFullParts(slot);
+
+    const size_t freeLen = LONG_MESSAGE_PART_LEN - slot.content.length();
+    const size_t copyLen = length < freeLen ? length : freeLen;
+    slot.content.append(text, copyLen);
+    text   += copyLen;
+    length -= copyLen;
   }
+  sendFullParts(slot);
+}
 
-  // For each registered writer
-  for (LogWriter* writer : s_writerList)
+void LogManager::sendFullParts(LongMessageTable::Slot& slot)
+{
+  while (slot.content.length() >= LONG_MESSAGE_PART_LEN)
   {
-    // Try to send message to writer
-    writer->tryWriteMessage(message);
+    // Do not split lines between parts unless line is too long. Header is
+    // never sent alone
+    const size_t searchStart = slot.headerLen < LONG_MESSAGE_PART_LEN
+                                   ? slot.headerLen
+                                   : LONG_MESSAGE_PART_LEN;
+    const char*  content     = slot.content.data();
+    const char*  lineEnd     = static_cast<const char*>(
+        memrchr(content + searchStart, '\n',
+                LONG_MESSAGE_PART_LEN - searchStart));
+    const size_t partLen = lineEnd != nullptr
+                               ? (size_t)(lineEnd - content) + 1
+                               : LONG_MESSAGE_PART_LEN;
+
+    sendLongMessagePart(slot, partLen, false);
   }
 }
 
-LogManager::MessageFd LogManager::beginLongMessage(const LogMessage& message)
+bool LogManager::sendPendingContent(LongMessageTable::Slot& slot, bool isLast)
 {
-  if (s_currentStatus != Status::READY)
+  // Message consisting of header only is not sent. Once message has
+  // started, the last part is sent even if empty to mark its end
+  const size_t length = slot.content.length();
+  if (length <= slot.headerLen && (!isLast || slot.partCount == 0))
   {
-    return STDERR_FILENO;
+    return false;
   }
 
-  MessageFd pipeFds[2] = {MESSAGE_FD_INVALID, MESSAGE_FD_INVALID};
+  sendLongMessagePart(slot, length, isLast);
+  return true;
+}
 
-  // Open pipe for message content
-  int pipeStatus = pipe(pipeFds);
-  if (pipeStatus != 0) // Failed to create pipe
+void LogManager::sendLongMessagePart(LongMessageTable::Slot& slot,
+                                     size_t length, bool isLast)
+{
+  LogMessage message = slot.message;
+  message.content    = slot.content.data();
+  message.contentLen = length;
+
+  if (slot.partCount == 0)
   {
-    return MESSAGE_FD_INVALID;
+    message.part = isLast ? LogMessage::Part::WHOLE : LogMessage::Part::BEGIN;
+  }
+  else
+  {
+    message.part = isLast ? LogMessage::Part::END : LogMessage::Part::CONTINUE;
   }
-  MessageFd pipeReadFd  = pipeFds[0];
-  MessageFd pipeWriteFd = pipeFds[1];
 
-  // Ensure correct buffer size for pipe
-  fcntl(pipeReadFd, F_SETPIPE_SZ, (int)LONG_MESSAGE_LEN_MAX);
+  if (message.part == LogMessage::Part::WHOLE)
+  {
+    message.longMessageId = 0;
+  }
 
-  // Make read nonblocking
-  int oldFlags = fcntl(pipeReadFd, F_GETFL);
-  fcntl(pipeReadFd, F_SETFL, oldFlags | O_NONBLOCK);
+  logMessage(message);
 
-  // Copy template content
-  char* contentCopy = new char[message.contentLen];
-  memcpy(contentCopy, message.content, message.contentLen);
+  slot.content.consume(length);
+  slot.headerLen = 0;
+  ++slot.partCount;
+}
 
-  // Create message for saving
-  LogMessage messageCopy = message;
-  messageCopy.content    = contentCopy;
+void LogManager::finishLongMessage(MessageHandle           handle,
+                                   LongMessageTable::Slot& slot)
+{
+  appendPipeContent(slot);
+  sendPendingContent(slot, true);
 
-  // Register long message
-  s_longMsgList.pushFront({.message        = messageCopy,
-                           .contentWriteFd = pipeWriteFd,
-                           .contentReadFd  = pipeReadFd});
+  // Close pipe descriptors
+  if (slot.contentReadFd >= 0)
+  {
+    close(slot.contentReadFd);
+    close(slot.contentWriteFd);
+  }
 
-  // Return opened pipe write file descriptor
-  return pipeWriteFd; // NOLINT: no memory leak, contentCopy is saved
+  LongMessageTable::release(handle);
 }
 
-void LogManager::endLongMessage(LogManager::MessageFd& fd)
+bool LogManager::startPipeDrainer()
 {
-  if (s_currentStatus != Status::READY)
+  if (s_pipeEpollFd >= 0)
   {
-    return;
+    return true;
   }
 
-  // Check input fd
-  assert(fd != MESSAGE_FD_INVALID && "Attempted access with invalid fd");
+  const int epollFd = epoll_create1(EPOLL_CLOEXEC);
+  const int wakeFd  = eventfd(0, EFD_CLOEXEC);
+
+  // Wake-up descriptor is marked with invalid handle
+  struct epoll_event wakeEvent = {};
+  wakeEvent.events             = EPOLLIN;
+  wakeEvent.data.u32           = MESSAGE_HANDLE_INVALID;
 
-  // Try to find message associated with file descriptor
-  LongMessageInfo* foundMessageInfo = nullptr;
-  for (LongMessageInfo& messageInfo : s_longMsgList)
+  if (epollFd < 0 || wakeFd < 0 ||
+      epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &wakeEvent) != 0)
   {
-    if (messageInfo.contentWriteFd == fd)
-      foundMessageInfo = &messageInfo;
+    if (epollFd >= 0)
+      close(epollFd);
+    if (wakeFd >= 0)
+      close(wakeFd);
+    return false;
   }
 
-  // Check that message is found
-  assert(foundMessageInfo != nullptr && "Unknown fd used to access message");
+  s_pipeEpollFd       = epollFd;
+  s_pipeWakeFd        = wakeFd;
+  s_pipeDrainerThread = std::thread(runPipeDrainer);
 
-  // Build message content
-  size_t appendedLen = appendPipeContent(foundMessageInfo);
+  return true;
+}
 
-  if (appendedLen > 0)
+void LogManager::stopPipeDrainer()
+{
+  std::lock_guard<std::mutex> lock(s_fdHandleMutex);
+  if (s_pipeEpollFd < 0)
   {
-    // Send message to all writers
-    logMessage(foundMessageInfo->message);
+    return;
   }
 
-  // Save pipe descriptors
-  MessageFd readFd  = foundMessageInfo->contentReadFd;
-  MessageFd writeFd = foundMessageInfo->contentWriteFd;
+  const uint64_t wakeValue = 1;
+  ssize_t        written   = 0;
+  do
+  {
+    written = write(s_pipeWakeFd, &wakeValue, sizeof(wakeValue));
+  } while (written < 0 && errno == EINTR);
+  s_pipeDrainerThread.join();
+
+  close(s_pipeEpollFd);
+  close(s_pipeWakeFd);
+  s_pipeEpollFd = -1;
+  s_pipeWakeFd  = -1;
+}
+
+void LogManager::runPipeDrainer()
+{
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr int EVENT_COUNT_MAX = 64;
 
-  // Save message content
-  const char* messageContent = foundMessageInfo->message.content;
+  /// Time for which small content waits in pipe to be spliced with more
+  static constexpr std::chrono::milliseconds SPLICE_DELAY(10);
 
-  // Remove message from list
-  for (auto it = s_longMsgList.begin(), end = s_longMsgList.end(); it != end;
-       ++it)
+  utils::SimpleList<MessageHandle> deferredHandles;
+  Clock::time_point                deferDeadline = Clock::time_point();
+
+  struct epoll_event events[EVENT_COUNT_MAX] = {};
+  while (true)
   {
-    if ((*it).contentWriteFd == fd)
+    int timeoutMs = -1;
+    if (!deferredHandles.empty())
+    {
+      const auto timeLeft = std::chrono::duration_cast<
+          std::chrono::milliseconds>(deferDeadline - Clock::now());
+      timeoutMs = timeLeft.count() > 0 ? (int)timeLeft.count() : 0;
+    }
+
+    const int eventCount =
+        epoll_wait(s_pipeEpollFd, events, EVENT_COUNT_MAX, timeoutMs);
+    if (eventCount < 0 && errno != EINTR)
+    {
+      break;
+    }
+
+    bool isStopRequested = false;
+    for (int i = 0; i < eventCount; ++i)
+    {
+      const MessageHandle handle = events[i].data.u32;
+      if (handle == MESSAGE_HANDLE_INVALID)
+      {
+        isStopRequested = true;
+        continue;
+      }
+
+      if (drainPipe(handle, true))
+      {
+        if (deferredHandles.empty())
+        {
+          deferDeadline = Clock::now() + SPLICE_DELAY;
+        }
+        deferredHandles.pushFront(handle);
+      }
+    }
+
+    // Send content which waited long enough
+    if (!deferredHandles.empty() && Clock::now() >= deferDeadline)
+    {
+      for (MessageHandle handle : deferredHandles)
+      {
+        drainPipe(handle, false);
+      }
+      deferredHandles.clear();
+    }
+
+    if (isStopRequested)
     {
-      s_longMsgList.erase(it);
       break;
     }
   }
 
-  // Close pipe descriptors
-  close(readFd);
-  close(writeFd);
+  // Remaining content is sent when messages are ended
+  deferredHandles.clear();
+}
+
+bool LogManager::drainPipe(MessageHandle handle, bool canDefer)
+{
+  LongMessageTable::Slot* slot = LongMessageTable::find(handle);
+  if (slot == nullptr)
+  {
+    return false;
+  }
+
+  // Message could have been ended while waiting for it
+  bool isNewlyDeferred = false;
+  lockLongMessage(*slot);
+  if (LongMessageTable::find(handle) == slot)
+  {
+    const bool isDeferred = !appendPipeContent(*slot, canDefer);
+    if (isDeferred != slot->isPipeDeferred)
+    {
+      // Level-triggered pipe would wake drainer until it is read, so
+      // deferred pipe is watched for new writes only
+      struct epoll_event pipeEvent = {};
+      pipeEvent.events             = isDeferred ? EPOLLIN | EPOLLET : EPOLLIN;
+      pipeEvent.data.u32           = handle;
+      epoll_ctl(s_pipeEpollFd, EPOLL_CTL_MOD, slot->contentReadFd,
+                &pipeEvent);
+
+      isNewlyDeferred      = isDeferred;
+      slot->isPipeDeferred = isDeferred;
+    }
+  }
+  unlockLongMessage(*slot);
+
+  return isNewlyDeferred;
+}
+
+void LogManager::endLogs()
+{
+  // Check that logs are started
+  assert(s_currentStatus.load(std::memory_order_relaxed) == Status::READY &&
+         "Cannot end logs: logs not started");
+
+  // Pipes are drained below, no new content can arrive after that
+  stopPipeDrainer();
+
+  // Send all open long messages
+  LongMessageTable::forEachOpen([](LongMessageTable::Slot& slot,
+                                   MessageHandle          handle) {
+    lockLongMessage(slot);
+    if (slot.isOpen.load(std::memory_order_acquire))
+    {
+      finishLongMessage(handle, slot);
+    }
+    unlockLongMessage(slot);
+  });
+
+  {
+    std::lock_guard<std::mutex> lock(s_fdHandleMutex);
+    delete[] s_fdHandles;
+    s_fdHandles        = nullptr;
+    s_fdHandleCapacity = 0;
+  }
+
+  // Report messages dropped at sites which stayed quiet
+  logSuppressedSummaries(&logMessage);
+
+  // Write all queued messages and stop dispatcher thread
+  if (s_asyncQueue != nullptr)
+  {
+    // Threads which are pushing messages finish before queue is deleted
+    s_isQueueClosed.store(true);
+    while (s_pushingCount.load(std::memory_order_acquire) != 0)
+    {
+      std::this_thread::yield();
+    }
+
+    s_dispatcherStop.store(true, std::memory_order_release);
+    s_dispatcherThread.join();
+
+    delete s_asyncQueue;
+    s_asyncQueue = nullptr;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(s_configMutex);
+
+    // Mark LogManager as deinitialized
+    s_currentStatus.store(Status::UNINITIALIZED, std::memory_order_release);
+
+    // Unpublish all writers
+    utils::SimpleList<LogWriter*> removedWriters;
+    for (LogWriter* writer : s_writerList)
+    {
+      removedWriters.pushFront(writer);
+    }
+    s_writerList.clear();
+    publishSnapshot();
+
+    // Buffered messages are written when writer is deleted
+    for (LogWriter* writer : removedWriters)
+    {
+      utils::EpochReclaimer::retire(writer);
+    }
+    removedWriters.clear();
+  }
+
+  // Wait for threads still writing to removed writers
+  utils::EpochReclaimer::synchronize();
+}
+
+void LogManager::initLogs()
+{
+  // Check that logs are not started
+  assert(s_currentStatus.load(std::memory_order_relaxed) ==
+             Status::UNINITIALIZED &&
+         "Cannot start logs: logs already started");
+
+  // Register exit callbacks
+  atexit(&LogManager::endLogs);
+
+  // Let crash handler run after stack overflow in this thread
+  stack_t altStack = {};
+  if (sigaltstack(nullptr, &altStack) == 0 &&
+      (altStack.ss_flags & SS_DISABLE) != 0)
+  {
+    altStack = {
+        .ss_sp = s_crashStack, .ss_flags = 0, .ss_size = CRASH_STACK_SIZE};
+    sigaltstack(&altStack, nullptr);
+  }
+
+  // Crash handler cannot call into C library to get time zone
+  utils::TimestampFormatter::captureUtcOffset();
+
+  // Register signal handlers
+  for (int signum : SIGNALS_TO_HANDLE)
+  {
+    struct sigaction prevAction = {}, newAction = {};
+
+    bool isCrashSignal = false;
+    for (int crashSignum : CRASH_SIGNALS)
+    {
+      isCrashSignal = isCrashSignal || crashSignum == signum;
+    }
+
+    newAction.sa_handler = isCrashSignal ? &handleCrashSignal : &handleSignal;
+    sigemptyset(&newAction.sa_mask);
+    newAction.sa_flags = isCrashSignal ? SA_ONSTACK : 0;
+
+    sigaction(signum, &newAction, &prevAction);
+    s_handledSignals.pushFront({.signal = signum, .prevAction = prevAction});
+  }
+
+  // Measure timestamp clock before messages are rendered
+  utils::LogClock::calibrate();
+  RateLimiter::updateLimits();
+
+  // Start dispatcher thread if requested
+  if (s_asyncQueueCapacity > 0)
+  {
+    s_asyncQueue =
+        new utils::MpscRingBuffer<QueuedMessage>(s_asyncQueueCapacity);
+    s_dispatcherStop.store(false, std::memory_order_relaxed);
+    s_isQueueClosed.store(false, std::memory_order_relaxed);
+    s_dispatchedCount.store(0, std::memory_order_relaxed);
+    s_dispatcherThread = std::thread(&LogManager::runDispatcher);
+  }
+
+  // Mark LogManager as ready
+  s_currentStatus.store(Status::READY, std::memory_order_release);
+  onConfigChanged();
+}
+
+void LogManager::onConfigChanged()
+{
+  std::lock_guard<std::mutex> lock(s_configMutex);
+  publishSnapshot();
+}
+
+void LogManager::publishSnapshot()
+{
+  WriterSnapshot* snapshot = new WriterSnapshot();
+
+  // Index writers
+  snapshot->writerCount = s_writerList.size();
+  snapshot->writers     = new LogWriter*[snapshot->writerCount];
+  size_t index          = 0;
+  for (LogWriter* writer : s_writerList)
+  {
+    snapshot->writers[index++] = writer;
+  }
+
+  // Invalidate cached routing decisions
+  ++s_configEpoch;
+  if (s_configEpoch == LogSiteState::RouteCache::EPOCH_LOCKED)
+  {
+    s_configEpoch = LogSiteState::RouteCache::EPOCH_NONE + 1;
+  }
+  snapshot->configEpoch = s_configEpoch;
+
+  const RouteCompiler::AttributeSet acceptMask = buildRouteTable(snapshot);
+
+  const WriterSnapshot* oldSnapshot =
+      s_writerSnapshot.exchange(snapshot, std::memory_order_acq_rel);
+  s_acceptMask.store(acceptMask, std::memory_order_relaxed);
+
+  if (oldSnapshot != nullptr)
+  {
+    utils::EpochReclaimer::retire(oldSnapshot);
+  }
+}
+
+void LogManager::registerWriter(LogWriter* writer)
+{
+  std::lock_guard<std::mutex> lock(s_configMutex);
+
+  s_writerList.pushFront(writer);
+  publishSnapshot();
+}
+
+void LogManager::exchangeWriter(LogWriter* oldWriter, LogWriter* newWriter)
+{
+  // Let old writer receive messages logged before the call
+  waitDispatched();
+
+  {
+    std::lock_guard<std::mutex> lock(s_configMutex);
+
+    auto it = s_writerList.begin();
+    while (it != s_writerList.end() && *it != oldWriter)
+    {
+      ++it;
+    }
+    assert(it != s_writerList.end() && "Writer is not registered");
+
+    // Keep writer position, so that write order does not change
+    if (newWriter != nullptr)
+    {
+      *it = newWriter;
+    }
+    else
+    {
+      s_writerList.erase(it);
+    }
+    publishSnapshot();
+
+    // Buffered messages are written when writer is deleted
+    utils::EpochReclaimer::retire(oldWriter);
+  }
+
+  // Wait for threads still writing to old writer
+  utils::EpochReclaimer::synchronize();
+}
+
+void LogManager::getSiteRoutes(const WriterSnapshot&    snapshot,
+                               LogSite::Id             siteId,
+                               LogMessage::ContentType contentType,
+                               uint64_t*               acceptedWriters,
+                               uint64_t*               matchedWriters)
+{
+  using RouteCache = LogSiteState::RouteCache;
+
+  RouteCache& cache =
+      LogSiteRegistry::getSiteState(siteId).routes[(size_t)contentType];
+  const uint32_t epoch = snapshot.configEpoch;
+
+  // Try to read cached decision
+  uint32_t cachedEpoch = cache.epoch.load(std::memory_order_acquire);
+  if (cachedEpoch == epoch)
+  {
+    *acceptedWriters = cache.acceptedWriters.load(std::memory_order_relaxed);
+    *matchedWriters  = cache.matchedWriters.load(std::memory_order_relaxed);
+
+    // Check that masks were not updated while being read
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (cache.epoch.load(std::memory_order_relaxed) == epoch)
+    {
+      return;
+    }
+  }
+
+  // Evaluate routes against site only for writers which cannot decide by
+  // severity and content type
+  const LogSite&         site  = LogSiteRegistry::getSite(siteId);
+  const RouteTableEntry& entry =
+      snapshot.routeTable[RouteCompiler::getAttributeIndex(site.severity,
+                                                           contentType)];
+  *acceptedWriters = entry.acceptedWriters;
+  *matchedWriters  = 0;
+
+  uint64_t undecidedWriters = entry.matchedWriters;
+  while (undecidedWriters != 0)
+  {
+    const size_t i = __builtin_ctzll(undecidedWriters);
+    undecidedWriters &= undecidedWriters - 1;
+
+    switch (snapshot.writers[i]->matchSite(site, contentType))
+    {
+    case RuleMatch::ALWAYS:
+      *acceptedWriters |= uint64_t{1} << i;
+      break;
+    case RuleMatch::MAYBE:
+      *matchedWriters |= uint64_t{1} << i;
+      break;
+    case RuleMatch::NEVER:
+    default:
+      break;
+    }
+  }
+
+  // Save decision unless other thread is saving it right now
+  if (cachedEpoch != RouteCache::EPOCH_LOCKED &&
+      cache.epoch.compare_exchange_strong(cachedEpoch,
+                                          RouteCache::EPOCH_LOCKED,
+                                          std::memory_order_acquire))
+  {
+    // Readers which see new values must also see locked epoch
+    std::atomic_thread_fence(std::memory_order_release);
+    cache.acceptedWriters.store(*acceptedWriters, std::memory_order_relaxed);
+    cache.matchedWriters.store(*matchedWriters, std::memory_order_relaxed);
+    cache.epoch.store(epoch, std::memory_order_release);
+  }
+}
+
+RouteCompiler::AttributeSet
+LogManager::buildRouteTable(WriterSnapshot* snapshot)
+{
+  using Severity    = LogMessage::Severity;
+  using ContentType = LogMessage::ContentType;
+
+  const size_t writerCount = snapshot->writerCount;
+
+  RouteCompiler::AttributeSet acceptMask = RouteCompiler::ATTRIBUTES_NONE;
+
+  for (size_t sev = 0; sev < RouteCompiler::SEVERITY_COUNT; ++sev)
+  {
+    for (size_t type = 0; type < RouteCompiler::CONTENT_TYPE_COUNT; ++type)
+    {
+      RouteTableEntry entry = {.acceptedWriters = 0, .matchedWriters = 0};
+
+      for (size_t i = 0; i < writerCount && i < ROUTE_CACHE_WRITERS_MAX; ++i)
+      {
+        switch (snapshot->writers[i]->matchAttributes((Severity)sev,
+                                                      (ContentType)type))
+        {
+        case RuleMatch::ALWAYS:
+          entry.acceptedWriters |= uint64_t{1} << i;
+          break;
+        case RuleMatch::MAYBE:
+          entry.matchedWriters |= uint64_t{1} << i;
+          break;
+        case RuleMatch::NEVER:
+        default:
+          break;
+        }
+      }
+
+      snapshot->routeTable[RouteCompiler::getAttributeIndex(
+          (Severity)sev, (ContentType)type)] = entry;
+
+      // Writers which do not fit into table are checked one by one
+      bool mayAccept = (entry.acceptedWriters | entry.matchedWriters) != 0;
+      for (size_t i = ROUTE_CACHE_WRITERS_MAX; !mayAccept && i < writerCount;
+           ++i)
+      {
+        if (snapshot->writers[i]->mayAcceptMessage((Severity)sev,
+                                                   (ContentType)type))
+        {
+          mayAccept = true;
+        }
+      }
+
+      // Nothing is accepted until logs are started
+      if (mayAccept &&
+          s_currentStatus.load(std::memory_order_relaxed) == Status::READY)
+      {
+        acceptMask |=
+            RouteCompiler::getAttributeBit((Severity)sev, (ContentType)type);
+      }
+    }
+  }
+
+  return acceptMask;
+}
+
+void LogManager::useAsyncDispatch(size_t queueCapacity)
+{
+  assert(s_currentStatus.load(std::memory_order_relaxed) ==
+             Status::UNINITIALIZED &&
+         "Cannot change dispatch mode: logs already started");
+
+  s_asyncQueueCapacity = queueCapacity;
+}
+
+void LogManager::useDeferredFormatting()
+{
+  assert(s_currentStatus.load(std::memory_order_relaxed) ==
+             Status::UNINITIALIZED &&
+         "Cannot change formatting mode: logs already started");
+  assert(s_asyncQueueCapacity > 0 &&
+         "Deferred formatting requires asynchronous dispatch");
+
+  s_deferFormatting = true;
+}
+
+void LogManager::logMessage(const LogMessage& message)
+{
+  // Check that LogManager is ready
+  if (s_currentStatus.load(std::memory_order_acquire) != Status::READY)
+  {
+    return;
+  }
+
+  // Defer writing to dispatcher thread if it is running
+  if (s_asyncQueue != nullptr)
+  {
+    enqueueMessage(message);
+    return;
+  }
+
+  dispatchMessage(message);
+}
+
+void LogManager::logDeferredMessage(const LogMessage& messageTemplate,
+                                    const char*       format,
+                                    const char*       encodedArgs,
+                                    size_t            encodedArgsLen)
+{
+  // Check that LogManager is ready
+  if (s_currentStatus.load(std::memory_order_acquire) != Status::READY)
+  {
+    return;
+  }
+
+  // Without dispatcher thread content has to be rendered right away
+  if (s_asyncQueue == nullptr)
+  {
+    utils::TextBuffer content;
+    utils::DeferredArgs::render(content, format, encodedArgs, encodedArgsLen);
+
+    LogMessage message = messageTemplate;
+    message.content    = content.data();
+    message.contentLen = content.length() + 1;
+    dispatchMessage(message);
+    return;
+  }
+
+  assert(messageTemplate.siteId != LogSite::ID_NONE &&
+         "Deferred formatting requires log site");
+  assert(encodedArgsLen <= QueuedMessage::INLINE_CONTENT_LEN &&
+         "Encoded arguments do not fit into queue record");
+
+  QueuedMessage queued; // NOLINT: inline content is filled only partially
+
+  fillQueuedMessage(&queued, messageTemplate);
+  queued.contentLen = encodedArgsLen;
+  queued.format     = format;
+  memcpy(queued.inlineContent, encodedArgs, encodedArgsLen);
+
+  pushQueuedMessage(queued);
+}
+
+void LogManager::waitDispatched()
+{
+  if (s_asyncQueue == nullptr)
+  {
+    return;
+  }
+
+  // Wait until dispatcher writes out all claimed queue cells
+  const size_t pushedCount = s_asyncQueue->pushedCount();
+  while (s_dispatchedCount.load(std::memory_order_acquire) < pushedCount)
+  {
+    std::this_thread::yield();
+  }
+}
+
+void LogManager::flushMessages()
+{
+  waitDispatched();
+
+  utils::EpochReclaimer::ReadGuard guard;
+  const WriterSnapshot* snapshot =
+      s_writerSnapshot.load(std::memory_order_acquire);
+  if (snapshot == nullptr)
+  {
+    return;
+  }
+
+  for (size_t i = 0; i < snapshot->writerCount; ++i)
+  {
+    snapshot->writers[i]->flush();
+  }
+}
+
+void LogManager::getMessageRoutes(const WriterSnapshot& snapshot,
+                                  const LogMessage&     message,
+                                  uint64_t*             acceptedWriters,
+                                  uint64_t*             matchedWriters)
+{
+  // Use cached routing decision if message has known source
+  if (message.siteId != LogSite::ID_NONE)
+  {
+    getSiteRoutes(snapshot, message.siteId, message.contentType,
+                  acceptedWriters, matchedWriters);
+    return;
+  }
+
+  const RouteTableEntry& entry =
+      snapshot.routeTable[RouteCompiler::getAttributeIndex(
+          message.severity, message.contentType)];
+  *acceptedWriters = entry.acceptedWriters;
+  *matchedWriters  = entry.matchedWriters;
+}
+
+void LogManager::dispatchMessage(const LogMessage& message)
+{
+  utils::EpochReclaimer::ReadGuard guard;
+  const WriterSnapshot* snapshot =
+      s_writerSnapshot.load(std::memory_order_acquire);
+  if (snapshot == nullptr)
+  {
+    return;
+  }
+
+  if (snapshot->writerCount <= ROUTE_CACHE_WRITERS_MAX)
+  {
+    uint64_t acceptedWriters = 0;
+    uint64_t matchedWriters  = 0;
+    getMessageRoutes(*snapshot, message, &acceptedWriters, &matchedWriters);
+
+    // Write message to all interested writers in writer list order
+    uint64_t writers = acceptedWriters | matchedWriters;
+    while (writers != 0)
+    {
+      const size_t   index = __builtin_ctzll(writers);
+      const uint64_t bit   = uint64_t{1} << index;
+      writers &= writers - 1;
+
+      if (acceptedWriters & bit)
+      {
+        snapshot->writers[index]->writeAcceptedMessage(message);
+      }
+      else
+      {
+        snapshot->writers[index]->tryWriteMessage(message);
+      }
+    }
+    return;
+  }
+
+  // For each registered writer
+  for (size_t i = 0; i < snapshot->writerCount; ++i)
+  {
+    // Try to send message to writer
+    snapshot->writers[i]->tryWriteMessage(message);
+  }
+}
+
+void LogManager::enqueueMessage(const LogMessage& message)
+{
+  QueuedMessage queued; // NOLINT: inline content is filled only partially
+
+  char* contentCopy = fillQueuedMessage(&queued, message);
+
+  // Copy content into record or, if it is too long, to heap
+  const size_t inlineLen =
+      QueuedMessage::INLINE_CONTENT_LEN - (contentCopy - queued.inlineContent);
+  if (message.contentLen > inlineLen)
+  {
+    queued.heapContent = new char[message.contentLen];
+    contentCopy        = queued.heapContent;
+  }
+  memcpy(contentCopy, message.content, message.contentLen);
+
+  pushQueuedMessage(queued);
+}
+
+char* LogManager::fillQueuedMessage(QueuedMessage*    queued,
+                                   const LogMessage& message)
+{
+  queued->siteId        = message.siteId;
+  queued->contentLen    = message.contentLen;
+  queued->severity      = message.severity;
+  queued->contentType   = message.contentType;
+  queued->part          = message.part;
+  queued->longMessageId = message.longMessageId;
+  queued->timestamp     = message.timestamp;
+  queued->logger        = message.source.logger;
+  queued->format        = nullptr;
+  queued->heapContent   = nullptr;
+
+  // Site describes source, otherwise it has to be stored in record
+  if (message.siteId != LogSite::ID_NONE)
+  {
+    return queued->inlineContent;
+  }
+
+  memcpy(queued->inlineContent, &message.source, sizeof(message.source));
+  return queued->inlineContent + sizeof(message.source);
+}
+
+LogMessage LogManager::restoreQueuedMessage(const QueuedMessage& queued)
+{
+  LogMessage message = {.severity      = queued.severity,
+                        .source        = {},
+                        .contentType   = queued.contentType,
+                        .content       = queued.inlineContent,
+                        .contentLen    = queued.contentLen,
+                        .timestamp     = queued.timestamp,
+                        .siteId        = queued.siteId,
+                        .part          = queued.part,
+                        .longMessageId = queued.longMessageId};
+
+  // Restore source
+  if (queued.siteId != LogSite::ID_NONE)
+  {
+    const LogSite& site = LogSiteRegistry::getSite(queued.siteId);
+    message.source      = {.file     = site.file,
+                           .function = site.function,
+                           .line     = site.line,
+                           .logger   = queued.logger};
+  }
+  else
+  {
+    memcpy(&message.source, queued.inlineContent, sizeof(message.source));
+    message.content += sizeof(message.source);
+  }
+
+  if (queued.heapContent != nullptr)
+  {
+    message.content = queued.heapContent;
+  }
+
+  return message;
+}
+
+void LogManager::pushQueuedMessage(const QueuedMessage& queued)
+{
+  // `endLogs()` waits for pushing threads once queue is closed
+  s_pushingCount.fetch_add(1);
+  if (s_isQueueClosed.load())
+  {
+    s_pushingCount.fetch_sub(1, std::memory_order_release);
+    delete[] queued.heapContent;
+    return;
+  }
+
+  // Wait for dispatcher to free some space
+  while (!s_asyncQueue->tryPush(queued))
+  {
+    std::this_thread::yield();
+  }
+
+  s_pushingCount.fetch_sub(1, std::memory_order_release);
+}
+
+void LogManager::runDispatcher()
+{
+  constexpr unsigned                  SPIN_ROUNDS_MAX = 64;
+  constexpr std::chrono::microseconds IDLE_SLEEP(100);
+
+  // Leave signal handling to logging threads
+  sigset_t blockedSignals = {};
+  sigfillset(&blockedSignals);
+  pthread_sigmask(SIG_BLOCK, &blockedSignals, NULL);
+
+  utils::TextBuffer renderedContent;
+  unsigned          idleRounds = 0;
+
+  while (true)
+  {
+    // Thread handling terminating signal writes queued messages itself
+    if (s_crashingThread.load(std::memory_order_relaxed) != 0)
+    {
+      if (s_dispatcherStop.load(std::memory_order_acquire))
+      {
+        break;
+      }
+      std::this_thread::sleep_for(IDLE_SLEEP);
+      continue;
+    }
+
+    // Message stays queued until written, so crash handler still sees it
+    const QueuedMessage* head = s_asyncQueue->front();
+    if (head != nullptr)
+    {
+      idleRounds = 0;
+
+      LogMessage message = restoreQueuedMessage(*head);
+
+      // Render content with deferred formatting
+      if (head->format != nullptr)
+      {
+        renderedContent.clear();
+        utils::DeferredArgs::render(renderedContent, head->format,
+                                    head->inlineContent, head->contentLen);
+        message.content    = renderedContent.data();
+        message.contentLen = renderedContent.length() + 1;
+      }
+
+      dispatchMessage(message);
+
+      char* heapContent = head->heapContent;
+      s_asyncQueue->popFront();
+
+      // Crash handler may still read content of message it saw queued
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (s_crashingThread.load(std::memory_order_relaxed) == 0)
+      {
+        delete[] heapContent;
+      }
+      s_dispatchedCount.fetch_add(1, std::memory_order_release);
+      continue;
+    }
+
+    // Exit only when every claimed cell has been written out
+    if (s_dispatcherStop.load(std::memory_order_acquire) &&
+        s_asyncQueue->poppedCount() == s_asyncQueue->pushedCount())
+    {
+      break;
+    }
+
+    // Spin for a while before going to sleep
+    if (idleRounds < SPIN_ROUNDS_MAX)
+    {
+      ++idleRounds;
+      std::this_thread::yield();
+    }
+    else
+    {
+      // Queue may be full, so reports are not pushed to it
+      logSuppressedSummaries(&dispatchMessage);
+
+      std::this_thread::sleep_for(IDLE_SLEEP);
+    }
+  }
+}
+
+void LogManager::logSuppressedSummaries(void (*emit)(const LogMessage&))
+{
+  if (!RateLimiter::takeHasSuppressed())
+  {
+    return;
+  }
+
+  utils::TextBuffer summary;
+  const size_t      siteCount = LogSiteRegistry::siteCount();
+  for (LogSite::Id siteId = 1; siteId <= siteCount; ++siteId)
+  {
+    const uint64_t suppressedCount = RateLimiter::takeSuppressedCount(siteId);
+    if (suppressedCount == 0)
+    {
+      continue;
+    }
+
+    summary.clear();
+    RateLimiter::appendSummary(summary, siteId, suppressedCount);
+
+    const LogSite&   site    = LogSiteRegistry::getSite(siteId);
+    const LogMessage message = {
+        .severity      = site.severity,
+        .source        = {.file     = site.file,
+                          .function = site.function,
+                          .line     = site.line,
+                          .logger   = SUPPRESSED_SUMMARY_LOGGER},
+        .contentType   = LogMessage::ContentType::TEXT,
+        .content       = summary.data(),
+        .contentLen    = summary.length() + 1,
+        .timestamp     = utils::LogClock::now(),
+        .siteId        = siteId,
+        .part          = LogMessage::Part::WHOLE,
+        .longMessageId = 0};
+    emit(message);
+  }
+}
+
+LogManager::MessageHandle
+LogManager::openLongMessage(const LogMessage& messageTemplate)
+{
+  if (s_currentStatus.load(std::memory_order_acquire) != Status::READY)
+  {
+    return MESSAGE_HANDLE_INVALID;
+  }
+
+  LongMessageTable::Slot* slot   = nullptr;
+  const MessageHandle     handle = LongMessageTable::allocate(&slot);
+  if (handle == MESSAGE_HANDLE_INVALID)
+  {
+    return MESSAGE_HANDLE_INVALID;
+  }
+
+  // Copy template content
+  slot->message = messageTemplate;
+  slot->content.append(messageTemplate.content,
+                       strnlen(messageTemplate.content,
+                               messageTemplate.contentLen));
+  slot->message.content       = nullptr;
+  slot->message.contentLen    = 0;
+  slot->message.longMessageId = handle;
+  slot->headerLen             = slot->content.length();
+
+  // Publish slot for signal handler
+  slot->isOpen.store(true, std::memory_order_release);
+
+  return handle;
+}
+
+void LogManager::appendLongMessage(MessageHandle handle, const char* text,
+                                   size_t length)
+{
+  LongMessageTable::Slot* slot = LongMessageTable::find(handle);
+  if (slot == nullptr)
+  {
+    return;
+  }
+
+  lockLongMessage(*slot);
+  appendContent(*slot, text, length);
+  unlockLongMessage(*slot);
+}
+
+void LogManager::vappendLongMessagef(MessageHandle handle, const char* format,
+                                     va_list args)
+{
+  LongMessageTable::Slot* slot = LongMessageTable::find(handle);
+  if (slot == nullptr)
+  {
+    return;
+  }
+
+  lockLongMessage(*slot);
+  slot->content.vappendf(format, args);
+  sendFullParts(*slot);
+  unlockLongMessage(*slot);
+}
+
+void LogManager::closeLongMessage(MessageHandle& handle)
+{
+  LongMessageTable::Slot* slot = LongMessageTable::find(handle);
+  if (slot != nullptr)
+  {
+    lockLongMessage(*slot);
+    finishLongMessage(handle, *slot);
+    unlockLongMessage(*slot);
+  }
+
+  // Invalidate input handle
+  handle = MESSAGE_HANDLE_INVALID;
+}
+
+LogManager::MessageFd LogManager::beginLongMessage(const LogMessage& message)
+{
+  if (s_currentStatus.load(std::memory_order_acquire) != Status::READY)
+  {
+    return STDERR_FILENO;
+  }
+
+  MessageFd pipeFds[2] = {MESSAGE_FD_INVALID, MESSAGE_FD_INVALID};
+
+  // Open pipe for message content
+  int pipeStatus = pipe(pipeFds);
+  if (pipeStatus != 0) // Failed to create pipe
+  {
+    return MESSAGE_FD_INVALID;
+  }
+  MessageFd pipeReadFd  = pipeFds[0];
+  MessageFd pipeWriteFd = pipeFds[1];
+
+  // Make read nonblocking
+  int oldFlags = fcntl(pipeReadFd, F_GETFL);
+  fcntl(pipeReadFd, F_SETFL, oldFlags | O_NONBLOCK);
+
+  // Register long message
+  MessageHandle handle = openLongMessage(message);
+  if (handle == MESSAGE_HANDLE_INVALID)
+  {
+    close(pipeReadFd);
+    close(pipeWriteFd);
+    return MESSAGE_FD_INVALID;
+  }
+
+  LongMessageTable::Slot* slot = LongMessageTable::find(handle);
+  lockLongMessage(*slot);
+  slot->contentReadFd  = pipeReadFd;
+  slot->contentWriteFd = pipeWriteFd;
+  unlockLongMessage(*slot);
+
+  std::lock_guard<std::mutex> lock(s_fdHandleMutex);
+
+  // Read pipe in background. Without drainer, content is read when message
+  // ends, so writes block once pipe is full
+  if (startPipeDrainer())
+  {
+    struct epoll_event pipeEvent = {};
+    pipeEvent.events             = EPOLLIN;
+    pipeEvent.data.u32           = handle;
+    epoll_ctl(s_pipeEpollFd, EPOLL_CTL_ADD, pipeReadFd, &pipeEvent);
+  }
+
+  // Remember handle of descriptor
+  if ((size_t)pipeWriteFd >= s_fdHandleCapacity)
+  {
+    size_t newCapacity = s_fdHandleCapacity > 0 ? s_fdHandleCapacity : 64;
+    while (newCapacity <= (size_t)pipeWriteFd)
+    {
+      newCapacity *= 2;
+    }
+
+    MessageHandle* newHandles = new MessageHandle[newCapacity]();
+    for (size_t i = 0; i < s_fdHandleCapacity; ++i)
+    {
+      newHandles[i] = s_fdHandles[i];
+    }
+    delete[] s_fdHandles;
+    s_fdHandles        = newHandles;
+    s_fdHandleCapacity = newCapacity;
+  }
+  s_fdHandles[pipeWriteFd] = handle;
+
+  // Return opened pipe write file descriptor
+  return pipeWriteFd;
+}
+
+void LogManager::endLongMessage(LogManager::MessageFd& fd)
+{
+  if (s_currentStatus.load(std::memory_order_acquire) != Status::READY)
+  {
+    return;
+  }
+
+  // Check input fd
+  assert(fd != MESSAGE_FD_INVALID && "Attempted access with invalid fd");
+
+  // Find message associated with file descriptor
+  MessageHandle handle = MESSAGE_HANDLE_INVALID;
+  {
+    std::lock_guard<std::mutex> lock(s_fdHandleMutex);
+    if ((size_t)fd < s_fdHandleCapacity)
+    {
+      handle          = s_fdHandles[fd];
+      s_fdHandles[fd] = MESSAGE_HANDLE_INVALID;
+    }
+  }
+
+  // Check that message is found
+  assert(handle != MESSAGE_HANDLE_INVALID &&
+         "Unknown fd used to access message");
 
-  // Delete content
-  delete[] messageContent;
+  closeLongMessage(handle);
 
   // Invalidate input descriptor
   fd = MESSAGE_FD_INVALID;
@@ -12,12 +12,24 @@
 #ifndef __MEERKAT_LOGS_LOGMANAGER_H
 #define __MEERKAT_LOGS_LOGMANAGER_H
 
+#include <atomic>
 #include <csignal>
+#include <cstddef>
+#include <cstdarg>
+#include <cstdint>
+#include <mutex>
 #include <signal.h>
+#include <sys/types.h>
+#include <thread>
 
 #include "mklog/LogMessage.h"
+#include "mklog/LogSite.h"
 #include "mklog/LogWriter.h"
+#include "mklog/LongMessageTable.h"
+#include "mklog/RouteCompiler.h"
+#include "mklog/utils/MpscRingBuffer.h"
 #include "mklog/utils/SimpleList.h"
+#include "mklog/utils/TextBuffer.h"
 
 namespace mklog
 {
@@ -35,29 +47,291 @@ public:
   using MessageFd = int;
 
   /**
-   * @brief Maximum number of characters to append to long message content
+   * @brief Maximum length of single part of long message. Long message
+   * content is not limited, it is delivered to writers in parts as it is
+   * appended
    */
-  static constexpr size_t LONG_MESSAGE_LEN_MAX = 4096;
+  static constexpr size_t LONG_MESSAGE_PART_LEN = 16384;
 
   static constexpr MessageFd MESSAGE_FD_INVALID = -1;
 
+  /**
+   * @brief Handle of long message built in memory
+   */
+  using MessageHandle = LongMessageTable::Handle;
+
+  static constexpr MessageHandle MESSAGE_HANDLE_INVALID =
+      LongMessageTable::HANDLE_INVALID;
+
+  /**
+   * @brief Default number of messages in asynchronous dispatch queue
+   */
+  static constexpr size_t ASYNC_QUEUE_CAPACITY_DEFAULT = 8192;
+
+  /**
+   * @brief Size of single record in asynchronous dispatch queue
+   */
+  static constexpr size_t ASYNC_RECORD_SIZE = 256;
+
+  /**
+   * @brief Size of message description stored in asynchronous queue record
+   */
+  static constexpr size_t ASYNC_RECORD_HEADER_SIZE = 48;
+
+  /**
+   * @brief Maximum length of encoded arguments for message with deferred
+   * formatting
+   */
+  static constexpr size_t DEFERRED_ARGS_LEN_MAX =
+      ASYNC_RECORD_SIZE - ASYNC_RECORD_HEADER_SIZE;
+
 private:
   /**
-   * @brief List of all registered LogWriters
+   * @brief List of all registered LogWriters. Guarded by `s_configMutex`,
+   * logging threads use `s_writerSnapshot` instead
    */
   static utils::SimpleList<LogWriter*> s_writerList;
 
   /**
-   * @brief Description of started long message
+   * @brief Serializes changes of writer set and writer configuration
+   */
+  static std::mutex s_configMutex;
+
+  /**
+   * @brief Handles of long messages created by `beginLongMessage()`,
+   * indexed by pipe write descriptor. Guarded by `s_fdHandleMutex`
    */
-  struct LongMessageInfo
+  static MessageHandle* s_fdHandles;
+  static size_t         s_fdHandleCapacity;
+  static std::mutex     s_fdHandleMutex;
+
+  /**
+   * @brief Thread reading long message pipes as soon as content is written
+   * to them, so that writing to pipe does not block. Started by first call
+   * to `beginLongMessage()`. Pipes are watched with epoll instance
+   * `s_pipeEpollFd`, `s_pipeWakeFd` wakes thread up to stop it.
+   */
+  static std::thread s_pipeDrainerThread;
+  static int         s_pipeEpollFd;
+  static int         s_pipeWakeFd;
+
+  /**
+   * @brief Fixed-size message record stored in asynchronous dispatch queue.
+   * Message source is referenced by site id. Messages without site store
+   * their `LogMessage::Source` at the start of `inlineContent`.
+   *
+   * Content which does not fit into `inlineContent` is copied to heap. If
+   * `format` is set, `inlineContent` holds encoded format arguments instead
+   * of content.
+   */
+  struct QueuedMessage
   {
-    LogMessage message;
-    MessageFd  contentWriteFd;
-    MessageFd  contentReadFd;
+    static constexpr size_t INLINE_CONTENT_LEN = DEFERRED_ARGS_LEN_MAX;
+
+    LogSite::Id             siteId;
+    uint32_t                contentLen;
+    LogMessage::Severity    severity    : 8;
+    LogMessage::ContentType contentType : 8;
+    LogMessage::Part        part        : 8;
+    uint32_t                longMessageId;
+    uint64_t                timestamp;
+    const char*             logger;
+    const char*             format;
+    char*                   heapContent;
+    char                    inlineContent[INLINE_CONTENT_LEN];
   };
 
-  static utils::SimpleList<LongMessageInfo> s_longMsgList;
+  static_assert(sizeof(QueuedMessage) == ASYNC_RECORD_SIZE &&
+                    offsetof(QueuedMessage, inlineContent) ==
+                        ASYNC_RECORD_HEADER_SIZE,
+                "Unexpected queued message padding");
+
+  /**
+   * @brief Capacity of asynchronous dispatch queue. Zero if messages are
+   * dispatched synchronously
+   */
+  static size_t s_asyncQueueCapacity;
+
+  /**
+   * @brief Queue of messages waiting to be dispatched by dispatcher thread
+   */
+  static utils::MpscRingBuffer<QueuedMessage>* s_asyncQueue;
+
+  /**
+   * @brief Thread draining `s_asyncQueue` into registered writers
+   */
+  static std::thread s_dispatcherThread;
+
+  /**
+   * @brief Request for dispatcher thread to drain queue and exit
+   */
+  static std::atomic<bool> s_dispatcherStop;
+
+  /**
+   * @brief Number of queued messages written by dispatcher thread
+   */
+  static std::atomic<size_t> s_dispatchedCount;
+
+  /**
+   * @brief Queue accepts no more messages and is deleted once threads
+   * pushing to it finish
+   */
+  static std::atomic<bool> s_isQueueClosed;
+
+  /**
+   * @brief Number of threads pushing message to `s_asyncQueue`
+   */
+  static std::atomic<size_t> s_pushingCount;
+
+  /**
+   * @brief Id of thread handling terminating signal, zero if there was none.
+   * Only the first such thread writes messages, dispatcher stops once it is
+   * set
+   */
+  static std::atomic<pid_t> s_crashingThread;
+
+  /**
+   * @brief Logger name of reports issued by `logSuppressedSummaries()`.
+   * Loggers which issued dropped messages may no longer exist
+   */
+  static constexpr const char* SUPPRESSED_SUMMARY_LOGGER = "mklog";
+
+  /**
+   * @brief Leave message formatting to dispatcher thread
+   */
+  static bool s_deferFormatting;
+
+  /**
+   * @brief Set of (severity, content type) pairs accepted by at least one
+   * writer. Empty unless LogManager is ready.
+   */
+  static std::atomic<RouteCompiler::AttributeSet> s_acceptMask;
+
+  /**
+   * @brief Maximum number of writers for which routing decisions are cached
+   */
+  static constexpr size_t ROUTE_CACHE_WRITERS_MAX = 64;
+
+  /**
+   * @brief Writers interested in messages with some severity and content
+   * type
+   */
+  struct RouteTableEntry
+  {
+    uint64_t acceptedWriters; /// Writers accepting all such messages
+    uint64_t matchedWriters;  /// Writers which must check each message
+  };
+
+  /**
+   * @brief Immutable set of registered writers with routing decisions
+   * derived from their configuration. Replaced as a whole on every
+   * configuration change, old snapshots are reclaimed by
+   * `utils::EpochReclaimer`
+   */
+  struct WriterSnapshot
+  {
+    /// Registered writers. Routing masks refer to writers by index
+    LogWriter** writers;
+    size_t      writerCount;
+
+    /// Epoch of routing decisions cached in log sites
+    uint32_t configEpoch;
+
+    /// Routing decisions indexed by `RouteCompiler::getAttributeIndex()`.
+    /// Valid only if `writerCount <= ROUTE_CACHE_WRITERS_MAX`
+    RouteTableEntry routeTable[RouteCompiler::ATTRIBUTE_COUNT];
+
+    WriterSnapshot() : writers(nullptr), writerCount(0), configEpoch(0) {}
+
+    // No copying
+    WriterSnapshot(const WriterSnapshot&)            = delete;
+    WriterSnapshot& operator=(const WriterSnapshot&) = delete;
+
+    ~WriterSnapshot() { delete[] writers; }
+  };
+
+  /**
+   * @brief Current writer set. Must be loaded inside
+   * `utils::EpochReclaimer::ReadGuard`. Null until logs are started
+   */
+  static std::atomic<const WriterSnapshot*> s_writerSnapshot;
+
+  /**
+   * @brief Configuration epoch. Incremented every time set of writers or
+   * their routes change. Invalidates routing decisions cached in log sites.
+   * Guarded by `s_configMutex`
+   */
+  static uint32_t s_configEpoch;
+
+  /**
+   * @brief Build snapshot of `s_writerList`, publish it and update
+   * `s_acceptMask`. `s_configMutex` must be held
+   */
+  static void publishSnapshot();
+
+  /**
+   * @brief Compute routing decisions for snapshot writers
+   *
+   * @param[inout] snapshot   Snapshot with filled writer list
+   *
+   * @return Set of message attributes accepted by at least one writer
+   */
+  static RouteCompiler::AttributeSet
+  buildRouteTable(WriterSnapshot* snapshot);
+
+  /**
+   * @brief Replace registered writer or remove it if `newWriter` is null.
+   * Old writer is deleted once no thread is writing to it
+   */
+  static void exchangeWriter(LogWriter* oldWriter, LogWriter* newWriter);
+
+  /**
+   * @brief Add writer to registered writers
+   */
+  static void registerWriter(LogWriter* writer);
+
+  /**
+   * @brief Wait until dispatcher thread writes all messages queued before
+   * this call
+   */
+  static void waitDispatched();
+
+  /**
+   * @brief Update all state derived from writer configuration
+   */
+  static void onConfigChanged();
+
+  /**
+   * @brief Get writers accepting messages from log site. Routing decision is
+   * cached in site state until configuration changes.
+   *
+   * @param[in]  snapshot         Current writer set
+   * @param[in]  siteId           Log site id
+   * @param[in]  contentType      Message content type
+   * @param[out] acceptedWriters  Writers accepting every such message
+   * @param[out] matchedWriters   Writers which must check each message
+   */
+  static void getSiteRoutes(const WriterSnapshot& snapshot,
+                            LogSite::Id siteId,
+                            LogMessage::ContentType contentType,
+                            uint64_t* acceptedWriters,
+                            uint64_t* matchedWriters);
+
+  /**
+   * @brief Get writers accepting message. Snapshot must have at most
+   * `ROUTE_CACHE_WRITERS_MAX` writers
+   *
+   * @param[in]  snapshot         Current writer set
+   * @param[in]  message          Log message
+   * @param[out] acceptedWriters  Writers accepting message
+   * @param[out] matchedWriters   Writers which must check message content
+   */
+  static void getMessageRoutes(const WriterSnapshot& snapshot,
+                               const LogMessage&     message,
+                               uint64_t*             acceptedWriters,
+                               uint64_t*             matchedWriters);
+
+  friend class LogWriter;
 
   /**
    * @brief State of LogManager
@@ -72,7 +346,7 @@ private:
   /**
    * @brief Current state of LogManager
    */
-  static Status s_currentStatus;
+  static std::atomic<Status> s_currentStatus;
 
   /**
    * @brief Signal handled by log manager
@@ -89,11 +363,41 @@ private:
   static utils::SimpleList<HandledSignal> s_handledSignals;
 
   /**
-   * @brief All signals LogManager should handle
+   * @brief All signals LogManager should handle. `SIGKILL` cannot be
+   * caught; messages written before it are kept by `MappedRingLogWriter`
+   */
+  static constexpr int SIGNALS_TO_HANDLE[] = {SIGFPE,  SIGILL,  SIGSEGV,
+                                              SIGBUS,  SIGABRT, SIGSYS,
+                                              SIGTERM, SIGINT,  SIGQUIT,
+                                              SIGHUP};
+
+  /**
+   * @brief Signals after which process cannot continue. Their handler runs
+   * on alternate stack and uses only async-signal-safe functions, since
+   * interrupted thread may hold any lock, including allocator ones
+   */
+  static constexpr int CRASH_SIGNALS[] = {SIGFPE, SIGILL,  SIGSEGV,
+                                          SIGBUS, SIGABRT, SIGSYS};
+
+  /**
+   * @brief Size of each preallocated buffer used by crash handler
    */
-  static constexpr int SIGNALS_TO_HANDLE[] = {SIGFPE,  SIGILL,  SIGSEGV, SIGBUS,
-                                              SIGABRT, SIGSYS,  SIGTERM, SIGINT,
-                                              SIGQUIT, SIGKILL, SIGHUP};
+  static constexpr size_t CRASH_BUFFER_SIZE = 64 * 1024;
+
+  /**
+   * @brief Size of alternate signal stack, on which crash handler runs
+   * after stack overflow
+   */
+  static constexpr size_t CRASH_STACK_SIZE = 64 * 1024;
+
+  /// Buffer for records rendered by writers in crash handler
+  static char s_crashRecordBuffer[CRASH_BUFFER_SIZE];
+
+  /// Buffer for message content rendered or read in crash handler
+  static char s_crashContentBuffer[CRASH_BUFFER_SIZE];
+
+  /// Alternate signal stack of thread which started logs
+  static char s_crashStack[CRASH_STACK_SIZE];
 
   /**
    * @brief Handler registered for all `SIGNALS_TO_HANDLE`
@@ -101,19 +405,241 @@ private:
   static void handleSignal(int signumber);
 
   /**
-   * @brief Read all long message content and save it
+   * @brief Check if handler replaced by LogManager is the default one, so
+   * that passing signal to it terminates process
+   */
+  static bool isTerminatingSignal(int signumber);
+
+  /**
+   * @brief Handler registered for `CRASH_SIGNALS`
+   */
+  static void handleCrashSignal(int signumber);
+
+  /**
+   * @brief Restore handler which was replaced by LogManager and pass
+   * signal to it
+   */
+  static void raiseWithPrevHandler(int signumber);
+
+  /**
+   * @brief Write buffered, queued and open long messages to writers without
+   * locking or allocating memory
+   */
+  static void flushOnCrash();
+
+  /**
+   * @brief Write message to all writers accepting it from crash handler
+   */
+  static void writeCrashMessage(const WriterSnapshot& snapshot,
+                                const LogMessage&     message);
+
+  /**
+   * @brief Write content of open long message from crash handler. Content
+   * is sent as the last part of message
+   */
+  static void writeCrashLongMessage(const WriterSnapshot&   snapshot,
+                                    LongMessageTable::Slot& slot);
+
+  /**
+   * @brief Result of moving long message pipe content to writers
+   */
+  enum class SpliceStatus
+  {
+    SPLICED,     /// Content was moved to writers without copying
+    DEFERRED,    /// Content was left in pipe until more of it is written
+    UNSUPPORTED, /// Content must be read to memory
+  };
+
+  /**
+   * @brief Send content waiting in long message pipe as next part of
+   * message, moving it to writers with `splice()`. Writers which cannot
+   * splice content get it copied to memory. Possible only with synchronous
+   * dispatch and at least one writer which can splice content
+   *
+   * @param[inout] slot       Long message with pipe. Must be locked
+   * @param[in]    canDefer   Whether content shorter than
+   *                          `LONG_MESSAGE_PART_LEN` may be left in pipe
+   *
+   * @return Splicing result
+   */
+  static SpliceStatus splicePipeContent(LongMessageTable::Slot& slot,
+                                        bool                    canDefer);
+
+  /**
+   * @brief Move everything written to long message pipe to message content
+   * or directly to writers
+   *
+   * @param[inout] slot       Long message with pipe. Must be locked
+   * @param[in]    canDefer   Whether content to be spliced may be left in
+   *                          pipe until more of it is written
+   *
+   * @return `false` if content was left in pipe, `true` otherwise
+   */
+  static bool appendPipeContent(LongMessageTable::Slot& slot,
+                                bool                    canDefer = false);
+
+  /**
+   * @brief Append text to long message, sending every part filled on the
+   * way
+   *
+   * @param[inout] slot     Long message. Must be locked
+   * @param[in]    text     Text to be appended
+   * @param[in]    length   Text length
+   */
+  static void appendContent(LongMessageTable::Slot& slot, const char* text,
+                            size_t length);
+
+  /**
+   * @brief Send parts of long message while it has at least
+   * `LONG_MESSAGE_PART_LEN` pending characters. Parts are cut after the last
+   * full line if possible
+   *
+   * @param[inout] slot   Long message. Must be locked
+   */
+  static void sendFullParts(LongMessageTable::Slot& slot);
+
+  /**
+   * @brief Send all pending content of long message as its next part
+   *
+   * @param[inout] slot     Long message. Must be locked
+   * @param[in]    isLast   Whether message ends with this part
+   *
+   * @return `true` if part was sent, `false` if there was nothing to send
+   */
+  static bool sendPendingContent(LongMessageTable::Slot& slot, bool isLast);
+
+  /**
+   * @brief Send start of pending content of long message as its next part
    *
-   * @param[inout] messageInfo	Long message to read content of
+   * @param[inout] slot     Long message. Must be locked
+   * @param[in]    length   Number of pending characters to send
+   * @param[in]    isLast   Whether message ends with this part
+   */
+  static void sendLongMessagePart(LongMessageTable::Slot& slot, size_t length,
+                                  bool isLast);
+
+  /**
+   * @brief Start pipe drainer thread if it is not running.
+   * `s_fdHandleMutex` must be held
    *
-   * @return Length of appended content
+   * @return `true` if thread is running, `false` otherwise
    */
-  static size_t appendPipeContent(LongMessageInfo* messageInfo);
+  static bool startPipeDrainer();
+
+  /**
+   * @brief Stop pipe drainer thread if it is running
+   */
+  static void stopPipeDrainer();
+
+  /**
+   * @brief Pipe drainer thread routine. Append pipe content to long messages
+   * until woken up through `s_pipeWakeFd`
+   */
+  static void runPipeDrainer();
+
+  /**
+   * @brief Move pipe content of long message. Deferred pipe is watched for
+   * every write, so that it is spliced as soon as enough content arrives.
+   * Called by pipe drainer thread
+   *
+   * @param[in] handle    Long message handle
+   * @param[in] canDefer  Whether content may be left in pipe
+   *
+   * @return `true` if pipe has just been deferred, `false` otherwise
+   */
+  static bool drainPipe(MessageHandle handle, bool canDefer);
+
+  /**
+   * @brief Send long message, close its pipe and free its slot
+   *
+   * @param[in] handle  Long message handle
+   * @param[in] slot    Long message slot. Must be locked
+   */
+  static void finishLongMessage(MessageHandle handle,
+                                LongMessageTable::Slot& slot);
+
+  /**
+   * @brief Get exclusive access to long message. Wait if it is used by
+   * other thread
+   */
+  static void lockLongMessage(LongMessageTable::Slot& slot)
+  {
+    while (slot.isBusy.exchange(true, std::memory_order_acquire))
+    {
+      std::this_thread::yield();
+    }
+  }
+
+  static void unlockLongMessage(LongMessageTable::Slot& slot)
+  {
+    slot.isBusy.store(false, std::memory_order_release);
+  }
 
   /**
    * @brief End all logging. Invalidate LogManager
    */
   static void endLogs();
 
+  /**
+   * @brief Send log message to all registered writers on the calling thread
+   *
+   * @param[in] message	  Log message to be sent
+   */
+  static void dispatchMessage(const LogMessage& message);
+
+  /**
+   * @brief Report messages dropped by `RateLimiter` at sites which have not
+   * written a message since. Called periodically by dispatcher thread and
+   * once by `endLogs()`
+   *
+   * @param[in] emit  Function sending report messages, `dispatchMessage()`
+   *                  on dispatcher thread, `logMessage()` otherwise
+   */
+  static void logSuppressedSummaries(void (*emit)(const LogMessage&));
+
+  /**
+   * @brief Copy log message to asynchronous dispatch queue. Wait for free
+   * space if queue is full. Message is dropped if queue is closed
+   *
+   * @param[in] message	  Log message to be queued
+   */
+  static void enqueueMessage(const LogMessage& message);
+
+  /**
+   * @brief Fill queue record fields describing message
+   *
+   * @param[out] queued   Queue record
+   * @param[in]  message  Log message
+   *
+   * @return Start of free space in `queued.inlineContent`
+   */
+  static char* fillQueuedMessage(QueuedMessage* queued,
+                                 const LogMessage& message);
+
+  /**
+   * @brief Restore log message from queue record
+   *
+   * @param[in] queued  Queue record
+   *
+   * @return Log message with content stored in record
+   */
+  static LogMessage restoreQueuedMessage(const QueuedMessage& queued);
+
+  /**
+   * @brief Append record to asynchronous dispatch queue. Wait for free space
+   * if queue is full. Record is dropped and its heap content is freed if
+   * queue is closed
+   *
+   * @param[in] queued    Record to be appended
+   */
+  static void pushQueuedMessage(const QueuedMessage& queued);
+
+  /**
+   * @brief Dispatcher thread routine. Drain queue until stop is requested
+   * and no messages are left
+   */
+  static void runDispatcher();
+
 public:
   // Forbid construction of static class
   LogManager() = delete;
@@ -129,38 +655,173 @@ public:
   static TWriter& addWriter(TArgs... args)
   {
     TWriter* writer = new TWriter(args...);
-    s_writerList.pushFront(writer);
+    registerWriter(writer);
     return *writer;
   }
 
+  /**
+   * @brief Unregister LogWriter and delete it. Messages logged before this
+   * call are written to it, then writer is deleted as soon as no thread is
+   * writing to it. May be called while other threads are logging
+   *
+   * @param[in] writer  Registered writer
+   */
+  static void removeWriter(LogWriter& writer)
+  {
+    exchangeWriter(&writer, nullptr);
+  }
+
+  /**
+   * @brief Atomically replace registered LogWriter with another one. Old
+   * writer is deleted as soon as no thread is writing to it. May be called
+   * while other threads are logging, unlike writer reconfiguration
+   *
+   * @tparam TWriter  LogWriter implementation
+   *
+   * @param[in] oldWriter   Registered writer
+   * @param[in] newWriter   Writer allocated with `new`. LogManager takes
+   *                        ownership of it
+   */
+  template <typename TWriter>
+  static TWriter& replaceWriter(LogWriter& oldWriter, TWriter* newWriter)
+  {
+    exchangeWriter(&oldWriter, newWriter);
+    return *newWriter;
+  }
+
+  /**
+   * @brief Dispatch messages to writers from a dedicated background thread.
+   * Logging calls only copy message into bounded lock-free queue. Must be
+   * called before `initLogs()`.
+   *
+   * @param[in] queueCapacity   Maximum number of queued messages. Must be a
+   *                            power of two
+   */
+  static void useAsyncDispatch(size_t queueCapacity =
+                                   ASYNC_QUEUE_CAPACITY_DEFAULT);
+
+  /**
+   * @brief Capture format arguments in binary form and render message
+   * content on dispatcher thread. Requires asynchronous dispatch. Must be
+   * called before `initLogs()`.
+   */
+  static void useDeferredFormatting();
+
+  /**
+   * @brief Check if messages should be passed with unformatted arguments
+   */
+  static bool isFormattingDeferred()
+  {
+    return s_deferFormatting && s_asyncQueue != nullptr;
+  }
+
+  /**
+   * @brief Check if any writer may accept message with given severity and
+   * content type. Costs a single relaxed load, used by LOG_* macros to skip
+   * messages before their arguments are evaluated.
+   *
+   * @param[in] severity      Message severity
+   * @param[in] contentType   Message content type
+   *
+   * @return `false` if message would not be written, `true` otherwise
+   */
+  static bool isMessageAccepted(LogMessage::Severity    severity,
+                                LogMessage::ContentType contentType)
+  {
+    return (s_acceptMask.load(std::memory_order_relaxed) &
+            RouteCompiler::getAttributeBit(severity, contentType)) != 0;
+  }
+
   /**
    * @brief Initialize logging for program
    */
   static void initLogs();
 
   /**
-   * @brief Send log message to all registered writers
+   * @brief Send log message to all registered writers. In asynchronous mode
+   * message is queued and written later by dispatcher thread.
    *
    * @param[in] message	  Log message to be sent
    */
   static void logMessage(const LogMessage& message);
 
+  /**
+   * @brief Send log message with deferred formatting. Content is rendered by
+   * dispatcher thread right before it is written.
+   *
+   * @param[in] messageTemplate   Log message without content. Must have
+   *                              valid `siteId`
+   * @param[in] format            Printf format string. Must outlive message
+   * @param[in] encodedArgs       Arguments encoded by `utils::DeferredArgs`
+   * @param[in] encodedArgsLen    Length of encoded arguments. Must not exceed
+   *                              `LogManager::DEFERRED_ARGS_LEN_MAX`
+   */
+  static void logDeferredMessage(const LogMessage& messageTemplate,
+                                 const char*       format,
+                                 const char*       encodedArgs,
+                                 size_t            encodedArgsLen);
+
+  /**
+   * @brief Wait until all messages queued before this call are written and
+   * flush buffered output of all writers
+   */
+  static void flushMessages();
+
+  /**
+   * @brief Start long message built in memory. Content appended to returned
+   * handle is added to `messageTemplate.content`. If nothing is appended,
+   * no message will be written. Content may be appended only by one thread
+   * at a time. Content of any length is sent to writers in parts of
+   * `LONG_MESSAGE_PART_LEN` characters.
+   *
+   * @param[in] messageTemplate   Template for long message
+   *
+   * @return Long message handle. `LogManager::MESSAGE_HANDLE_INVALID` if
+   *         logs are not started or too many long messages are open
+   */
+  static MessageHandle openLongMessage(const LogMessage& messageTemplate);
+
+  /**
+   * @brief Append text to long message
+   *
+   * @param[in] handle  Long message handle
+   * @param[in] text    Text to be appended
+   * @param[in] length  Text length
+   */
+  static void appendLongMessage(MessageHandle handle, const char* text,
+                                size_t length);
+
+  /**
+   * @brief Append printf-formatted text to long message
+   *
+   * @param[in] handle  Long message handle
+   * @param[in] format  Printf format string
+   * @param[in] args    Printf format arguments
+   */
+  static void vappendLongMessagef(MessageHandle handle, const char* format,
+                                  va_list args)
+      __attribute__((__format__(__printf__, 2, 0)));
+
+  /**
+   * @brief End long message. If any content has been appended, the message
+   * is guaranteed to be printed after call to this function.
+   *
+   * @param[inout] handle   Long message handle. Invalidated after call
+   */
+  static void closeLongMessage(MessageHandle& handle);
+
   /**
    * @brief Create file descriptor for new long message. Anything written
    * to returned `MessageFd` will be appended to `messageTemplate.content`.
    * If nothing is written to returned `MessageFd`, no message will be
    * written. Message is not guaranteed to be printed all at once, it may be
-   * split into several messages. Total length of appended content for long
-   * message may not exceed `LogManager::LONG_MESSAGE_LEN_MAX`.
+   * split into several parts.
    *
    * @param[in] messageTemplate	  Template for long message
    *
    * @return Upon success, return file descriptor for message content
    *         If error occured while creating long message, return
    *         `LogManager::MESSAGE_FD_INVALID`
-   *
-   * @warning  Any attempt to write more than `LogManager::LONG_MESSAGE_LEN_MAX`
-   * to returned `MessageFd` results in undefined behaviour.
    */
   static MessageFd beginLongMessage(const LogMessage& messageTemplate);
 
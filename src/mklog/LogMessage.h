@@ -13,6 +13,7 @@
 #define __MEERKAT_LOGS_LOGMESSAGE_H
 
 #include <cstddef>
+#include <cstdint>
 #include <ctime>
 
 namespace mklog
@@ -47,6 +48,20 @@ struct LogMessage
     TEXT,
     CODE,
     IMAGE,
+
+    MIN_TYPE = TEXT,
+    MAX_TYPE = IMAGE,
+  };
+
+  /**
+   * @brief Position of message in long message delivered in several parts
+   */
+  enum class Part
+  {
+    WHOLE,    /// Complete message
+    BEGIN,    /// First part of long message
+    CONTINUE, /// Part following `BEGIN` or other `CONTINUE`
+    END,      /// Last part of long message
   };
 
   /**
@@ -66,12 +81,24 @@ struct LogMessage
 
   const char* content;
   size_t      contentLen;
-  time_t      timestamp;
+
+  /// Raw `utils::LogClock` ticks, converted to wall-clock time on render
+  uint64_t timestamp;
+
+  /// Id of LogSite which issued message, `LogSite::ID_NONE` if unknown
+  uint32_t siteId;
+
+  /// Position in long message, `Part::WHOLE` for ordinary messages
+  Part part;
+
+  /// Id shared by all parts of one long message, 0 for whole messages
+  uint32_t longMessageId;
 };
 
 using MessageContentType = LogMessage::ContentType;
 using MessageSeverity    = LogMessage::Severity;
 using MessageSource      = LogMessage::Source;
+using MessagePart        = LogMessage::Part;
 
 } // namespace mklog
 
@@ -12,8 +12,12 @@
 #ifndef __MEERKAT_LOGS_LOGROUTE_H
 #define __MEERKAT_LOGS_LOGROUTE_H
 
+#include <atomic>
+#include <cstddef>
+
 #include "mklog/LogMessage.h"
 #include "mklog/LogRoutingRule.h"
+#include "mklog/RouteCompiler.h"
 
 namespace mklog
 {
@@ -29,9 +33,9 @@ private: // TODO: Maybe write public before private
   LogRoutingRule* routingRule;
 
   /// Number of LogRoutes referencing routingRule
-  size_t* refCount;
+  std::atomic<size_t>* refCount;
 
-  LogRoute(LogRoutingRule* routingRule, size_t* refCount)
+  LogRoute(LogRoutingRule* routingRule, std::atomic<size_t>* refCount)
       : routingRule(routingRule), refCount(refCount) // refCount(new size_t{1})
   {
   }
@@ -49,13 +53,13 @@ public:
   template <typename TRule, typename... TArgs>
   static LogRoute makeRoute(TArgs... args)
   {
-    return LogRoute(new TRule(args...), new size_t{1});
+    return LogRoute(new TRule(args...), new std::atomic<size_t>(1));
   }
 
   LogRoute(const LogRoute& other)
       : routingRule(other.routingRule), refCount(other.refCount)
   {
-    *refCount += 1;
+    refCount->fetch_add(1, std::memory_order_relaxed);
   }
 
   LogRoute& operator=(const LogRoute& other)
@@ -67,7 +71,7 @@ public:
 
     routingRule = other.routingRule;
     refCount    = other.refCount;
-    *refCount += 1;
+    refCount->fetch_add(1, std::memory_order_relaxed);
 
     return *this;
   }
@@ -84,10 +88,52 @@ public:
     return routingRule->matchMessage(message);
   }
 
+  /**
+   * @brief Check if messages with given severity and content type match
+   * routing rule of this route
+   *
+   * @param[in] severity      Message severity
+   * @param[in] contentType   Message content type
+   *
+   * @return Whether such messages match routing rule
+   */
+  RuleMatch matchAttributes(LogMessage::Severity    severity,
+                            LogMessage::ContentType contentType) const
+  {
+    return routingRule->matchAttributes(severity, contentType);
+  }
+
+  /**
+   * @brief Check if messages issued from log site match routing rule of this
+   * route
+   *
+   * @param[in] site          Log site
+   * @param[in] contentType   Message content type
+   *
+   * @return Whether messages from this site match routing rule
+   */
+  RuleMatch matchSite(const LogSite&          site,
+                      LogMessage::ContentType contentType) const
+  {
+    return routingRule->matchSite(site, contentType);
+  }
+
+  /**
+   * @brief Add routing rule of this route to route program. Routes sharing
+   * routing rule are compiled only once.
+   *
+   * @param[inout] compiler  Compiler building route program
+   *
+   * @return Node evaluating routing rule
+   */
+  RouteNodeId compile(RouteCompiler& compiler) const
+  {
+    return compiler.compileRule(*routingRule);
+  }
+
   ~LogRoute()
   {
-    *refCount -= 1;
-    if (*refCount == 0)
+    if (refCount->fetch_sub(1, std::memory_order_acq_rel) == 1)
     {
       delete routingRule;
       delete refCount;
@@ -115,6 +161,28 @@ public:
     return firstRoute.matchMessage(message) &&
            secondRoute.matchMessage(message);
   }
+
+  virtual RuleMatch
+  matchAttributes(LogMessage::Severity    severity,
+                  LogMessage::ContentType contentType) const override
+  {
+    return matchBoth(firstRoute.matchAttributes(severity, contentType),
+                     secondRoute.matchAttributes(severity, contentType));
+  }
+
+  virtual RuleMatch
+  matchSite(const LogSite&          site,
+            LogMessage::ContentType contentType) const override
+  {
+    return matchBoth(firstRoute.matchSite(site, contentType),
+                     secondRoute.matchSite(site, contentType));
+  }
+
+  virtual RouteNodeId compile(RouteCompiler& compiler) const override
+  {
+    return compiler.addAnd(firstRoute.compile(compiler),
+                           secondRoute.compile(compiler));
+  }
 };
 
 /**
@@ -137,6 +205,28 @@ public:
     return firstRoute.matchMessage(message) ||
            secondRoute.matchMessage(message);
   }
+
+  virtual RuleMatch
+  matchAttributes(LogMessage::Severity    severity,
+                  LogMessage::ContentType contentType) const override
+  {
+    return matchEither(firstRoute.matchAttributes(severity, contentType),
+                       secondRoute.matchAttributes(severity, contentType));
+  }
+
+  virtual RuleMatch
+  matchSite(const LogSite&          site,
+            LogMessage::ContentType contentType) const override
+  {
+    return matchEither(firstRoute.matchSite(site, contentType),
+                       secondRoute.matchSite(site, contentType));
+  }
+
+  virtual RouteNodeId compile(RouteCompiler& compiler) const override
+  {
+    return compiler.addOr(firstRoute.compile(compiler),
+                          secondRoute.compile(compiler));
+  }
 };
 
 /**
@@ -154,6 +244,25 @@ public:
   {
     return !route.matchMessage(message);
   }
+
+  virtual RuleMatch
+  matchAttributes(LogMessage::Severity    severity,
+                  LogMessage::ContentType contentType) const override
+  {
+    return invertMatch(route.matchAttributes(severity, contentType));
+  }
+
+  virtual RuleMatch
+  matchSite(const LogSite&          site,
+            LogMessage::ContentType contentType) const override
+  {
+    return invertMatch(route.matchSite(site, contentType));
+  }
+
+  virtual RouteNodeId compile(RouteCompiler& compiler) const override
+  {
+    return compiler.addNot(route.compile(compiler));
+  }
 };
 
 inline LogRoute operator&&(const LogRoute& first, const LogRoute& second)
@@ -0,0 +1,47 @@
+#include "mklog/LogRoutingRule.h"
+
+#include "mklog/RouteCompiler.h"
+
+namespace mklog
+{
+
+using Severity     = LogMessage::Severity;
+using ContentType  = LogMessage::ContentType;
+using AttributeSet = RouteCompiler::AttributeSet;
+
+RouteNodeId LogRoutingRule::compile(RouteCompiler& compiler) const
+{
+  return compiler.addRule(*this);
+}
+
+RouteNodeId SeverityRoutingRule::compile(RouteCompiler& compiler) const
+{
+  AttributeSet attributes = RouteCompiler::ATTRIBUTES_NONE;
+  for (size_t sev = (size_t)minSeverity; sev < RouteCompiler::SEVERITY_COUNT;
+       ++sev)
+  {
+    for (size_t type = 0; type < RouteCompiler::CONTENT_TYPE_COUNT; ++type)
+    {
+      attributes |=
+          RouteCompiler::getAttributeBit((Severity)sev, (ContentType)type);
+    }
+  }
+  return compiler.addAttributes(attributes);
+}
+
+RouteNodeId ContentTypeRoutingRule::compile(RouteCompiler& compiler) const
+{
+  AttributeSet attributes = RouteCompiler::ATTRIBUTES_NONE;
+  for (size_t sev = 0; sev < RouteCompiler::SEVERITY_COUNT; ++sev)
+  {
+    attributes |= RouteCompiler::getAttributeBit((Severity)sev, contentType);
+  }
+  return compiler.addAttributes(attributes);
+}
+
+RouteNodeId DefaultRoutingRule::compile(RouteCompiler& compiler) const
+{
+  return compiler.addAttributes(RouteCompiler::ATTRIBUTES_ALL);
+}
+
+} // namespace mklog
@@ -12,11 +12,73 @@
 #ifndef __MEERKAT_LOGS_LOGROUTINGRULE_H
 #define __MEERKAT_LOGS_LOGROUTINGRULE_H
 
+#include <cstdint>
+
 #include "mklog/LogMessage.h"
+#include "mklog/LogSite.h"
 
 namespace mklog
 {
 
+class RouteCompiler;
+
+/**
+ * @brief Index of node in route program built by RouteCompiler
+ */
+using RouteNodeId = uint16_t;
+
+/**
+ * @brief Result of matching message attributes which are known before
+ * message is created
+ */
+enum class RuleMatch
+{
+  NEVER,  /// No message with such attributes matches rule
+  MAYBE,  /// Result depends on other message fields
+  ALWAYS, /// Every message with such attributes matches rule
+};
+
+/**
+ * @brief Logical AND of rule matching results
+ */
+inline RuleMatch matchBoth(RuleMatch first, RuleMatch second)
+{
+  if (first == RuleMatch::NEVER || second == RuleMatch::NEVER)
+    return RuleMatch::NEVER;
+  if (first == RuleMatch::ALWAYS && second == RuleMatch::ALWAYS)
+    return RuleMatch::ALWAYS;
+  return RuleMatch::MAYBE;
+}
+
+/**
+ * @brief Logical OR of rule matching results
+ */
+inline RuleMatch matchEither(RuleMatch first, RuleMatch second)
+{
+  if (first == RuleMatch::ALWAYS || second == RuleMatch::ALWAYS)
+    return RuleMatch::ALWAYS;
+  if (first == RuleMatch::NEVER && second == RuleMatch::NEVER)
+    return RuleMatch::NEVER;
+  return RuleMatch::MAYBE;
+}
+
+/**
+ * @brief Logical NOT of rule matching result
+ */
+inline RuleMatch invertMatch(RuleMatch match)
+{
+  switch (match)
+  {
+  case RuleMatch::NEVER:
+    return RuleMatch::ALWAYS;
+  case RuleMatch::ALWAYS:
+    return RuleMatch::NEVER;
+  case RuleMatch::MAYBE:
+  default:
+    return RuleMatch::MAYBE;
+  }
+}
+
 /**
  * @brief Rule for routing LogMessages
  */
@@ -32,6 +94,50 @@ public:
    */
   virtual bool matchMessage(const LogMessage& message) const = 0;
 
+  /**
+   * @brief Check if messages with given severity and content type match this
+   * routing rule. Rules which cannot tell must return `RuleMatch::MAYBE`.
+   *
+   * @param[in] severity      Message severity
+   * @param[in] contentType   Message content type
+   *
+   * @return Whether such messages match routing rule
+   */
+  virtual RuleMatch matchAttributes(LogMessage::Severity    severity,
+                                    LogMessage::ContentType contentType) const
+  {
+    (void)severity;
+    (void)contentType;
+    return RuleMatch::MAYBE;
+  }
+
+  /**
+   * @brief Check if messages issued from log site match this routing rule.
+   * Result must depend only on static site attributes and content type.
+   * Rules which cannot tell must return `RuleMatch::MAYBE`.
+   *
+   * @param[in] site          Log site
+   * @param[in] contentType   Message content type
+   *
+   * @return Whether messages from this site match routing rule
+   */
+  virtual RuleMatch matchSite(const LogSite&          site,
+                              LogMessage::ContentType contentType) const
+  {
+    return matchAttributes(site.severity, contentType);
+  }
+
+  /**
+   * @brief Add this rule to route program. Rules which depend only on
+   * severity and content type should be compiled into attribute sets.
+   * Default implementation adds opaque node calling `matchMessage()`.
+   *
+   * @param[inout] compiler  Compiler building route program
+   *
+   * @return Node evaluating this rule
+   */
+  virtual RouteNodeId compile(RouteCompiler& compiler) const;
+
   virtual ~LogRoutingRule() = default;
 };
 
@@ -50,6 +156,42 @@ public:
   {
     return message.severity >= minSeverity;
   }
+
+  RuleMatch matchAttributes(LogMessage::Severity severity,
+                            LogMessage::ContentType) const override
+  {
+    return severity >= minSeverity ? RuleMatch::ALWAYS : RuleMatch::NEVER;
+  }
+
+  RouteNodeId compile(RouteCompiler& compiler) const override;
+};
+
+/**
+ * @brief Route messages with given content type
+ */
+class ContentTypeRoutingRule : public LogRoutingRule
+{
+private:
+  LogMessage::ContentType contentType;
+
+public:
+  ContentTypeRoutingRule(LogMessage::ContentType contentType)
+      : contentType(contentType)
+  {
+  }
+
+  bool matchMessage(const LogMessage& message) const override
+  {
+    return message.contentType == contentType;
+  }
+
+  RuleMatch matchAttributes(LogMessage::Severity,
+                            LogMessage::ContentType type) const override
+  {
+    return type == contentType ? RuleMatch::ALWAYS : RuleMatch::NEVER;
+  }
+
+  RouteNodeId compile(RouteCompiler& compiler) const override;
 };
 
 /**
@@ -58,6 +200,14 @@ public:
 class DefaultRoutingRule : public LogRoutingRule
 {
   bool matchMessage(const LogMessage&) const override { return true; }
+
+  RuleMatch matchAttributes(LogMessage::Severity,
+                            LogMessage::ContentType) const override
+  {
+    return RuleMatch::ALWAYS;
+  }
+
+  RouteNodeId compile(RouteCompiler& compiler) const override;
 };
 
 } // namespace mklog
@@ -0,0 +1,37 @@
+#include "mklog/LogSite.h"
+
+#include <cassert>
+
+namespace mklog
+{
+
+LogSiteRegistry::SiteEntry*
+    LogSiteRegistry::s_chunks[LogSiteRegistry::CHUNK_COUNT_MAX] = {};
+
+std::atomic<size_t> LogSiteRegistry::s_siteCount(0);
+
+std::mutex LogSiteRegistry::s_registerMutex;
+
+LogSite::Id LogSiteRegistry::registerSite(const LogSite& site)
+{
+  std::lock_guard<std::mutex> lock(s_registerMutex);
+
+  const size_t index = s_siteCount.load(std::memory_order_relaxed);
+  assert(index < SITE_COUNT_MAX && "Too many log sites");
+
+  // Allocate new chunk if needed
+  SiteEntry*& chunk = s_chunks[index / CHUNK_SIZE];
+  if (chunk == nullptr)
+  {
+    // Value-initialization zeroes site states
+    chunk = new SiteEntry[CHUNK_SIZE]();
+  }
+  chunk[index % CHUNK_SIZE].site = site;
+
+  // Publish site
+  s_siteCount.store(index + 1, std::memory_order_release);
+
+  return (LogSite::Id)(index + 1);
+}
+
+} // namespace mklog
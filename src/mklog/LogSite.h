@@ -0,0 +1,205 @@
+/**
+ * @file LogSite.h
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Static description of places where log messages are issued
+ *
+ * @version 0.1
+ * @date 2023-09-07
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#ifndef __MEERKAT_LOGS_LOGSITE_H
+#define __MEERKAT_LOGS_LOGSITE_H
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include "mklog/LogMessage.h"
+
+namespace mklog
+{
+
+/**
+ * @brief Log call site. Created once for every LOG_* macro expansion.
+ */
+struct LogSite
+{
+  using Id = uint32_t;
+
+  /// Id of messages not issued through LOG_* macros
+  static constexpr Id ID_NONE = 0;
+
+  const char*          file;
+  const char*          function;
+  size_t               line;
+  LogMessage::Severity severity;
+  const char*          format; /// `nullptr` if format is not a literal
+};
+
+/**
+ * @brief Mutable runtime state of log site
+ */
+struct LogSiteState
+{
+  static constexpr size_t CONTENT_TYPE_COUNT =
+      (size_t)LogMessage::ContentType::MAX_TYPE + 1;
+
+  /**
+   * @brief Routing decision for messages from site, valid while `epoch`
+   * matches LogManager configuration epoch. Guarded as a sequence lock:
+   * `epoch` is set to `EPOCH_LOCKED` while masks are being updated.
+   */
+  struct RouteCache
+  {
+    static constexpr uint32_t EPOCH_NONE   = 0;
+    static constexpr uint32_t EPOCH_LOCKED = UINT32_MAX;
+
+    std::atomic<uint32_t> epoch;
+    std::atomic<uint64_t> acceptedWriters; /// Writers accepting all messages
+    std::atomic<uint64_t> matchedWriters;  /// Writers checking each message
+  };
+
+  /**
+   * @brief Token bucket of site rate limit, see `RateLimiter`. Bucket is
+   * stored as the time at which it is full again, so that taking a token is
+   * a single compare-and-swap
+   */
+  struct RateBucket
+  {
+    std::atomic<uint64_t> fullTicks;       /// When all tokens are refilled
+    std::atomic<uint64_t> suppressedCount; /// Messages dropped since last
+                                           /// written one
+  };
+
+  /**
+   * @brief Progress of sampling macros such as `LOG_EVERY_N`
+   */
+  struct SampleCounter
+  {
+    std::atomic<uint64_t> occurrences; /// Times site was reached
+    std::atomic<uint64_t> nextTicks;   /// Earliest time of next message
+  };
+
+  RouteCache    routes[CONTENT_TYPE_COUNT];
+  RateBucket    rateBucket;
+  SampleCounter sampling;
+};
+
+/**
+ * @brief Get offset of file name in file path
+ *
+ * @param[in] path  File path
+ *
+ * @return Offset of first character after last '/' in path
+ */
+constexpr size_t getBaseNameOffset(const char* path)
+{
+  size_t offset = 0;
+  for (size_t i = 0; path[i] != '\0'; ++i)
+  {
+    if (path[i] == '/')
+    {
+      offset = i + 1;
+    }
+  }
+  return offset;
+}
+
+/**
+ * @brief Storage of all registered log sites. Sites are never removed, so
+ * references returned by `getSite()` stay valid until program exit.
+ */
+class LogSiteRegistry
+{
+private:
+  static constexpr size_t CHUNK_SIZE      = 256;
+  static constexpr size_t CHUNK_COUNT_MAX = 4096;
+
+  struct SiteEntry
+  {
+    LogSite      site;
+    LogSiteState state;
+  };
+
+  /**
+   * @brief Sites are stored in fixed-size chunks which never move, so they
+   * can be read without locking
+   */
+  static SiteEntry* s_chunks[CHUNK_COUNT_MAX];
+
+  static SiteEntry& getEntry(LogSite::Id id)
+  {
+    assert(id != LogSite::ID_NONE &&
+           id <= s_siteCount.load(std::memory_order_acquire) &&
+           "Unknown log site id");
+
+    const size_t index = id - 1;
+    return s_chunks[index / CHUNK_SIZE][index % CHUNK_SIZE];
+  }
+
+  /**
+   * @brief Number of registered sites
+   */
+  static std::atomic<size_t> s_siteCount;
+
+  /**
+   * @brief Lock serializing site registration
+   */
+  static std::mutex s_registerMutex;
+
+public:
+  // Forbid construction of static class
+  LogSiteRegistry() = delete;
+
+  /**
+   * @brief Maximum number of registered sites
+   */
+  static constexpr size_t SITE_COUNT_MAX = CHUNK_SIZE * CHUNK_COUNT_MAX;
+
+  /**
+   * @brief Register new log site. Called once per LOG_* macro expansion.
+   *
+   * @param[in] site  Site description
+   *
+   * @return Id of registered site
+   */
+  static LogSite::Id registerSite(const LogSite& site);
+
+  /**
+   * @brief Get registered site
+   *
+   * @param[in] id  Id returned by `registerSite()`
+   *
+   * @return Site description
+   */
+  static const LogSite& getSite(LogSite::Id id) { return getEntry(id).site; }
+
+  /**
+   * @brief Get runtime state of registered site
+   *
+   * @param[in] id  Id returned by `registerSite()`
+   *
+   * @return Site state, zero-initialized on registration
+   */
+  static LogSiteState& getSiteState(LogSite::Id id)
+  {
+    return getEntry(id).state;
+  }
+
+  /**
+   * @brief Get number of registered sites. Valid site ids are in range
+   * [1, siteCount()].
+   */
+  static size_t siteCount()
+  {
+    return s_siteCount.load(std::memory_order_acquire);
+  }
+};
+
+} // namespace mklog
+
+#endif /* LogSite.h */
@@ -0,0 +1,10 @@
+#include "mklog/LogWriter.h"
+
+#include "mklog/LogManager.h"
+
+namespace mklog
+{
+
+void LogWriter::notifyConfigChanged() { LogManager::onConfigChanged(); }
+
+} // namespace mklog
@@ -12,8 +12,12 @@
 #ifndef __MEERKAT_LOGS_LOGWRITER_H
 #define __MEERKAT_LOGS_LOGWRITER_H
 
+#include <cassert>
+#include <cstddef>
+
 #include "mklog/LogMessage.h"
 #include "mklog/LogRoute.h"
+#include "mklog/RouteCompiler.h"
 
 namespace mklog
 {
@@ -35,8 +39,21 @@ public:
     ROUTE_NO_MATCH,           /// Message not accepted by routing rules
   };
 
+  /**
+   * @brief Long message content waiting in pipe
+   */
+  struct PipedContent
+  {
+    int    fd;      /// Read end of pipe
+    size_t length;  /// Number of bytes in pipe which belong to message
+    bool   consume; /// Whether content may be removed from pipe. If not,
+                    /// it must be left there for other writers
+  };
+
 private:
-  LogRoute route;
+  /// Route owning routing rules referenced by `compiledRoute`
+  LogRoute      route;
+  CompiledRoute compiledRoute;
 
   /**
    * @brief Check if message matches routing rules defined by route
@@ -45,9 +62,9 @@ private:
    *
    * @return `true` if message matches routing rules, `false` otherwise
    */
-  bool matchMessage(const LogMessage& message)
+  bool matchMessage(const LogMessage& message) const
   {
-    return route.matchMessage(message);
+    return compiledRoute.matchMessage(message);
   }
 
 protected:
@@ -70,7 +87,62 @@ protected:
    */
   virtual Status writeMessage(const LogMessage& message) = 0;
 
-  LogWriter() : route(LogRoute::makeRoute<DefaultRoutingRule>()) {}
+  /**
+   * @brief Check if writer can move piped content to its output without
+   * copying it to memory
+   *
+   * @return `true` if `spliceMessage()` is implemented, `false` otherwise
+   */
+  virtual bool canSpliceContent() const { return false; }
+
+  /**
+   * @brief Write log message followed by content waiting in pipe. Called
+   * only if `canSpliceContent()` returns `true`
+   *
+   * @param[in] message   Message to be written. Piped content continues
+   *                      its content
+   * @param[in] piped     Content waiting in pipe
+   *
+   * @return `LogWriter::Status::OK`
+   */
+  virtual Status spliceMessage(const LogMessage&   message,
+                               const PipedContent& piped)
+  {
+    (void)message;
+    (void)piped;
+    assert(0 && "Writer cannot splice content");
+    return Status::CONTENT_TYPE_NOT_ALLOWED;
+  }
+
+  /**
+   * @brief Write log message from crash signal handler, bypassing writer
+   * buffers. Implementations must be async-signal-safe: they may not lock,
+   * allocate memory or use stdio. Default implementation drops message
+   *
+   * @param[in] message     Message to be written
+   * @param[in] buffer      Preallocated buffer for rendered text
+   * @param[in] bufferSize  Buffer size
+   */
+  virtual void writeMessageSignalSafe(const LogMessage& message, char* buffer,
+                                      size_t bufferSize)
+  {
+    (void)message;
+    (void)buffer;
+    (void)bufferSize;
+  }
+
+  LogWriter()
+      : route(LogRoute::makeRoute<DefaultRoutingRule>()), compiledRoute()
+  {
+    compiledRoute.compile(route);
+  }
+
+  /**
+   * @brief Notify LogManager that set of messages accepted by this writer
+   * has changed. Must be called by implementations when result of
+   * `canAcceptContentType` changes.
+   */
+  void notifyConfigChanged();
 
 public:
   /**
@@ -94,9 +166,142 @@ public:
     return writeMessage(message);
   }
 
+  /**
+   * @brief Check if message matches routing rules and content type of this
+   * writer
+   *
+   * @param[in] message	  Message to be matched
+   *
+   * @return `true` if message would be written, `false` otherwise
+   */
+  bool acceptsMessage(const LogMessage& message) const
+  {
+    return matchMessage(message) &&
+           canAcceptContentType(message.contentType);
+  }
+
+  /**
+   * @brief Check if this writer may accept messages with given severity and
+   * content type
+   *
+   * @param[in] severity      Message severity
+   * @param[in] contentType   Message content type
+   *
+   * @return `false` if no such message can be written, `true` otherwise
+   */
+  bool mayAcceptMessage(LogMessage::Severity    severity,
+                        LogMessage::ContentType contentType) const
+  {
+    return matchAttributes(severity, contentType) != RuleMatch::NEVER;
+  }
+
+  /**
+   * @brief Check if this writer accepts messages with given severity and
+   * content type
+   *
+   * @param[in] severity      Message severity
+   * @param[in] contentType   Message content type
+   *
+   * @return Whether such messages are written
+   */
+  RuleMatch matchAttributes(LogMessage::Severity    severity,
+                            LogMessage::ContentType contentType) const
+  {
+    if (!canAcceptContentType(contentType))
+    {
+      return RuleMatch::NEVER;
+    }
+    return compiledRoute.matchAttributes(severity, contentType);
+  }
+
+  /**
+   * @brief Check if this writer accepts messages issued from log site
+   *
+   * @param[in] site          Log site
+   * @param[in] contentType   Message content type
+   *
+   * @return Whether messages from this site are written
+   */
+  RuleMatch matchSite(const LogSite&          site,
+                      LogMessage::ContentType contentType) const
+  {
+    if (!canAcceptContentType(contentType))
+    {
+      return RuleMatch::NEVER;
+    }
+    return compiledRoute.matchSite(site, contentType);
+  }
+
+  /**
+   * @brief Write log message without checking routing rules. Must be called
+   * only for messages for which `matchSite()` or `matchAttributes()` returned
+   * `RuleMatch::ALWAYS`
+   *
+   * @param[in] message	  Message to be written
+   *
+   * @return Status of printing message
+   */
+  Status writeAcceptedMessage(const LogMessage& message)
+  {
+    return writeMessage(message);
+  }
+
+  /**
+   * @brief Check if this writer can write piped content without copying it
+   */
+  bool maySpliceContent() const { return canSpliceContent(); }
+
+  /**
+   * @brief Write log message continued by piped content without checking
+   * routing rules. Must be called only for writers accepting message, for
+   * which `maySpliceContent()` returned `true`
+   *
+   * @param[in] message   Message to be written
+   * @param[in] piped     Content waiting in pipe
+   *
+   * @return Status of printing message
+   */
+  Status writeAcceptedSplicedMessage(const LogMessage&   message,
+                                     const PipedContent& piped)
+  {
+    return spliceMessage(message, piped);
+  }
+
+  /**
+   * @brief Write log message from crash signal handler if it matches
+   * routing rules and content type of this writer
+   *
+   * @param[in] message     Message to be written
+   * @param[in] buffer      Preallocated buffer for rendered text
+   * @param[in] bufferSize  Buffer size
+   */
+  void tryWriteMessageSignalSafe(const LogMessage& message, char* buffer,
+                                 size_t bufferSize)
+  {
+    if (acceptsMessage(message))
+    {
+      writeMessageSignalSafe(message, buffer, bufferSize);
+    }
+  }
+
+  /**
+   * @brief Write all messages buffered by this writer. Called by LogManager
+   * at exit, on signals and from `LogManager::flushMessages()`
+   */
+  virtual void flush() {}
+
+  /**
+   * @brief Write messages buffered by this writer from crash signal
+   * handler. Must be async-signal-safe; thread which was writing to writer
+   * may be interrupted at any point, so only completed records are written
+   */
+  virtual void flushSignalSafe() {}
+
   LogWriter& setRoute(const LogRoute& route)
   {
     this->route = route;
+    compiledRoute.compile(this->route);
+    notifyConfigChanged();
     return *this;
   }
 
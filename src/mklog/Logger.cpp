@@ -2,96 +2,270 @@
 
 #include <cstdarg>
 #include <cstdio>
+#include <cstring>
 #include <ctime>
 
 #include "mklog/LogManager.h"
+#include "mklog/utils/LogClock.h"
 
 namespace mklog // TODO: Maybe meerkat::logs?
 {
 
-void Logger::logMessage(MessageSeverity severity, MessageSource source,
-                        MessageContentType contentType, const char* format, ...)
+/**
+ * @brief Per-thread buffer for message content
+ */
+struct FormatBuffer
 {
-  // Get message timestamp
-  const time_t timestamp = time(NULL);
+  char*  data;
+  size_t capacity;
 
-  // Fill information about source logger
-  source.logger = loggerName;
+  ~FormatBuffer() { delete[] data; }
+};
 
-  // Calculate message content length
-  va_list args = {};
-  va_start(args, format);
-  // Add 1 for NUL terminator -------------------------------v
-  const size_t contentLen = vsnprintf(NULL, 0, format, args) + 1;
-  va_end(args);
+/// Initial capacity of thread-local format buffer
+static constexpr size_t FORMAT_BUFFER_LEN_INITIAL = 256;
+
+/// Messages longer than this are formatted into one-time heap buffer
+static constexpr size_t FORMAT_BUFFER_LEN_MAX = 4096;
+
+/// Content of messages which could not be formatted
+static constexpr char FORMAT_ERROR_CONTENT[] = "<format error>";
+
+static thread_local FormatBuffer t_formatBuffer = {.data     = nullptr,
+                                                   .capacity = 0};
+
+/**
+ * @brief Format message content in a single pass if it fits into
+ * thread-local buffer. Leave `suffixLen` bytes after formatted text.
+ *
+ * @param[out] heapContent  Set to allocated buffer if content did not fit
+ *                          into thread-local buffer, `nullptr` otherwise
+ * @param[in]  suffixLen    Number of bytes to reserve after formatted text
+ * @param[in]  format       Printf format string
+ * @param[in]  args         Printf format arguments
+ *
+ * @return Pointer to formatted content. Length of formatted text is stored
+ *         in `*textLen`. Content is `FORMAT_ERROR_CONTENT` if formatting
+ *         failed
+ */
+static char* formatContent(char** heapContent, size_t* textLen,
+                           size_t suffixLen, const char* format, va_list args)
+    __attribute__((__format__(__printf__, 4, 0)));
+
+static char* formatContent(char** heapContent, size_t* textLen,
+                           size_t suffixLen, const char* format, va_list args)
+{
+  FormatBuffer& buffer = t_formatBuffer;
+  *heapContent         = nullptr;
+
+  if (buffer.data == nullptr)
+  {
+    buffer.data     = new char[FORMAT_BUFFER_LEN_INITIAL];
+    buffer.capacity = FORMAT_BUFFER_LEN_INITIAL;
+  }
+
+  // Try to format content in one pass
+  va_list argsCopy = {};
+  va_copy(argsCopy, args);
+  const int formattedLen =
+      vsnprintf(buffer.data, buffer.capacity, format, argsCopy);
+  va_end(argsCopy);
+
+  // Invalid conversion or wide character which cannot be encoded
+  if (formattedLen < 0)
+  {
+    *textLen = sizeof(FORMAT_ERROR_CONTENT) - 1;
+    memcpy(buffer.data, FORMAT_ERROR_CONTENT, sizeof(FORMAT_ERROR_CONTENT));
+    return buffer.data;
+  }
+  *textLen = (size_t)formattedLen;
+
+  const size_t requiredLen = *textLen + suffixLen;
+  if (requiredLen <= buffer.capacity)
+  {
+    return buffer.data;
+  }
+
+  // Content is too long, choose where to put it
+  char* content = nullptr;
+  if (requiredLen <= FORMAT_BUFFER_LEN_MAX)
+  {
+    size_t newCapacity = buffer.capacity;
+    while (newCapacity < requiredLen)
+    {
+      newCapacity *= 2;
+    }
+
+    delete[] buffer.data;
+    buffer.data     = new char[newCapacity];
+    buffer.capacity = newCapacity;
+    content         = buffer.data;
+  }
+  else
+  {
+    *heapContent = new char[requiredLen];
+    content      = *heapContent;
+  }
+
+  // Format content again into large enough buffer
+  vsnprintf(content, requiredLen, format, args);
+
+  return content;
+}
+
+LogMessage Logger::createMessage(LogSite::Id        siteId,
+                                 MessageContentType contentType)
+{
+  const LogSite& site = LogSiteRegistry::getSite(siteId);
+
+  return {.severity      = site.severity,
+          .source        = {.file     = site.file,
+                            .function = site.function,
+                            .line     = site.line,
+                            .logger   = loggerName},
+          .contentType   = contentType,
+          .content       = nullptr,
+          .contentLen    = 0,
+          .timestamp     = utils::LogClock::now(),
+          .siteId        = siteId,
+          .part          = LogMessage::Part::WHOLE,
+          .longMessageId = 0};
+}
+
+void Logger::logSuppressedSummary(LogSite::Id siteId,
+                                  uint64_t    suppressedCount)
+{
+  utils::TextBuffer summary;
+  RateLimiter::appendSummary(summary, siteId, suppressedCount);
+
+  logFormattedMessage(siteId, MessageContentType::TEXT, "%s", summary.data());
+}
+
+void Logger::logFormattedMessage(LogSite::Id        siteId,
+                                 MessageContentType contentType,
+                                 const char*        format, ...)
+{
+  // Get message source and timestamp
+  LogMessage message = createMessage(siteId, contentType);
 
   // Produce message content
-  char* messageContent = new char[contentLen]; // TODO: Reuse memory
+  char*   heapContent = nullptr;
+  size_t  textLen     = 0;
+  va_list args        = {};
   va_start(args, format);
-  vsnprintf(messageContent, contentLen, format, args);
+  // Reserve 1 for NUL terminator ---------------------v
+  char* messageContent =
+      formatContent(&heapContent, &textLen, 1, format, args);
   va_end(args);
 
-  // Construct LogMessage
-  LogMessage message = {.severity    = severity,
-                        .source      = source,
-                        .contentType = contentType,
-                        .content     = messageContent,
-                        .contentLen  = contentLen,
-                        .timestamp   = timestamp};
+  // Attach content to LogMessage
+  message.content    = messageContent;
+  message.contentLen = textLen + 1;
 
   // Send LogMessage through LogManager
   LogManager::logMessage(message);
 
-  // Dispose message content
-  delete[] messageContent;
+  // Dispose oversized message content
+  delete[] heapContent;
 }
 
-LogManager::MessageFd Logger::beginLongMessage(MessageSeverity    severity,
-                                               MessageSource      source,
-                                               MessageContentType contentType,
-                                               const char*        format, ...)
+void Logger::logDeferredMessage(LogSite::Id        siteId,
+                                MessageContentType contentType,
+                                const char* format, const char* encodedArgs,
+                                size_t encodedArgsLen)
 {
-  // Get message timestamp
-  const time_t timestamp = time(NULL);
+  // Construct LogMessage without content
+  LogMessage message = createMessage(siteId, contentType);
 
-  // Fill information about source logger
-  source.logger = loggerName;
+  // Send LogMessage with captured arguments through LogManager
+  LogManager::logDeferredMessage(message, format, encodedArgs, encodedArgsLen);
+}
 
-  // Calculate message content length
-  va_list args = {};
-  va_start(args, format);
-  // Add 2 for NUL terminator and LF ------------------------v
-  const size_t contentLen = vsnprintf(NULL, 0, format, args) + 2;
-  va_end(args);
+LogManager::MessageFd Logger::beginLongMessage(LogSite::Id        siteId,
+                                               MessageContentType contentType,
+                                               const char*        format, ...)
+{
+  // Get message source and timestamp
+  LogMessage message = createMessage(siteId, contentType);
 
   // Produce message content
-  char* messageContent = new char[contentLen];
+  char*   heapContent = nullptr;
+  size_t  textLen     = 0;
+  va_list args        = {};
   va_start(args, format);
-  vsnprintf(messageContent, contentLen, format, args);
+  // Reserve 2 for NUL terminator and LF ---------------v
+  char* messageContent =
+      formatContent(&heapContent, &textLen, 2, format, args);
   va_end(args);
   // Add LF
+  const size_t contentLen        = textLen + 2;
   messageContent[contentLen - 2] = '\n';
   messageContent[contentLen - 1] = '\0';
 
-  // Construct LogMessage
-  LogMessage message = {.severity    = severity,
-                        .source      = source,
-                        .contentType = contentType,
-                        .content     = messageContent,
-                        .contentLen  = contentLen,
-                        .timestamp   = timestamp};
+  // Attach content to LogMessage
+  message.content    = messageContent;
+  message.contentLen = contentLen;
 
   // Register long message
   LogManager::MessageFd messageFd = LogManager::beginLongMessage(message);
 
-  // Dispose message content
-  delete[] messageContent;
+  // Dispose oversized message content
+  delete[] heapContent;
 
   return messageFd;
 }
 
+LongMessage Logger::openLongMessage(LogSite::Id        siteId,
+                                    MessageContentType contentType,
+                                    const char*        format, ...)
+{
+  // Do not format header of message which would not be written
+  if (!LogManager::isMessageAccepted(LogSiteRegistry::getSite(siteId).severity,
+                                     contentType))
+  {
+    return LongMessage();
+  }
+
+  if (!isWithinRateLimit(siteId, LogSiteRegistry::getSite(siteId).severity))
+  {
+    return LongMessage();
+  }
+
+  // Get message source and timestamp
+  LogMessage message = createMessage(siteId, contentType);
+
+  // Produce message header
+  char*   heapContent = nullptr;
+  size_t  textLen     = 0;
+  va_list args        = {};
+  va_start(args, format);
+  // Reserve 2 for NUL terminator and LF ---------------v
+  char* messageContent =
+      formatContent(&heapContent, &textLen, 2, format, args);
+  va_end(args);
+  // Add LF
+  const size_t contentLen        = textLen + 2;
+  messageContent[contentLen - 2] = '\n';
+  messageContent[contentLen - 1] = '\0';
+
+  // Attach header to LogMessage
+  message.content    = messageContent;
+  message.contentLen = contentLen;
+
+  // Register long message
+  LongMessage longMessage(LogManager::openLongMessage(message));
+
+  // Dispose oversized message content
+  delete[] heapContent;
+
+  return longMessage;
+}
+
 void Logger::endLongMessage(LogManager::MessageFd& messageFd)
 {
+  if (messageFd == LogManager::MESSAGE_FD_INVALID)
+    return;
+
   LogManager::endLongMessage(messageFd);
 }
 } // namespace mklog
@@ -13,8 +13,14 @@
 #define __MEERKAT_LOGS_LOGGER_H
 
 #include <cstring>
+#include <type_traits>
 
 #include "mklog/LogManager.h"
+#include "mklog/LogSite.h"
+#include "mklog/LongMessage.h"
+#include "mklog/RateLimiter.h"
+#include "mklog/utils/DeferredArgs.h"
+#include "mklog/utils/LogClock.h"
 
 namespace mklog
 {
@@ -24,6 +30,25 @@ class Logger
 private:
   char* loggerName;
 
+  /**
+   * @brief Create message issued from log site, without content
+   *
+   * @param[in] siteId      Log site id
+   * @param[in] contentType Log message content type
+   *
+   * @return Log message with source, severity and timestamp filled
+   */
+  LogMessage createMessage(LogSite::Id siteId, MessageContentType contentType);
+
+  /**
+   * @brief Issue message reporting number of messages dropped at log site by
+   * `RateLimiter`
+   *
+   * @param[in] siteId          Log site id
+   * @param[in] suppressedCount Number of dropped messages
+   */
+  void logSuppressedSummary(LogSite::Id siteId, uint64_t suppressedCount);
+
 public:
   static constexpr size_t NAME_LEN_MAX = 128;
 
@@ -43,70 +68,330 @@ public:
 
   /**
    * @brief Issue new log message. Cannot be called directly, use LOG_* macros
-   * instead.
+   * instead. If formatting is deferred and format is constant, only
+   * arguments are captured and content is rendered later by dispatcher
+   * thread.
+   *
+   * @param[in] siteId	          Log site id
+   * @param[in] contentType       Log message content type
+   * @param[in] isFormatConstant  Format is known at compile time, so that it
+   *                              outlives queued message
+   * @param[in] format	          Log message printf format string
+   * @param[in] args	            Log message printf format arguments
+   */
+  template <typename... TArgs>
+  __attribute__((__format__(__printf__, 5, 0))) void
+  logMessage(LogSite::Id siteId, MessageContentType contentType,
+             bool isFormatConstant, const char* format, TArgs&&... args)
+  {
+    using utils::DeferredArgs;
+
+    // Format built at run time may be gone before dispatcher renders it
+    if (isFormatConstant && LogManager::isFormattingDeferred())
+    {
+      const size_t argsLen =
+          DeferredArgs::getEncodedSize(static_cast<TArgs&&>(args)...);
+
+      // Arguments which do not fit into queue record are formatted here
+      if (argsLen <= LogManager::DEFERRED_ARGS_LEN_MAX)
+      {
+        char encodedArgs[LogManager::DEFERRED_ARGS_LEN_MAX] = {};
+        DeferredArgs::encode(encodedArgs, static_cast<TArgs&&>(args)...);
+
+        logDeferredMessage(siteId, contentType, format, encodedArgs, argsLen);
+        return;
+      }
+    }
+
+    logFormattedMessage(siteId, contentType, format, args...);
+  }
+
+  /**
+   * @brief Issue new log message with content formatted on calling thread
    *
-   * @param[in] severity	  Log message severity
-   * @param[in] source	    Log message source
+   * @param[in] siteId	    Log site id
    * @param[in] contentType Log message content type
    * @param[in] format	    Log message printf format string
    * @param[in] ...	        Log message printf format arguments
    */
-  void logMessage(MessageSeverity severity, MessageSource source,
-                  MessageContentType contentType, const char* format, ...)
-      __attribute__((__format__(__printf__, 5, 6)));
+  void logFormattedMessage(LogSite::Id siteId, MessageContentType contentType,
+                           const char* format, ...)
+      __attribute__((__format__(__printf__, 4, 0)));
+
+  /**
+   * @brief Issue new log message with deferred formatting
+   *
+   * @param[in] siteId	        Log site id
+   * @param[in] contentType     Log message content type
+   * @param[in] format	        Log message printf format string
+   * @param[in] encodedArgs     Arguments encoded by `utils::DeferredArgs`
+   * @param[in] encodedArgsLen  Length of encoded arguments
+   */
+  void logDeferredMessage(LogSite::Id siteId, MessageContentType contentType,
+                          const char* format, const char* encodedArgs,
+                          size_t encodedArgsLen);
+
+  /**
+   * @brief Never called. Used by LOG_* macros to check printf format
+   * arguments at compile time.
+   */
+  static int checkFormat(const char* format, ...)
+      __attribute__((__format__(__printf__, 1, 2)));
 
   /**
    * @brief Register new long message. Cannot be called directly, use
    * LOG_BEGIN_* macros instead.
    *
-   * @param[in] severity	  Log message severity
-   * @param[in] source	    Log message source
+   * @param[in] siteId	    Log site id
    * @param[in] contentType Log message content type
    * @param[in] format	    Log message printf format string
    * @param[in] ...	        Log message printf format arguments
    *
    * @return File descriptor for long message content
    */
-  LogManager::MessageFd
-  beginLongMessage(MessageSeverity severity, MessageSource source,
-                   MessageContentType contentType, const char* format, ...)
-      __attribute__((__format__(__printf__, 5, 6)));
+  LogManager::MessageFd beginLongMessage(LogSite::Id        siteId,
+                                         MessageContentType contentType,
+                                         const char* format, ...)
+      __attribute__((__format__(__printf__, 4, 5)));
 
   /**
-   * @brief End long message. Invalidate `messageFd`
+   * @brief Start long message built in memory. Cannot be called directly,
+   * use LOG_LONG_* macros instead.
+   *
+   * @param[in] siteId	    Log site id
+   * @param[in] contentType Log message content type
+   * @param[in] format	    Log message printf format string
+   * @param[in] ...	        Log message printf format arguments
+   *
+   * @return Long message. Not open if message would not be written
+   */
+  LongMessage openLongMessage(LogSite::Id        siteId,
+                              MessageContentType contentType,
+                              const char* format, ...)
+      __attribute__((__format__(__printf__, 4, 5)));
+
+  /**
+   * @brief End long message. Invalidate `messageFd`. Does nothing for
+   * `LogManager::MESSAGE_FD_INVALID` returned by LOG_BEGIN_* macros for
+   * rejected or skipped messages
    *
    * @param[inout] messageFd	Content file descriptor for long message
    */
   void endLongMessage(LogManager::MessageFd& messageFd);
 
+  /**
+   * @brief Check rate limit of log site. Cannot be called directly, used by
+   * LOG_* macros before message arguments are evaluated. Messages dropped
+   * since the last one written from site are reported before it.
+   *
+   * @param[in] siteId    Log site id
+   * @param[in] severity  Log site severity
+   *
+   * @return `false` if message must be dropped, `true` otherwise
+   */
+  bool isWithinRateLimit(LogSite::Id siteId, LogMessage::Severity severity)
+  {
+    if (!RateLimiter::tryAcquire(siteId, severity))
+      return false;
+
+    const uint64_t suppressedCount = RateLimiter::takeSuppressedCount(siteId);
+    if (suppressedCount != 0)
+    {
+      logSuppressedSummary(siteId, suppressedCount);
+    }
+    return true;
+  }
+
+  /**
+   * @brief Issue log message only if it may be accepted by some writer.
+   * Cannot be called directly, use LOG_* macros instead.
+   *
+   * @param[in] isAccepted  Result of `LogManager::isMessageAccepted()`
+   * @param[in] function    Name of function issuing message
+   * @param[in] logCall     Callable issuing message. Receives this logger
+   *                        and `function`
+   */
+  template <typename TLogCall>
+  void logIfAccepted(bool isAccepted, const char* function, TLogCall logCall)
+  {
+    if (isAccepted)
+    {
+      logCall(*this, function);
+    }
+  }
+
+  /**
+   * @brief Call function with log site registered inside it. Cannot be
+   * called directly, use LOG_BEGIN_* and LOG_LONG_* sampling macros instead.
+   *
+   * @param[in] function    Name of function issuing message
+   * @param[in] siteCall    Callable registering site and issuing message.
+   *                        Receives this logger and `function`
+   *
+   * @return Result of `siteCall`
+   */
+  template <typename TSiteCall>
+  auto callWithSite(const char* function, TSiteCall siteCall)
+      -> decltype(siteCall(*this, function))
+  {
+    return siteCall(*this, function);
+  }
+
+  /**
+   * @brief Count occurrence of log site. Used by `LOG_EVERY_N` macros
+   *
+   * @param[in] siteId  Log site id
+   * @param[in] n       Sampling period. Zero is treated as 1
+   *
+   * @return `true` for the 1st, (n+1)th, (2n+1)th... occurrence
+   */
+  static bool isEveryNthOccurrence(LogSite::Id siteId, uint64_t n)
+  {
+    std::atomic<uint64_t>& occurrences =
+        LogSiteRegistry::getSiteState(siteId).sampling.occurrences;
+
+    return n <= 1 ||
+           occurrences.fetch_add(1, std::memory_order_relaxed) % n == 0;
+  }
+
+  /**
+   * @brief Count occurrence of log site. Used by `LOG_FIRST_N` macros
+   *
+   * @param[in] siteId  Log site id
+   * @param[in] n       Number of messages to be issued
+   *
+   * @return `true` for the first `n` occurrences
+   */
+  static bool isAmongFirstOccurrences(LogSite::Id siteId, uint64_t n)
+  {
+    std::atomic<uint64_t>& occurrences =
+        LogSiteRegistry::getSiteState(siteId).sampling.occurrences;
+
+    // Stop writing to counter once all messages are issued
+    if (occurrences.load(std::memory_order_relaxed) >= n)
+      return false;
+
+    return occurrences.fetch_add(1, std::memory_order_relaxed) < n;
+  }
+
+  /**
+   * @brief Check if enough time passed since the last message issued from
+   * log site. Used by `LOG_EVERY_T` macros
+   *
+   * @param[in] siteId      Log site id
+   * @param[in] periodSec   Minimum time between messages in seconds
+   *
+   * @return `true` for the first occurrence and for the first one at least
+   *         `periodSec` seconds after the previous accepted one
+   */
+  static bool isPeriodElapsed(LogSite::Id siteId, double periodSec)
+  {
+    std::atomic<uint64_t>& nextTicks =
+        LogSiteRegistry::getSiteState(siteId).sampling.nextTicks;
+
+    const utils::LogClock::Ticks now = utils::LogClock::now();
+
+    uint64_t next = nextTicks.load(std::memory_order_relaxed);
+    if ((int64_t)(now - next) < 0)
+      return false;
+
+    const uint64_t periodNs =
+        periodSec > 0
+            ? (uint64_t)(periodSec * (double)utils::LogClock::NS_PER_SECOND)
+            : 0;
+
+    // Only one of threads reaching site at the same time issues message
+    return nextTicks.compare_exchange_strong(
+        next, now + utils::LogClock::toTicks(periodNs),
+        std::memory_order_relaxed);
+  }
+
   /**
    * @brief Do not print message
    */
   void doNothing(void) const {}
 
+// Expands to first macro argument
+#define __LOG_FORMAT(format, ...) format
+
+// Register log site once. Expands to site id
+#define __LOG_SITE(siteSeverity, siteFunction, siteFormat)                     \
+  [](const char* __function, const char* __format) {                           \
+    static const mklog::LogSite::Id __siteId =                                 \
+        mklog::LogSiteRegistry::registerSite(                                  \
+            {.file     = __FILE__ + std::integral_constant<                    \
+                                    size_t, mklog::getBaseNameOffset(          \
+                                                __FILE__)>::value,             \
+             .function = __function,                                           \
+             .line     = __LINE__,                                             \
+             .severity = siteSeverity,                                         \
+             .format   = __format});                                           \
+    return __siteId;                                                           \
+  }(siteFunction, __builtin_constant_p(siteFormat) ? (siteFormat) : nullptr)
+
 #ifndef NLOGS
 
-#define __LOG_MESSAGE(severity, type, ...)                                     \
-  logMessage(severity,                                                         \
-             {.file     = __FILE__,                                            \
-              .function = __PRETTY_FUNCTION__,                                 \
-              .line     = __LINE__,                                            \
-              .logger   = nullptr},                                            \
-             type, __VA_ARGS__)
+// Arguments are evaluated inside lambda only if message is accepted, site is
+// sampled and site is within its rate limit. `isSampled` may use `__siteId`
+#define __LOG_SAMPLED(severity, isSampled, type, ...)                          \
+  logIfAccepted(                                                               \
+      mklog::LogManager::isMessageAccepted(severity, type),                    \
+      __PRETTY_FUNCTION__,                                                     \
+      [&](mklog::Logger& __logger, const char* __function) {                   \
+        const mklog::LogSite::Id __siteId =                                    \
+            __LOG_SITE(severity, __function, __LOG_FORMAT(__VA_ARGS__, ));     \
+        if ((isSampled) && __logger.isWithinRateLimit(__siteId, severity))     \
+        {                                                                      \
+          __logger.logMessage(                                                 \
+              __siteId,                                                        \
+              ((void)sizeof(mklog::Logger::checkFormat(__VA_ARGS__)), type),  \
+              __builtin_constant_p(__LOG_FORMAT(__VA_ARGS__, )),               \
+              __VA_ARGS__);                                                    \
+        }                                                                      \
+      })
 
 #else
 
-#define __LOG_MESSAGE(severity, type, ...) doNothing()
+#define __LOG_SAMPLED(severity, isSampled, type, ...) doNothing()
 
 #endif // NLOGS
 
+#define __LOG_MESSAGE(severity, type, ...)                                     \
+  __LOG_SAMPLED(severity, true, type, __VA_ARGS__)
+
 #define __LOG_BEGIN(severity, type, ...)                                       \
-  beginLongMessage(severity,                                                   \
-                   {.file     = __FILE__,                                      \
-                    .function = __PRETTY_FUNCTION__,                           \
-                    .line     = __LINE__,                                      \
-                    .logger   = nullptr},                                        \
-                   type, __VA_ARGS__)
+  __LOG_BEGIN_SAMPLED(severity, true, type, __VA_ARGS__)
+
+#define __LOG_LONG(severity, type, ...)                                        \
+  __LOG_LONG_SAMPLED(severity, true, type, __VA_ARGS__)
+
+// Header arguments are evaluated only if message is accepted, site is sampled
+// and site is within its rate limit. Sampling counters are not advanced for
+// rejected messages
+#define __LOG_BEGIN_SAMPLED(severity, isSampled, type, ...)                    \
+  callWithSite(                                                                \
+      __PRETTY_FUNCTION__,                                                     \
+      [&](mklog::Logger& __logger, const char* __function) {                   \
+        const mklog::LogSite::Id __siteId =                                    \
+            __LOG_SITE(severity, __function, __LOG_FORMAT(__VA_ARGS__, ));     \
+        return mklog::LogManager::isMessageAccepted(severity, type) &&         \
+                       (isSampled) &&                                          \
+                       __logger.isWithinRateLimit(__siteId, severity)          \
+                   ? __logger.beginLongMessage(__siteId, type, __VA_ARGS__)    \
+                   : mklog::LogManager::MESSAGE_FD_INVALID;                    \
+      })
+
+#define __LOG_LONG_SAMPLED(severity, isSampled, type, ...)                     \
+  callWithSite(                                                                \
+      __PRETTY_FUNCTION__,                                                     \
+      [&](mklog::Logger& __logger, const char* __function) {                   \
+        const mklog::LogSite::Id __siteId =                                    \
+            __LOG_SITE(severity, __function, __LOG_FORMAT(__VA_ARGS__, ));     \
+        return mklog::LogManager::isMessageAccepted(severity, type) &&         \
+                       (isSampled)                                             \
+                   ? __logger.openLongMessage(__siteId, type, __VA_ARGS__)     \
+                   : mklog::LongMessage();                                     \
+      })
 
 #ifndef NLOG_TRACE
 
@@ -219,6 +504,52 @@ public:
 
 #endif // NLOG_FATAL
 
+/**
+ * @brief Issue log message on the 1st, (n+1)th, (2n+1)th... time it is
+ * reached. Arguments are not evaluated on other occurrences. Occurrences
+ * are counted only while some writer may accept message
+ *
+ * @param[in] severity    Severity name, e.g. `INFO`
+ * @param[in] n           Sampling period
+ * @param[in] contentType Log message content type
+ * @param[in] format	    Log message printf format string
+ * @param[in] ...	        Log message printf format arguments
+ */
+#define LOG_EVERY_N(severity, n, ...)                                          \
+  __LOG_SAMPLED(mklog::MessageSeverity::severity,                              \
+                mklog::Logger::isEveryNthOccurrence(__siteId, n), __VA_ARGS__)
+
+/**
+ * @brief Issue log message only the first `n` times it is reached.
+ * Arguments are not evaluated afterwards. Occurrences are counted only
+ * while some writer may accept message
+ *
+ * @param[in] severity    Severity name, e.g. `INFO`
+ * @param[in] n           Number of messages
+ * @param[in] contentType Log message content type
+ * @param[in] format	    Log message printf format string
+ * @param[in] ...	        Log message printf format arguments
+ */
+#define LOG_FIRST_N(severity, n, ...)                                          \
+  __LOG_SAMPLED(mklog::MessageSeverity::severity,                              \
+                mklog::Logger::isAmongFirstOccurrences(__siteId, n),           \
+                __VA_ARGS__)
+
+/**
+ * @brief Issue log message at most once per `seconds`. Arguments are not
+ * evaluated on skipped occurrences
+ *
+ * @param[in] severity    Severity name, e.g. `INFO`
+ * @param[in] seconds     Minimum time between messages
+ * @param[in] contentType Log message content type
+ * @param[in] format	    Log message printf format string
+ * @param[in] ...	        Log message printf format arguments
+ */
+#define LOG_EVERY_T(severity, seconds, ...)                                    \
+  __LOG_SAMPLED(mklog::MessageSeverity::severity,                              \
+                mklog::Logger::isPeriodElapsed(__siteId, seconds),             \
+                __VA_ARGS__)
+
 // TODO: Conditionally disable LOG_BEGIN macros
 
 /**
@@ -228,7 +559,9 @@ public:
  * @param[in] format	    Log message printf format string
  * @param[in] ...	        Log message printf format arguments
  *
- * @return File descriptor for long message content
+ * @return File descriptor for long message content,
+ *         `LogManager::MESSAGE_FD_INVALID` if no writer accepts message
+ *         or site exceeds its rate limit
  */
 #define LOG_BEGIN_TRACE(...)                                                   \
   __LOG_BEGIN(mklog::MessageSeverity::TRACE, __VA_ARGS__)
@@ -240,7 +573,9 @@ public:
  * @param[in] format	    Log message printf format string
  * @param[in] ...	        Log message printf format arguments
  *
- * @return File descriptor for long message content
+ * @return File descriptor for long message content,
+ *         `LogManager::MESSAGE_FD_INVALID` if no writer accepts message
+ *         or site exceeds its rate limit
  */
 #define LOG_BEGIN_DEBUG(...)                                                   \
   __LOG_BEGIN(mklog::MessageSeverity::DEBUG, __VA_ARGS__)
@@ -252,7 +587,9 @@ public:
  * @param[in] format	    Log message printf format string
  * @param[in] ...	        Log message printf format arguments
  *
- * @return File descriptor for long message content
+ * @return File descriptor for long message content,
+ *         `LogManager::MESSAGE_FD_INVALID` if no writer accepts message
+ *         or site exceeds its rate limit
  */
 #define LOG_BEGIN_INFO(...)                                                    \
   __LOG_BEGIN(mklog::MessageSeverity::INFO, __VA_ARGS__)
@@ -264,7 +601,9 @@ public:
  * @param[in] format	    Log message printf format string
  * @param[in] ...	        Log message printf format arguments
  *
- * @return File descriptor for long message content
+ * @return File descriptor for long message content,
+ *         `LogManager::MESSAGE_FD_INVALID` if no writer accepts message
+ *         or site exceeds its rate limit
  */
 #define LOG_BEGIN_WARNING(...)                                                 \
   __LOG_BEGIN(mklog::MessageSeverity::WARNING, __VA_ARGS__)
@@ -276,7 +615,9 @@ public:
  * @param[in] format	    Log message printf format string
  * @param[in] ...	        Log message printf format arguments
  *
- * @return File descriptor for long message content
+ * @return File descriptor for long message content,
+ *         `LogManager::MESSAGE_FD_INVALID` if no writer accepts message
+ *         or site exceeds its rate limit
  */
 #define LOG_BEGIN_ERROR(...)                                                   \
   __LOG_BEGIN(mklog::MessageSeverity::ERROR, __VA_ARGS__)
@@ -288,12 +629,196 @@ public:
  * @param[in] format	    Log message printf format string
  * @param[in] ...	        Log message printf format arguments
  *
- * @return File descriptor for long message content
+ * @return File descriptor for long message content,
+ *         `LogManager::MESSAGE_FD_INVALID` if no writer accepts message
+ *         or site exceeds its rate limit
  */
 #define LOG_BEGIN_FATAL(...)                                                   \
   __LOG_BEGIN(mklog::MessageSeverity::FATAL, __VA_ARGS__)
 
-  ~Logger() { delete[] loggerName; }
+/**
+ * @brief Register new long message on the 1st, (n+1)th, (2n+1)th... time it
+ * is reached
+ *
+ * @param[in] severity    Severity name, e.g. `INFO`
+ * @param[in] n           Sampling period
+ * @param[in] contentType Log message content type
+ * @param[in] format	    Log message printf format string
+ * @param[in] ...	        Log message printf format arguments
+ *
+ * @return File descriptor for long message content,
+ *         `LogManager::MESSAGE_FD_INVALID` on skipped occurrences
+ */
+#define LOG_BEGIN_EVERY_N(severity, n, ...)                                    \
+  __LOG_BEGIN_SAMPLED(mklog::MessageSeverity::severity,                        \
+                      mklog::Logger::isEveryNthOccurrence(__siteId, n),        \
+                      __VA_ARGS__)
+
+/**
+ * @brief Register new long message only the first `n` times it is reached
+ *
+ * @param[in] severity    Severity name, e.g. `INFO`
+ * @param[in] n           Number of messages
+ * @param[in] contentType Log message content type
+ * @param[in] format	    Log message printf format string
+ * @param[in] ...	        Log message printf format arguments
+ *
+ * @return File descriptor for long message content,
+ *         `LogManager::MESSAGE_FD_INVALID` on skipped occurrences
+ */
+#define LOG_BEGIN_FIRST_N(severity, n, ...)                                    \
+  __LOG_BEGIN_SAMPLED(mklog::MessageSeverity::severity,                        \
+                      mklog::Logger::isAmongFirstOccurrences(__siteId, n),     \
+                      __VA_ARGS__)
+
+/**
+ * @brief Register new long message at most once per `seconds`
+ *
+ * @param[in] severity    Severity name, e.g. `INFO`
+ * @param[in] seconds     Minimum time between messages
+ * @param[in] contentType Log message content type
+ * @param[in] format	    Log message printf format string
+ * @param[in] ...	        Log message printf format arguments
+ *
+ * @return File descriptor for long message content,
+ *         `LogManager::MESSAGE_FD_INVALID` on skipped occurrences
+ */
+#define LOG_BEGIN_EVERY_T(severity, seconds, ...)                              \
+  __LOG_BEGIN_SAMPLED(mklog::MessageSeverity::severity,                        \
+                      mklog::Logger::isPeriodElapsed(__siteId, seconds),       \
+                      __VA_ARGS__)
+
+/**
+ * @brief Start long message with severity TRACE built in memory
+ *
+ * @param[in] contentType Log message content type
+ * @param[in] format	    Log message printf format string
+ * @param[in] ...	        Log message printf format arguments
+ *
+ * @return `mklog::LongMessage` accepting content
+ */
+#define LOG_LONG_TRACE(...)                                                    \
+  __LOG_LONG(mklog::MessageSeverity::TRACE, __VA_ARGS__)
+
+/**
+ * @brief Start long message with severity DEBUG built in memory
+ *
+ * @param[in] contentType Log message content type
+ * @param[in] format	    Log message printf format string
+ * @param[in] ...	        Log message printf format arguments
+ *
+ * @return `mklog::LongMessage` accepting content
+ */
+#define LOG_LONG_DEBUG(...)                                                    \
+  __LOG_LONG(mklog::MessageSeverity::DEBUG, __VA_ARGS__)
+
+/**
+ * @brief Start long message with severity INFO built in memory
+ *
+ * @param[in] contentType Log message content type
+ * @param[in] format	    Log message printf format string
+ * @param[in] ...	        Log message printf format arguments
+ *
+ * @return `mklog::LongMessage` accepting content
+ */
+#define LOG_LONG_INFO(...)                                                     \
+  __LOG_LONG(mklog::MessageSeverity::INFO, __VA_ARGS__)
+
+/**
+ * @brief Start long message with severity WARNING built in memory
+ *
+ * @param[in] contentType Log message content type
+ * @param[in] format	    Log message printf format string
+ * @param[in] ...	        Log message printf format arguments
+ *
+ * @return `mklog::LongMessage` accepting content
+ */
+#define LOG_LONG_WARNING(...)                                                  \
+  __LOG_LONG(mklog::MessageSeverity::WARNING, __VA_ARGS__)
+
+/**
+ * @brief Start long message with severity ERROR built in memory
+ *
+ * @param[in] contentType Log message content type
+ * @param[in] format	    Log message printf format string
+ * @param[in] ...	        Log message printf format arguments
+ *
+ * @return `mklog::LongMessage` accepting content
+ */
+#define LOG_LONG_ERROR(...)                                                    \
+  __LOG_LONG(mklog::MessageSeverity::ERROR, __VA_ARGS__)
+
+/**
+ * @brief Start long message with severity FATAL built in memory
+ *
+ * @param[in] contentType Log message content type
+ * @param[in] format	    Log message printf format string
+ * @param[in] ...	        Log message printf format arguments
+ *
+ * @return `mklog::LongMessage` accepting content
+ */
+#define LOG_LONG_FATAL(...)                                                    \
+  __LOG_LONG(mklog::MessageSeverity::FATAL, __VA_ARGS__)
+
+/**
+ * @brief Start long message built in memory on the 1st, (n+1)th,
+ * (2n+1)th... time it is reached
+ *
+ * @param[in] severity    Severity name, e.g. `INFO`
+ * @param[in] n           Sampling period
+ * @param[in] contentType Log message content type
+ * @param[in] format	    Log message printf format string
+ * @param[in] ...	        Log message printf format arguments
+ *
+ * @return `mklog::LongMessage` accepting content, not open on skipped
+ *         occurrences
+ */
+#define LOG_LONG_EVERY_N(severity, n, ...)                                     \
+  __LOG_LONG_SAMPLED(mklog::MessageSeverity::severity,                         \
+                     mklog::Logger::isEveryNthOccurrence(__siteId, n),         \
+                     __VA_ARGS__)
+
+/**
+ * @brief Start long message built in memory only the first `n` times it is
+ * reached
+ *
+ * @param[in] severity    Severity name, e.g. `INFO`
+ * @param[in] n           Number of messages
+ * @param[in] contentType Log message content type
+ * @param[in] format	    Log message printf format string
+ * @param[in] ...	        Log message printf format arguments
+ *
+ * @return `mklog::LongMessage` accepting content, not open on skipped
+ *         occurrences
+ */
+#define LOG_LONG_FIRST_N(severity, n, ...)                                     \
+  __LOG_LONG_SAMPLED(mklog::MessageSeverity::severity,                         \
+                     mklog::Logger::isAmongFirstOccurrences(__siteId, n),      \
+                     __VA_ARGS__)
+
+/**
+ * @brief Start long message built in memory at most once per `seconds`
+ *
+ * @param[in] severity    Severity name, e.g. `INFO`
+ * @param[in] seconds     Minimum time between messages
+ * @param[in] contentType Log message content type
+ * @param[in] format	    Log message printf format string
+ * @param[in] ...	        Log message printf format arguments
+ *
+ * @return `mklog::LongMessage` accepting content, not open on skipped
+ *         occurrences
+ */
+#define LOG_LONG_EVERY_T(severity, seconds, ...)                               \
+  __LOG_LONG_SAMPLED(mklog::MessageSeverity::severity,                         \
+                     mklog::Logger::isPeriodElapsed(__siteId, seconds),        \
+                     __VA_ARGS__)
+
+  ~Logger()
+  {
+    // Queued messages may still reference logger name
+    LogManager::flushMessages();
+    delete[] loggerName;
+  }
 };
 
 } // namespace mklog
@@ -0,0 +1,153 @@
+/**
+ * @file LongMessage.h
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Long message content built in memory
+ *
+ * @version 0.1
+ * @date 2023-09-12
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#ifndef __MEERKAT_LOGS_LONGMESSAGE_H
+#define __MEERKAT_LOGS_LONGMESSAGE_H
+
+#include <cstdarg>
+#include <cstring>
+#include <type_traits>
+
+#include "mklog/LogManager.h"
+
+namespace mklog
+{
+
+/**
+ * @brief Open long message. Content appended with `printf()`, `append()` or
+ * `operator<<` is collected in memory and written as a single message when
+ * `end()` is called or object is destroyed.
+ */
+class LongMessage
+{
+private:
+  LogManager::MessageHandle handle;
+
+public:
+  LongMessage() : handle(LogManager::MESSAGE_HANDLE_INVALID) {}
+
+  explicit LongMessage(LogManager::MessageHandle handle) : handle(handle) {}
+
+  LongMessage(LongMessage&& other) : handle(other.handle)
+  {
+    other.handle = LogManager::MESSAGE_HANDLE_INVALID;
+  }
+
+  LongMessage& operator=(LongMessage&& other)
+  {
+    if (this != &other)
+    {
+      end();
+      handle       = other.handle;
+      other.handle = LogManager::MESSAGE_HANDLE_INVALID;
+    }
+    return *this;
+  }
+
+  // No copying
+  LongMessage(const LongMessage&)            = delete;
+  LongMessage& operator=(const LongMessage&) = delete;
+
+  /**
+   * @brief Check if message accepts content. Message is not open if logs
+   * are not started or no writer accepts it
+   */
+  bool isOpen() const { return handle != LogManager::MESSAGE_HANDLE_INVALID; }
+
+  /**
+   * @brief Append text to message
+   *
+   * @param[in] text    Text to be appended
+   * @param[in] length  Text length
+   */
+  LongMessage& append(const char* text, size_t length)
+  {
+    if (isOpen())
+    {
+      LogManager::appendLongMessage(handle, text, length);
+    }
+    return *this;
+  }
+
+  /**
+   * @brief Append printf-formatted text to message
+   *
+   * @param[in] format  Printf format string
+   * @param[in] ...     Printf format arguments
+   */
+  LongMessage& printf(const char* format, ...)
+      __attribute__((__format__(__printf__, 2, 3)))
+  {
+    if (isOpen())
+    {
+      va_list args = {};
+      va_start(args, format);
+      LogManager::vappendLongMessagef(handle, format, args);
+      va_end(args);
+    }
+    return *this;
+  }
+
+  LongMessage& operator<<(const char* text)
+  {
+    return append(text, strlen(text));
+  }
+
+  LongMessage& operator<<(char ch) { return append(&ch, 1); }
+
+  LongMessage& operator<<(bool value)
+  {
+    return value ? append("true", 4) : append("false", 5);
+  }
+
+  template <typename TValue>
+  typename std::enable_if<std::is_integral<TValue>::value &&
+                              std::is_signed<TValue>::value,
+                          LongMessage&>::type
+  operator<<(TValue value)
+  {
+    return printf("%lld", (long long)value);
+  }
+
+  template <typename TValue>
+  typename std::enable_if<std::is_integral<TValue>::value &&
+                              std::is_unsigned<TValue>::value,
+                          LongMessage&>::type
+  operator<<(TValue value)
+  {
+    return printf("%llu", (unsigned long long)value);
+  }
+
+  LongMessage& operator<<(double value) { return printf("%g", value); }
+
+  LongMessage& operator<<(const void* pointer)
+  {
+    return printf("%p", pointer);
+  }
+
+  /**
+   * @brief Write message if anything has been appended. No content can be
+   * appended after call
+   */
+  void end()
+  {
+    if (isOpen())
+    {
+      LogManager::closeLongMessage(handle);
+    }
+  }
+
+  ~LongMessage() { end(); }
+};
+
+} // namespace mklog
+
+#endif /* LongMessage.h */
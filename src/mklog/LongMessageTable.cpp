@@ -0,0 +1,75 @@
+#include "mklog/LongMessageTable.h"
+
+namespace mklog
+{
+
+LongMessageTable::Slot*
+    LongMessageTable::s_chunks[LongMessageTable::CHUNK_COUNT_MAX] = {};
+
+std::atomic<size_t> LongMessageTable::s_slotCount(0);
+
+uint32_t LongMessageTable::s_firstFree = LongMessageTable::FREE_NONE;
+
+std::mutex LongMessageTable::s_tableMutex;
+
+LongMessageTable::Handle LongMessageTable::allocate(Slot** slot)
+{
+  std::lock_guard<std::mutex> lock(s_tableMutex);
+
+  size_t index = s_firstFree;
+  if (index != FREE_NONE)
+  {
+    s_firstFree = getSlot(index).nextFree;
+  }
+  else
+  {
+    index = s_slotCount.load(std::memory_order_relaxed);
+    if (index >= SLOT_COUNT_MAX)
+    {
+      return HANDLE_INVALID;
+    }
+
+    // Allocate new chunk if needed
+    Slot*& chunk = s_chunks[index / CHUNK_SIZE];
+    if (chunk == nullptr)
+    {
+      chunk = new Slot[CHUNK_SIZE];
+    }
+
+    // Publish slot
+    s_slotCount.store(index + 1, std::memory_order_release);
+  }
+
+  Slot& allocated = getSlot(index);
+  allocated.content.clear();
+  allocated.headerLen      = 0;
+  allocated.partCount      = 0;
+  allocated.contentReadFd  = -1;
+  allocated.contentWriteFd = -1;
+  allocated.isPipeDeferred = false;
+  allocated.nextFree       = FREE_NONE;
+
+  *slot = &allocated;
+  const uint32_t generation =
+      allocated.generation.load(std::memory_order_relaxed);
+  return ((Handle)generation << INDEX_BITS) | (Handle)(index + 1);
+}
+
+void LongMessageTable::release(Handle handle)
+{
+  std::lock_guard<std::mutex> lock(s_tableMutex);
+
+  const size_t index = (handle & INDEX_MASK) - 1;
+  Slot&        slot  = getSlot(index);
+  const uint32_t generation = slot.generation.load(std::memory_order_relaxed);
+  assert(generation == (handle >> INDEX_BITS) && "Stale message handle");
+
+  slot.isOpen.store(false, std::memory_order_release);
+  slot.generation.store((generation + 1) & GENERATION_MASK,
+                        std::memory_order_relaxed);
+
+  slot.nextFree = s_firstFree;
+  s_firstFree   = (uint32_t)index;
+}
+
+} // namespace mklog
@@ -0,0 +1,195 @@
+/**
+ * @file LongMessageTable.h
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Storage of long messages which are being built
+ *
+ * @version 0.1
+ * @date 2023-09-12
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#ifndef __MEERKAT_LOGS_LONGMESSAGETABLE_H
+#define __MEERKAT_LOGS_LONGMESSAGETABLE_H
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include "mklog/LogMessage.h"
+#include "mklog/utils/TextBuffer.h"
+
+namespace mklog
+{
+
+/**
+ * @brief Table of open long messages addressed by handles. Handle encodes
+ * slot index and slot generation, so lookup takes constant time and stale
+ * handles are detected. Slots are reused together with their content
+ * buffers.
+ */
+class LongMessageTable
+{
+public:
+  using Handle = uint32_t;
+
+  static constexpr Handle HANDLE_INVALID = 0;
+
+  /**
+   * @brief Long message being built
+   */
+  struct Slot
+  {
+    /// Message template. Content is stored in `content`
+    LogMessage message;
+
+    /// Header followed by appended content
+    utils::TextBuffer content;
+
+    /// Length of message header at the start of `content`. Zero after
+    /// the first part is sent
+    size_t headerLen;
+
+    /// Number of parts sent to writers
+    uint32_t partCount;
+
+    /// Read end of pipe for messages created by
+    /// `LogManager::beginLongMessage()`, -1 otherwise
+    int contentReadFd;
+
+    /// Write end of pipe, -1 if message has no pipe
+    int contentWriteFd;
+
+    /// Pipe content is left for pipe drainer to be spliced later
+    bool isPipeDeferred;
+
+    /// Slot is being modified. Set by appending thread and signal handler
+    std::atomic<bool> isBusy;
+
+    std::atomic<bool>     isOpen;
+    std::atomic<uint32_t> generation;
+    uint32_t              nextFree;
+
+    Slot()
+        : message(),
+          content(),
+          headerLen(0),
+          partCount(0),
+          contentReadFd(-1),
+          contentWriteFd(-1),
+          isPipeDeferred(false),
+          isBusy(false),
+          isOpen(false),
+          generation(0),
+          nextFree(0)
+    {
+    }
+  };
+
+private:
+  static constexpr unsigned INDEX_BITS      = 20;
+  static constexpr Handle   INDEX_MASK      = (Handle{1} << INDEX_BITS) - 1;
+  static constexpr uint32_t GENERATION_MASK = UINT32_MAX >> INDEX_BITS;
+  static constexpr size_t   CHUNK_SIZE      = 256;
+  static constexpr size_t   CHUNK_COUNT_MAX = INDEX_MASK / CHUNK_SIZE;
+
+  /// Marks end of free slot list
+  static constexpr uint32_t FREE_NONE = UINT32_MAX;
+
+  /**
+   * @brief Slots are stored in fixed-size chunks which never move, so they
+   * can be looked up without locking
+   */
+  static Slot* s_chunks[CHUNK_COUNT_MAX];
+
+  /// Number of slots ever used
+  static std::atomic<size_t> s_slotCount;
+
+  static uint32_t   s_firstFree;
+  static std::mutex s_tableMutex;
+
+  static Slot& getSlot(size_t index)
+  {
+    return s_chunks[index / CHUNK_SIZE][index % CHUNK_SIZE];
+  }
+
+public:
+  // Forbid construction of static class
+  LongMessageTable() = delete;
+
+  /**
+   * @brief Maximum number of simultaneously open long messages
+   */
+  static constexpr size_t SLOT_COUNT_MAX = CHUNK_SIZE * CHUNK_COUNT_MAX;
+
+  /**
+   * @brief Take free slot. Slot content is empty, other fields must be
+   * filled by caller before slot is published with `isOpen`
+   *
+   * @param[out] slot   Allocated slot
+   *
+   * @return Handle of slot, `HANDLE_INVALID` if table is full
+   */
+  static Handle allocate(Slot** slot);
+
+  /**
+   * @brief Return slot to table. Handle becomes invalid
+   *
+   * @param[in] handle  Handle returned by `allocate()`
+   */
+  static void release(Handle handle);
+
+  /**
+   * @brief Find slot of open long message
+   *
+   * @param[in] handle  Handle returned by `allocate()`
+   *
+   * @return Slot, `nullptr` if handle is stale or invalid
+   */
+  static Slot* find(Handle handle)
+  {
+    const size_t index = (handle & INDEX_MASK) - 1;
+    if (handle == HANDLE_INVALID ||
+        index >= s_slotCount.load(std::memory_order_acquire))
+    {
+      return nullptr;
+    }
+
+    Slot& slot = getSlot(index);
+    if (slot.generation.load(std::memory_order_relaxed) !=
+            (handle >> INDEX_BITS) ||
+        !slot.isOpen.load(std::memory_order_acquire))
+    {
+      return nullptr;
+    }
+    return &slot;
+  }
+
+  /**
+   * @brief Call function for every open long message. Slots may be
+   * released concurrently, function must check `isOpen` under `isBusy`
+   *
+   * @param[in] function  Callable receiving `Slot&` and its handle
+   */
+  template <typename TFunction>
+  static void forEachOpen(TFunction function)
+  {
+    const size_t slotCount = s_slotCount.load(std::memory_order_acquire);
+    for (size_t i = 0; i < slotCount; ++i)
+    {
+      Slot& slot = getSlot(i);
+      if (slot.isOpen.load(std::memory_order_acquire))
+      {
+        const uint32_t generation =
+            slot.generation.load(std::memory_order_relaxed);
+        function(slot, ((Handle)generation << INDEX_BITS) | (Handle)(i + 1));
+      }
+    }
+  }
+};
+
+} // namespace mklog
+
+#endif /* LongMessageTable.h */
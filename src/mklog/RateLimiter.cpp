@@ -0,0 +1,81 @@
+#include "mklog/RateLimiter.h"
+
+#include <cinttypes>
+
+namespace mklog
+{
+
+RateLimiter::Limit RateLimiter::s_limits[RateLimiter::SEVERITY_COUNT] = {};
+
+RateLimiter::Policy RateLimiter::s_policies[RateLimiter::SEVERITY_COUNT] = {};
+
+std::mutex RateLimiter::s_policyMutex;
+
+std::atomic<bool> RateLimiter::s_hasSuppressed(false);
+
+void RateLimiter::storeLimit(size_t severityIndex)
+{
+  const Policy& policy = s_policies[severityIndex];
+  Limit&        limit  = s_limits[severityIndex];
+
+  if (policy.messagesPerSecond == 0)
+  {
+    limit.intervalTicks.store(0, std::memory_order_relaxed);
+    return;
+  }
+
+  uint64_t interval = utils::LogClock::toTicks(
+      utils::LogClock::NS_PER_SECOND / policy.messagesPerSecond);
+  // Zero interval means no limit
+  if (interval == 0)
+    interval = 1;
+
+  const uint64_t burst = policy.burst > 0 ? policy.burst : 1;
+
+  // Logging threads may briefly see new interval with old tolerance, which
+  // only changes how many messages pass during reconfiguration
+  limit.toleranceTicks.store((burst - 1) * interval,
+                             std::memory_order_relaxed);
+  limit.intervalTicks.store(interval, std::memory_order_relaxed);
+}
+
+void RateLimiter::setPolicy(const Policy& policy)
+{
+  std::lock_guard<std::mutex> lock(s_policyMutex);
+
+  for (size_t i = 0; i < SEVERITY_COUNT; ++i)
+  {
+    s_policies[i] = policy;
+    storeLimit(i);
+  }
+}
+
+void RateLimiter::setPolicy(LogMessage::Severity severity,
+                            const Policy&        policy)
+{
+  std::lock_guard<std::mutex> lock(s_policyMutex);
+
+  s_policies[(size_t)severity] = policy;
+  storeLimit((size_t)severity);
+}
+
+void RateLimiter::updateLimits()
+{
+  std::lock_guard<std::mutex> lock(s_policyMutex);
+
+  for (size_t i = 0; i < SEVERITY_COUNT; ++i)
+  {
+    storeLimit(i);
+  }
+}
+
+void RateLimiter::appendSummary(utils::TextBuffer& output, LogSite::Id siteId,
+                                uint64_t suppressedCount)
+{
+  const LogSite& site = LogSiteRegistry::getSite(siteId);
+
+  output.appendf("suppressed %" PRIu64 " messages from %s:%zu",
+                 suppressedCount, site.file, site.line);
+}
+
+} // namespace mklog
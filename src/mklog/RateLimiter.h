@@ -0,0 +1,206 @@
+/**
+ * @file RateLimiter.h
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Per-site limits on rate of log messages
+ *
+ * @version 0.1
+ * @date 2023-09-20
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#ifndef __MEERKAT_LOGS_RATELIMITER_H
+#define __MEERKAT_LOGS_RATELIMITER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include "mklog/LogMessage.h"
+#include "mklog/LogSite.h"
+#include "mklog/utils/LogClock.h"
+#include "mklog/utils/TextBuffer.h"
+
+namespace mklog
+{
+
+/**
+ * @brief Limits number of messages issued from every log site. Each site has
+ * its own token bucket, refilled at rate configured for site severity.
+ * Messages issued while bucket is empty are dropped before they are
+ * formatted and only counted; the count is reported by the next message
+ * from the same site which is written, or by `LogManager` if the site
+ * stays quiet.
+ */
+class RateLimiter
+{
+public:
+  /**
+   * @brief Rate limit applied to every log site with some severity
+   */
+  struct Policy
+  {
+    /// Sustained number of messages per second. Zero disables limit
+    uint32_t messagesPerSecond;
+
+    /// Number of messages which may be issued at once by site which was
+    /// quiet for a while. Treated as 1 if zero
+    uint32_t burst;
+  };
+
+  static constexpr Policy POLICY_NONE = {.messagesPerSecond = 0, .burst = 0};
+
+  static constexpr Policy POLICY_DEFAULT = {.messagesPerSecond = 100,
+                                            .burst             = 1000};
+
+private:
+  static constexpr size_t SEVERITY_COUNT =
+      (size_t)LogMessage::Severity::MAX_LEVEL + 1;
+
+  /**
+   * @brief Policy converted to clock ticks
+   */
+  struct Limit
+  {
+    std::atomic<uint64_t> intervalTicks;  /// Time to refill one token, zero
+                                          /// if there is no limit
+    std::atomic<uint64_t> toleranceTicks; /// Time to refill all tokens but
+                                          /// one
+  };
+
+  /**
+   * @brief Limits indexed by severity. Read by logging threads without
+   * locking
+   */
+  static Limit s_limits[SEVERITY_COUNT];
+
+  /**
+   * @brief Configured policies indexed by severity. Guarded by
+   * `s_policyMutex`
+   */
+  static Policy     s_policies[SEVERITY_COUNT];
+  static std::mutex s_policyMutex;
+
+  /**
+   * @brief Set when a message is dropped, so that pending counts are
+   * searched for only after drops
+   */
+  static std::atomic<bool> s_hasSuppressed;
+
+  /**
+   * @brief Convert policy for severity to ticks. `s_policyMutex` must be
+   * held
+   */
+  static void storeLimit(size_t severityIndex);
+
+public:
+  // Forbid construction of static class
+  RateLimiter() = delete;
+
+  /**
+   * @brief Limit rate of messages with every severity. May be called while
+   * other threads are logging
+   */
+  static void setPolicy(const Policy& policy);
+
+  /**
+   * @brief Limit rate of messages with given severity. May be called while
+   * other threads are logging
+   */
+  static void setPolicy(LogMessage::Severity severity, const Policy& policy);
+
+  /**
+   * @brief Convert all policies to ticks again. Called by
+   * `LogManager::initLogs()` once clock is calibrated
+   */
+  static void updateLimits();
+
+  /**
+   * @brief Take token from bucket of log site. Costs a single relaxed load
+   * if there is no limit for severity, otherwise a compare-and-swap on
+   * success or an increment of suppressed count on failure
+   *
+   * @param[in] siteId    Log site id
+   * @param[in] severity  Log site severity
+   *
+   * @return `false` if message must be dropped, `true` otherwise
+   */
+  static bool tryAcquire(LogSite::Id siteId, LogMessage::Severity severity)
+  {
+    const Limit&   limit = s_limits[(size_t)severity];
+    const uint64_t interval =
+        limit.intervalTicks.load(std::memory_order_relaxed);
+    if (interval == 0)
+      return true;
+
+    const uint64_t tolerance =
+        limit.toleranceTicks.load(std::memory_order_relaxed);
+
+    LogSiteState::RateBucket& bucket =
+        LogSiteRegistry::getSiteState(siteId).rateBucket;
+    const utils::LogClock::Ticks now = utils::LogClock::now();
+
+    uint64_t fullTicks    = bucket.fullTicks.load(std::memory_order_relaxed);
+    uint64_t newFullTicks = 0;
+    do
+    {
+      // Full bucket does not gain tokens while site is quiet
+      const uint64_t refillStart =
+          (int64_t)(fullTicks - now) > 0 ? fullTicks : now;
+      if (refillStart - now > tolerance)
+      {
+        bucket.suppressedCount.fetch_add(1, std::memory_order_relaxed);
+        if (!s_hasSuppressed.load(std::memory_order_relaxed))
+          s_hasSuppressed.store(true, std::memory_order_release);
+        return false;
+      }
+      newFullTicks = refillStart + interval;
+    } while (!bucket.fullTicks.compare_exchange_weak(
+        fullTicks, newFullTicks, std::memory_order_relaxed));
+
+    return true;
+  }
+
+  /**
+   * @brief Get number of messages dropped at log site since previous call
+   * and reset it
+   *
+   * @param[in] siteId  Log site id
+   */
+  static uint64_t takeSuppressedCount(LogSite::Id siteId)
+  {
+    std::atomic<uint64_t>& count =
+        LogSiteRegistry::getSiteState(siteId).rateBucket.suppressedCount;
+
+    // Do not write shared cache line if nothing was dropped
+    if (count.load(std::memory_order_relaxed) == 0)
+      return 0;
+
+    return count.exchange(0, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Check if any message was dropped since previous call and reset
+   * the flag. Counts of all sites must be taken after `true` is returned
+   */
+  static bool takeHasSuppressed()
+  {
+    return s_hasSuppressed.load(std::memory_order_relaxed) &&
+           s_hasSuppressed.exchange(false, std::memory_order_acquire);
+  }
+
+  /**
+   * @brief Append report of dropped messages to buffer
+   *
+   * @param[inout] output           Buffer for report text
+   * @param[in]    siteId           Log site id
+   * @param[in]    suppressedCount  Number of dropped messages
+   */
+  static void appendSummary(utils::TextBuffer& output, LogSite::Id siteId,
+                            uint64_t suppressedCount);
+};
+
+} // namespace mklog
+
+#endif /* RateLimiter.h */
@@ -0,0 +1,382 @@
+#include "mklog/RouteCompiler.h"
+
+#include <cassert>
+#include <cstring>
+
+#include "mklog/LogRoute.h"
+
+namespace mklog
+{
+
+using Instruction = RouteCompiler::Instruction;
+using OpCode      = RouteCompiler::OpCode;
+
+/**
+ * @brief Make sure array has space for one more element
+ */
+template <typename TElement>
+static void reserveNext(TElement** array, size_t length, size_t* capacity)
+{
+  static constexpr size_t INITIAL_CAPACITY = 16;
+
+  if (length < *capacity)
+    return;
+
+  const size_t newCapacity =
+      *capacity == 0 ? INITIAL_CAPACITY : *capacity * 2;
+  TElement* newArray = new TElement[newCapacity];
+  if (length > 0)
+    memcpy(newArray, *array, length * sizeof(TElement));
+
+  delete[] *array;
+  *array    = newArray;
+  *capacity = newCapacity;
+}
+
+static bool isSameInstruction(const Instruction& first,
+                              const Instruction& second)
+{
+  return first.opCode == second.opCode && first.first == second.first &&
+         first.second == second.second &&
+         first.attributes == second.attributes && first.rule == second.rule;
+}
+
+RouteCompiler::RouteCompiler()
+    : program(nullptr),
+      programLen(0),
+      programCapacity(0),
+      compiledRules(nullptr),
+      compiledRuleCount(0),
+      compiledRuleCapacity(0)
+{
+}
+
+RouteNodeId RouteCompiler::addInstruction(const Instruction& instruction)
+{
+  for (size_t i = 0; i < programLen; ++i)
+  {
+    if (isSameInstruction(program[i], instruction))
+      return (RouteNodeId)i;
+  }
+
+  assert(programLen < PROGRAM_LEN_MAX && "Route program is too long");
+
+  reserveNext(&program, programLen, &programCapacity);
+  program[programLen] = instruction;
+  return (RouteNodeId)programLen++;
+}
+
+RouteNodeId RouteCompiler::compileRule(const LogRoutingRule& rule)
+{
+  for (size_t i = 0; i < compiledRuleCount; ++i)
+  {
+    if (compiledRules[i].rule == &rule)
+      return compiledRules[i].node;
+  }
+
+  const RouteNodeId node = rule.compile(*this);
+
+  reserveNext(&compiledRules, compiledRuleCount, &compiledRuleCapacity);
+  compiledRules[compiledRuleCount++] = {.rule = &rule, .node = node};
+
+  return node;
+}
+
+RouteNodeId RouteCompiler::addAttributes(AttributeSet attributes)
+{
+  return addInstruction({.opCode     = OpCode::ATTRIBUTES,
+                         .first      = 0,
+                         .second     = 0,
+                         .attributes = attributes & ATTRIBUTES_ALL,
+                         .rule       = nullptr});
+}
+
+RouteNodeId RouteCompiler::addRule(const LogRoutingRule& rule)
+{
+  return addInstruction({.opCode     = OpCode::RULE,
+                         .first      = 0,
+                         .second     = 0,
+                         .attributes = ATTRIBUTES_NONE,
+                         .rule       = &rule});
+}
+
+RouteNodeId RouteCompiler::addAnd(RouteNodeId first, RouteNodeId second)
+{
+  // Copy nodes, adding instructions may reallocate program
+  const Instruction lhs = program[first];
+  const Instruction rhs = program[second];
+
+  if (first == second)
+    return first;
+
+  if (lhs.opCode == OpCode::ATTRIBUTES && rhs.opCode == OpCode::ATTRIBUTES)
+    return addAttributes(lhs.attributes & rhs.attributes);
+
+  if (lhs.opCode == OpCode::ATTRIBUTES)
+  {
+    if (lhs.attributes == ATTRIBUTES_ALL)
+      return second;
+    if (lhs.attributes == ATTRIBUTES_NONE)
+      return first;
+  }
+  if (rhs.opCode == OpCode::ATTRIBUTES)
+  {
+    if (rhs.attributes == ATTRIBUTES_ALL)
+      return first;
+    if (rhs.attributes == ATTRIBUTES_NONE)
+      return second;
+  }
+
+  // Expression and its negation
+  if ((lhs.opCode == OpCode::NOT && lhs.first == second) ||
+      (rhs.opCode == OpCode::NOT && rhs.first == first))
+    return addAttributes(ATTRIBUTES_NONE);
+
+  // Operands of commutative operations are ordered to find equal nodes
+  if (first > second)
+    return addAnd(second, first);
+
+  return addInstruction({OpCode::AND, first, second, 0, nullptr});
+}
+
+RouteNodeId RouteCompiler::addOr(RouteNodeId first, RouteNodeId second)
+{
+  // Copy nodes, adding instructions may reallocate program
+  const Instruction lhs = program[first];
+  const Instruction rhs = program[second];
+
+  if (first == second)
+    return first;
+
+  if (lhs.opCode == OpCode::ATTRIBUTES && rhs.opCode == OpCode::ATTRIBUTES)
+    return addAttributes(lhs.attributes | rhs.attributes);
+
+  if (lhs.opCode == OpCode::ATTRIBUTES)
+  {
+    if (lhs.attributes == ATTRIBUTES_NONE)
+      return second;
+    if (lhs.attributes == ATTRIBUTES_ALL)
+      return first;
+  }
+  if (rhs.opCode == OpCode::ATTRIBUTES)
+  {
+    if (rhs.attributes == ATTRIBUTES_NONE)
+      return first;
+    if (rhs.attributes == ATTRIBUTES_ALL)
+      return second;
+  }
+
+  // Expression or its negation
+  if ((lhs.opCode == OpCode::NOT && lhs.first == second) ||
+      (rhs.opCode == OpCode::NOT && rhs.first == first))
+    return addAttributes(ATTRIBUTES_ALL);
+
+  // Operands of commutative operations are ordered to find equal nodes
+  if (first > second)
+    return addOr(second, first);
+
+  return addInstruction({OpCode::OR, first, second, 0, nullptr});
+}
+
+RouteNodeId RouteCompiler::addNot(RouteNodeId operand)
+{
+  const Instruction node = program[operand];
+
+  if (node.opCode == OpCode::ATTRIBUTES)
+    return addAttributes(~node.attributes);
+
+  if (node.opCode == OpCode::NOT)
+    return node.first;
+
+  return addInstruction({OpCode::NOT, operand, 0, 0, nullptr});
+}
+
+RouteCompiler::~RouteCompiler()
+{
+  delete[] program;
+  delete[] compiledRules;
+}
+
+/**
+ * @brief Convert result of attribute check to evaluation value
+ */
+static void setValue(bool* value, bool matched) { *value = matched; }
+
+static void setValue(RuleMatch* value, bool matched)
+{
+  *value = matched ? RuleMatch::ALWAYS : RuleMatch::NEVER;
+}
+
+static bool matchBoth(bool first, bool second) { return first && second; }
+
+static bool matchEither(bool first, bool second) { return first || second; }
+
+static bool invertMatch(bool match) { return !match; }
+
+CompiledRoute::CompiledRoute()
+    : program(nullptr),
+      programLen(0),
+      alwaysSet(RouteCompiler::ATTRIBUTES_NONE),
+      neverSet(RouteCompiler::ATTRIBUTES_ALL)
+{
+}
+
+template <typename TValue, typename TMatchRule>
+TValue CompiledRoute::evaluate(AttributeSet attribute,
+                               TMatchRule   matchRule) const
+{
+  TValue  stackValues[EVAL_STACK_LEN];
+  TValue* values =
+      programLen <= EVAL_STACK_LEN ? stackValues : new TValue[programLen];
+
+  for (size_t i = 0; i < programLen; ++i)
+  {
+    const RouteCompiler::Instruction& node = program[i];
+    switch (node.opCode)
+    {
+    case OpCode::ATTRIBUTES:
+      setValue(&values[i], (node.attributes & attribute) != 0);
+      break;
+    case OpCode::RULE:
+      values[i] = matchRule(*node.rule);
+      break;
+    case OpCode::AND:
+      values[i] = matchBoth(values[node.first], values[node.second]);
+      break;
+    case OpCode::OR:
+      values[i] = matchEither(values[node.first], values[node.second]);
+      break;
+    case OpCode::NOT:
+      values[i] = invertMatch(values[node.first]);
+      break;
+    default:
+      assert(0 && "Invalid route program node");
+    }
+  }
+
+  // Root is always the last node
+  const TValue result = values[programLen - 1];
+
+  if (values != stackValues)
+    delete[] values;
+
+  return result;
+}
+
+void CompiledRoute::compile(const LogRoute& route)
+{
+  using Severity    = LogMessage::Severity;
+  using ContentType = LogMessage::ContentType;
+
+  RouteCompiler      compiler;
+  const RouteNodeId  root  = route.compile(compiler);
+  const Instruction* nodes = compiler.getProgram();
+
+  // Leave only nodes reachable from root. Operands always precede nodes
+  // using them, so a single backward pass is enough
+  bool* reachable = new bool[root + 1]();
+  reachable[root] = true;
+  for (size_t i = root + 1; i-- > 0;)
+  {
+    if (!reachable[i])
+      continue;
+
+    switch (nodes[i].opCode)
+    {
+    case OpCode::AND:
+    case OpCode::OR:
+      reachable[nodes[i].second] = true;
+      reachable[nodes[i].first]  = true;
+      break;
+    case OpCode::NOT:
+      reachable[nodes[i].first] = true;
+      break;
+    case OpCode::ATTRIBUTES:
+    case OpCode::RULE:
+    default:
+      break;
+    }
+  }
+
+  RouteNodeId* newIds = new RouteNodeId[root + 1];
+  size_t       newLen = 0;
+  for (size_t i = 0; i <= root; ++i)
+  {
+    if (reachable[i])
+      newIds[i] = (RouteNodeId)newLen++;
+  }
+
+  delete[] program;
+  program    = new Instruction[newLen];
+  programLen = newLen;
+
+  for (size_t i = 0; i <= root; ++i)
+  {
+    if (!reachable[i])
+      continue;
+
+    Instruction& node = program[newIds[i]];
+    node              = nodes[i];
+    if (node.opCode == OpCode::AND || node.opCode == OpCode::OR)
+    {
+      node.first  = newIds[node.first];
+      node.second = newIds[node.second];
+    }
+    else if (node.opCode == OpCode::NOT)
+    {
+      node.first = newIds[node.first];
+    }
+  }
+
+  delete[] newIds;
+  delete[] reachable;
+
+  // Precompute result for each (severity, content type) pair
+  alwaysSet = RouteCompiler::ATTRIBUTES_NONE;
+  neverSet  = RouteCompiler::ATTRIBUTES_NONE;
+  for (size_t sev = 0; sev < RouteCompiler::SEVERITY_COUNT; ++sev)
+  {
+    for (size_t type = 0; type < RouteCompiler::CONTENT_TYPE_COUNT; ++type)
+    {
+      const AttributeSet attribute =
+          RouteCompiler::getAttributeBit((Severity)sev, (ContentType)type);
+
+      const RuleMatch match = evaluate<RuleMatch>(
+          attribute, [sev, type](const LogRoutingRule& rule) {
+            return rule.matchAttributes((Severity)sev, (ContentType)type);
+          });
+
+      if (match == RuleMatch::ALWAYS)
+        alwaysSet |= attribute;
+      else if (match == RuleMatch::NEVER)
+        neverSet |= attribute;
+    }
+  }
+}
+
+bool CompiledRoute::evaluateMessage(const LogMessage& message) const
+{
+  return evaluate<bool>(
+      RouteCompiler::getAttributeBit(message.severity, message.contentType),
+      [&message](const LogRoutingRule& rule) {
+        return rule.matchMessage(message);
+      });
+}
+
+RuleMatch CompiledRoute::matchSite(const LogSite&          site,
+                                   LogMessage::ContentType contentType) const
+{
+  const RuleMatch match = matchAttributes(site.severity, contentType);
+  if (match != RuleMatch::MAYBE)
+    return match;
+
+  return evaluate<RuleMatch>(
+      RouteCompiler::getAttributeBit(site.severity, contentType),
+      [&site, contentType](const LogRoutingRule& rule) {
+        return rule.matchSite(site, contentType);
+      });
+}
+
+CompiledRoute::~CompiledRoute() { delete[] program; }
+
+} // namespace mklog
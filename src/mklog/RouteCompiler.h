@@ -0,0 +1,298 @@
+/**
+ * @file RouteCompiler.h
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Compilation of routing rule trees into flat predicate programs
+ *
+ * @version 0.1
+ * @date 2023-09-07
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#ifndef __MEERKAT_LOGS_ROUTECOMPILER_H
+#define __MEERKAT_LOGS_ROUTECOMPILER_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "mklog/LogMessage.h"
+#include "mklog/LogRoutingRule.h"
+#include "mklog/LogSite.h"
+
+namespace mklog
+{
+
+class LogRoute;
+
+/**
+ * @brief Builder of route programs. Program is a sequence of nodes in which
+ * operands always precede nodes using them. Tests of severity and content
+ * type are merged into bitsets, constant subexpressions are folded and equal
+ * nodes are stored only once.
+ */
+class RouteCompiler
+{
+public:
+  /**
+   * @brief Set of (severity, content type) pairs, one bit per pair
+   */
+  using AttributeSet = uint32_t;
+
+  static constexpr size_t SEVERITY_COUNT =
+      (size_t)LogMessage::Severity::MAX_LEVEL + 1;
+  static constexpr size_t CONTENT_TYPE_COUNT =
+      (size_t)LogMessage::ContentType::MAX_TYPE + 1;
+  static constexpr size_t ATTRIBUTE_COUNT = SEVERITY_COUNT * CONTENT_TYPE_COUNT;
+
+  static_assert(ATTRIBUTE_COUNT <= 32, "Attribute set is too small");
+
+  static constexpr AttributeSet ATTRIBUTES_NONE = 0;
+  static constexpr AttributeSet ATTRIBUTES_ALL =
+      (AttributeSet{1} << ATTRIBUTE_COUNT) - 1;
+
+  /**
+   * @brief Maximum number of nodes in route program
+   */
+  static constexpr size_t PROGRAM_LEN_MAX = UINT16_MAX;
+
+  /**
+   * @brief Get index of (severity, content type) pair in attribute set
+   */
+  static constexpr size_t getAttributeIndex(LogMessage::Severity    severity,
+                                            LogMessage::ContentType type)
+  {
+    return (size_t)severity * CONTENT_TYPE_COUNT + (size_t)type;
+  }
+
+  /**
+   * @brief Get attribute set containing only given pair
+   */
+  static constexpr AttributeSet getAttributeBit(LogMessage::Severity    severity,
+                                                LogMessage::ContentType type)
+  {
+    return AttributeSet{1} << getAttributeIndex(severity, type);
+  }
+
+  /**
+   * @brief Operation performed by route program node
+   */
+  enum class OpCode : uint8_t
+  {
+    ATTRIBUTES, /// Check if message attributes are in set
+    RULE,       /// Call `matchMessage()` of routing rule
+    AND,
+    OR,
+    NOT,
+  };
+
+  /**
+   * @brief Route program node. Unused fields are zero.
+   */
+  struct Instruction
+  {
+    OpCode                opCode;
+    RouteNodeId           first;      /// First operand of AND, OR and NOT
+    RouteNodeId           second;     /// Second operand of AND and OR
+    AttributeSet          attributes; /// Set checked by ATTRIBUTES
+    const LogRoutingRule* rule;       /// Rule called by RULE
+  };
+
+private:
+  Instruction* program;
+  size_t       programLen;
+  size_t       programCapacity;
+
+  /**
+   * @brief Node built for routing rule. Used to compile rules shared
+   * between several routes only once
+   */
+  struct CompiledRule
+  {
+    const LogRoutingRule* rule;
+    RouteNodeId           node;
+  };
+
+  CompiledRule* compiledRules;
+  size_t        compiledRuleCount;
+  size_t        compiledRuleCapacity;
+
+  /**
+   * @brief Append node to program unless equal node already exists
+   *
+   * @param[in] instruction   Node to be added
+   *
+   * @return Id of added or existing node
+   */
+  RouteNodeId addInstruction(const Instruction& instruction);
+
+public:
+  RouteCompiler();
+
+  // No copying
+  RouteCompiler(const RouteCompiler&)            = delete;
+  RouteCompiler& operator=(const RouteCompiler&) = delete;
+
+  /**
+   * @brief Compile routing rule. Rule which was already compiled is not
+   * compiled again.
+   *
+   * @param[in] rule  Routing rule. Must outlive compiled program
+   *
+   * @return Node evaluating rule
+   */
+  RouteNodeId compileRule(const LogRoutingRule& rule);
+
+  /**
+   * @brief Add node matching messages with attributes from set
+   */
+  RouteNodeId addAttributes(AttributeSet attributes);
+
+  /**
+   * @brief Add node calling `matchMessage()` of routing rule
+   */
+  RouteNodeId addRule(const LogRoutingRule& rule);
+
+  RouteNodeId addAnd(RouteNodeId first, RouteNodeId second);
+  RouteNodeId addOr(RouteNodeId first, RouteNodeId second);
+  RouteNodeId addNot(RouteNodeId operand);
+
+  /**
+   * @brief Get built program
+   */
+  const Instruction* getProgram() const { return program; }
+
+  /**
+   * @brief Get number of nodes in built program
+   */
+  size_t getProgramLen() const { return programLen; }
+
+  ~RouteCompiler();
+};
+
+/**
+ * @brief LogRoute compiled into flat program. Results for each
+ * (severity, content type) pair are precomputed, so routes depending only on
+ * these attributes are matched by a single bitset lookup. Other routes
+ * evaluate their program without virtual calls except for custom rules.
+ *
+ * Compiled route does not own routing rules. LogRoute it was compiled from
+ * must be kept alive.
+ */
+class CompiledRoute
+{
+public:
+  using AttributeSet = RouteCompiler::AttributeSet;
+
+private:
+  RouteCompiler::Instruction* program;
+  size_t                      programLen;
+
+  /// Attributes of messages matching route regardless of other fields
+  AttributeSet alwaysSet;
+
+  /// Attributes of messages never matching route
+  AttributeSet neverSet;
+
+  /**
+   * @brief Number of node results kept on stack during evaluation
+   */
+  static constexpr size_t EVAL_STACK_LEN = 64;
+
+  /**
+   * @brief Evaluate program for message with given attributes
+   *
+   * @tparam TValue       `bool` or `RuleMatch`
+   *
+   * @param[in] attribute   Bit of message attributes
+   * @param[in] matchRule   Function evaluating custom routing rule
+   *
+   * @return Result of last program node
+   */
+  template <typename TValue, typename TMatchRule>
+  TValue evaluate(AttributeSet attribute, TMatchRule matchRule) const;
+
+  /**
+   * @brief Evaluate program for message
+   */
+  bool evaluateMessage(const LogMessage& message) const;
+
+public:
+  /**
+   * @brief Create route matching no messages
+   */
+  CompiledRoute();
+
+  // No copying
+  CompiledRoute(const CompiledRoute&)            = delete;
+  CompiledRoute& operator=(const CompiledRoute&) = delete;
+
+  /**
+   * @brief Replace program with compiled route
+   *
+   * @param[in] route   Route to be compiled
+   */
+  void compile(const LogRoute& route);
+
+  /**
+   * @brief Check if message matches route
+   *
+   * @param[in] message   Message to be matched
+   *
+   * @return `true` if message matches route, `false` otherwise
+   */
+  bool matchMessage(const LogMessage& message) const
+  {
+    const AttributeSet attribute =
+        RouteCompiler::getAttributeBit(message.severity, message.contentType);
+
+    if (alwaysSet & attribute)
+      return true;
+    if (neverSet & attribute)
+      return false;
+    return evaluateMessage(message);
+  }
+
+  /**
+   * @brief Check if messages with given severity and content type match
+   * route
+   *
+   * @param[in] severity      Message severity
+   * @param[in] contentType   Message content type
+   *
+   * @return Whether such messages match route
+   */
+  RuleMatch matchAttributes(LogMessage::Severity    severity,
+                            LogMessage::ContentType contentType) const
+  {
+    const AttributeSet attribute =
+        RouteCompiler::getAttributeBit(severity, contentType);
+
+    if (alwaysSet & attribute)
+      return RuleMatch::ALWAYS;
+    if (neverSet & attribute)
+      return RuleMatch::NEVER;
+    return RuleMatch::MAYBE;
+  }
+
+  /**
+   * @brief Check if messages issued from log site match route
+   *
+   * @param[in] site          Log site
+   * @param[in] contentType   Message content type
+   *
+   * @return Whether messages from this site match route
+   */
+  RuleMatch matchSite(const LogSite&          site,
+                      LogMessage::ContentType contentType) const;
+
+  /**
+   * @brief Get number of nodes in compiled program
+   */
+  size_t getProgramLen() const { return programLen; }
+
+  ~CompiledRoute();
+};
+
+} // namespace mklog
+
+#endif /* RouteCompiler.h */
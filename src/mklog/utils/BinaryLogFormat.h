@@ -0,0 +1,165 @@
+/**
+ * @file BinaryLogFormat.h
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Layout of compact binary log files
+ *
+ * @version 0.1
+ * @date 2023-09-17
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#ifndef __MEERKAT_LOGS_UTILS_BINARYLOGFORMAT_H
+#define __MEERKAT_LOGS_UTILS_BINARYLOGFORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace mklog
+{
+
+namespace utils
+{
+
+/**
+ * @brief Binary log file layout: checksummed blocks of tagged entries.
+ * Encoding functions are async-signal-safe.
+ */
+class BinaryLogFormat
+{
+public:
+  // Forbid construction of static class
+  BinaryLogFormat() = delete;
+
+  enum class Tag : uint8_t
+  {
+    SESSION = 1, /// Format version, resets string dictionary
+    STRING  = 2, /// Dictionary string with its id
+    RECORD  = 3, /// Encoded `LogMessage`
+  };
+
+  static constexpr uint32_t VERSION = 1;
+
+  static constexpr uint32_t BLOCK_MAGIC       = 0x4B4C424D; /// "MBLK"
+  static constexpr size_t   BLOCK_HEADER_SIZE = 12;
+
+  /**
+   * @brief Longest accepted block payload
+   */
+  static constexpr size_t PAYLOAD_LEN_MAX = 1u << 30;
+
+  static constexpr size_t VARINT_LEN_MAX = 10;
+
+  /**
+   * @brief Id of string reference which is followed by string itself
+   */
+  static constexpr uint64_t STRING_INLINE = 0;
+
+  /**
+   * @brief Write unsigned LEB128 number
+   *
+   * @param[out] output  Buffer of at least `VARINT_LEN_MAX` bytes
+   * @param[in]  value   Number
+   *
+   * @return Number of written bytes
+   */
+  static size_t encodeVarint(char* output, uint64_t value)
+  {
+    size_t length = 0;
+    while (value >= 0x80)
+    {
+      output[length++] = (char)(value | 0x80);
+      value >>= 7;
+    }
+    output[length++] = (char)value;
+    return length;
+  }
+
+  /**
+   * @brief Read unsigned LEB128 number
+   *
+   * @param[inout] cur     Input position, moved past number
+   * @param[in]    end     End of input
+   * @param[out]   value   Number
+   *
+   * @return `false` if number is truncated or too long
+   */
+  static bool decodeVarint(const char** cur, const char* end,
+                           uint64_t* value)
+  {
+    uint64_t result = 0;
+    for (unsigned shift = 0; shift < 64 && *cur < end; shift += 7)
+    {
+      const uint8_t byte = (uint8_t) * (*cur)++;
+      result |= (uint64_t)(byte & 0x7F) << shift;
+      if ((byte & 0x80) == 0)
+      {
+        *value = result;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  static uint64_t encodeZigzag(int64_t value)
+  {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+  }
+
+  static int64_t decodeZigzag(uint64_t value)
+  {
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+  }
+
+  /**
+   * @brief Write block header
+   *
+   * @param[out] output      Buffer of `BLOCK_HEADER_SIZE` bytes
+   * @param[in]  payloadLen  Length of payload
+   * @param[in]  checksum    CRC-32C of payload
+   */
+  static void encodeBlockHeader(char* output, uint32_t payloadLen,
+                                uint32_t checksum)
+  {
+    encodeUint32(output, BLOCK_MAGIC);
+    encodeUint32(output + 4, payloadLen);
+    encodeUint32(output + 8, checksum);
+  }
+
+  static void encodeUint32(char* output, uint32_t value)
+  {
+    for (size_t i = 0; i < sizeof(value); ++i)
+    {
+      output[i] = (char)(value >> (8 * i));
+    }
+  }
+
+  static uint32_t decodeUint32(const char* input)
+  {
+    uint32_t value = 0;
+    for (size_t i = 0; i < sizeof(value); ++i)
+    {
+      value |= (uint32_t)(uint8_t)input[i] << (8 * i);
+    }
+    return value;
+  }
+
+  static void encodeUint64(char* output, uint64_t value)
+  {
+    encodeUint32(output, (uint32_t)value);
+    encodeUint32(output + 4, (uint32_t)(value >> 32));
+  }
+
+  static uint64_t decodeUint64(const char* input)
+  {
+    return (uint64_t)decodeUint32(input) |
+           (uint64_t)decodeUint32(input + 4) << 32;
+  }
+};
+
+} // namespace utils
+
+} // namespace mklog
+
+#endif /* BinaryLogFormat.h */
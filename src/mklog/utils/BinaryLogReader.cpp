@@ -0,0 +1,336 @@
+#include "mklog/utils/BinaryLogReader.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mklog/utils/BinaryLogFormat.h"
+#include "mklog/utils/CompressedLogReader.h"
+#include "mklog/utils/Crc32c.h"
+
+namespace mklog
+{
+
+namespace utils
+{
+
+/// Largest accepted dictionary id
+static constexpr uint64_t STRING_ID_MAX = 1u << 24;
+
+/// Name of string whose definition was lost with damaged block
+static const char STRING_UNKNOWN[] = "?";
+
+BinaryLogReader::BinaryLogReader()
+    : mapping(nullptr),
+      mappingLen(0),
+      unpacked(),
+      blockCur(nullptr),
+      blockEnd(nullptr),
+      nextBlockOffset(0),
+      prevTimestampNs(0),
+      strings(nullptr),
+      stringCount(0),
+      stringCapacity(0),
+      inlineNames{},
+      inlineNameCapacities{},
+      skippedBlockCount(0)
+{
+}
+
+bool BinaryLogReader::open(const char* filename)
+{
+  close();
+
+  // Damaged compressed blocks are left out, like damaged binary blocks
+  CompressedLogReader compressed;
+  if (compressed.open(filename))
+  {
+    for (size_t i = 0; i < compressed.getBlockCount(); ++i)
+    {
+      compressed.readBlock(i, unpacked);
+    }
+    if (unpacked.length() > 0)
+    {
+      mapping    = unpacked.data();
+      mappingLen = unpacked.length();
+    }
+    return true;
+  }
+
+  const int fd = ::open(filename, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+  {
+    return false;
+  }
+
+  struct stat fileStat = {};
+  if (fstat(fd, &fileStat) != 0)
+  {
+    ::close(fd);
+    return false;
+  }
+
+  // Empty file has no blocks and cannot be mapped
+  if (fileStat.st_size > 0)
+  {
+    void* map = mmap(nullptr, (size_t)fileStat.st_size, PROT_READ,
+                     MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED)
+    {
+      ::close(fd);
+      return false;
+    }
+    mapping    = static_cast<const char*>(map);
+    mappingLen = (size_t)fileStat.st_size;
+    madvise(map, mappingLen, MADV_SEQUENTIAL);
+  }
+
+  ::close(fd);
+  return true;
+}
+
+bool BinaryLogReader::nextBlock()
+{
+  bool   isResyncing = false;
+  size_t offset      = nextBlockOffset;
+  while (offset + BinaryLogFormat::BLOCK_HEADER_SIZE <= mappingLen)
+  {
+    const char* header     = mapping + offset;
+    const char* payload    = header + BinaryLogFormat::BLOCK_HEADER_SIZE;
+    const size_t payloadLen = BinaryLogFormat::decodeUint32(header + 4);
+
+    if (BinaryLogFormat::decodeUint32(header) == BinaryLogFormat::BLOCK_MAGIC &&
+        payloadLen <= mappingLen - (size_t)(payload - mapping) &&
+        Crc32c::compute(payload, payloadLen) ==
+            BinaryLogFormat::decodeUint32(header + 8))
+    {
+      blockCur        = payload;
+      blockEnd        = payload + payloadLen;
+      nextBlockOffset = (size_t)(blockEnd - mapping);
+      prevTimestampNs = 0;
+      return true;
+    }
+
+    // Look for the next block header byte by byte
+    if (!isResyncing)
+    {
+      ++skippedBlockCount;
+      isResyncing = true;
+    }
+    ++offset;
+  }
+
+  blockCur = blockEnd = nullptr;
+  nextBlockOffset     = mappingLen;
+  return false;
+}
+
+bool BinaryLogReader::readString()
+{
+  uint64_t id     = 0;
+  uint64_t length = 0;
+  if (!BinaryLogFormat::decodeVarint(&blockCur, blockEnd, &id) ||
+      !BinaryLogFormat::decodeVarint(&blockCur, blockEnd, &length) ||
+      id == 0 || id > STRING_ID_MAX ||
+      length > (uint64_t)(blockEnd - blockCur))
+  {
+    return false;
+  }
+
+  if (id >= stringCapacity)
+  {
+    uint32_t newCapacity = stringCapacity == 0 ? 64 : stringCapacity;
+    while (newCapacity <= id)
+    {
+      newCapacity *= 2;
+    }
+
+    char** newStrings = new char*[newCapacity]();
+    if (strings != nullptr)
+    {
+      memcpy(newStrings, strings, stringCapacity * sizeof(*strings));
+    }
+    delete[] strings;
+    strings        = newStrings;
+    stringCapacity = newCapacity;
+  }
+
+  delete[] strings[id];
+  strings[id] = new char[length + 1];
+  memcpy(strings[id], blockCur, length);
+  strings[id][length] = '\0';
+  if (id > stringCount)
+  {
+    stringCount = (uint32_t)id;
+  }
+
+  blockCur += length;
+  return true;
+}
+
+bool BinaryLogReader::readStringRef(size_t index, const char** str)
+{
+  uint64_t id = 0;
+  if (!BinaryLogFormat::decodeVarint(&blockCur, blockEnd, &id))
+  {
+    return false;
+  }
+
+  if (id != BinaryLogFormat::STRING_INLINE)
+  {
+    *str = id <= stringCount && strings[id] != nullptr ? strings[id]
+                                                       : STRING_UNKNOWN;
+    return true;
+  }
+
+  uint64_t length = 0;
+  if (!BinaryLogFormat::decodeVarint(&blockCur, blockEnd, &length) ||
+      length > (uint64_t)(blockEnd - blockCur))
+  {
+    return false;
+  }
+
+  if (length + 1 > inlineNameCapacities[index])
+  {
+    delete[] inlineNames[index];
+    inlineNames[index]          = new char[length + 1];
+    inlineNameCapacities[index] = length + 1;
+  }
+  memcpy(inlineNames[index], blockCur, length);
+  inlineNames[index][length] = '\0';
+  blockCur += length;
+
+  *str = inlineNames[index];
+  return true;
+}
+
+bool BinaryLogReader::readRecord(Record* record)
+{
+  using Tag = BinaryLogFormat::Tag;
+
+  while (true)
+  {
+    if (blockCur == blockEnd && !nextBlock())
+    {
+      return false;
+    }
+
+    const Tag tag = (Tag)*blockCur++;
+    if (tag == Tag::SESSION)
+    {
+      uint64_t version = 0;
+      if (BinaryLogFormat::decodeVarint(&blockCur, blockEnd, &version) &&
+          version == BinaryLogFormat::VERSION)
+      {
+        clearStrings();
+        continue;
+      }
+    }
+    else if (tag == Tag::STRING)
+    {
+      if (readString())
+        continue;
+    }
+    else if (tag == Tag::RECORD)
+    {
+      uint64_t timestampDelta = 0;
+      uint64_t longMessageId  = 0;
+      uint64_t line           = 0;
+      uint64_t contentLen     = 0;
+
+      LogMessage& message = record->message;
+      message             = {};
+      bool isValid =
+          BinaryLogFormat::decodeVarint(&blockCur, blockEnd,
+                                        &timestampDelta) &&
+          blockEnd - blockCur >= 3;
+      if (isValid)
+      {
+        message.severity    = (LogMessage::Severity)blockCur[0];
+        message.contentType = (LogMessage::ContentType)blockCur[1];
+        message.part        = (LogMessage::Part)blockCur[2];
+        blockCur += 3;
+
+        isValid = message.severity <= LogMessage::Severity::MAX_LEVEL &&
+                  message.contentType <= LogMessage::ContentType::MAX_TYPE &&
+                  message.part <= LogMessage::Part::END;
+      }
+      if (isValid && message.part != LogMessage::Part::WHOLE)
+      {
+        isValid = BinaryLogFormat::decodeVarint(&blockCur, blockEnd,
+                                                &longMessageId);
+      }
+
+      isValid = isValid && readStringRef(0, &message.source.logger) &&
+                readStringRef(1, &message.source.function) &&
+                readStringRef(2, &message.source.file) &&
+                BinaryLogFormat::decodeVarint(&blockCur, blockEnd, &line) &&
+                BinaryLogFormat::decodeVarint(&blockCur, blockEnd,
+                                              &contentLen) &&
+                contentLen <= (uint64_t)(blockEnd - blockCur);
+      if (isValid)
+      {
+        prevTimestampNs += (uint64_t)BinaryLogFormat::decodeZigzag(
+            timestampDelta);
+
+        message.source.line   = (size_t)line;
+        message.longMessageId = (uint32_t)longMessageId;
+        message.content       = blockCur;
+        message.contentLen    = (size_t)contentLen;
+        blockCur += contentLen;
+
+        record->seconds     = (time_t)(prevTimestampNs / 1000000000);
+        record->nanoseconds = (uint32_t)(prevTimestampNs % 1000000000);
+        return true;
+      }
+    }
+
+    // Block passed checksum but is malformed, rest of it is dropped
+    ++skippedBlockCount;
+    blockCur = blockEnd;
+  }
+}
+
+void BinaryLogReader::clearStrings()
+{
+  for (uint32_t i = 0; i < stringCapacity; ++i)
+  {
+    delete[] strings[i];
+    strings[i] = nullptr;
+  }
+  stringCount = 0;
+}
+
+void BinaryLogReader::close()
+{
+  if (mapping != nullptr && mapping != unpacked.data())
+  {
+    munmap(const_cast<char*>(mapping), mappingLen);
+  }
+  unpacked.clear();
+
+  clearStrings();
+  delete[] strings;
+  for (size_t i = 0; i < sizeof(inlineNames) / sizeof(*inlineNames); ++i)
+  {
+    delete[] inlineNames[i];
+    inlineNames[i]          = nullptr;
+    inlineNameCapacities[i] = 0;
+  }
+
+  mapping           = nullptr;
+  mappingLen        = 0;
+  blockCur          = nullptr;
+  blockEnd          = nullptr;
+  nextBlockOffset   = 0;
+  prevTimestampNs   = 0;
+  strings           = nullptr;
+  stringCapacity    = 0;
+  skippedBlockCount = 0;
+}
+
+} // namespace utils
+
+} // namespace mklog
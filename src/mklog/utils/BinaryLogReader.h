@@ -0,0 +1,132 @@
+/**
+ * @file BinaryLogReader.h
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Decoding of binary log files
+ *
+ * @version 0.1
+ * @date 2023-09-17
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#ifndef __MEERKAT_LOGS_UTILS_BINARYLOGREADER_H
+#define __MEERKAT_LOGS_UTILS_BINARYLOGREADER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+#include "mklog/LogMessage.h"
+#include "mklog/utils/TextBuffer.h"
+
+namespace mklog
+{
+
+namespace utils
+{
+
+/**
+ * @brief Reads records of file written by `BinaryLogWriter`. Damaged
+ * blocks are skipped, reading continues from the next intact block.
+ * Compressed files are decompressed into memory whole.
+ */
+class BinaryLogReader
+{
+public:
+  /**
+   * @brief Decoded record. Strings stay valid until next record is read
+   */
+  struct Record
+  {
+    /// Message without timestamp. Content is not NUL-terminated
+    LogMessage message;
+
+    time_t   seconds;
+    uint32_t nanoseconds;
+  };
+
+private:
+  const char* mapping;
+  size_t      mappingLen;
+
+  /// Content of compressed file, `mapping` points into it then
+  TextBuffer unpacked;
+
+  /// Current block payload, `blockCur` is `nullptr` before first block
+  const char* blockCur;
+  const char* blockEnd;
+  size_t      nextBlockOffset;
+
+  uint64_t prevTimestampNs;
+
+  /// Dictionary strings by id, element 0 is unused
+  char**   strings;
+  uint32_t stringCount;
+  uint32_t stringCapacity;
+
+  /// Copies of names written in place, indexed by logger, function, file
+  char*  inlineNames[3];
+  size_t inlineNameCapacities[3];
+
+  size_t skippedBlockCount;
+
+  /**
+   * @brief Find next intact block and make it current
+   *
+   * @return `false` at end of file
+   */
+  bool nextBlock();
+
+  /**
+   * @brief Process entry defining string
+   */
+  bool readString();
+
+  /**
+   * @brief Read string reference
+   *
+   * @param[in]  index   Name index in `inlineNames`
+   * @param[out] str     Referenced string
+   */
+  bool readStringRef(size_t index, const char** str);
+
+  void clearStrings();
+
+public:
+  BinaryLogReader();
+
+  // No copying
+  BinaryLogReader(const BinaryLogReader&)            = delete;
+  BinaryLogReader& operator=(const BinaryLogReader&) = delete;
+
+  /**
+   * @brief Map log file
+   *
+   * @return `true` if file was opened, `false` otherwise
+   */
+  bool open(const char* filename);
+
+  /**
+   * @brief Read next record
+   *
+   * @param[out] record  Decoded record
+   *
+   * @return `false` at end of file
+   */
+  bool readRecord(Record* record);
+
+  /**
+   * @brief Get number of blocks skipped so far because of damage
+   */
+  size_t getSkippedBlockCount() const { return skippedBlockCount; }
+
+  void close();
+
+  ~BinaryLogReader() { close(); }
+};
+
+} // namespace utils
+
+} // namespace mklog
+
+#endif /* BinaryLogReader.h */
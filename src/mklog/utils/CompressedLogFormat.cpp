@@ -0,0 +1,162 @@
+#include "mklog/utils/CompressedLogFormat.h"
+
+#include <zlib.h>
+
+#include "mklog/utils/Crc32c.h"
+
+namespace mklog
+{
+
+namespace utils
+{
+
+/// Offsets of frame header fields
+static constexpr size_t METHOD_OFFSET     = 4;
+static constexpr size_t FLAGS_OFFSET      = 5;
+static constexpr size_t STORED_LEN_OFFSET = 8;
+static constexpr size_t RAW_LEN_OFFSET    = 12;
+static constexpr size_t CHECKSUM_OFFSET   = 16;
+static constexpr size_t FIRST_TIME_OFFSET = 20;
+static constexpr size_t LAST_TIME_OFFSET  = 28;
+static constexpr size_t COUNTS_OFFSET     = 36;
+static constexpr size_t HEADER_CRC_OFFSET =
+    CompressedLogFormat::FRAME_HEADER_SIZE - 4;
+
+void CompressedLogFormat::BlockSummary::merge(const BlockSummary& other)
+{
+  firstTimeNs = other.firstTimeNs < firstTimeNs ? other.firstTimeNs
+                                                : firstTimeNs;
+  lastTimeNs  = other.lastTimeNs > lastTimeNs ? other.lastTimeNs : lastTimeNs;
+  for (size_t i = 0; i < SEVERITY_COUNT; ++i)
+  {
+    severityCounts[i] += other.severityCounts[i];
+  }
+}
+
+bool CompressedLogFormat::FrameHeader::mayContain(
+    uint64_t fromNs, uint64_t toNs, LogMessage::Severity minSeverity) const
+{
+  if ((flags & FLAG_UNINDEXED) != 0)
+  {
+    return true;
+  }
+  if (summary.lastTimeNs < fromNs || summary.firstTimeNs > toNs)
+  {
+    return false;
+  }
+
+  for (size_t i = (size_t)minSeverity; i < SEVERITY_COUNT; ++i)
+  {
+    if (summary.severityCounts[i] != 0)
+      return true;
+  }
+  return false;
+}
+
+void CompressedLogFormat::encodeFrameHeader(char*              output,
+                                            const FrameHeader& header)
+{
+  BinaryLogFormat::encodeUint32(output, FRAME_MAGIC);
+  output[METHOD_OFFSET]    = (char)header.method;
+  output[FLAGS_OFFSET]     = (char)header.flags;
+  output[FLAGS_OFFSET + 1] = 0;
+  output[FLAGS_OFFSET + 2] = 0;
+  BinaryLogFormat::encodeUint32(output + STORED_LEN_OFFSET, header.storedLen);
+  BinaryLogFormat::encodeUint32(output + RAW_LEN_OFFSET, header.rawLen);
+  BinaryLogFormat::encodeUint32(output + CHECKSUM_OFFSET, header.checksum);
+  BinaryLogFormat::encodeUint64(output + FIRST_TIME_OFFSET,
+                                header.summary.firstTimeNs);
+  BinaryLogFormat::encodeUint64(output + LAST_TIME_OFFSET,
+                                header.summary.lastTimeNs);
+  for (size_t i = 0; i < SEVERITY_COUNT; ++i)
+  {
+    BinaryLogFormat::encodeUint32(output + COUNTS_OFFSET + 4 * i,
+                                  header.summary.severityCounts[i]);
+  }
+  BinaryLogFormat::encodeUint32(output + HEADER_CRC_OFFSET,
+                                Crc32c::compute(output, HEADER_CRC_OFFSET));
+}
+
+bool CompressedLogFormat::decodeFrameHeader(const char*  input,
+                                            FrameHeader* header)
+{
+  if (BinaryLogFormat::decodeUint32(input) != FRAME_MAGIC ||
+      BinaryLogFormat::decodeUint32(input + HEADER_CRC_OFFSET) !=
+          Crc32c::compute(input, HEADER_CRC_OFFSET))
+  {
+    return false;
+  }
+
+  header->method    = (Method)input[METHOD_OFFSET];
+  header->flags     = (uint8_t)input[FLAGS_OFFSET];
+  header->storedLen = BinaryLogFormat::decodeUint32(input + STORED_LEN_OFFSET);
+  header->rawLen    = BinaryLogFormat::decodeUint32(input + RAW_LEN_OFFSET);
+  header->checksum  = BinaryLogFormat::decodeUint32(input + CHECKSUM_OFFSET);
+  header->summary.firstTimeNs =
+      BinaryLogFormat::decodeUint64(input + FIRST_TIME_OFFSET);
+  header->summary.lastTimeNs =
+      BinaryLogFormat::decodeUint64(input + LAST_TIME_OFFSET);
+  for (size_t i = 0; i < SEVERITY_COUNT; ++i)
+  {
+    header->summary.severityCounts[i] =
+        BinaryLogFormat::decodeUint32(input + COUNTS_OFFSET + 4 * i);
+  }
+
+  return (header->method == Method::STORED ||
+          header->method == Method::DEFLATE ||
+          header->method == Method::INDEX) &&
+         header->rawLen <= BLOCK_LEN_MAX &&
+         (header->method != Method::STORED ||
+          header->storedLen == header->rawLen);
+}
+
+void CompressedLogFormat::encodeTrailer(char* output, uint64_t indexOffset)
+{
+  BinaryLogFormat::encodeUint64(output, indexOffset);
+  BinaryLogFormat::encodeUint32(output + 8, TRAILER_MAGIC);
+  BinaryLogFormat::encodeUint32(output + 12, Crc32c::compute(output, 12));
+}
+
+bool CompressedLogFormat::decodeTrailer(const char* input,
+                                        uint64_t*   indexOffset)
+{
+  if (BinaryLogFormat::decodeUint32(input + 8) != TRAILER_MAGIC ||
+      BinaryLogFormat::decodeUint32(input + 12) != Crc32c::compute(input, 12))
+  {
+    return false;
+  }
+
+  *indexOffset = BinaryLogFormat::decodeUint64(input);
+  return true;
+}
+
+size_t CompressedLogFormat::getCompressedLenMax(size_t rawLen)
+{
+  return compressBound((uLong)rawLen);
+}
+
+size_t CompressedLogFormat::compress(char* output, const char* input,
+                                     size_t length, int level)
+{
+  uLongf compressedLen = compressBound((uLong)length);
+  const int result     = compress2(reinterpret_cast<Bytef*>(output),
+                                   &compressedLen,
+                                   reinterpret_cast<const Bytef*>(input),
+                                   (uLong)length, level);
+  return result == Z_OK ? (size_t)compressedLen : 0;
+}
+
+bool CompressedLogFormat::decompress(char* output, size_t rawLen,
+                                     const char* input, size_t length)
+{
+  uLongf    decompressedLen = (uLongf)rawLen;
+  uLong     inputLen        = (uLong)length;
+  const int result =
+      uncompress2(reinterpret_cast<Bytef*>(output), &decompressedLen,
+                  reinterpret_cast<const Bytef*>(input), &inputLen);
+  return result == Z_OK && decompressedLen == rawLen && inputLen == length;
+}
+
+} // namespace utils
+
+} // namespace mklog
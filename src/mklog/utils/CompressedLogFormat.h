@@ -0,0 +1,195 @@
+/**
+ * @file CompressedLogFormat.h
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Layout of log files compressed in independent blocks
+ *
+ * @version 0.1
+ * @date 2023-09-18
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#ifndef __MEERKAT_LOGS_UTILS_COMPRESSEDLOGFORMAT_H
+#define __MEERKAT_LOGS_UTILS_COMPRESSEDLOGFORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "mklog/LogMessage.h"
+#include "mklog/utils/BinaryLogFormat.h"
+
+namespace mklog
+{
+
+namespace utils
+{
+
+/**
+ * @brief Compressed log file layout: frames of independently compressed
+ * blocks, followed by index of blocks and trailer when file is closed.
+ */
+class CompressedLogFormat
+{
+public:
+  // Forbid construction of static class
+  CompressedLogFormat() = delete;
+
+  enum class Method : uint8_t
+  {
+    STORED  = 0, /// Block is not compressed
+    DEFLATE = 1, /// Block is zlib stream
+    INDEX   = 2, /// Offsets and headers of blocks of session
+  };
+
+  static constexpr uint32_t FRAME_MAGIC   = 0x464B434D; /// "MCKF"
+  static constexpr uint32_t TRAILER_MAGIC = 0x494B434D; /// "MCKI"
+
+  /// Frame is written by crash handler and left out of index
+  static constexpr uint8_t FLAG_UNINDEXED = 1;
+
+  static constexpr size_t SEVERITY_COUNT =
+      (size_t)LogMessage::Severity::MAX_LEVEL + 1;
+
+  static constexpr size_t FRAME_HEADER_SIZE = 40 + 4 * SEVERITY_COUNT;
+  static constexpr size_t INDEX_HEADER_SIZE = 12;
+  static constexpr size_t INDEX_ENTRY_SIZE  = 8 + FRAME_HEADER_SIZE;
+  static constexpr size_t TRAILER_SIZE      = 16;
+
+  /**
+   * @brief Longest accepted decompressed block
+   */
+  static constexpr size_t BLOCK_LEN_MAX = 1u << 30;
+
+  /**
+   * @brief Messages of block, used to choose blocks without decompressing
+   * them
+   */
+  struct BlockSummary
+  {
+    uint64_t firstTimeNs;
+    uint64_t lastTimeNs;
+    uint32_t severityCounts[SEVERITY_COUNT];
+
+    /**
+     * @brief Account message in summary
+     */
+    void add(LogMessage::Severity severity, uint64_t timeNs)
+    {
+      firstTimeNs = timeNs < firstTimeNs ? timeNs : firstTimeNs;
+      lastTimeNs  = timeNs > lastTimeNs ? timeNs : lastTimeNs;
+      if ((size_t)severity < SEVERITY_COUNT)
+      {
+        ++severityCounts[(size_t)severity];
+      }
+    }
+
+    /**
+     * @brief Account messages of other summary
+     */
+    void merge(const BlockSummary& other);
+
+    bool isEmpty() const
+    {
+      for (uint32_t count : severityCounts)
+      {
+        if (count != 0)
+          return false;
+      }
+      return true;
+    }
+  };
+
+  static constexpr BlockSummary BLOCK_SUMMARY_EMPTY = {
+      .firstTimeNs = UINT64_MAX, .lastTimeNs = 0, .severityCounts = {}};
+
+  struct FrameHeader
+  {
+    Method       method;
+    uint8_t      flags;
+    uint32_t     storedLen;
+    uint32_t     rawLen;
+    uint32_t     checksum; /// CRC-32C of stored payload
+    BlockSummary summary;
+
+    /**
+     * @brief Check if block may contain messages from time range with at
+     * least given severity
+     *
+     * @param[in] fromNs       Start of range, in nanoseconds since Epoch
+     * @param[in] toNs         End of range, inclusive
+     * @param[in] minSeverity  Least severity
+     */
+    bool mayContain(uint64_t fromNs, uint64_t toNs,
+                    LogMessage::Severity minSeverity) const;
+  };
+
+  /**
+   * @brief Write frame header. Async-signal-safe
+   *
+   * @param[out] output  Buffer of `FRAME_HEADER_SIZE` bytes
+   * @param[in]  header  Frame header
+   */
+  static void encodeFrameHeader(char* output, const FrameHeader& header);
+
+  /**
+   * @brief Read frame header
+   *
+   * @param[in]  input   `FRAME_HEADER_SIZE` bytes of header
+   * @param[out] header  Decoded header
+   *
+   * @return `false` if header is damaged
+   */
+  static bool decodeFrameHeader(const char* input, FrameHeader* header);
+
+  /**
+   * @brief Write file trailer
+   *
+   * @param[out] output       Buffer of `TRAILER_SIZE` bytes
+   * @param[in]  indexOffset  Offset of index frame
+   */
+  static void encodeTrailer(char* output, uint64_t indexOffset);
+
+  /**
+   * @brief Read file trailer
+   *
+   * @return `false` if trailer is damaged
+   */
+  static bool decodeTrailer(const char* input, uint64_t* indexOffset);
+
+  /**
+   * @brief Get buffer size sufficient for compressed block
+   */
+  static size_t getCompressedLenMax(size_t rawLen);
+
+  /**
+   * @brief Compress block with deflate
+   *
+   * @param[out] output     Buffer of `getCompressedLenMax()` bytes
+   * @param[in]  input      Block
+   * @param[in]  length     Block length
+   * @param[in]  level      Compression level, 1 to 9
+   *
+   * @return Length of compressed block, zero on failure
+   */
+  static size_t compress(char* output, const char* input, size_t length,
+                         int level);
+
+  /**
+   * @brief Decompress deflate block
+   *
+   * @param[out] output     Buffer of `rawLen` bytes
+   * @param[in]  rawLen     Length of decompressed block
+   * @param[in]  input      Compressed block
+   * @param[in]  length     Compressed block length
+   *
+   * @return `true` if block was decompressed to exactly `rawLen` bytes
+   */
+  static bool decompress(char* output, size_t rawLen, const char* input,
+                         size_t length);
+};
+
+} // namespace utils
+
+} // namespace mklog
+
+#endif /* CompressedLogFormat.h */
@@ -0,0 +1,248 @@
+#include "mklog/utils/CompressedLogReader.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mklog/utils/Crc32c.h"
+
+namespace mklog
+{
+
+namespace utils
+{
+
+using FrameHeader = CompressedLogFormat::FrameHeader;
+
+bool CompressedLogReader::open(const char* filename)
+{
+  close();
+
+  const int fd = ::open(filename, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+  {
+    return false;
+  }
+
+  struct stat fileStat = {};
+  if (fstat(fd, &fileStat) != 0 ||
+      (size_t)fileStat.st_size < CompressedLogFormat::FRAME_HEADER_SIZE)
+  {
+    ::close(fd);
+    return false;
+  }
+
+  void* map = mmap(nullptr, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE,
+                   fd, 0);
+  ::close(fd);
+  if (map == MAP_FAILED)
+  {
+    return false;
+  }
+  mapping    = static_cast<const char*>(map);
+  mappingLen = (size_t)fileStat.st_size;
+
+  FrameHeader firstHeader = {};
+  if (!CompressedLogFormat::decodeFrameHeader(mapping, &firstHeader))
+  {
+    close();
+    return false;
+  }
+
+  // Earlier sessions are found by scanning, indexed one follows them
+  uint64_t sessionStart = 0;
+  if (readIndex(&sessionStart))
+  {
+    Block* indexed = blocks;
+    blocks         = nullptr;
+    blockCount     = 0;
+    blockCapacity  = 0;
+
+    scanFrames(0, sessionStart);
+    for (size_t i = 0; i < indexedBlockCount; ++i)
+    {
+      addBlock(indexed[i].offset, indexed[i].header);
+    }
+    delete[] indexed;
+  }
+  else
+  {
+    scanFrames(0, mappingLen);
+  }
+
+  return true;
+}
+
+void CompressedLogReader::addBlock(uint64_t           offset,
+                                   const FrameHeader& header)
+{
+  if (blockCount == blockCapacity)
+  {
+    const size_t newCapacity = blockCapacity > 0 ? 2 * blockCapacity : 64;
+    Block*       newBlocks   = new Block[newCapacity];
+    if (blockCount > 0)
+    {
+      memcpy(newBlocks, blocks, blockCount * sizeof(*blocks));
+    }
+    delete[] blocks;
+    blocks        = newBlocks;
+    blockCapacity = newCapacity;
+  }
+
+  blocks[blockCount++] = {.offset = offset, .header = header};
+}
+
+bool CompressedLogReader::readFrameHeader(uint64_t     offset,
+                                          FrameHeader* header) const
+{
+  return offset + CompressedLogFormat::FRAME_HEADER_SIZE <= mappingLen &&
+         CompressedLogFormat::decodeFrameHeader(mapping + offset, header) &&
+         header->storedLen <= mappingLen - offset -
+                                  CompressedLogFormat::FRAME_HEADER_SIZE;
+}
+
+bool CompressedLogReader::isPayloadIntact(const Block& block) const
+{
+  const char* payload =
+      mapping + block.offset + CompressedLogFormat::FRAME_HEADER_SIZE;
+  return Crc32c::compute(payload, block.header.storedLen) ==
+         block.header.checksum;
+}
+
+bool CompressedLogReader::readIndex(uint64_t* sessionStart)
+{
+  uint64_t indexOffset = 0;
+  if (mappingLen < CompressedLogFormat::TRAILER_SIZE ||
+      !CompressedLogFormat::decodeTrailer(
+          mapping + mappingLen - CompressedLogFormat::TRAILER_SIZE,
+          &indexOffset))
+  {
+    return false;
+  }
+
+  Block index = {.offset = indexOffset, .header = {}};
+  if (indexOffset >= mappingLen || !readFrameHeader(indexOffset, &index.header) ||
+      index.header.method != CompressedLogFormat::Method::INDEX ||
+      index.header.storedLen < CompressedLogFormat::INDEX_HEADER_SIZE ||
+      !isPayloadIntact(index))
+  {
+    return false;
+  }
+
+  const char* payload =
+      mapping + indexOffset + CompressedLogFormat::FRAME_HEADER_SIZE;
+  const uint64_t start      = BinaryLogFormat::decodeUint64(payload);
+  const uint32_t entryCount = BinaryLogFormat::decodeUint32(payload + 8);
+  if (start > indexOffset ||
+      index.header.storedLen != CompressedLogFormat::INDEX_HEADER_SIZE +
+                                    (uint64_t)entryCount *
+                                        CompressedLogFormat::INDEX_ENTRY_SIZE)
+  {
+    return false;
+  }
+
+  const char* entry = payload + CompressedLogFormat::INDEX_HEADER_SIZE;
+  for (uint32_t i = 0; i < entryCount;
+       ++i, entry += CompressedLogFormat::INDEX_ENTRY_SIZE)
+  {
+    const uint64_t offset = BinaryLogFormat::decodeUint64(entry);
+    FrameHeader    header = {};
+    if (offset < start || offset >= indexOffset ||
+        !CompressedLogFormat::decodeFrameHeader(entry + sizeof(offset),
+                                                &header))
+    {
+      continue;
+    }
+    addBlock(offset, header);
+  }
+
+  *sessionStart     = start;
+  indexedBlockCount = blockCount;
+  return true;
+}
+
+void CompressedLogReader::scanFrames(uint64_t start, uint64_t end)
+{
+  char magic[sizeof(uint32_t)] = {};
+  BinaryLogFormat::encodeUint32(magic, CompressedLogFormat::FRAME_MAGIC);
+
+  uint64_t offset = start;
+  while (offset + CompressedLogFormat::FRAME_HEADER_SIZE <= end)
+  {
+    FrameHeader header = {};
+    if (readFrameHeader(offset, &header))
+    {
+      if (header.method != CompressedLogFormat::Method::INDEX)
+      {
+        addBlock(offset, header);
+      }
+      offset += CompressedLogFormat::FRAME_HEADER_SIZE + header.storedLen;
+      continue;
+    }
+
+    uint64_t indexOffset = 0;
+    if (offset + CompressedLogFormat::TRAILER_SIZE <= end &&
+        CompressedLogFormat::decodeTrailer(mapping + offset, &indexOffset))
+    {
+      offset += CompressedLogFormat::TRAILER_SIZE;
+      continue;
+    }
+
+    // Frame is damaged or was cut short by crash, resume at next magic
+    const void* next = memmem(mapping + offset + 1, end - offset - 1, magic,
+                              sizeof(magic));
+    if (next == nullptr)
+    {
+      break;
+    }
+    offset = (uint64_t)(static_cast<const char*>(next) - mapping);
+  }
+}
+
+bool CompressedLogReader::readBlock(size_t index, TextBuffer& output) const
+{
+  const Block& block = blocks[index];
+  if (!isPayloadIntact(block))
+  {
+    return false;
+  }
+
+  const char* payload =
+      mapping + block.offset + CompressedLogFormat::FRAME_HEADER_SIZE;
+  if (block.header.method == CompressedLogFormat::Method::STORED)
+  {
+    output.append(payload, block.header.storedLen);
+    return true;
+  }
+
+  output.reserve(block.header.rawLen);
+  if (!CompressedLogFormat::decompress(output.tail(), block.header.rawLen,
+                                       payload, block.header.storedLen))
+  {
+    return false;
+  }
+  output.extend(block.header.rawLen);
+  return true;
+}
+
+void CompressedLogReader::close()
+{
+  if (mapping != nullptr)
+  {
+    munmap(const_cast<char*>(mapping), mappingLen);
+  }
+  delete[] blocks;
+
+  mapping           = nullptr;
+  mappingLen        = 0;
+  blocks            = nullptr;
+  blockCount        = 0;
+  blockCapacity     = 0;
+  indexedBlockCount = 0;
+}
+
+} // namespace utils
+
+} // namespace mklog
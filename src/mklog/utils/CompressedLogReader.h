@@ -0,0 +1,145 @@
+/**
+ * @file CompressedLogReader.h
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Random access to blocks of compressed log file
+ *
+ * @version 0.1
+ * @date 2023-09-18
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#ifndef __MEERKAT_LOGS_UTILS_COMPRESSEDLOGREADER_H
+#define __MEERKAT_LOGS_UTILS_COMPRESSEDLOGREADER_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "mklog/utils/CompressedLogFormat.h"
+#include "mklog/utils/TextBuffer.h"
+
+namespace mklog
+{
+
+namespace utils
+{
+
+/**
+ * @brief Lists blocks of file in format described by `CompressedLogFormat`
+ * and decompresses them on request. Blocks are taken from index written
+ * when file was closed; blocks of sessions which have no index, e.g. ones
+ * of crashed process, are found by scanning frame headers. Damaged frames
+ * are skipped.
+ */
+class CompressedLogReader
+{
+public:
+  /**
+   * @brief Block found in file
+   */
+  struct Block
+  {
+    uint64_t                         offset; /// Offset of frame header
+    CompressedLogFormat::FrameHeader header;
+  };
+
+private:
+  const char* mapping;
+  size_t      mappingLen;
+
+  Block* blocks;
+  size_t blockCount;
+  size_t blockCapacity;
+
+  /// Number of blocks taken from index rather than found by scanning
+  size_t indexedBlockCount;
+
+  void addBlock(uint64_t offset, const CompressedLogFormat::FrameHeader& header);
+
+  /**
+   * @brief Read header of complete frame
+   *
+   * @return `false` if there is no intact frame header at offset or frame
+   * exceeds end of file
+   */
+  bool readFrameHeader(uint64_t offset,
+                       CompressedLogFormat::FrameHeader* header) const;
+
+  /**
+   * @brief Check stored payload of frame against its checksum
+   */
+  bool isPayloadIntact(const Block& block) const;
+
+  /**
+   * @brief Add blocks listed in index of the last session
+   *
+   * @param[out] sessionStart   Offset of the first block of session
+   *
+   * @return `false` if file has no intact index at its end
+   */
+  bool readIndex(uint64_t* sessionStart);
+
+  /**
+   * @brief Add blocks found by walking frames in part of file
+   *
+   * @param[in] start   Offset of the first frame
+   * @param[in] end     End of scanned part
+   */
+  void scanFrames(uint64_t start, uint64_t end);
+
+public:
+  CompressedLogReader()
+      : mapping(nullptr),
+        mappingLen(0),
+        blocks(nullptr),
+        blockCount(0),
+        blockCapacity(0),
+        indexedBlockCount(0)
+  {
+  }
+
+  // No copying
+  CompressedLogReader(const CompressedLogReader&)            = delete;
+  CompressedLogReader& operator=(const CompressedLogReader&) = delete;
+
+  /**
+   * @brief Map file and list its blocks
+   *
+   * @param[in] filename  Log file name
+   *
+   * @return `true` if file is compressed log, `false` otherwise
+   */
+  bool open(const char* filename);
+
+  size_t getBlockCount() const { return blockCount; }
+
+  /**
+   * @brief Get block by index. Blocks are ordered by offset
+   */
+  const Block& getBlock(size_t index) const { return blocks[index]; }
+
+  /**
+   * @brief Get number of blocks which were listed in index
+   */
+  size_t getIndexedBlockCount() const { return indexedBlockCount; }
+
+  /**
+   * @brief Decompress block and append it to buffer
+   *
+   * @param[in]    index   Block index
+   * @param[inout] output  Buffer receiving block content
+   *
+   * @return `false` if block is damaged, buffer is not changed then
+   */
+  bool readBlock(size_t index, TextBuffer& output) const;
+
+  void close();
+
+  ~CompressedLogReader() { close(); }
+};
+
+} // namespace utils
+
+} // namespace mklog
+
+#endif /* CompressedLogReader.h */
@@ -0,0 +1,85 @@
+#include "mklog/utils/Crc32c.h"
+
+#include <cstring>
+#include <nmmintrin.h>
+
+namespace mklog
+{
+
+namespace utils
+{
+
+/// Reflected Castagnoli polynomial
+static constexpr uint32_t POLYNOMIAL = 0x82F63B78;
+
+struct CrcTable
+{
+  uint32_t entries[256];
+};
+
+static constexpr CrcTable makeCrcTable()
+{
+  CrcTable table = {};
+  for (uint32_t byte = 0; byte < 256; ++byte)
+  {
+    uint32_t crc = byte;
+    for (int bit = 0; bit < 8; ++bit)
+    {
+      crc = (crc & 1) != 0 ? (crc >> 1) ^ POLYNOMIAL : crc >> 1;
+    }
+    table.entries[byte] = crc;
+  }
+  return table;
+}
+
+static constexpr CrcTable CRC_TABLE = makeCrcTable();
+
+static uint32_t updateScalar(uint32_t crc, const void* data, size_t length)
+{
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+  crc = ~crc;
+  for (size_t i = 0; i < length; ++i)
+  {
+    crc = CRC_TABLE.entries[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+__attribute__((target("sse4.2"))) static uint32_t
+updateSse42(uint32_t crc, const void* data, size_t length)
+{
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+  uint64_t state = ~crc;
+  for (; length >= sizeof(uint64_t); length -= sizeof(uint64_t))
+  {
+    uint64_t word = 0;
+    memcpy(&word, bytes, sizeof(word));
+    state = _mm_crc32_u64(state, word);
+    bytes += sizeof(word);
+  }
+
+  uint32_t tail = (uint32_t)state;
+  for (; length > 0; --length)
+  {
+    tail = _mm_crc32_u8(tail, *bytes++);
+  }
+  return ~tail;
+}
+
+std::atomic<Crc32c::UpdateFunction> Crc32c::s_updateFunction(
+    &Crc32c::updateFirstCall);
+
+uint32_t Crc32c::updateFirstCall(uint32_t crc, const void* data,
+                                 size_t length)
+{
+  const UpdateFunction update =
+      __builtin_cpu_supports("sse4.2") ? &updateSse42 : &updateScalar;
+  s_updateFunction.store(update, std::memory_order_relaxed);
+  return update(crc, data, length);
+}
+
+} // namespace utils
+
+} // namespace mklog
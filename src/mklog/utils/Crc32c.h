@@ -0,0 +1,81 @@
+/**
+ * @file Crc32c.h
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief CRC-32C checksum of record data
+ *
+ * @version 0.1
+ * @date 2023-09-15
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#ifndef __MEERKAT_LOGS_UTILS_CRC32C_H
+#define __MEERKAT_LOGS_UTILS_CRC32C_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace mklog
+{
+
+namespace utils
+{
+
+/**
+ * @brief Computes CRC-32C (Castagnoli) checksums, with SSE4.2 `crc32`
+ * instruction if CPU supports it. Async-signal-safe
+ */
+class Crc32c
+{
+private:
+  using UpdateFunction = uint32_t (*)(uint32_t crc, const void* data,
+                                      size_t length);
+
+  /**
+   * @brief Selected implementation. Resolved on first call
+   */
+  static std::atomic<UpdateFunction> s_updateFunction;
+
+  static uint32_t updateFirstCall(uint32_t crc, const void* data,
+                                  size_t length);
+
+public:
+  // Forbid construction of static class
+  Crc32c() = delete;
+
+  /**
+   * @brief Checksum of empty data
+   */
+  static constexpr uint32_t CRC_INITIAL = 0;
+
+  /**
+   * @brief Extend checksum with more data. Checksum of several pieces
+   * equals checksum of their concatenation
+   *
+   * @param[in] crc     Checksum of preceding data, `CRC_INITIAL` if none
+   * @param[in] data    Data
+   * @param[in] length  Data length
+   *
+   * @return Checksum of preceding data followed by `data`
+   */
+  static uint32_t update(uint32_t crc, const void* data, size_t length)
+  {
+    return s_updateFunction.load(std::memory_order_relaxed)(crc, data,
+                                                            length);
+  }
+
+  /**
+   * @brief Compute checksum of data
+   */
+  static uint32_t compute(const void* data, size_t length)
+  {
+    return update(CRC_INITIAL, data, length);
+  }
+};
+
+} // namespace utils
+
+} // namespace mklog
+
+#endif /* Crc32c.h */
@@ -0,0 +1,254 @@
+#include "mklog/utils/DeferredArgs.h"
+
+#include <cstring>
+
+// Conversion specifications are taken from format strings checked at
+// compile time, so they are safe to pass as non-literal formats
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+#pragma GCC diagnostic ignored "-Wformat-security"
+
+namespace mklog
+{
+
+namespace utils
+{
+
+/// Longest conversion specification which is rendered
+static constexpr size_t CONVERSION_LEN_MAX = 32;
+
+static constexpr char CONVERSION_FLAGS[]     = "-+ #0'I";
+static constexpr char CONVERSION_MODIFIERS[] = "hlLqjzt";
+
+/**
+ * @brief Reader of encoded arguments
+ */
+struct ArgReader
+{
+  const char* cur;
+  const char* end;
+
+  bool hasArg() const { return cur < end; }
+
+  DeferredArgs::ArgType peekType() const
+  {
+    return (DeferredArgs::ArgType)*cur;
+  }
+
+  template <typename TValue>
+  bool read(TValue* value)
+  {
+    if (end - cur < (ptrdiff_t)(1 + sizeof(TValue)))
+    {
+      cur = end;
+      return false;
+    }
+
+    memcpy(value, cur + 1, sizeof(TValue));
+    cur += 1 + sizeof(TValue);
+    return true;
+  }
+
+  bool readString(const char** str)
+  {
+    using StringLen = DeferredArgs::StringLen;
+
+    StringLen len = 0;
+    if (!read(&len) || end - cur < (ptrdiff_t)len)
+    {
+      cur = end;
+      return false;
+    }
+
+    *str = len > 0 ? cur : nullptr;
+    cur += len;
+    return true;
+  }
+};
+
+template <typename TValue>
+static void renderConversion(TextBuffer& output, const char* conversion,
+                             const int* stars, size_t starCount, TValue value)
+{
+  switch (starCount)
+  {
+  case 0:
+    output.appendf(conversion, value);
+    break;
+  case 1:
+    output.appendf(conversion, stars[0], value);
+    break;
+  default:
+    output.appendf(conversion, stars[0], stars[1], value);
+    break;
+  }
+}
+
+template <typename TValue>
+static void renderConversion(SignalSafeWriter& output, const char* conversion,
+                             const int* stars, size_t starCount, TValue value)
+{
+  output.appendConversion(conversion, stars, starCount, value);
+}
+
+/**
+ * @brief Render single conversion with next encoded argument
+ *
+ * @return `false` if there is no suitable argument
+ */
+template <typename TOutput>
+static bool renderArg(TOutput& output, const char* conversion,
+                      const int* stars, size_t starCount, ArgReader& reader)
+{
+  using ArgType = DeferredArgs::ArgType;
+
+  if (!reader.hasArg())
+  {
+    return false;
+  }
+
+#define RENDER_VALUE(type)                                                     \
+  {                                                                            \
+    type value = {};                                                           \
+    if (!reader.read(&value))                                                  \
+      return false;                                                            \
+    renderConversion(output, conversion, stars, starCount, value);            \
+    return true;                                                               \
+  }
+
+  switch (reader.peekType())
+  {
+  case ArgType::INT:                RENDER_VALUE(int)
+  case ArgType::UNSIGNED:           RENDER_VALUE(unsigned)
+  case ArgType::LONG:               RENDER_VALUE(long)
+  case ArgType::UNSIGNED_LONG:      RENDER_VALUE(unsigned long)
+  case ArgType::LONG_LONG:          RENDER_VALUE(long long)
+  case ArgType::UNSIGNED_LONG_LONG: RENDER_VALUE(unsigned long long)
+  case ArgType::DOUBLE:             RENDER_VALUE(double)
+  case ArgType::LONG_DOUBLE:        RENDER_VALUE(long double)
+  case ArgType::POINTER:            RENDER_VALUE(const void*)
+  case ArgType::STRING_COPY:
+  {
+    const char* str = nullptr;
+    if (!reader.readString(&str))
+      return false;
+    renderConversion(output, conversion, stars, starCount, str);
+    return true;
+  }
+  default:
+    reader.cur = reader.end;
+    return false;
+  }
+
+#undef RENDER_VALUE
+}
+
+/**
+ * @brief Render format string to any output providing `append()` and
+ * matching `renderConversion()` overload
+ */
+template <typename TOutput>
+static void renderFormat(TOutput& output, const char* format,
+                         const char* args, size_t argsLen)
+{
+  using ArgType = DeferredArgs::ArgType;
+
+  ArgReader reader = {.cur = args, .end = args + argsLen};
+
+  const char* cur = format;
+  while (*cur != '\0')
+  {
+    // Copy plain text up to next conversion
+    const char* percent = strchr(cur, '%');
+    if (percent == nullptr)
+    {
+      output.append(cur, strlen(cur));
+      break;
+    }
+    output.append(cur, percent - cur);
+
+    if (percent[1] == '%')
+    {
+      output.append('%');
+      cur = percent + 2;
+      continue;
+    }
+
+    // Find end of conversion specification
+    int    stars[2]  = {};
+    size_t starCount = 0;
+    bool   isValid   = true;
+
+    const char* specEnd = percent + 1;
+    specEnd += strspn(specEnd, CONVERSION_FLAGS);
+    for (int part = 0; part < 2; ++part)
+    {
+      if (part == 1)
+      {
+        if (*specEnd != '.')
+          break;
+        ++specEnd;
+      }
+
+      if (*specEnd == '*')
+      {
+        isValid = isValid && reader.hasArg() &&
+                  reader.peekType() == ArgType::INT &&
+                  reader.read(&stars[starCount]);
+        ++starCount;
+        ++specEnd;
+      }
+      else
+      {
+        specEnd += strspn(specEnd, "0123456789");
+      }
+    }
+    specEnd += strspn(specEnd, CONVERSION_MODIFIERS);
+
+    if (*specEnd == '\0')
+    {
+      output.append(percent, specEnd - percent);
+      break;
+    }
+    ++specEnd;
+
+    // Copy specification into separate format string
+    const size_t specLen = specEnd - percent;
+    char         conversion[CONVERSION_LEN_MAX + 1] = "";
+    isValid = isValid && specLen <= CONVERSION_LEN_MAX;
+    if (isValid)
+    {
+      memcpy(conversion, percent, specLen);
+      conversion[specLen] = '\0';
+    }
+
+    // '%n' stores to memory and is never rendered
+    if (specEnd[-1] == 'n')
+    {
+      const void* ignored = nullptr;
+      reader.read(&ignored);
+    }
+    else if (!isValid ||
+             !renderArg(output, conversion, stars, starCount, reader))
+    {
+      output.append(percent, specLen);
+    }
+
+    cur = specEnd;
+  }
+}
+
+void DeferredArgs::render(TextBuffer& output, const char* format,
+                          const char* args, size_t argsLen)
+{
+  renderFormat(output, format, args, argsLen);
+}
+
+void DeferredArgs::render(SignalSafeWriter& output, const char* format,
+                          const char* args, size_t argsLen)
+{
+  renderFormat(output, format, args, argsLen);
+}
+
+} // namespace utils
+
+} // namespace mklog
@@ -0,0 +1,235 @@
+/**
+ * @file DeferredArgs.h
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Binary capture of printf arguments for deferred formatting
+ *
+ * @version 0.1
+ * @date 2023-09-05
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#ifndef __MEERKAT_LOGS_UTILS_DEFERREDARGS_H
+#define __MEERKAT_LOGS_UTILS_DEFERREDARGS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "mklog/utils/SignalSafeWriter.h"
+#include "mklog/utils/TextBuffer.h"
+
+namespace mklog
+{
+
+namespace utils
+{
+
+/**
+ * @brief Encoder and renderer of printf arguments. Arguments are stored as
+ * a sequence of one-byte type tag followed by argument value after default
+ * argument promotion. Text is produced only when `render()` is called.
+ *
+ * String arguments, including character arrays, are copied, since their
+ * storage may be reused before message is rendered. Only format string is
+ * stored by address.
+ */
+class DeferredArgs
+{
+public:
+  /**
+   * @brief Type of encoded argument
+   */
+  enum class ArgType : uint8_t
+  {
+    INT,
+    UNSIGNED,
+    LONG,
+    UNSIGNED_LONG,
+    LONG_LONG,
+    UNSIGNED_LONG_LONG,
+    DOUBLE,
+    LONG_DOUBLE,
+    POINTER,
+    STRING_COPY,
+  };
+
+  using StringLen = uint32_t;
+
+private:
+  /**
+   * @brief Type of argument after default argument promotion
+   */
+  template <typename TArg, typename = void>
+  struct Promoted
+  {
+    using type = TArg;
+  };
+
+  template <typename TArg>
+  struct Promoted<TArg, std::enable_if_t<std::is_enum_v<TArg>>>
+  {
+    using type = typename Promoted<std::underlying_type_t<TArg>>::type;
+  };
+
+  template <typename TArg>
+  struct Promoted<TArg, std::enable_if_t<std::is_integral_v<TArg> &&
+                                         sizeof(TArg) < sizeof(int)>>
+  {
+    using type = int;
+  };
+
+  template <typename TArg>
+  struct Promoted<TArg, std::enable_if_t<std::is_same_v<TArg, float>>>
+  {
+    using type = double;
+  };
+
+  template <typename TArg>
+  struct Promoted<TArg, std::enable_if_t<std::is_pointer_v<TArg> ||
+                                         std::is_null_pointer_v<TArg>>>
+  {
+    using type = const void*;
+  };
+
+  template <typename TArg>
+  using PromotedType = typename Promoted<std::decay_t<TArg>>::type;
+
+  /**
+   * @brief Check if argument is a character pointer which must be copied
+   */
+  template <typename TArg>
+  static constexpr bool isStringCopy()
+  {
+    using TDecayed = std::decay_t<TArg>;
+    return std::is_same_v<TDecayed, char*> ||
+           std::is_same_v<TDecayed, const char*>;
+  }
+
+  template <typename TValue>
+  static constexpr ArgType getArgType()
+  {
+    if constexpr (std::is_same_v<TValue, int>)
+      return ArgType::INT;
+    else if constexpr (std::is_same_v<TValue, unsigned>)
+      return ArgType::UNSIGNED;
+    else if constexpr (std::is_same_v<TValue, long>)
+      return ArgType::LONG;
+    else if constexpr (std::is_same_v<TValue, unsigned long>)
+      return ArgType::UNSIGNED_LONG;
+    else if constexpr (std::is_same_v<TValue, long long>)
+      return ArgType::LONG_LONG;
+    else if constexpr (std::is_same_v<TValue, unsigned long long>)
+      return ArgType::UNSIGNED_LONG_LONG;
+    else if constexpr (std::is_same_v<TValue, double>)
+      return ArgType::DOUBLE;
+    else if constexpr (std::is_same_v<TValue, long double>)
+      return ArgType::LONG_DOUBLE;
+    else
+    {
+      static_assert(std::is_same_v<TValue, const void*>,
+                    "Unsupported printf argument type");
+      return ArgType::POINTER;
+    }
+  }
+
+  template <typename TArg>
+  static size_t getArgSize(TArg&& arg)
+  {
+    if constexpr (isStringCopy<TArg>())
+    {
+      return sizeof(ArgType) + sizeof(StringLen) +
+             (arg != nullptr ? strlen(arg) + 1 : 0);
+    }
+    else
+    {
+      return sizeof(ArgType) + sizeof(PromotedType<TArg>);
+    }
+  }
+
+  template <typename TArg>
+  static char* encodeArg(char* buffer, TArg&& arg)
+  {
+    if constexpr (isStringCopy<TArg>())
+    {
+      // Zero length marks null pointer
+      const StringLen len = arg != nullptr ? strlen(arg) + 1 : 0;
+      *buffer++           = (char)ArgType::STRING_COPY;
+      memcpy(buffer, &len, sizeof(len));
+      if (len > 0)
+        memcpy(buffer + sizeof(len), arg, len);
+      return buffer + sizeof(len) + len;
+    }
+    else
+    {
+      using TValue = PromotedType<TArg>;
+
+      const TValue value = (TValue)arg;
+      *buffer++          = (char)getArgType<TValue>();
+      memcpy(buffer, &value, sizeof(value));
+      return buffer + sizeof(value);
+    }
+  }
+
+public:
+  // Forbid construction of static class
+  DeferredArgs() = delete;
+
+  /**
+   * @brief Get number of bytes required to encode arguments
+   *
+   * @param[in] args  Printf format arguments
+   *
+   * @return Encoded arguments length
+   */
+  template <typename... TArgs>
+  static size_t getEncodedSize(TArgs&&... args)
+  {
+    return (size_t{0} + ... + getArgSize(static_cast<TArgs&&>(args)));
+  }
+
+  /**
+   * @brief Encode arguments into buffer. Buffer must be at least
+   * `getEncodedSize(args...)` bytes long
+   *
+   * @param[out] buffer   Buffer for encoded arguments
+   * @param[in]  args     Printf format arguments
+   */
+  template <typename... TArgs>
+  static void encode(char* buffer, TArgs&&... args)
+  {
+    ((buffer = encodeArg(buffer, static_cast<TArgs&&>(args))), ...);
+    (void)buffer;
+  }
+
+  /**
+   * @brief Render format string with encoded arguments and append result to
+   * buffer. Conversions without matching argument are copied as is.
+   *
+   * @param[inout] output     Buffer for rendered text
+   * @param[in]    format     Printf format string
+   * @param[in]    args       Encoded arguments
+   * @param[in]    argsLen    Length of encoded arguments
+   */
+  static void render(TextBuffer& output, const char* format, const char* args,
+                     size_t argsLen);
+
+  /**
+   * @brief Render format string with encoded arguments using conversions
+   * implemented by `SignalSafeWriter`. Async-signal-safe
+   *
+   * @param[inout] output     Signal-safe output
+   * @param[in]    format     Printf format string
+   * @param[in]    args       Encoded arguments
+   * @param[in]    argsLen    Length of encoded arguments
+   */
+  static void render(SignalSafeWriter& output, const char* format,
+                     const char* args, size_t argsLen);
+};
+
+} // namespace utils
+
+} // namespace mklog
+
+#endif /* DeferredArgs.h */
@@ -0,0 +1,161 @@
+#include "mklog/utils/EpochReclaimer.h"
+
+#include <cassert>
+#include <thread>
+
+namespace mklog
+{
+
+namespace utils
+{
+
+std::atomic<uint64_t> EpochReclaimer::s_globalEpoch(
+    EpochReclaimer::EPOCH_INACTIVE + 1);
+
+std::atomic<EpochReclaimer::ReaderSlot*> EpochReclaimer::s_slots(nullptr);
+
+std::mutex EpochReclaimer::s_retireMutex;
+
+SimpleList<EpochReclaimer::RetiredObject> EpochReclaimer::s_retiredList =
+    SimpleList<EpochReclaimer::RetiredObject>();
+
+EpochReclaimer::ReaderSlot* EpochReclaimer::getThreadSlot()
+{
+  /**
+   * @brief Releases slot when thread exits
+   */
+  struct SlotOwner
+  {
+    ReaderSlot* slot;
+
+    ~SlotOwner()
+    {
+      if (slot != nullptr)
+        slot->inUse.store(false, std::memory_order_release);
+    }
+  };
+
+  static thread_local SlotOwner t_owner = {.slot = nullptr};
+
+  if (t_owner.slot != nullptr)
+    return t_owner.slot;
+
+  // Reuse slot of exited thread
+  for (ReaderSlot* slot = s_slots.load(std::memory_order_acquire);
+       slot != nullptr; slot = slot->next)
+  {
+    bool inUse = false;
+    if (slot->inUse.compare_exchange_strong(inUse, true,
+                                            std::memory_order_acquire))
+    {
+      t_owner.slot = slot;
+      return slot;
+    }
+  }
+
+  // Add new slot
+  ReaderSlot* slot = new ReaderSlot{
+      .epoch = {EPOCH_INACTIVE}, .inUse = {true}, .depth = 0, .next = nullptr};
+  ReaderSlot* head = s_slots.load(std::memory_order_relaxed);
+  do
+  {
+    slot->next = head;
+  } while (!s_slots.compare_exchange_weak(head, slot,
+                                          std::memory_order_release,
+                                          std::memory_order_relaxed));
+
+  t_owner.slot = slot;
+  return slot;
+}
+
+void EpochReclaimer::enter(ReaderSlot* slot)
+{
+  if (slot->depth++ > 0)
+    return;
+
+  slot->epoch.store(s_globalEpoch.load(std::memory_order_acquire),
+                    std::memory_order_relaxed);
+  // Make epoch visible to reclaimers before any published pointer is loaded
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+void EpochReclaimer::exit(ReaderSlot* slot)
+{
+  assert(slot->depth > 0 && "Unbalanced read guard");
+
+  if (--slot->depth > 0)
+    return;
+
+  slot->epoch.store(EPOCH_INACTIVE, std::memory_order_release);
+}
+
+void EpochReclaimer::retire(void* object, void (*deleter)(void* object))
+{
+  std::lock_guard<std::mutex> lock(s_retireMutex);
+
+  // Readers entering after increment cannot see unpublished object
+  const uint64_t epoch = s_globalEpoch.fetch_add(1, std::memory_order_acq_rel);
+  s_retiredList.pushFront(
+      {.object = object, .deleter = deleter, .epoch = epoch});
+
+  reclaimLocked();
+}
+
+size_t EpochReclaimer::reclaimLocked()
+{
+  if (s_retiredList.empty())
+    return 0;
+
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  // Find oldest epoch still observed by some reader
+  uint64_t minEpoch = UINT64_MAX;
+  for (ReaderSlot* slot = s_slots.load(std::memory_order_acquire);
+       slot != nullptr; slot = slot->next)
+  {
+    const uint64_t epoch = slot->epoch.load(std::memory_order_acquire);
+    if (epoch != EPOCH_INACTIVE && epoch < minEpoch)
+      minEpoch = epoch;
+  }
+
+  for (auto it = s_retiredList.begin(); it != s_retiredList.end();)
+  {
+    const RetiredObject retired = *it;
+    if (retired.epoch >= minEpoch)
+    {
+      ++it;
+      continue;
+    }
+
+    s_retiredList.erase(it);
+    retired.deleter(retired.object);
+  }
+
+  return s_retiredList.size();
+}
+
+void EpochReclaimer::reclaim()
+{
+  std::lock_guard<std::mutex> lock(s_retireMutex);
+  reclaimLocked();
+}
+
+void EpochReclaimer::synchronize()
+{
+  assert(getThreadSlot()->depth == 0 &&
+         "Cannot wait for readers inside read guard");
+
+  while (true)
+  {
+    {
+      std::lock_guard<std::mutex> lock(s_retireMutex);
+      if (reclaimLocked() == 0)
+        return;
+    }
+    std::this_thread::yield();
+  }
+}
+
+} // namespace utils
+
+} // namespace mklog
@@ -0,0 +1,148 @@
+/**
+ * @file EpochReclaimer.h
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Epoch-based reclamation of objects shared with lock-free readers
+ *
+ * @version 0.1
+ * @date 2023-09-11
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#ifndef __MEERKAT_LOGS_UTILS_EPOCHRECLAIMER_H
+#define __MEERKAT_LOGS_UTILS_EPOCHRECLAIMER_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+#include "mklog/utils/SimpleList.h"
+
+namespace mklog
+{
+
+namespace utils
+{
+
+/**
+ * @brief Defers deletion of objects unpublished from atomic pointers until
+ * no reader can reference them.
+ *
+ * Readers access published objects only while holding `ReadGuard`, which
+ * records current global epoch in per-thread slot. Retired objects are
+ * tagged with epoch at which they were retired and deleted once every
+ * active reader has entered a later epoch.
+ */
+class EpochReclaimer
+{
+private:
+  /**
+   * @brief Per-thread reader state. Slots are never freed, slot of exited
+   * thread is reused by the next new thread
+   */
+  struct ReaderSlot
+  {
+    /// Epoch at which reader entered, `EPOCH_INACTIVE` outside of guard
+    std::atomic<uint64_t> epoch;
+    std::atomic<bool>     inUse;
+    uint32_t              depth; /// Number of nested guards
+    ReaderSlot*           next;
+  };
+
+  /**
+   * @brief Object waiting for deletion
+   */
+  struct RetiredObject
+  {
+    void* object;
+    void (*deleter)(void* object);
+    uint64_t epoch;
+  };
+
+  static constexpr uint64_t EPOCH_INACTIVE = 0;
+
+  static std::atomic<uint64_t>    s_globalEpoch;
+  static std::atomic<ReaderSlot*> s_slots;
+
+  static std::mutex                s_retireMutex;
+  static SimpleList<RetiredObject> s_retiredList;
+
+  /**
+   * @brief Get slot owned by calling thread, acquire one if needed
+   */
+  static ReaderSlot* getThreadSlot();
+
+  /**
+   * @brief Delete retired objects which cannot be referenced by readers.
+   * `s_retireMutex` must be held
+   *
+   * @return Number of objects left in retired list
+   */
+  static size_t reclaimLocked();
+
+  static void enter(ReaderSlot* slot);
+  static void exit(ReaderSlot* slot);
+
+public:
+  // Forbid construction of static class
+  EpochReclaimer() = delete;
+
+  /**
+   * @brief Read-side critical section. Objects loaded from published
+   * pointers stay alive until guard is destroyed. Guards may be nested
+   */
+  class ReadGuard
+  {
+  private:
+    ReaderSlot* slot;
+
+  public:
+    ReadGuard() : slot(getThreadSlot()) { enter(slot); }
+
+    // No copying
+    ReadGuard(const ReadGuard&)            = delete;
+    ReadGuard& operator=(const ReadGuard&) = delete;
+
+    ~ReadGuard() { exit(slot); }
+  };
+
+  /**
+   * @brief Delete object once current readers leave their critical
+   * sections. Object must already be unreachable for new readers
+   *
+   * @param[in] object    Unpublished object
+   * @param[in] deleter   Function deleting object
+   */
+  static void retire(void* object, void (*deleter)(void* object));
+
+  /**
+   * @brief Delete object once current readers leave their critical
+   * sections. Object must already be unreachable for new readers
+   *
+   * @param[in] object  Unpublished object allocated with `new`
+   */
+  template <typename TObject>
+  static void retire(TObject* object)
+  {
+    retire(const_cast<void*>(static_cast<const void*>(object)),
+           [](void* retired) { delete static_cast<TObject*>(retired); });
+  }
+
+  /**
+   * @brief Delete retired objects which are no longer referenced
+   */
+  static void reclaim();
+
+  /**
+   * @brief Wait until all readers leave critical sections entered before
+   * this call and delete all retired objects. Must not be called inside
+   * `ReadGuard`
+   */
+  static void synchronize();
+};
+
+} // namespace utils
+
+} // namespace mklog
+
+#endif /* EpochReclaimer.h */
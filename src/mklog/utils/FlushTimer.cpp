@@ -0,0 +1,95 @@
+#include "mklog/utils/FlushTimer.h"
+
+#include <csignal>
+#include <pthread.h>
+
+namespace mklog
+{
+
+namespace utils
+{
+
+FlushTimer::FlushTimer(Callback callback, void* context)
+    : callback(callback),
+      context(context),
+      mutex(),
+      wakeup(),
+      thread(),
+      isScheduled(false),
+      isStopping(false),
+      deadline()
+{
+}
+
+void FlushTimer::schedule(uint32_t delayMs)
+{
+  const Clock::time_point newDeadline =
+      Clock::now() + std::chrono::milliseconds(delayMs);
+
+  std::lock_guard<std::mutex> lock(mutex);
+  if (isStopping || (isScheduled && deadline <= newDeadline))
+  {
+    return;
+  }
+
+  isScheduled = true;
+  deadline    = newDeadline;
+
+  if (!thread.joinable())
+  {
+    thread = std::thread(&FlushTimer::run, this);
+    return;
+  }
+  wakeup.notify_one();
+}
+
+void FlushTimer::run()
+{
+  // Leave signal handling to logging threads
+  sigset_t blockedSignals = {};
+  sigfillset(&blockedSignals);
+  pthread_sigmask(SIG_BLOCK, &blockedSignals, NULL);
+
+  std::unique_lock<std::mutex> lock(mutex);
+  while (!isStopping)
+  {
+    if (!isScheduled)
+    {
+      wakeup.wait(lock);
+      continue;
+    }
+
+    if (wakeup.wait_until(lock, deadline) == std::cv_status::no_timeout ||
+        Clock::now() < deadline)
+    {
+      // Woken up early, deadline may have changed
+      continue;
+    }
+
+    isScheduled = false;
+    lock.unlock();
+    callback(context);
+    lock.lock();
+  }
+}
+
+void FlushTimer::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    isStopping  = true;
+    isScheduled = false;
+  }
+  wakeup.notify_one();
+
+  if (thread.joinable())
+  {
+    thread.join();
+  }
+}
+
+FlushTimer::~FlushTimer() { stop(); }
+
+} // namespace utils
+
+} // namespace mklog
@@ -0,0 +1,90 @@
+/**
+ * @file FlushTimer.h
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Background timer for flushing buffered output
+ *
+ * @version 0.1
+ * @date 2023-09-08
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#ifndef __MEERKAT_LOGS_UTILS_FLUSHTIMER_H
+#define __MEERKAT_LOGS_UTILS_FLUSHTIMER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace mklog
+{
+
+namespace utils
+{
+
+/**
+ * @brief Timer calling function when scheduled delay expires. Thread is
+ * started on first `schedule()` call. Callback is called without timer
+ * lock held and may schedule timer again.
+ */
+class FlushTimer
+{
+public:
+  using Callback = void (*)(void* context);
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  Callback callback;
+  void*    context;
+
+  std::mutex              mutex;
+  std::condition_variable wakeup;
+  std::thread             thread;
+
+  bool              isScheduled;
+  bool              isStopping;
+  Clock::time_point deadline;
+
+  /**
+   * @brief Wait for deadlines and call callback until timer is stopped
+   */
+  void run();
+
+public:
+  /**
+   * @brief Create stopped timer
+   *
+   * @param[in] callback  Function called when delay expires
+   * @param[in] context   Argument passed to `callback`
+   */
+  FlushTimer(Callback callback, void* context);
+
+  // No copying
+  FlushTimer(const FlushTimer&)            = delete;
+  FlushTimer& operator=(const FlushTimer&) = delete;
+
+  /**
+   * @brief Call callback after given delay, unless it is already scheduled
+   * to be called earlier
+   *
+   * @param[in] delayMs   Delay in milliseconds
+   */
+  void schedule(uint32_t delayMs);
+
+  /**
+   * @brief Cancel scheduled call and wait for timer thread. Must not be
+   * called with locks taken by callback held
+   */
+  void stop();
+
+  ~FlushTimer();
+};
+
+} // namespace utils
+
+} // namespace mklog
+
+#endif /* FlushTimer.h */
@@ -0,0 +1,306 @@
+#include "mklog/utils/HtmlEscaper.h"
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <immintrin.h>
+
+namespace mklog
+{
+
+namespace utils
+{
+
+/**
+ * @brief HTML entity padded to fixed size, so that it can be copied with
+ * a single move
+ */
+struct Entity
+{
+  static constexpr size_t PADDED_LEN = 8;
+
+  char   text[PADDED_LEN];
+  size_t length;
+};
+
+#define ENTITY(str)                                                            \
+  {                                                                            \
+    .text = str, .length = sizeof(str) - 1                                     \
+  }
+
+static constexpr Entity ENTITY_LT   = ENTITY("&lt;");
+static constexpr Entity ENTITY_GT   = ENTITY("&gt;");
+static constexpr Entity ENTITY_AMP  = ENTITY("&amp;");
+static constexpr Entity ENTITY_QUOT = ENTITY("&quot;");
+
+#undef ENTITY
+
+/**
+ * @brief Maximum number of characters written for single input character,
+ * including padding of last entity
+ */
+static constexpr size_t ESCAPED_CHAR_LEN_MAX = 6;
+
+/**
+ * @brief Write HTML entity for special character
+ *
+ * @return Position after written entity
+ */
+static char* writeEntity(char* output, char ch)
+{
+  const Entity& entity = ch == '<'   ? ENTITY_LT
+                         : ch == '>' ? ENTITY_GT
+                         : ch == '&' ? ENTITY_AMP
+                                     : ENTITY_QUOT;
+
+  memcpy(output, entity.text, Entity::PADDED_LEN);
+  return output + entity.length;
+}
+
+static bool isSpecial(char ch, char quote)
+{
+  return ch == '<' || ch == '>' || ch == '&' || ch == quote;
+}
+
+/**
+ * @brief Get number of characters which must be reserved in output buffer
+ * to escape given number of characters
+ */
+static constexpr size_t getEscapedLenMax(size_t length)
+{
+  return length * ESCAPED_CHAR_LEN_MAX + Entity::PADDED_LEN;
+}
+
+/**
+ * @brief Escape text checking characters one by one
+ */
+static void escapeScalar(TextBuffer& output, const char* text, size_t length,
+                         char quote)
+{
+  output.reserve(getEscapedLenMax(length));
+  char* const start = output.tail();
+  char*       out   = start;
+  for (size_t pos = 0; pos < length; ++pos)
+  {
+    if (isSpecial(text[pos], quote))
+      out = writeEntity(out, text[pos]);
+    else
+      *out++ = text[pos];
+  }
+  output.extend(out - start);
+}
+
+/**
+ * @brief Escape text, searching special characters in blocks of
+ * `TSearch::WIDTH` bytes. Each block is copied straight into output buffer
+ * and entities are written over special characters.
+ *
+ * @tparam TSearch  Class with static `findSpecial(block, quote)` returning
+ *                  bit mask of special characters in block
+ */
+template <typename TSearch>
+static void escapeText(TextBuffer& output, const char* text, size_t length,
+                       char quote)
+{
+  size_t pos = 0;
+  for (; length - pos >= TSearch::WIDTH; pos += TSearch::WIDTH)
+  {
+    uint64_t found = TSearch::findSpecial(text + pos, quote);
+    if (found == 0)
+    {
+      output.append(text + pos, TSearch::WIDTH);
+      continue;
+    }
+
+    output.reserve(getEscapedLenMax(TSearch::WIDTH));
+    char* const start  = output.tail();
+    char*       out    = start;
+    size_t      copied = 0; // Block prefix which is already written
+    while (found != 0)
+    {
+      const size_t index = __builtin_ctzll(found);
+      found &= found - 1;
+
+      memcpy(out, text + pos + copied, index - copied);
+      out    = writeEntity(out + index - copied, text[pos + index]);
+      copied = index + 1;
+    }
+    memcpy(out, text + pos + copied, TSearch::WIDTH - copied);
+    out += TSearch::WIDTH - copied;
+
+    output.extend(out - start);
+  }
+
+  // Check remaining bytes one by one
+  escapeScalar(output, text + pos, length - pos, quote);
+}
+
+struct Sse42Search
+{
+  static constexpr size_t WIDTH = 16;
+
+  __attribute__((target("sse4.2"))) static uint64_t
+  findSpecial(const char* block, char quote)
+  {
+    const __m128i special = _mm_setr_epi8('<', '>', '&', quote, 0, 0, 0, 0, 0,
+                                          0, 0, 0, 0, 0, 0, 0);
+    const __m128i data =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+
+    const __m128i found =
+        _mm_cmpestrm(special, 4, data, 16,
+                     _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_BIT_MASK);
+    return (uint32_t)_mm_cvtsi128_si32(found);
+  }
+};
+
+struct Avx2Search
+{
+  static constexpr size_t WIDTH = 32;
+
+  __attribute__((target("avx2"))) static uint64_t
+  findSpecial(const char* block, char quote)
+  {
+    const __m256i data =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+
+    const __m256i found = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(data, _mm256_set1_epi8('<')),
+                        _mm256_cmpeq_epi8(data, _mm256_set1_epi8('>'))),
+        _mm256_or_si256(_mm256_cmpeq_epi8(data, _mm256_set1_epi8('&')),
+                        _mm256_cmpeq_epi8(data, _mm256_set1_epi8(quote))));
+    return (uint32_t)_mm256_movemask_epi8(found);
+  }
+};
+
+struct Avx512Search
+{
+  static constexpr size_t WIDTH = 64;
+
+  __attribute__((target("avx512f,avx512bw"))) static uint64_t
+  findSpecial(const char* block, char quote)
+  {
+    const __m512i data = _mm512_loadu_si512(block);
+
+    return _mm512_cmpeq_epi8_mask(data, _mm512_set1_epi8('<')) |
+           _mm512_cmpeq_epi8_mask(data, _mm512_set1_epi8('>')) |
+           _mm512_cmpeq_epi8_mask(data, _mm512_set1_epi8('&')) |
+           _mm512_cmpeq_epi8_mask(data, _mm512_set1_epi8(quote));
+  }
+};
+
+// Entry points are flattened so that search functions are inlined into code
+// compiled for their instruction set
+
+__attribute__((target("sse4.2"), flatten)) static void
+escapeSse42(TextBuffer& output, const char* text, size_t length, char quote)
+{
+  escapeText<Sse42Search>(output, text, length, quote);
+}
+
+__attribute__((target("avx2"), flatten)) static void
+escapeAvx2(TextBuffer& output, const char* text, size_t length, char quote)
+{
+  escapeText<Avx2Search>(output, text, length, quote);
+}
+
+__attribute__((target("avx512f,avx512bw"), flatten)) static void
+escapeAvx512(TextBuffer& output, const char* text, size_t length, char quote)
+{
+  escapeText<Avx512Search>(output, text, length, quote);
+}
+
+std::atomic<HtmlEscaper::EscapeFunction> HtmlEscaper::s_escapeFunction(
+    &HtmlEscaper::escapeFirstCall);
+
+HtmlEscaper::EscapeFunction
+HtmlEscaper::getEscapeFunction(Implementation implementation)
+{
+  switch (implementation)
+  {
+  case Implementation::AVX512:
+    return &escapeAvx512;
+  case Implementation::AVX2:
+    return &escapeAvx2;
+  case Implementation::SSE42:
+    return &escapeSse42;
+  case Implementation::SCALAR:
+  default:
+    return &escapeScalar;
+  }
+}
+
+bool HtmlEscaper::isSupported(Implementation implementation)
+{
+  __builtin_cpu_init();
+
+  switch (implementation)
+  {
+  case Implementation::AVX512:
+    return __builtin_cpu_supports("avx512f") &&
+           __builtin_cpu_supports("avx512bw");
+  case Implementation::AVX2:
+    return __builtin_cpu_supports("avx2");
+  case Implementation::SSE42:
+    return __builtin_cpu_supports("sse4.2");
+  case Implementation::SCALAR:
+    return true;
+  default:
+    return false;
+  }
+}
+
+HtmlEscaper::Implementation HtmlEscaper::detectImplementation()
+{
+  constexpr Implementation PREFERENCE_ORDER[] = {
+      Implementation::AVX512, Implementation::AVX2, Implementation::SSE42};
+
+  for (Implementation implementation : PREFERENCE_ORDER)
+  {
+    if (isSupported(implementation))
+      return implementation;
+  }
+  return Implementation::SCALAR;
+}
+
+void HtmlEscaper::escapeFirstCall(TextBuffer& output, const char* text,
+                                  size_t length, char quote)
+{
+  const EscapeFunction escape = getEscapeFunction(detectImplementation());
+  s_escapeFunction.store(escape, std::memory_order_relaxed);
+  escape(output, text, length, quote);
+}
+
+void HtmlEscaper::useImplementation(Implementation implementation)
+{
+  assert(isSupported(implementation) &&
+         "Implementation is not supported by CPU");
+
+  s_escapeFunction.store(getEscapeFunction(implementation),
+                         std::memory_order_relaxed);
+}
+
+HtmlEscaper::Implementation HtmlEscaper::getImplementation()
+{
+  constexpr Implementation IMPLEMENTATIONS[] = {
+      Implementation::SCALAR, Implementation::SSE42, Implementation::AVX2,
+      Implementation::AVX512};
+
+  EscapeFunction escape = s_escapeFunction.load(std::memory_order_relaxed);
+  if (escape == &escapeFirstCall)
+  {
+    escape = getEscapeFunction(detectImplementation());
+    s_escapeFunction.store(escape, std::memory_order_relaxed);
+  }
+
+  for (Implementation implementation : IMPLEMENTATIONS)
+  {
+    if (getEscapeFunction(implementation) == escape)
+      return implementation;
+  }
+  return Implementation::SCALAR;
+}
+
+} // namespace utils
+
+} // namespace mklog
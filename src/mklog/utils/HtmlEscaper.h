@@ -0,0 +1,110 @@
+/**
+ * @file HtmlEscaper.h
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Vectorized escaping of HTML special characters
+ *
+ * @version 0.1
+ * @date 2023-09-09
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#ifndef __MEERKAT_LOGS_UTILS_HTMLESCAPER_H
+#define __MEERKAT_LOGS_UTILS_HTMLESCAPER_H
+
+#include <atomic>
+#include <cstddef>
+
+#include "mklog/utils/TextBuffer.h"
+
+namespace mklog
+{
+
+namespace utils
+{
+
+/**
+ * @brief Replaces '<', '>', '&' and, optionally, '"' with HTML entities.
+ * Special characters are searched with the widest vector instructions
+ * supported by CPU, text between them is copied to output as is.
+ */
+class HtmlEscaper
+{
+public:
+  /**
+   * @brief Instruction set used to search special characters
+   */
+  enum class Implementation
+  {
+    SCALAR,
+    SSE42,
+    AVX2,
+    AVX512,
+  };
+
+private:
+  using EscapeFunction = void (*)(TextBuffer& output, const char* text,
+                                  size_t length, char quote);
+
+  /**
+   * @brief Selected implementation. Resolved on first call
+   */
+  static std::atomic<EscapeFunction> s_escapeFunction;
+
+  static EscapeFunction getEscapeFunction(Implementation implementation);
+
+  /**
+   * @brief Select best implementation supported by CPU
+   */
+  static Implementation detectImplementation();
+
+  /**
+   * @brief Initial value of `s_escapeFunction`. Select implementation and
+   * escape text with it
+   */
+  static void escapeFirstCall(TextBuffer& output, const char* text,
+                              size_t length, char quote);
+
+public:
+  // Forbid construction of static class
+  HtmlEscaper() = delete;
+
+  /**
+   * @brief Append escaped text to buffer
+   *
+   * @param[inout] output         Buffer for escaped text
+   * @param[in]    text           Text to be escaped
+   * @param[in]    length         Text length
+   * @param[in]    escapeQuotes   Also escape '"'. Required for text inside
+   *                              attribute values
+   */
+  static void append(TextBuffer& output, const char* text, size_t length,
+                     bool escapeQuotes = false)
+  {
+    // Searching '&' twice is cheaper than branching on quotes
+    s_escapeFunction.load(std::memory_order_relaxed)(
+        output, text, length, escapeQuotes ? '"' : '&');
+  }
+
+  /**
+   * @brief Check if implementation can run on this CPU
+   */
+  static bool isSupported(Implementation implementation);
+
+  /**
+   * @brief Override automatically selected implementation. Implementation
+   * must be supported by CPU
+   */
+  static void useImplementation(Implementation implementation);
+
+  /**
+   * @brief Get implementation currently in use
+   */
+  static Implementation getImplementation();
+};
+
+} // namespace utils
+
+} // namespace mklog
+
+#endif /* HtmlEscaper.h */
@@ -0,0 +1,374 @@
+#include "mklog/utils/IoUring.h"
+
+#include <cerrno>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace mklog
+{
+
+namespace utils
+{
+
+/// Idle time after which polling kernel thread sleeps
+static constexpr unsigned SQ_THREAD_IDLE_MS = 1000;
+
+static int setupRing(unsigned entries, struct io_uring_params* params)
+{
+  return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int enterRing(int ringFd, unsigned submitCount, unsigned minComplete,
+                     unsigned flags)
+{
+  return (int)syscall(__NR_io_uring_enter, ringFd, submitCount, minComplete,
+                      flags, nullptr, 0);
+}
+
+static int registerRing(int ringFd, unsigned opcode, const void* args,
+                        unsigned argCount)
+{
+  return (int)syscall(__NR_io_uring_register, ringFd, opcode, args,
+                      argCount);
+}
+
+/**
+ * @brief Get pointer to ring field at given offset
+ */
+static unsigned* getRingField(void* ring, uint32_t offset)
+{
+  return reinterpret_cast<unsigned*>(static_cast<char*>(ring) + offset);
+}
+
+IoUring::IoUring()
+    : ringFd(-1),
+      fileFd(-1),
+      isPolling(false),
+      isFileRegistered(false),
+      isBufferRegistered(false),
+      buffers(nullptr),
+      writes(),
+      nextBuffer(0),
+      inFlightCount(0),
+      sqRing(nullptr),
+      sqRingLen(0),
+      cqRing(nullptr),
+      cqRingLen(0),
+      sqes(nullptr),
+      sqesLen(0),
+      sqHead(nullptr),
+      sqTail(nullptr),
+      sqMask(nullptr),
+      sqFlags(nullptr),
+      sqArray(nullptr),
+      cqHead(nullptr),
+      cqTail(nullptr),
+      cqMask(nullptr),
+      cqes(nullptr)
+{
+}
+
+bool IoUring::open(int fd, bool isPolling)
+{
+  close();
+
+  struct io_uring_params params = {};
+  if (isPolling)
+  {
+    params.flags          = IORING_SETUP_SQPOLL;
+    params.sq_thread_idle = SQ_THREAD_IDLE_MS;
+  }
+
+  // Each buffer has at most one write queued, so queue never overflows
+  ringFd = setupRing(BUFFER_COUNT, &params);
+  if (ringFd < 0)
+  {
+    ringFd = -1;
+    return false;
+  }
+
+  if (!mapRings(params))
+  {
+    close();
+    return false;
+  }
+
+  void* memory = mmap(nullptr, BUFFER_COUNT * BUFFER_SIZE,
+                      PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                      -1, 0);
+  if (memory == MAP_FAILED)
+  {
+    close();
+    return false;
+  }
+  buffers = static_cast<char*>(memory);
+
+  // Registration may fail on memory lock limit, plain writes are used then
+  struct iovec bufferIovecs[BUFFER_COUNT] = {};
+  for (size_t i = 0; i < BUFFER_COUNT; ++i)
+  {
+    bufferIovecs[i] = {.iov_base = buffers + i * BUFFER_SIZE,
+                       .iov_len  = BUFFER_SIZE};
+  }
+  isBufferRegistered = registerRing(ringFd, IORING_REGISTER_BUFFERS,
+                                    bufferIovecs, BUFFER_COUNT) == 0;
+  isFileRegistered =
+      registerRing(ringFd, IORING_REGISTER_FILES, &fd, 1) == 0;
+
+  fileFd          = fd;
+  this->isPolling = isPolling;
+  return true;
+}
+
+bool IoUring::mapRings(const struct io_uring_params& params)
+{
+  sqRingLen = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cqRingLen = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+  // Both rings may share one mapping
+  const bool isSingleMapping = (params.features & IORING_FEAT_SINGLE_MMAP);
+  if (isSingleMapping)
+  {
+    sqRingLen = cqRingLen = sqRingLen > cqRingLen ? sqRingLen : cqRingLen;
+  }
+
+  sqRing = mmap(nullptr, sqRingLen, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+  if (sqRing == MAP_FAILED)
+  {
+    sqRing = nullptr;
+    return false;
+  }
+
+  if (isSingleMapping)
+  {
+    cqRing    = sqRing;
+    cqRingLen = 0;
+  }
+  else
+  {
+    cqRing = mmap(nullptr, cqRingLen, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+    if (cqRing == MAP_FAILED)
+    {
+      cqRing = nullptr;
+      return false;
+    }
+  }
+
+  sqesLen  = params.sq_entries * sizeof(io_uring_sqe);
+  void* sq = mmap(nullptr, sqesLen, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+  if (sq == MAP_FAILED)
+  {
+    return false;
+  }
+  sqes = static_cast<io_uring_sqe*>(sq);
+
+  sqHead  = getRingField(sqRing, params.sq_off.head);
+  sqTail  = getRingField(sqRing, params.sq_off.tail);
+  sqMask  = getRingField(sqRing, params.sq_off.ring_mask);
+  sqFlags = getRingField(sqRing, params.sq_off.flags);
+  sqArray = getRingField(sqRing, params.sq_off.array);
+  cqHead  = getRingField(cqRing, params.cq_off.head);
+  cqTail  = getRingField(cqRing, params.cq_off.tail);
+  cqMask  = getRingField(cqRing, params.cq_off.ring_mask);
+  cqes    = reinterpret_cast<io_uring_cqe*>(static_cast<char*>(cqRing) +
+                                         params.cq_off.cqes);
+  return true;
+}
+
+char* IoUring::acquireBuffer(size_t* index)
+{
+  reapCompletions();
+
+  // Buffers are used in turn, so the oldest write is waited for first
+  while (writes[nextBuffer].isBusy)
+  {
+    waitCompletion();
+    reapCompletions();
+  }
+
+  *index     = nextBuffer;
+  nextBuffer = (nextBuffer + 1) % BUFFER_COUNT;
+  return buffers + *index * BUFFER_SIZE;
+}
+
+void IoUring::submitWrite(size_t index, size_t length, uint64_t offset)
+{
+  writes[index] = {
+      .offset = offset, .length = length, .writtenLen = 0, .isBusy = true};
+  submit(index);
+}
+
+void IoUring::submit(size_t index)
+{
+  const Write& write = writes[index];
+
+  const unsigned tail = *sqTail;
+  const unsigned slot = tail & *sqMask;
+
+  io_uring_sqe& sqe = sqes[slot];
+  memset(&sqe, 0, sizeof(sqe));
+  sqe.opcode    = isBufferRegistered ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+  sqe.fd        = isFileRegistered ? 0 : fileFd;
+  sqe.flags     = isFileRegistered ? IOSQE_FIXED_FILE : 0;
+  sqe.off       = write.offset + write.writtenLen;
+  sqe.addr      = (uint64_t)(uintptr_t)(buffers + index * BUFFER_SIZE +
+                                        write.writtenLen);
+  sqe.len       = (uint32_t)(write.length - write.writtenLen);
+  sqe.buf_index = (uint16_t)index;
+  sqe.user_data = index;
+
+  sqArray[slot] = slot;
+  inFlightCount.fetch_add(1, std::memory_order_relaxed);
+  __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+
+  if (!isPolling)
+  {
+    while (enterRing(ringFd, 1, 0, 0) < 0 && errno == EINTR)
+    {
+    }
+    return;
+  }
+
+  // Polling thread sleeps after being idle and must be woken up then
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (__atomic_load_n(sqFlags, __ATOMIC_RELAXED) & IORING_SQ_NEED_WAKEUP)
+  {
+    enterRing(ringFd, 0, 0, IORING_ENTER_SQ_WAKEUP);
+  }
+}
+
+size_t IoUring::reapCompletions()
+{
+  unsigned       head = *cqHead;
+  const unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+
+  size_t reapedCount = 0;
+  for (; head != tail; ++head, ++reapedCount)
+  {
+    const io_uring_cqe& cqe   = cqes[head & *cqMask];
+    Write&              write = writes[cqe.user_data];
+
+    if (cqe.res == -EINTR || cqe.res == -EAGAIN)
+    {
+      submit(cqe.user_data);
+    }
+    else if (cqe.res > 0 &&
+             write.writtenLen + (size_t)cqe.res < write.length)
+    {
+      write.writtenLen += (size_t)cqe.res;
+      submit(cqe.user_data);
+    }
+    else
+    {
+      // Written completely or failed, failed data is dropped like in
+      // ordinary writes
+      write.isBusy = false;
+    }
+    inFlightCount.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+  return reapedCount;
+}
+
+void IoUring::waitCompletion()
+{
+  while (enterRing(ringFd, 0, 1, IORING_ENTER_GETEVENTS) < 0 &&
+         errno == EINTR)
+  {
+  }
+}
+
+void IoUring::waitAll()
+{
+  if (!isOpen())
+  {
+    return;
+  }
+
+  reapCompletions();
+  while (inFlightCount.load(std::memory_order_relaxed) > 0)
+  {
+    waitCompletion();
+    reapCompletions();
+  }
+}
+
+void IoUring::waitSignalSafe()
+{
+  if (!isOpen())
+  {
+    return;
+  }
+
+  // Completions are not reaped, so queue holds all finished writes
+  const unsigned count = inFlightCount.load(std::memory_order_relaxed);
+  const int      savedErrno = errno;
+  while (count > 0 &&
+         enterRing(ringFd, 0, count, IORING_ENTER_GETEVENTS) < 0 &&
+         errno == EINTR)
+  {
+  }
+  errno = savedErrno;
+}
+
+void IoUring::close()
+{
+  // Rings may be missing if `open()` failed
+  if (cqHead != nullptr)
+  {
+    waitAll();
+  }
+
+  if (sqes != nullptr)
+  {
+    munmap(sqes, sqesLen);
+  }
+  if (cqRing != nullptr && cqRing != sqRing)
+  {
+    munmap(cqRing, cqRingLen);
+  }
+  if (sqRing != nullptr)
+  {
+    munmap(sqRing, sqRingLen);
+  }
+  if (buffers != nullptr)
+  {
+    munmap(buffers, BUFFER_COUNT * BUFFER_SIZE);
+  }
+  if (ringFd >= 0)
+  {
+    ::close(ringFd);
+  }
+
+  ringFd             = -1;
+  fileFd             = -1;
+  isPolling          = false;
+  isFileRegistered   = false;
+  isBufferRegistered = false;
+  buffers            = nullptr;
+  nextBuffer         = 0;
+  sqRing = cqRing = nullptr;
+  sqRingLen = cqRingLen = 0;
+  sqes                  = nullptr;
+  sqesLen               = 0;
+  sqHead = sqTail = sqMask = sqFlags = sqArray = nullptr;
+  cqHead = cqTail = cqMask = nullptr;
+  cqes                     = nullptr;
+  for (Write& write : writes)
+  {
+    write.isBusy = false;
+  }
+  inFlightCount.store(0, std::memory_order_relaxed);
+}
+
+} // namespace utils
+
+} // namespace mklog
@@ -0,0 +1,174 @@
+/**
+ * @file IoUring.h
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Asynchronous file writes submitted through io_uring
+ *
+ * @version 0.1
+ * @date 2023-09-16
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#ifndef __MEERKAT_LOGS_UTILS_IOURING_H
+#define __MEERKAT_LOGS_UTILS_IOURING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+struct io_uring_params;
+
+namespace mklog
+{
+
+namespace utils
+{
+
+/**
+ * @brief io_uring instance writing to single file from fixed set of
+ * buffers. Buffers are registered with kernel, so that their pages are not
+ * pinned on every write, and are recycled when their writes complete.
+ * Instance is not thread-safe, except for `waitSignalSafe()`.
+ *
+ * Writes are submitted at explicit offsets and may complete in any order.
+ */
+class IoUring
+{
+public:
+  static constexpr size_t BUFFER_SIZE  = 256 * 1024;
+  static constexpr size_t BUFFER_COUNT = 8;
+
+private:
+  /**
+   * @brief State of write from one buffer
+   */
+  struct Write
+  {
+    uint64_t offset;
+    size_t   length;
+    size_t   writtenLen;
+    bool     isBusy;
+  };
+
+  int   ringFd;
+  int   fileFd;
+  bool  isPolling;
+  bool  isFileRegistered;
+  bool  isBufferRegistered;
+  char* buffers;
+
+  Write  writes[BUFFER_COUNT];
+  size_t nextBuffer;
+
+  /// Writes submitted and not yet reaped
+  std::atomic<unsigned> inFlightCount;
+
+  void*  sqRing;
+  size_t sqRingLen;
+  void*  cqRing;
+  size_t cqRingLen;
+
+  io_uring_sqe* sqes;
+  size_t        sqesLen;
+
+  unsigned* sqHead;
+  unsigned* sqTail;
+  unsigned* sqMask;
+  unsigned* sqFlags;
+  unsigned* sqArray;
+
+  unsigned*     cqHead;
+  unsigned*     cqTail;
+  unsigned*     cqMask;
+  io_uring_cqe* cqes;
+
+  /**
+   * @brief Map submission and completion rings
+   */
+  bool mapRings(const struct io_uring_params& params);
+
+  /**
+   * @brief Queue write of unwritten part of buffer and notify kernel
+   */
+  void submit(size_t index);
+
+  /**
+   * @brief Process available completions. Buffers whose writes are
+   * complete or failed become free, short writes are resubmitted
+   *
+   * @return Number of processed completions
+   */
+  size_t reapCompletions();
+
+  /**
+   * @brief Block until at least one completion is available
+   */
+  void waitCompletion();
+
+public:
+  IoUring();
+
+  // No copying
+  IoUring(const IoUring&)            = delete;
+  IoUring& operator=(const IoUring&) = delete;
+
+  /**
+   * @brief Create ring writing to file
+   *
+   * @param[in] fd          File descriptor
+   * @param[in] isPolling   Whether kernel thread polls submission queue,
+   *                        so that writes are submitted without system calls
+   *
+   * @return `true` if ring is ready, `false` if io_uring is unavailable
+   */
+  bool open(int fd, bool isPolling);
+
+  bool isOpen() const { return ringFd >= 0; }
+
+  /**
+   * @brief Get free buffer, waiting for completions if all buffers are
+   * busy
+   *
+   * @param[out] index  Index of buffer, passed to `submitWrite()`
+   *
+   * @return Buffer of `BUFFER_SIZE` bytes
+   */
+  char* acquireBuffer(size_t* index);
+
+  /**
+   * @brief Write contents of acquired buffer to file
+   *
+   * @param[in] index   Buffer index returned by `acquireBuffer()`
+   * @param[in] length  Number of bytes filled
+   * @param[in] offset  File offset
+   */
+  void submitWrite(size_t index, size_t length, uint64_t offset);
+
+  /**
+   * @brief Recycle buffers of completed writes without blocking
+   */
+  void poll() { reapCompletions(); }
+
+  /**
+   * @brief Wait for all submitted writes to complete
+   */
+  void waitAll();
+
+  /**
+   * @brief Wait for all submitted writes to complete without touching ring
+   * state. Async-signal-safe
+   */
+  void waitSignalSafe();
+
+  void close();
+
+  ~IoUring() { close(); }
+};
+
+} // namespace utils
+
+} // namespace mklog
+
+#endif /* IoUring.h */
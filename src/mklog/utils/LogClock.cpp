@@ -0,0 +1,248 @@
+#include "mklog/utils/LogClock.h"
+
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+namespace mklog
+{
+
+namespace utils
+{
+
+/**
+ * @brief Time spent measuring tick frequency in `calibrate()`
+ */
+static constexpr uint64_t CALIBRATION_NS = 1000000;
+
+/**
+ * @brief Minimum time between calibration refinements
+ */
+static constexpr uint64_t REFINE_PERIOD_NS = LogClock::NS_PER_SECOND;
+
+/**
+ * @brief Number of attempts to take sample without interruption
+ */
+static constexpr size_t SAMPLE_ATTEMPTS = 8;
+
+/**
+ * @brief Number of attempts to read calibration in signal handler, which
+ * may have interrupted calibration update
+ */
+static constexpr size_t SIGNAL_SAFE_READ_ATTEMPTS = 64;
+
+std::atomic<bool>     LogClock::s_useTsc(false);
+std::atomic<uint32_t> LogClock::s_sequence(0);
+LogClock::Calibration LogClock::s_calibration = {};
+std::mutex            LogClock::s_refineMutex;
+
+bool LogClock::isTscInvariant()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  constexpr unsigned LEAF_POWER_MANAGEMENT = 0x80000007;
+  constexpr unsigned BIT_INVARIANT_TSC     = 1u << 8;
+
+  unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+  if (!__get_cpuid(LEAF_POWER_MANAGEMENT, &eax, &ebx, &ecx, &edx))
+    return false;
+
+  return (edx & BIT_INVARIANT_TSC) != 0;
+#else
+  return false;
+#endif
+}
+
+void LogClock::takeSample(Ticks* ticks, uint64_t* rawNs, uint64_t* realNs)
+{
+  Ticks bestSpread = UINT64_MAX;
+
+  // Keep sample taken in the shortest time
+  for (size_t i = 0; i < SAMPLE_ATTEMPTS; ++i)
+  {
+    struct timespec realTime = {};
+
+    const Ticks    before = now();
+    const uint64_t raw    = getRawNs();
+    clock_gettime(CLOCK_REALTIME, &realTime);
+    const Ticks after = now();
+
+    if (after - before < bestSpread)
+    {
+      bestSpread = after - before;
+      *ticks     = before + (after - before) / 2;
+      *rawNs     = raw;
+      *realNs    = (uint64_t)realTime.tv_sec * NS_PER_SECOND +
+                (uint64_t)realTime.tv_nsec;
+    }
+  }
+}
+
+void LogClock::storeCalibration(Ticks originTicks, uint64_t originRawNs,
+                                Ticks baseTicks, uint64_t baseRealNs,
+                                uint64_t nsPerTick)
+{
+  const Ticks refinePeriod =
+      (Ticks)(((unsigned __int128)REFINE_PERIOD_NS << NS_PER_TICK_SHIFT) /
+              nsPerTick);
+
+  const uint32_t sequence = s_sequence.load(std::memory_order_relaxed);
+  s_sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  s_calibration.originTicks.store(originTicks, std::memory_order_relaxed);
+  s_calibration.originRawNs.store(originRawNs, std::memory_order_relaxed);
+  s_calibration.baseTicks.store(baseTicks, std::memory_order_relaxed);
+  s_calibration.baseRealNs.store(baseRealNs, std::memory_order_relaxed);
+  s_calibration.nsPerTick.store(nsPerTick, std::memory_order_relaxed);
+  s_calibration.refineTicks.store(baseTicks + refinePeriod,
+                                  std::memory_order_relaxed);
+
+  s_sequence.store(sequence + 2, std::memory_order_release);
+}
+
+void LogClock::calibrate()
+{
+  std::lock_guard<std::mutex> lock(s_refineMutex);
+
+  s_useTsc.store(isTscInvariant(), std::memory_order_relaxed);
+
+  Ticks    originTicks = 0, ticks = 0;
+  uint64_t originRawNs = 0, rawNs = 0;
+  uint64_t originRealNs = 0, realNs = 0;
+  takeSample(&originTicks, &originRawNs, &originRealNs);
+
+  // Raw monotonic time is used as ticks, no need to measure
+  if (!s_useTsc.load(std::memory_order_relaxed))
+  {
+    storeCalibration(originTicks, originRawNs, originTicks, originRealNs,
+                     (uint64_t)1 << NS_PER_TICK_SHIFT);
+    return;
+  }
+
+  do
+  {
+    takeSample(&ticks, &rawNs, &realNs);
+  } while (rawNs - originRawNs < CALIBRATION_NS || ticks == originTicks);
+
+  const uint64_t nsPerTick =
+      (uint64_t)(((unsigned __int128)(rawNs - originRawNs)
+                  << NS_PER_TICK_SHIFT) /
+                 (ticks - originTicks));
+  storeCalibration(originTicks, originRawNs, ticks, realNs, nsPerTick);
+}
+
+void LogClock::refine()
+{
+  std::unique_lock<std::mutex> lock(s_refineMutex, std::try_to_lock);
+  // Other thread is refining calibration
+  if (!lock.owns_lock())
+    return;
+
+  Ticks    ticks = 0;
+  uint64_t rawNs = 0, realNs = 0;
+  takeSample(&ticks, &rawNs, &realNs);
+
+  const Ticks originTicks =
+      s_calibration.originTicks.load(std::memory_order_relaxed);
+  const uint64_t originRawNs =
+      s_calibration.originRawNs.load(std::memory_order_relaxed);
+  uint64_t nsPerTick = s_calibration.nsPerTick.load(std::memory_order_relaxed);
+
+  // Longer interval gives more precise frequency
+  if (ticks > originTicks && rawNs > originRawNs)
+  {
+    nsPerTick = (uint64_t)(((unsigned __int128)(rawNs - originRawNs)
+                            << NS_PER_TICK_SHIFT) /
+                           (ticks - originTicks));
+  }
+
+  // Wall clock may be adjusted, follow it
+  storeCalibration(originTicks, originRawNs, ticks, realNs, nsPerTick);
+}
+
+bool LogClock::loadCalibration(Ticks* baseTicks, uint64_t* baseRealNs,
+                               uint64_t* nsPerTick, size_t attemptCount)
+{
+  for (size_t i = 0; i < attemptCount; ++i)
+  {
+    const uint32_t sequence = s_sequence.load(std::memory_order_acquire);
+
+    *baseTicks  = s_calibration.baseTicks.load(std::memory_order_relaxed);
+    *baseRealNs = s_calibration.baseRealNs.load(std::memory_order_relaxed);
+    *nsPerTick  = s_calibration.nsPerTick.load(std::memory_order_relaxed);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if ((sequence & 1) == 0 &&
+        sequence == s_sequence.load(std::memory_order_relaxed))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+void LogClock::convertTicks(Ticks ticks, Ticks baseTicks, uint64_t baseRealNs,
+                            uint64_t nsPerTick, time_t* seconds,
+                            uint32_t* nanoseconds)
+{
+  // Ticks may precede base if calibration was refined after they were taken
+  const __int128 elapsedNs =
+      ((__int128)(int64_t)(ticks - baseTicks) * (__int128)nsPerTick) >>
+      NS_PER_TICK_SHIFT;
+  const uint64_t realNs = (uint64_t)((__int128)baseRealNs + elapsedNs);
+
+  *seconds     = (time_t)(realNs / NS_PER_SECOND);
+  *nanoseconds = (uint32_t)(realNs % NS_PER_SECOND);
+}
+
+LogClock::Ticks LogClock::toTicks(uint64_t nanoseconds)
+{
+  const uint64_t nsPerTick =
+      s_calibration.nsPerTick.load(std::memory_order_relaxed);
+  if (nsPerTick == 0)
+    return nanoseconds;
+
+  const unsigned __int128 ticks =
+      ((unsigned __int128)nanoseconds << NS_PER_TICK_SHIFT) / nsPerTick;
+  return ticks > UINT64_MAX ? UINT64_MAX : (Ticks)ticks;
+}
+
+void LogClock::toRealtime(Ticks ticks, time_t* seconds, uint32_t* nanoseconds)
+{
+  // Refine before converting, so that every writer converts ticks alike
+  const Ticks refineTicks =
+      s_calibration.refineTicks.load(std::memory_order_relaxed);
+  if ((int64_t)(ticks - refineTicks) >= 0 &&
+      s_calibration.nsPerTick.load(std::memory_order_relaxed) != 0)
+  {
+    refine();
+  }
+
+  Ticks    baseTicks  = 0;
+  uint64_t baseRealNs = 0;
+  uint64_t nsPerTick  = 0;
+
+  loadCalibration(&baseTicks, &baseRealNs, &nsPerTick, SIZE_MAX);
+
+  convertTicks(ticks, baseTicks, baseRealNs, nsPerTick, seconds, nanoseconds);
+}
+
+void LogClock::toRealtimeSignalSafe(Ticks ticks, time_t* seconds,
+                                    uint32_t* nanoseconds)
+{
+  Ticks    baseTicks  = 0;
+  uint64_t baseRealNs = 0;
+  uint64_t nsPerTick  = 0;
+
+  // Interrupted update never completes, mixed calibration is still usable
+  // for crash report
+  loadCalibration(&baseTicks, &baseRealNs, &nsPerTick,
+                  SIGNAL_SAFE_READ_ATTEMPTS);
+  convertTicks(ticks, baseTicks, baseRealNs, nsPerTick, seconds, nanoseconds);
+}
+
+} // namespace utils
+
+} // namespace mklog
@@ -0,0 +1,173 @@
+/**
+ * @file LogClock.h
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief High-resolution message timestamps
+ *
+ * @version 0.1
+ * @date 2023-09-10
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#ifndef __MEERKAT_LOGS_UTILS_LOGCLOCK_H
+#define __MEERKAT_LOGS_UTILS_LOGCLOCK_H
+
+#include <atomic>
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+
+namespace mklog
+{
+
+namespace utils
+{
+
+/**
+ * @brief Source of message timestamps. Timestamps are taken as raw ticks,
+ * which are either TSC values (on x86 with invariant TSC) or
+ * `CLOCK_MONOTONIC_RAW` nanoseconds. Ticks are converted to wall-clock time
+ * only when message is rendered, using calibration recorded by
+ * `calibrate()` and refined at most once per second during conversion.
+ */
+class LogClock
+{
+public:
+  using Ticks = uint64_t;
+
+  static constexpr uint64_t NS_PER_SECOND = 1000000000;
+
+private:
+  /**
+   * @brief Conversion from ticks to wall-clock nanoseconds. Fields are
+   * guarded as a sequence lock: `s_sequence` is odd while they are updated
+   */
+  struct Calibration
+  {
+    /// Sample used to measure tick frequency
+    std::atomic<Ticks>    originTicks;
+    std::atomic<uint64_t> originRawNs;
+
+    /// Sample from which wall-clock time is counted
+    std::atomic<Ticks>    baseTicks;
+    std::atomic<uint64_t> baseRealNs;
+
+    /// Nanoseconds per tick as 32.32 fixed-point number
+    std::atomic<uint64_t> nsPerTick;
+
+    /// Ticks at which calibration is refined next
+    std::atomic<Ticks> refineTicks;
+  };
+
+  static constexpr unsigned NS_PER_TICK_SHIFT = 32;
+
+  static std::atomic<bool>     s_useTsc;
+  static std::atomic<uint32_t> s_sequence;
+  static Calibration           s_calibration;
+  static std::mutex            s_refineMutex;
+
+  static uint64_t getRawNs()
+  {
+    struct timespec time = {};
+    clock_gettime(CLOCK_MONOTONIC_RAW, &time);
+    return (uint64_t)time.tv_sec * NS_PER_SECOND + (uint64_t)time.tv_nsec;
+  }
+
+  /**
+   * @brief Check if TSC runs at constant rate in all power states
+   */
+  static bool isTscInvariant();
+
+  /**
+   * @brief Take ticks, raw monotonic and wall-clock time at (nearly) the
+   * same moment
+   */
+  static void takeSample(Ticks* ticks, uint64_t* rawNs, uint64_t* realNs);
+
+  /**
+   * @brief Store new calibration. `s_refineMutex` must be held
+   */
+  static void storeCalibration(Ticks originTicks, uint64_t originRawNs,
+                               Ticks baseTicks, uint64_t baseRealNs,
+                               uint64_t nsPerTick);
+
+  /**
+   * @brief Read consistent calibration. Gives up after `attemptCount`
+   * attempts, leaving possibly mixed values from concurrent update
+   *
+   * @return Whether read values are consistent
+   */
+  static bool loadCalibration(Ticks* baseTicks, uint64_t* baseRealNs,
+                              uint64_t* nsPerTick, size_t attemptCount);
+
+  /**
+   * @brief Convert ticks to seconds and nanoseconds since Epoch
+   */
+  static void convertTicks(Ticks ticks, Ticks baseTicks, uint64_t baseRealNs,
+                           uint64_t nsPerTick, time_t* seconds,
+                           uint32_t* nanoseconds);
+
+  /**
+   * @brief Recompute tick frequency over the whole time since `calibrate()`
+   * and move wall-clock base to current time
+   */
+  static void refine();
+
+public:
+  // Forbid construction of static class
+  LogClock() = delete;
+
+  /**
+   * @brief Get current time in ticks
+   */
+  static Ticks now()
+  {
+#if defined(__x86_64__) || defined(__i386__)
+    if (s_useTsc.load(std::memory_order_relaxed))
+      return __builtin_ia32_rdtsc();
+#endif
+    return getRawNs();
+  }
+
+  /**
+   * @brief Convert duration to ticks using current calibration
+   *
+   * @param[in] nanoseconds   Duration in nanoseconds
+   *
+   * @return Duration in ticks. Equal to `nanoseconds` before `calibrate()`
+   */
+  static Ticks toTicks(uint64_t nanoseconds);
+
+  /**
+   * @brief Select tick source and measure its frequency. Called by
+   * `LogManager::initLogs()`; ticks taken before are not meaningful
+   */
+  static void calibrate();
+
+  /**
+   * @brief Convert ticks to wall-clock time
+   *
+   * @param[in]  ticks        Ticks returned by `now()`
+   * @param[out] seconds      Seconds since Epoch
+   * @param[out] nanoseconds  Nanoseconds since start of second
+   */
+  static void toRealtime(Ticks ticks, time_t* seconds, uint32_t* nanoseconds);
+
+  /**
+   * @brief Convert ticks to wall-clock time without locking. Calibration is
+   * not refined, and concurrent calibration update interrupted by signal
+   * is not waited for. Async-signal-safe
+   *
+   * @param[in]  ticks        Ticks returned by `now()`
+   * @param[out] seconds      Seconds since Epoch
+   * @param[out] nanoseconds  Nanoseconds since start of second
+   */
+  static void toRealtimeSignalSafe(Ticks ticks, time_t* seconds,
+                                   uint32_t* nanoseconds);
+};
+
+} // namespace utils
+
+} // namespace mklog
+
+#endif /* LogClock.h */
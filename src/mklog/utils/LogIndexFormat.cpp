@@ -0,0 +1,104 @@
+#include "mklog/utils/LogIndexFormat.h"
+
+#include <cstring>
+
+#include "mklog/utils/BinaryLogFormat.h"
+#include "mklog/utils/Crc32c.h"
+
+namespace mklog
+{
+
+namespace utils
+{
+
+/// Offsets of entry fields
+static constexpr size_t OFFSET_OFFSET        = 0;
+static constexpr size_t LENGTH_OFFSET        = 8;
+static constexpr size_t FIRST_TIME_OFFSET    = 16;
+static constexpr size_t LAST_TIME_OFFSET     = 24;
+static constexpr size_t LOGGER_BITS_OFFSET   = 32;
+static constexpr size_t FILE_BITS_OFFSET     = 40;
+static constexpr size_t MESSAGE_COUNT_OFFSET = 48;
+static constexpr size_t SEVERITY_MASK_OFFSET = 52;
+static constexpr size_t RESERVED_OFFSET      = 56;
+static constexpr size_t ENTRY_CRC_OFFSET     = LogIndexFormat::ENTRY_SIZE - 4;
+
+uint64_t LogIndexFormat::getNameBits(const char* name, size_t length)
+{
+  // FNV-1a, stable across processes
+  uint64_t hash = 0xCBF29CE484222325;
+  for (size_t i = 0; i < length; ++i)
+  {
+    hash = (hash ^ (uint8_t)name[i]) * 0x100000001B3;
+  }
+  return (UINT64_C(1) << (hash & 63)) | (UINT64_C(1) << ((hash >> 32) & 63));
+}
+
+const char* LogIndexFormat::getBaseName(const char* path)
+{
+  const char* separator = strrchr(path, '/');
+  return separator != nullptr ? separator + 1 : path;
+}
+
+void LogIndexFormat::encodeFileHeader(char* output)
+{
+  BinaryLogFormat::encodeUint32(output, FILE_MAGIC);
+  BinaryLogFormat::encodeUint32(output + 4, VERSION);
+}
+
+bool LogIndexFormat::decodeFileHeader(const char* input)
+{
+  return BinaryLogFormat::decodeUint32(input) == FILE_MAGIC &&
+         BinaryLogFormat::decodeUint32(input + 4) == VERSION;
+}
+
+void LogIndexFormat::encodeEntry(char* output, const Entry& entry)
+{
+  BinaryLogFormat::encodeUint64(output + OFFSET_OFFSET, entry.offset);
+  BinaryLogFormat::encodeUint64(output + LENGTH_OFFSET, entry.length);
+  BinaryLogFormat::encodeUint64(output + FIRST_TIME_OFFSET,
+                                entry.summary.firstTimeNs);
+  BinaryLogFormat::encodeUint64(output + LAST_TIME_OFFSET,
+                                entry.summary.lastTimeNs);
+  BinaryLogFormat::encodeUint64(output + LOGGER_BITS_OFFSET,
+                                entry.summary.loggerBits);
+  BinaryLogFormat::encodeUint64(output + FILE_BITS_OFFSET,
+                                entry.summary.fileBits);
+  BinaryLogFormat::encodeUint32(output + MESSAGE_COUNT_OFFSET,
+                                entry.summary.messageCount);
+  BinaryLogFormat::encodeUint32(output + SEVERITY_MASK_OFFSET,
+                                entry.summary.severityMask);
+  BinaryLogFormat::encodeUint32(output + RESERVED_OFFSET, 0);
+  BinaryLogFormat::encodeUint32(output + ENTRY_CRC_OFFSET,
+                                Crc32c::compute(output, ENTRY_CRC_OFFSET));
+}
+
+bool LogIndexFormat::decodeEntry(const char* input, Entry* entry)
+{
+  if (BinaryLogFormat::decodeUint32(input + ENTRY_CRC_OFFSET) !=
+      Crc32c::compute(input, ENTRY_CRC_OFFSET))
+  {
+    return false;
+  }
+
+  entry->offset = BinaryLogFormat::decodeUint64(input + OFFSET_OFFSET);
+  entry->length = BinaryLogFormat::decodeUint64(input + LENGTH_OFFSET);
+  entry->summary.firstTimeNs =
+      BinaryLogFormat::decodeUint64(input + FIRST_TIME_OFFSET);
+  entry->summary.lastTimeNs =
+      BinaryLogFormat::decodeUint64(input + LAST_TIME_OFFSET);
+  entry->summary.loggerBits =
+      BinaryLogFormat::decodeUint64(input + LOGGER_BITS_OFFSET);
+  entry->summary.fileBits =
+      BinaryLogFormat::decodeUint64(input + FILE_BITS_OFFSET);
+  entry->summary.messageCount =
+      BinaryLogFormat::decodeUint32(input + MESSAGE_COUNT_OFFSET);
+  entry->summary.severityMask =
+      BinaryLogFormat::decodeUint32(input + SEVERITY_MASK_OFFSET);
+
+  return entry->offset + entry->length >= entry->offset;
+}
+
+} // namespace utils
+
+} // namespace mklog
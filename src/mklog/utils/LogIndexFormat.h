@@ -0,0 +1,154 @@
+/**
+ * @file LogIndexFormat.h
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Layout of sparse index written next to text log file
+ *
+ * @version 0.1
+ * @date 2023-09-19
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#ifndef __MEERKAT_LOGS_UTILS_LOGINDEXFORMAT_H
+#define __MEERKAT_LOGS_UTILS_LOGINDEXFORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "mklog/LogMessage.h"
+
+namespace mklog
+{
+
+namespace utils
+{
+
+/**
+ * @brief Sparse index file layout: header followed by one checksummed
+ * entry per chunk of log file. Chunks start and end between records.
+ */
+class LogIndexFormat
+{
+public:
+  // Forbid construction of static class
+  LogIndexFormat() = delete;
+
+  static constexpr uint32_t FILE_MAGIC = 0x58494B4D; /// "MKIX"
+  static constexpr uint32_t VERSION    = 1;
+
+  static constexpr size_t FILE_HEADER_SIZE = 8;
+  static constexpr size_t ENTRY_SIZE       = 64;
+
+  /**
+   * @brief Suffix appended to log file name to get name of its index
+   */
+  static constexpr char FILE_SUFFIX[] = ".idx";
+
+  /**
+   * @brief Messages of chunk, used to skip chunks without reading them
+   */
+  struct ChunkSummary
+  {
+    uint64_t firstTimeNs;
+    uint64_t lastTimeNs;
+    uint64_t loggerBits; /// Union of `getNameBits()` of logger names
+    uint64_t fileBits;   /// Union of `getNameBits()` of file base names
+    uint32_t messageCount;
+    uint32_t severityMask; /// Bit `1 << severity` for each severity present
+
+    /**
+     * @brief Account message in summary
+     */
+    void add(LogMessage::Severity severity, uint64_t timeNs,
+             uint64_t loggerNameBits, uint64_t fileNameBits)
+    {
+      firstTimeNs = timeNs < firstTimeNs ? timeNs : firstTimeNs;
+      lastTimeNs  = timeNs > lastTimeNs ? timeNs : lastTimeNs;
+      loggerBits |= loggerNameBits;
+      fileBits |= fileNameBits;
+      ++messageCount;
+      severityMask |= UINT32_C(1) << (unsigned)severity;
+    }
+
+    /**
+     * @brief Check if chunk may contain messages matching all conditions
+     *
+     * @param[in] fromNs          Start of time range, in nanoseconds since
+     *                            Epoch
+     * @param[in] toNs            End of time range, inclusive
+     * @param[in] minSeverity     Least severity
+     * @param[in] loggerNameBits  Bits of logger name, zero for any logger
+     * @param[in] fileNameBits    Bits of file base name, zero for any file
+     */
+    bool mayContain(uint64_t fromNs, uint64_t toNs,
+                    LogMessage::Severity minSeverity, uint64_t loggerNameBits,
+                    uint64_t fileNameBits) const
+    {
+      return messageCount > 0 && firstTimeNs <= toNs && lastTimeNs >= fromNs &&
+             (severityMask >> (unsigned)minSeverity) != 0 &&
+             (loggerBits & loggerNameBits) == loggerNameBits &&
+             (fileBits & fileNameBits) == fileNameBits;
+    }
+  };
+
+  static constexpr ChunkSummary CHUNK_SUMMARY_EMPTY = {
+      .firstTimeNs  = UINT64_MAX,
+      .lastTimeNs   = 0,
+      .loggerBits   = 0,
+      .fileBits     = 0,
+      .messageCount = 0,
+      .severityMask = 0,
+  };
+
+  struct Entry
+  {
+    uint64_t     offset;
+    uint64_t     length;
+    ChunkSummary summary;
+  };
+
+  /**
+   * @brief Get bits marking name in chunk summary
+   */
+  static uint64_t getNameBits(const char* name, size_t length);
+
+  /**
+   * @brief Get part of file path after the last '/'
+   */
+  static const char* getBaseName(const char* path);
+
+  /**
+   * @brief Write index file header
+   *
+   * @param[out] output  Buffer of `FILE_HEADER_SIZE` bytes
+   */
+  static void encodeFileHeader(char* output);
+
+  /**
+   * @brief Check index file header
+   *
+   * @return `false` if file is not index of supported version
+   */
+  static bool decodeFileHeader(const char* input);
+
+  /**
+   * @brief Write index entry
+   *
+   * @param[out] output  Buffer of `ENTRY_SIZE` bytes
+   * @param[in]  entry   Chunk description
+   */
+  static void encodeEntry(char* output, const Entry& entry);
+
+  /**
+   * @brief Read index entry
+   *
+   * @return `false` if entry is damaged
+   */
+  static bool decodeEntry(const char* input, Entry* entry);
+};
+
+} // namespace utils
+
+} // namespace mklog
+
+#endif /* LogIndexFormat.h */
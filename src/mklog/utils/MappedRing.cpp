@@ -0,0 +1,395 @@
+#include "mklog/utils/MappedRing.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mklog/utils/Crc32c.h"
+
+namespace mklog
+{
+
+namespace utils
+{
+
+/// Longest stored logger, function or file name, including NUL
+static constexpr size_t NAME_LEN_MAX = UINT16_MAX;
+
+static constexpr uint64_t NS_PER_SECOND = 1000000000;
+
+static size_t alignRecordLen(size_t length, size_t alignment)
+{
+  return (length + alignment - 1) & ~(alignment - 1);
+}
+
+static size_t getNameLen(const char* name)
+{
+  return name != nullptr ? strnlen(name, NAME_LEN_MAX - 1) + 1 : 1;
+}
+
+/**
+ * @brief Copy possibly truncated string and terminate it
+ *
+ * @return Position after terminating NUL
+ */
+static char* copyName(char* output, const char* name, size_t nameLen)
+{
+  if (name != nullptr)
+  {
+    memcpy(output, name, nameLen - 1);
+  }
+  output[nameLen - 1] = '\0';
+  return output + nameLen;
+}
+
+MappedRing::MappedRing()
+    : fd(-1),
+      mapping(nullptr),
+      mappingLen(0),
+      header(nullptr),
+      data(nullptr),
+      capacity(0)
+{
+}
+
+bool MappedRing::isValidHeader(const FileHeader* header, size_t fileSize)
+{
+  return fileSize >= HEADER_SIZE &&
+         memcmp(header->magic, MAGIC, sizeof(MAGIC)) == 0 &&
+         header->version == VERSION && header->headerSize == HEADER_SIZE &&
+         header->capacity >= CAPACITY_MIN &&
+         (header->capacity & (header->capacity - 1)) == 0 &&
+         fileSize == HEADER_SIZE + header->capacity;
+}
+
+bool MappedRing::isValidRecord(const char* record, size_t maxLen)
+{
+  RecordHeader recordHeader = {};
+  if (maxLen < sizeof(recordHeader))
+  {
+    return false;
+  }
+  memcpy(&recordHeader, record, sizeof(recordHeader));
+
+  const size_t usedLen = sizeof(recordHeader) + getPayloadLen(recordHeader);
+  if (recordHeader.sequence == 0 || recordHeader.length > maxLen ||
+      recordHeader.length % RECORD_ALIGN != 0 ||
+      alignRecordLen(usedLen, RECORD_ALIGN) != recordHeader.length ||
+      recordHeader.loggerLen == 0 || recordHeader.functionLen == 0 ||
+      recordHeader.fileLen == 0)
+  {
+    return false;
+  }
+
+  const size_t checksumLen = sizeof(recordHeader.checksum);
+  return Crc32c::compute(record + checksumLen, usedLen - checksumLen) ==
+         recordHeader.checksum;
+}
+
+bool MappedRing::open(const char* filename, size_t capacity)
+{
+  close();
+
+  fd = ::open(filename, O_RDWR | O_CREAT | O_CLOEXEC, S_IRUSR | S_IWUSR);
+  if (fd < 0)
+  {
+    return false;
+  }
+
+  struct stat fileStat = {};
+  FileHeader  existing = {};
+  const bool  isExisting =
+      fstat(fd, &fileStat) == 0 &&
+      pread(fd, &existing, sizeof(existing), 0) == (ssize_t)sizeof(existing) &&
+      isValidHeader(&existing, (size_t)fileStat.st_size);
+
+  if (isExisting)
+  {
+    capacity = existing.capacity;
+  }
+  else
+  {
+    size_t roundedCapacity = CAPACITY_MIN;
+    while (roundedCapacity < capacity)
+    {
+      roundedCapacity *= 2;
+    }
+    capacity = roundedCapacity;
+
+    // Blocks are allocated up front, so that writes to mapping never fail
+    // with SIGBUS on full disk
+    if (ftruncate(fd, 0) != 0 ||
+        posix_fallocate(fd, 0, (off_t)(HEADER_SIZE + capacity)) != 0)
+    {
+      ::close(fd);
+      fd = -1;
+      return false;
+    }
+  }
+
+  void* map = mmap(nullptr, HEADER_SIZE + capacity, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, fd, 0);
+  if (map == MAP_FAILED)
+  {
+    ::close(fd);
+    fd = -1;
+    return false;
+  }
+
+  mapping        = static_cast<char*>(map);
+  mappingLen     = HEADER_SIZE + capacity;
+  header         = reinterpret_cast<FileHeader*>(mapping);
+  data           = mapping + HEADER_SIZE;
+  this->capacity = capacity;
+
+  if (!isExisting)
+  {
+    header->version    = VERSION;
+    header->headerSize = HEADER_SIZE;
+    header->capacity   = capacity;
+    header->writePos.store(0, std::memory_order_relaxed);
+    header->nextSequence.store(1, std::memory_order_relaxed);
+
+    // Ring is recognized only when fully initialized
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(header->magic, MAGIC, sizeof(MAGIC));
+  }
+
+  return true;
+}
+
+size_t MappedRing::reserve(size_t recordLen)
+{
+  uint64_t pos = header->writePos.load(std::memory_order_relaxed);
+  uint64_t start = 0;
+  do
+  {
+    // Record which does not fit before end of data starts over from
+    // beginning, tail is left to be skipped by reader
+    const size_t offset = (size_t)(pos & (capacity - 1));
+    start = offset + recordLen > capacity ? pos + (capacity - offset) : pos;
+  } while (!header->writePos.compare_exchange_weak(
+      pos, start + recordLen, std::memory_order_relaxed));
+
+  return (size_t)(start & (capacity - 1));
+}
+
+void MappedRing::append(const LogMessage& message, time_t seconds,
+                        uint32_t nanoseconds)
+{
+  if (!isOpen())
+  {
+    return;
+  }
+
+  const size_t loggerLen   = getNameLen(message.source.logger);
+  const size_t functionLen = getNameLen(message.source.function);
+  const size_t fileLen     = getNameLen(message.source.file);
+  size_t       contentLen  = message.content != nullptr
+                                 ? strnlen(message.content, message.contentLen)
+                                 : 0;
+
+  // Keep record small enough not to overwrite too much of history
+  const size_t recordLenMax = capacity / 2;
+  const size_t fixedLen =
+      sizeof(RecordHeader) + loggerLen + functionLen + fileLen + 1;
+  if (fixedLen + RECORD_ALIGN > recordLenMax)
+  {
+    return;
+  }
+  if (fixedLen + contentLen + RECORD_ALIGN > recordLenMax)
+  {
+    contentLen = recordLenMax - RECORD_ALIGN - fixedLen;
+  }
+
+  RecordHeader record = {
+      .checksum      = 0,
+      .length        = (uint32_t)alignRecordLen(fixedLen + contentLen,
+                                                RECORD_ALIGN),
+      .sequence      = header->nextSequence.fetch_add(
+          1, std::memory_order_relaxed),
+      .realtimeNs    = (uint64_t)seconds * NS_PER_SECOND + nanoseconds,
+      .longMessageId = message.longMessageId,
+      .line          = (uint32_t)message.source.line,
+      .contentLen    = (uint32_t)contentLen,
+      .loggerLen     = (uint16_t)loggerLen,
+      .functionLen   = (uint16_t)functionLen,
+      .fileLen       = (uint16_t)fileLen,
+      .severity      = (uint8_t)message.severity,
+      .contentType   = (uint8_t)message.contentType,
+      .part          = (uint8_t)message.part,
+      .reserved      = {}};
+
+  char* const recordStart = data + reserve(record.length);
+
+  // Payload is written first, header with checksum completes record
+  char* payload = recordStart + sizeof(RecordHeader);
+  char* cur     = payload;
+  cur           = copyName(cur, message.source.logger, loggerLen);
+  cur           = copyName(cur, message.source.function, functionLen);
+  cur           = copyName(cur, message.source.file, fileLen);
+  if (contentLen > 0)
+  {
+    memcpy(cur, message.content, contentLen);
+  }
+  cur[contentLen] = '\0';
+
+  const size_t checksumLen = sizeof(record.checksum);
+  uint32_t     checksum    = Crc32c::compute(
+      reinterpret_cast<const char*>(&record) + checksumLen,
+      sizeof(record) - checksumLen);
+  record.checksum =
+      Crc32c::update(checksum, payload, getPayloadLen(record));
+
+  memcpy(recordStart, &record, sizeof(record));
+}
+
+void MappedRing::close()
+{
+  if (mapping != nullptr)
+  {
+    munmap(mapping, mappingLen);
+  }
+  if (fd >= 0)
+  {
+    ::close(fd);
+  }
+
+  fd         = -1;
+  mapping    = nullptr;
+  mappingLen = 0;
+  header     = nullptr;
+  data       = nullptr;
+  capacity   = 0;
+}
+
+bool MappedRingReader::open(const char* filename)
+{
+  close();
+
+  const int fd = ::open(filename, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+  {
+    return false;
+  }
+
+  struct stat fileStat = {};
+  if (fstat(fd, &fileStat) != 0 ||
+      (size_t)fileStat.st_size < MappedRing::HEADER_SIZE)
+  {
+    ::close(fd);
+    return false;
+  }
+
+  void* map = mmap(nullptr, (size_t)fileStat.st_size, PROT_READ, MAP_SHARED,
+                   fd, 0);
+  ::close(fd);
+  if (map == MAP_FAILED)
+  {
+    return false;
+  }
+
+  mapping    = static_cast<const char*>(map);
+  mappingLen = (size_t)fileStat.st_size;
+
+  const auto* header =
+      reinterpret_cast<const MappedRing::FileHeader*>(mapping);
+  if (!MappedRing::isValidHeader(header, mappingLen))
+  {
+    close();
+    return false;
+  }
+
+  recordCount = scan(nullptr);
+  records     = new MappedRing::Record[recordCount];
+  recordCount = scan(records);
+
+  std::sort(records, records + recordCount,
+            [](const MappedRing::Record& lhs, const MappedRing::Record& rhs) {
+              return lhs.sequence < rhs.sequence;
+            });
+
+  return true;
+}
+
+size_t MappedRingReader::scan(MappedRing::Record* records) const
+{
+  using RecordHeader = MappedRing::RecordHeader;
+
+  const char*  data     = mapping + MappedRing::HEADER_SIZE;
+  const size_t capacity = mappingLen - MappedRing::HEADER_SIZE;
+
+  // Records are not linked, so every aligned position may start one. Valid
+  // record cannot overlap later one, otherwise its checksum would fail
+  size_t count  = 0;
+  size_t offset = 0;
+  while (offset + sizeof(RecordHeader) <= capacity)
+  {
+    const char* record = data + offset;
+    if (!MappedRing::isValidRecord(record, capacity - offset))
+    {
+      offset += MappedRing::RECORD_ALIGN;
+      continue;
+    }
+
+    RecordHeader recordHeader = {};
+    memcpy(&recordHeader, record, sizeof(recordHeader));
+    offset += recordHeader.length;
+
+    // Ring may still be written, keep only records which fit into count
+    // taken by first pass
+    if (records == nullptr)
+    {
+      ++count;
+      continue;
+    }
+    if (count == recordCount)
+    {
+      break;
+    }
+
+    const char* logger   = record + sizeof(RecordHeader);
+    const char* function = logger + recordHeader.loggerLen;
+    const char* file     = function + recordHeader.functionLen;
+    const char* content  = file + recordHeader.fileLen;
+
+    records[count++] = {
+        .sequence      = recordHeader.sequence,
+        .seconds       = (time_t)(recordHeader.realtimeNs / NS_PER_SECOND),
+        .nanoseconds   = (uint32_t)(recordHeader.realtimeNs % NS_PER_SECOND),
+        .severity      = (LogMessage::Severity)recordHeader.severity,
+        .contentType   = (LogMessage::ContentType)recordHeader.contentType,
+        .part          = (LogMessage::Part)recordHeader.part,
+        .longMessageId = recordHeader.longMessageId,
+        .logger        = logger,
+        .function      = function,
+        .file          = file,
+        .line          = recordHeader.line,
+        .content       = content,
+        .contentLen    = recordHeader.contentLen};
+  }
+
+  return count;
+}
+
+void MappedRingReader::close()
+{
+  if (mapping != nullptr)
+  {
+    munmap(const_cast<char*>(mapping), mappingLen);
+  }
+  delete[] records;
+
+  mapping     = nullptr;
+  mappingLen  = 0;
+  records     = nullptr;
+  recordCount = 0;
+}
+
+} // namespace utils
+
+} // namespace mklog
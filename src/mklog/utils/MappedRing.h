@@ -0,0 +1,266 @@
+/**
+ * @file MappedRing.h
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Log records in memory-mapped file which outlives process
+ *
+ * @version 0.1
+ * @date 2023-09-15
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#ifndef __MEERKAT_LOGS_UTILS_MAPPEDRING_H
+#define __MEERKAT_LOGS_UTILS_MAPPEDRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+#include "mklog/LogMessage.h"
+
+namespace mklog
+{
+
+namespace utils
+{
+
+/**
+ * @brief Ring of log records in file mapped with `MAP_SHARED`. Records are
+ * copied straight into page cache, so they survive `SIGKILL`, OOM kills and
+ * any other death of process (but not loss of power or kernel crash).
+ *
+ * Each record carries sequence number and CRC-32C checksum. Records which
+ * were being written when process died, or which were partially
+ * overwritten by later records, fail the checksum and are skipped by
+ * `MappedRingReader`. Appending is lock-free and async-signal-safe; several
+ * processes must not write to the same ring.
+ */
+class MappedRing
+{
+public:
+  static constexpr size_t CAPACITY_DEFAULT = 4 * 1024 * 1024;
+  static constexpr size_t CAPACITY_MIN     = 64 * 1024;
+
+  /**
+   * @brief Record restored from ring. Strings point into reader mapping
+   * and are NUL-terminated
+   */
+  struct Record
+  {
+    uint64_t                sequence;
+    time_t                  seconds;
+    uint32_t                nanoseconds;
+    LogMessage::Severity    severity;
+    LogMessage::ContentType contentType;
+    LogMessage::Part        part;
+    uint32_t                longMessageId;
+    const char*             logger;
+    const char*             function;
+    const char*             file;
+    size_t                  line;
+    const char*             content;
+    size_t                  contentLen;
+  };
+
+private:
+  friend class MappedRingReader;
+
+  static constexpr char     MAGIC[8]     = {'M', 'K', 'L', 'G',
+                                            'R', 'I', 'N', 'G'};
+  static constexpr uint32_t VERSION      = 1;
+  static constexpr size_t   HEADER_SIZE  = 4096;
+  static constexpr size_t   RECORD_ALIGN = 8;
+
+  /**
+   * @brief Start of file. Data area follows at `HEADER_SIZE`
+   */
+  struct FileHeader
+  {
+    char     magic[sizeof(MAGIC)];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t capacity;
+
+    /// Position in data area at which next record is placed. Grows
+    /// without wrapping
+    std::atomic<uint64_t> writePos;
+
+    /// Sequence number of next record, starting from 1
+    std::atomic<uint64_t> nextSequence;
+  };
+
+  static_assert(std::atomic<uint64_t>::is_always_lock_free,
+                "Shared ring needs address-free atomics");
+
+  /**
+   * @brief Start of each record, followed by logger, function, file and
+   * content, each terminated by NUL. Records start at `RECORD_ALIGN`
+   * boundary and never wrap around end of data area
+   */
+  struct RecordHeader
+  {
+    /// CRC-32C of the rest of header and strings, without padding
+    uint32_t checksum;
+    uint32_t length; /// Length including header and padding
+    uint64_t sequence;
+    uint64_t realtimeNs;
+    uint32_t longMessageId;
+    uint32_t line;
+    uint32_t contentLen;
+    uint16_t loggerLen;
+    uint16_t functionLen;
+    uint16_t fileLen;
+    uint8_t  severity;
+    uint8_t  contentType;
+    uint8_t  part;
+    uint8_t  reserved[3];
+  };
+
+  int         fd;
+  char*       mapping;
+  size_t      mappingLen;
+  FileHeader* header;
+  char*       data;
+  size_t      capacity;
+
+  /**
+   * @brief Check if file starts with header of usable ring
+   *
+   * @param[in] header    File header
+   * @param[in] fileSize  Size of file
+   */
+  static bool isValidHeader(const FileHeader* header, size_t fileSize);
+
+  /**
+   * @brief Check record found at start of buffer
+   *
+   * @param[in] record    Possible record
+   * @param[in] maxLen    Bytes available from record start to end of data
+   *
+   * @return `true` if record is complete and intact
+   */
+  static bool isValidRecord(const char* record, size_t maxLen);
+
+  /**
+   * @brief Get length of record payload, excluding header and padding
+   */
+  static size_t getPayloadLen(const RecordHeader& record)
+  {
+    return (size_t)record.loggerLen + record.functionLen + record.fileLen +
+           record.contentLen + 1;
+  }
+
+  /**
+   * @brief Take place for record of given length
+   *
+   * @return Offset of record in data area
+   */
+  size_t reserve(size_t recordLen);
+
+public:
+  MappedRing();
+
+  // No copying
+  MappedRing(const MappedRing&)            = delete;
+  MappedRing& operator=(const MappedRing&) = delete;
+
+  /**
+   * @brief Open ring file, creating it if needed. Existing ring keeps its
+   * records, capacity and sequence numbers; file which does not contain
+   * valid ring is overwritten
+   *
+   * @param[in] filename  Ring file name
+   * @param[in] capacity  Size of data area for new ring. Rounded up to
+   *                      power of two, at least `CAPACITY_MIN`
+   *
+   * @return `true` if ring is ready, `false` otherwise
+   */
+  bool open(const char* filename, size_t capacity = CAPACITY_DEFAULT);
+
+  bool isOpen() const { return mapping != nullptr; }
+
+  /**
+   * @brief Append message to ring. Content which does not fit into half of
+   * ring is truncated. Lock-free and async-signal-safe
+   *
+   * @param[in] message       Message to be stored
+   * @param[in] seconds       Message wall-clock time
+   * @param[in] nanoseconds   Nanoseconds since start of second
+   */
+  void append(const LogMessage& message, time_t seconds,
+              uint32_t nanoseconds);
+
+  /**
+   * @brief Unmap and close ring file. Records stay in file
+   */
+  void close();
+
+  ~MappedRing() { close(); }
+};
+
+/**
+ * @brief Reads intact records from ring file, possibly left by dead
+ * process. Ring should not be written while reader is open: records
+ * overwritten after `open()` change under reader.
+ */
+class MappedRingReader
+{
+private:
+  const char*         mapping;
+  size_t              mappingLen;
+  MappedRing::Record* records;
+  size_t              recordCount;
+
+  /**
+   * @brief Scan data area for intact records
+   *
+   * @param[out] records  Found records, `nullptr` to only count them
+   *
+   * @return Number of found records
+   */
+  size_t scan(MappedRing::Record* records) const;
+
+public:
+  MappedRingReader()
+      : mapping(nullptr), mappingLen(0), records(nullptr), recordCount(0)
+  {
+  }
+
+  // No copying
+  MappedRingReader(const MappedRingReader&)            = delete;
+  MappedRingReader& operator=(const MappedRingReader&) = delete;
+
+  /**
+   * @brief Map ring file and collect its records
+   *
+   * @param[in] filename  Ring file name
+   *
+   * @return `true` if file contains valid ring, `false` otherwise
+   */
+  bool open(const char* filename);
+
+  /**
+   * @brief Get number of intact records in ring
+   */
+  size_t getRecordCount() const { return recordCount; }
+
+  /**
+   * @brief Get record by index. Records are ordered by sequence number,
+   * the oldest one first
+   */
+  const MappedRing::Record& getRecord(size_t index) const
+  {
+    return records[index];
+  }
+
+  void close();
+
+  ~MappedRingReader() { close(); }
+};
+
+} // namespace utils
+
+} // namespace mklog
+
+#endif /* MappedRing.h */
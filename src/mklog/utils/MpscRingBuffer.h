@@ -0,0 +1,222 @@
+/**
+ * @file MpscRingBuffer.h
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Bounded lock-free multi-producer single-consumer ring buffer
+ *
+ * @version 0.1
+ * @date 2023-09-02
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#ifndef __MEERKAT_LOGS_UTILS_MPSCRINGBUFFER_H
+#define __MEERKAT_LOGS_UTILS_MPSCRINGBUFFER_H
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+
+namespace mklog
+{
+
+namespace utils
+{
+
+/**
+ * @brief Bounded queue of fixed-size values. Any number of threads may push
+ * values concurrently, only one thread may pop them. Each cell carries a
+ * sequence number, so producers only contend on a single `fetch`/`CAS` of
+ * the enqueue position and never wait for each other to finish copying.
+ *
+ * @tparam TValue   Trivially copyable value type
+ */
+template <typename TValue>
+class MpscRingBuffer
+{
+private:
+  static constexpr size_t CACHE_LINE_SIZE = 64;
+
+  struct Cell
+  {
+    std::atomic<size_t> sequence;
+    TValue              value;
+  };
+
+  Cell*  cells;
+  size_t indexMask;
+
+  alignas(CACHE_LINE_SIZE) std::atomic<size_t> enqueuePos;
+  alignas(CACHE_LINE_SIZE) std::atomic<size_t> dequeuePos;
+
+public:
+  /**
+   * @brief Create ring buffer
+   *
+   * @param[in] capacity  Maximum number of stored values. Must be a power
+   *                      of two
+   */
+  explicit MpscRingBuffer(size_t capacity)
+      : cells(new Cell[capacity]),
+        indexMask(capacity - 1),
+        enqueuePos(0),
+        dequeuePos(0)
+  {
+    assert(capacity >= 2 && (capacity & (capacity - 1)) == 0 &&
+           "Ring buffer capacity must be a power of two");
+
+    for (size_t i = 0; i < capacity; ++i)
+    {
+      cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  // No copying
+  MpscRingBuffer(const MpscRingBuffer&)            = delete;
+  MpscRingBuffer& operator=(const MpscRingBuffer&) = delete;
+
+  /**
+   * @brief Try to append value to the end of queue. Safe to call from
+   * multiple threads
+   *
+   * @param[in] value   Value to be appended
+   *
+   * @return `true` if value was appended, `false` if queue is full
+   */
+  bool tryPush(const TValue& value)
+  {
+    size_t pos = enqueuePos.load(std::memory_order_relaxed);
+
+    while (true)
+    {
+      Cell*  cell     = &cells[pos & indexMask];
+      size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      ptrdiff_t diff  = (ptrdiff_t)sequence - (ptrdiff_t)pos;
+
+      if (diff == 0)
+      {
+        // Cell is free, try to claim it
+        if (enqueuePos.compare_exchange_weak(pos, pos + 1,
+                                             std::memory_order_relaxed))
+        {
+          cell->value = value;
+          cell->sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      }
+      else if (diff < 0)
+      {
+        // Cell still holds value from previous lap
+        return false;
+      }
+      else
+      {
+        // Other producer claimed this cell
+        pos = enqueuePos.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * @brief Get value at the front of queue without removing it. Must be
+   * called only from the consumer thread
+   *
+   * @return Pointer to value, valid until `popFront()` is called. `nullptr`
+   *         if queue is empty
+   */
+  const TValue* front() const
+  {
+    size_t      pos      = dequeuePos.load(std::memory_order_relaxed);
+    const Cell* cell     = &cells[pos & indexMask];
+    size_t      sequence = cell->sequence.load(std::memory_order_acquire);
+
+    if (sequence != pos + 1)
+    {
+      return nullptr;
+    }
+
+    return &cell->value;
+  }
+
+  /**
+   * @brief Remove value at the front of queue. Must be called only from the
+   * consumer thread, after `front()` returned value
+   */
+  void popFront()
+  {
+    size_t pos  = dequeuePos.load(std::memory_order_relaxed);
+    Cell*  cell = &cells[pos & indexMask];
+
+    cell->sequence.store(pos + indexMask + 1, std::memory_order_release);
+    dequeuePos.store(pos + 1, std::memory_order_release);
+  }
+
+  /**
+   * @brief Try to remove value from the front of queue. Must be called only
+   * from the consumer thread
+   *
+   * @param[out] value  Removed value
+   *
+   * @return `true` if value was removed, `false` if queue is empty
+   */
+  bool tryPop(TValue& value)
+  {
+    const TValue* head = front();
+    if (head == nullptr)
+    {
+      return false;
+    }
+
+    value = *head;
+    popFront();
+
+    return true;
+  }
+
+  /**
+   * @brief Call function for every value pushed and not yet popped, from
+   * the oldest one, without removing values. Cells still being written by
+   * producers are skipped. Meant for signal handlers, which may interrupt
+   * consumer or producer at any point: uses no locks, some values may be
+   * missed or visited after they are popped
+   *
+   * @param[in] function  Callable receiving `const TValue&`
+   */
+  template <typename TFunction>
+  void forEachPending(TFunction function) const
+  {
+    const size_t endPos = enqueuePos.load(std::memory_order_acquire);
+    for (size_t pos = dequeuePos.load(std::memory_order_acquire);
+         pos != endPos; ++pos)
+    {
+      const Cell& cell = cells[pos & indexMask];
+      if (cell.sequence.load(std::memory_order_acquire) == pos + 1)
+      {
+        function(cell.value);
+      }
+    }
+  }
+
+  /**
+   * @brief Total number of values pushed to queue
+   */
+  size_t pushedCount() const
+  {
+    return enqueuePos.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief Total number of values popped from queue
+   */
+  size_t poppedCount() const
+  {
+    return dequeuePos.load(std::memory_order_acquire);
+  }
+
+  ~MpscRingBuffer() { delete[] cells; }
+};
+
+} // namespace utils
+
+} // namespace mklog
+
+#endif /* MpscRingBuffer.h */
@@ -0,0 +1,209 @@
+#include "mklog/utils/SegmentCompressor.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <zlib.h>
+
+namespace mklog
+{
+
+namespace utils
+{
+
+/// `ioprio_set()` arguments, not exported by C library headers
+static constexpr int IOPRIO_WHO_PROCESS = 1;
+static constexpr int IOPRIO_CLASS_IDLE  = 3;
+static constexpr int IOPRIO_CLASS_SHIFT = 13;
+
+static constexpr int NICE_LOWEST = 19;
+
+static constexpr char COMPRESSED_SUFFIX[] = ".gz";
+static constexpr char TEMPORARY_SUFFIX[]  = ".gz.tmp";
+
+/**
+ * @brief Give calling thread the lowest CPU and I/O priority. Linux applies
+ * these to single thread rather than to whole process
+ */
+static void lowerThreadPriority()
+{
+  const pid_t threadId = (pid_t)syscall(SYS_gettid);
+  setpriority(PRIO_PROCESS, (id_t)threadId, NICE_LOWEST);
+
+  struct sched_param param = {};
+  pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+
+  syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0,
+          IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT);
+}
+
+/**
+ * @brief Allocate copy of string with suffix appended
+ */
+static char* concatenate(const char* str, const char* suffix)
+{
+  const size_t strLen    = strlen(str);
+  const size_t suffixLen = strlen(suffix);
+  char*        result    = new char[strLen + suffixLen + 1];
+  memcpy(result, str, strLen);
+  memcpy(result + strLen, suffix, suffixLen + 1);
+  return result;
+}
+
+bool SegmentCompressor::enqueue(const char* filename)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  if (queueLength == QUEUE_CAPACITY ||
+      isStopping.load(std::memory_order_relaxed))
+  {
+    return false;
+  }
+
+  queue[(queueStart + queueLength) % QUEUE_CAPACITY] =
+      concatenate(filename, "");
+  ++queueLength;
+
+  if (!thread.joinable())
+  {
+    thread = std::thread(&SegmentCompressor::run, this);
+  }
+  wakeup.notify_one();
+
+  return true;
+}
+
+void SegmentCompressor::run()
+{
+  // Leave signal handling to logging threads
+  sigset_t blockedSignals = {};
+  sigfillset(&blockedSignals);
+  pthread_sigmask(SIG_BLOCK, &blockedSignals, NULL);
+
+  lowerThreadPriority();
+
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true)
+  {
+    wakeup.wait(lock, [this]() {
+      return queueLength > 0 || isStopping.load(std::memory_order_relaxed);
+    });
+    if (isStopping.load(std::memory_order_relaxed))
+    {
+      break;
+    }
+
+    char* filename = queue[queueStart];
+    queueStart     = (queueStart + 1) % QUEUE_CAPACITY;
+    --queueLength;
+
+    lock.unlock();
+    compress(filename);
+    delete[] filename;
+    lock.lock();
+  }
+}
+
+bool SegmentCompressor::compress(const char* filename)
+{
+  const int inputFd = open(filename, O_RDONLY | O_CLOEXEC);
+  if (inputFd < 0)
+  {
+    return false;
+  }
+
+  char* const temporaryName = concatenate(filename, TEMPORARY_SUFFIX);
+  const int   outputFd      = open(temporaryName,
+                                   O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                                   S_IRUSR | S_IWUSR);
+
+  // Stream keeps its own descriptor, so that output can be synced after
+  // stream is closed
+  char   mode[] = {'w', 'b', (char)('0' + COMPRESSION_LEVEL), '\0'};
+  gzFile output = outputFd >= 0 ? gzdopen(dup(outputFd), mode) : nullptr;
+
+  char* const chunk     = new char[CHUNK_SIZE];
+  bool        isWritten = output != nullptr;
+  while (isWritten)
+  {
+    if (isStopping.load(std::memory_order_relaxed))
+    {
+      isWritten = false;
+      break;
+    }
+
+    const ssize_t readLen = read(inputFd, chunk, CHUNK_SIZE);
+    if (readLen < 0 && errno == EINTR)
+      continue;
+    if (readLen < 0)
+    {
+      isWritten = false;
+      break;
+    }
+    if (readLen == 0)
+      break;
+
+    isWritten = gzwrite(output, chunk, (unsigned)readLen) == (int)readLen;
+  }
+  delete[] chunk;
+
+  // Compressed file is not read back, keep it out of page cache
+  posix_fadvise(inputFd, 0, 0, POSIX_FADV_DONTNEED);
+  close(inputFd);
+
+  if (output != nullptr && gzclose(output) != Z_OK)
+  {
+    isWritten = false;
+  }
+  if (outputFd >= 0)
+  {
+    isWritten = isWritten && fsync(outputFd) == 0;
+    close(outputFd);
+  }
+
+  char* const compressedName = concatenate(filename, COMPRESSED_SUFFIX);
+  if (isWritten && rename(temporaryName, compressedName) == 0)
+  {
+    unlink(filename);
+  }
+  else
+  {
+    isWritten = false;
+    unlink(temporaryName);
+  }
+
+  delete[] compressedName;
+  delete[] temporaryName;
+  return isWritten;
+}
+
+void SegmentCompressor::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    isStopping.store(true, std::memory_order_relaxed);
+    wakeup.notify_one();
+  }
+
+  if (thread.joinable())
+  {
+    thread.join();
+  }
+
+  for (size_t i = 0; i < queueLength; ++i)
+  {
+    delete[] queue[(queueStart + i) % QUEUE_CAPACITY];
+  }
+  queueStart  = 0;
+  queueLength = 0;
+}
+
+} // namespace utils
+
+} // namespace mklog
@@ -0,0 +1,117 @@
+/**
+ * @file SegmentCompressor.h
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Background compression of rotated log files
+ *
+ * @version 0.1
+ * @date 2023-09-17
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#ifndef __MEERKAT_LOGS_UTILS_SEGMENTCOMPRESSOR_H
+#define __MEERKAT_LOGS_UTILS_SEGMENTCOMPRESSOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+
+namespace mklog
+{
+
+namespace utils
+{
+
+/**
+ * @brief Compresses closed log files with gzip on a background thread,
+ * replacing each file with "<name>.gz". Thread runs with idle CPU and I/O
+ * priority, so it only uses resources left by the rest of process.
+ *
+ * Compressed data is written to "<name>.gz.tmp", which is synced and
+ * renamed when complete, and only then is the original file removed, so
+ * that no log content is lost if process dies. Files still queued when
+ * compressor is stopped are left uncompressed.
+ */
+class SegmentCompressor
+{
+public:
+  /**
+   * @brief Maximum number of files waiting for compression
+   */
+  static constexpr size_t QUEUE_CAPACITY = 16;
+
+  static constexpr int COMPRESSION_LEVEL = 6;
+
+private:
+  static constexpr size_t CHUNK_SIZE = 256 * 1024;
+
+  std::thread             thread;
+  std::mutex              mutex;
+  std::condition_variable wakeup;
+
+  /// Names of queued files, owned by compressor
+  char*  queue[QUEUE_CAPACITY];
+  size_t queueStart;
+  size_t queueLength;
+
+  std::atomic<bool> isStopping;
+
+  /**
+   * @brief Compressor thread routine. Compress queued files until stop is
+   * requested
+   */
+  void run();
+
+  /**
+   * @brief Compress single file and remove it
+   *
+   * @param[in] filename  File to be compressed
+   *
+   * @return `true` if file was replaced with compressed one, `false` if it
+   * was left intact
+   */
+  bool compress(const char* filename);
+
+public:
+  SegmentCompressor()
+      : thread(),
+        mutex(),
+        wakeup(),
+        queue(),
+        queueStart(0),
+        queueLength(0),
+        isStopping(false)
+  {
+  }
+
+  // No copying
+  SegmentCompressor(const SegmentCompressor&)            = delete;
+  SegmentCompressor& operator=(const SegmentCompressor&) = delete;
+
+  /**
+   * @brief Queue file for compression, starting compressor thread if it is
+   * not running
+   *
+   * @param[in] filename  Closed file which is no longer written
+   *
+   * @return `true` if file was queued, `false` if queue is full or
+   * compressor is stopped
+   */
+  bool enqueue(const char* filename);
+
+  /**
+   * @brief Stop compressor thread. File being compressed is left intact,
+   * as are files still queued
+   */
+  void stop();
+
+  ~SegmentCompressor() { stop(); }
+};
+
+} // namespace utils
+
+} // namespace mklog
+
+#endif /* SegmentCompressor.h */
@@ -0,0 +1,634 @@
+#include "mklog/utils/SignalSafeWriter.h"
+
+#include <cerrno>
+#include <cfloat>
+#include <cmath>
+#include <unistd.h>
+
+#include "mklog/utils/LogClock.h"
+
+namespace mklog
+{
+
+namespace utils
+{
+
+/**
+ * @brief Upper bound of width and precision, protects against runaway
+ * padding in corrupted arguments
+ */
+static constexpr int FIELD_LEN_MAX = 1024;
+
+/**
+ * @brief Number of significant digits which survive decimal scaling of
+ * `double` done here. Further digits are written as zeros
+ */
+static constexpr int DOUBLE_DIGITS_MAX = DBL_DIG;
+
+/**
+ * @brief Length of buffer for rendered floating point number: up to 309
+ * integer digits, point and fraction digits
+ */
+static constexpr size_t DOUBLE_LEN_MAX = 320 + DOUBLE_DIGITS_MAX;
+
+static bool isDigit(char ch) { return '0' <= ch && ch <= '9'; }
+
+/**
+ * @brief Read decimal number, advance pointer past it
+ */
+static int parseNumber(const char** str)
+{
+  int number = 0;
+  for (; isDigit(**str); ++*str)
+  {
+    if (number < FIELD_LEN_MAX)
+      number = number * 10 + (**str - '0');
+  }
+  return number < FIELD_LEN_MAX ? number : FIELD_LEN_MAX;
+}
+
+/**
+ * @brief Get most significant decimal digits of positive finite number,
+ * rounded to nearest
+ *
+ * @param[in]  value        Number
+ * @param[in]  digitCount   Number of digits, at most `DOUBLE_DIGITS_MAX`
+ * @param[out] digits       Digit characters
+ *
+ * @return Decimal exponent of the first digit
+ */
+static int getSignificantDigits(double value, int digitCount, char* digits)
+{
+  int exponent = 0;
+  if (std::fpclassify(value) == FP_ZERO)
+  {
+    memset(digits, '0', (size_t)digitCount);
+    return 0;
+  }
+
+  // Normalize to [1, 10) with few large steps to limit rounding error
+  while (value >= 1e16)
+  {
+    value /= 1e16;
+    exponent += 16;
+  }
+  while (value < 1e-16)
+  {
+    value *= 1e16;
+    exponent -= 16;
+  }
+  while (value >= 10)
+  {
+    value /= 10;
+    ++exponent;
+  }
+  while (value < 1)
+  {
+    value *= 10;
+    --exponent;
+  }
+
+  for (int i = 0; i < digitCount; ++i)
+  {
+    const int digit = (int)value < 10 ? (int)value : 9;
+    digits[i]       = (char)('0' + digit);
+    value           = (value - digit) * 10;
+  }
+
+  // Round half to even, as printf does
+  const bool isLastOdd = ((digits[digitCount - 1] - '0') & 1) != 0;
+  if (value < 5 || (value <= 5 && !isLastOdd))
+    return exponent;
+
+  // Round up, carrying into preceding digits
+  for (int i = digitCount - 1; i >= 0; --i)
+  {
+    if (digits[i] != '9')
+    {
+      ++digits[i];
+      return exponent;
+    }
+    digits[i] = '0';
+  }
+
+  // All digits were nines
+  digits[0] = '1';
+  return exponent + 1;
+}
+
+/**
+ * @brief Write 'e±XX' exponent suffix
+ *
+ * @return Number of written characters
+ */
+static size_t writeExponent(char* buffer, char letter, int exponent)
+{
+  size_t length    = 0;
+  buffer[length++] = letter;
+  buffer[length++] = exponent < 0 ? '-' : '+';
+
+  const unsigned absExponent = exponent < 0 ? (unsigned)-exponent
+                                            : (unsigned)exponent;
+  if (absExponent < 10)
+    buffer[length++] = '0';
+  return length + SignalSafeWriter::formatUnsigned(buffer + length, absExponent);
+}
+
+/**
+ * @brief Render positive finite number in '%f' style
+ *
+ * @return Number of written characters
+ */
+static size_t renderFixed(char* buffer, double value, int precision,
+                          bool hasPoint)
+{
+  size_t length = 0;
+
+  if (value >= 1e17)
+  {
+    // Integer part alone exceeds exact digits, pad it with zeros
+    char      digits[DOUBLE_DIGITS_MAX];
+    const int exponent =
+        getSignificantDigits(value, DOUBLE_DIGITS_MAX, digits);
+    memcpy(buffer, digits, DOUBLE_DIGITS_MAX);
+    length = DOUBLE_DIGITS_MAX;
+    memset(buffer + length, '0', (size_t)(exponent + 1 - DOUBLE_DIGITS_MAX));
+    length += (size_t)(exponent + 1 - DOUBLE_DIGITS_MAX);
+    if (hasPoint)
+      buffer[length++] = '.';
+    memset(buffer + length, '0', (size_t)precision);
+    return length + (size_t)precision;
+  }
+
+  const int fractionDigits =
+      precision < DOUBLE_DIGITS_MAX ? precision : DOUBLE_DIGITS_MAX;
+  uint64_t scale = 1;
+  for (int i = 0; i < fractionDigits; ++i)
+    scale *= 10;
+
+  uint64_t     integer   = (uint64_t)value;
+  const double scaled    = (value - (double)integer) * (double)scale;
+  uint64_t     fraction  = (uint64_t)scaled;
+  const double remainder = scaled - (double)fraction;
+
+  // Round half to even, as printf does
+  const uint64_t lastDigit = fractionDigits > 0 ? fraction : integer;
+  if (remainder > 0.5 || (remainder >= 0.5 && (lastDigit & 1) != 0))
+  {
+    ++fraction;
+  }
+  if (fraction >= scale)
+  {
+    ++integer;
+    fraction -= scale;
+  }
+
+  length = SignalSafeWriter::formatUnsigned(buffer, integer);
+  if (hasPoint)
+    buffer[length++] = '.';
+
+  char         fractionText[SignalSafeWriter::UNSIGNED_LEN_MAX];
+  const size_t fractionLen =
+      SignalSafeWriter::formatUnsigned(fractionText, fraction);
+  if (fractionDigits > 0)
+  {
+    memset(buffer + length, '0', (size_t)fractionDigits - fractionLen);
+    length += (size_t)fractionDigits - fractionLen;
+    memcpy(buffer + length, fractionText, fractionLen);
+    length += fractionLen;
+  }
+  memset(buffer + length, '0', (size_t)(precision - fractionDigits));
+  return length + (size_t)(precision - fractionDigits);
+}
+
+size_t SignalSafeWriter::formatUnsigned(char* buffer, uint64_t value)
+{
+  char   digits[UNSIGNED_LEN_MAX];
+  size_t digitCount = 0;
+  do
+  {
+    digits[digitCount++] = (char)('0' + value % 10);
+    value /= 10;
+  } while (value != 0);
+
+  for (size_t i = 0; i < digitCount; ++i)
+  {
+    buffer[i] = digits[digitCount - 1 - i];
+  }
+  return digitCount;
+}
+
+void SignalSafeWriter::append(const char* text, size_t length)
+{
+  while (length > 0)
+  {
+    if (bufferLength == bufferCapacity)
+    {
+      // Nowhere to put text
+      if (fd < 0)
+        return;
+      flush();
+    }
+
+    const size_t freeLen = bufferCapacity - bufferLength;
+    const size_t copyLen = length < freeLen ? length : freeLen;
+    memcpy(bufferData + bufferLength, text, copyLen);
+
+    bufferLength += copyLen;
+    text += copyLen;
+    length -= copyLen;
+  }
+}
+
+void SignalSafeWriter::appendRepeated(char ch, size_t count)
+{
+  char         block[32];
+  const size_t blockLen = count < sizeof(block) ? count : sizeof(block);
+  memset(block, ch, blockLen);
+
+  while (count > 0)
+  {
+    const size_t chunkLen = count < blockLen ? count : blockLen;
+    append(block, chunkLen);
+    count -= chunkLen;
+  }
+}
+
+void SignalSafeWriter::appendUnsigned(uint64_t value, size_t minDigits)
+{
+  char         digits[UNSIGNED_LEN_MAX];
+  const size_t digitCount = formatUnsigned(digits, value);
+
+  if (minDigits > digitCount)
+    appendRepeated('0', minDigits - digitCount);
+  append(digits, digitCount);
+}
+
+void SignalSafeWriter::appendTimestamp(uint64_t                      ticks,
+                                       TimestampFormatter::Precision precision)
+{
+  time_t   seconds     = 0;
+  uint32_t nanoseconds = 0;
+  LogClock::toRealtimeSignalSafe(ticks, &seconds, &nanoseconds);
+
+  char         timestamp[TimestampFormatter::TIMESTAMP_LEN_MAX + 1];
+  const size_t timestampLen = TimestampFormatter::formatSignalSafe(
+      timestamp, seconds, nanoseconds, precision);
+  append(timestamp, timestampLen);
+}
+
+SignalSafeWriter::Conversion SignalSafeWriter::parseConversion(
+    const char* conversion, const int* stars, size_t starCount)
+{
+  Conversion parsed = {.isLeftAligned = false,
+                       .isZeroPadded  = false,
+                       .isAlternate   = false,
+                       .signChar      = '\0',
+                       .width         = 0,
+                       .precision     = -1,
+                       .valueBits     = 32,
+                       .type          = '\0'};
+
+  size_t      starIndex = 0;
+  const char* cur       = conversion + 1; // Skip '%'
+
+  for (; *cur != '\0' && strchr("-+ #0'I", *cur) != nullptr; ++cur)
+  {
+    switch (*cur)
+    {
+    case '-': parsed.isLeftAligned = true; break;
+    case '0': parsed.isZeroPadded = true; break;
+    case '#': parsed.isAlternate = true; break;
+    case '+': parsed.signChar = '+'; break;
+    case ' ':
+      if (parsed.signChar != '+')
+        parsed.signChar = ' ';
+      break;
+    default: break; // Grouping flags are ignored
+    }
+  }
+
+  if (*cur == '*')
+  {
+    int width = starIndex < starCount ? stars[starIndex++] : 0;
+    if (width < 0)
+    {
+      parsed.isLeftAligned = true;
+      width                = width > -FIELD_LEN_MAX ? -width : FIELD_LEN_MAX;
+    }
+    parsed.width = width < FIELD_LEN_MAX ? width : FIELD_LEN_MAX;
+    ++cur;
+  }
+  else
+  {
+    parsed.width = parseNumber(&cur);
+  }
+
+  if (*cur == '.')
+  {
+    ++cur;
+    if (*cur == '*')
+    {
+      const int precision = starIndex < starCount ? stars[starIndex++] : 0;
+      // Negative precision is taken as omitted
+      parsed.precision = precision < FIELD_LEN_MAX ? precision : FIELD_LEN_MAX;
+      ++cur;
+    }
+    else
+    {
+      parsed.precision = parseNumber(&cur);
+    }
+  }
+
+  for (; *cur != '\0' && strchr("hlLqjzt", *cur) != nullptr; ++cur)
+  {
+    if (*cur == 'h')
+      parsed.valueBits = parsed.valueBits == 16 ? 8 : 16;
+    else
+      parsed.valueBits = 64;
+  }
+
+  parsed.type = *cur;
+  return parsed;
+}
+
+void SignalSafeWriter::appendPadded(const Conversion& conversion,
+                                    const char* prefix, size_t prefixLen,
+                                    const char* body, size_t bodyLen,
+                                    size_t zeroCount, bool canZeroPad)
+{
+  const size_t contentLen = prefixLen + zeroCount + bodyLen;
+  const size_t width      = (size_t)conversion.width;
+  const size_t padLen     = width > contentLen ? width - contentLen : 0;
+
+  const bool isZeroPad =
+      canZeroPad && conversion.isZeroPadded && !conversion.isLeftAligned;
+
+  if (!conversion.isLeftAligned && !isZeroPad)
+    appendRepeated(' ', padLen);
+
+  append(prefix, prefixLen);
+  appendRepeated('0', zeroCount + (isZeroPad ? padLen : 0));
+  append(body, bodyLen);
+
+  if (conversion.isLeftAligned)
+    appendRepeated(' ', padLen);
+}
+
+void SignalSafeWriter::appendIntegerConversion(const Conversion& conversion,
+                                               uint64_t          value)
+{
+  const unsigned bits = conversion.valueBits;
+  const uint64_t mask = bits >= 64 ? UINT64_MAX : (uint64_t{1} << bits) - 1;
+  value &= mask;
+
+  if (conversion.type == 'c')
+  {
+    const char ch = (char)value;
+    appendPadded(conversion, "", 0, &ch, 1, 0, false);
+    return;
+  }
+
+  unsigned    base       = 10;
+  const char* digitChars = "0123456789abcdef";
+  bool        isSigned   = false;
+  switch (conversion.type)
+  {
+  case 'o': base = 8; break;
+  case 'x': base = 16; break;
+  case 'X':
+    base       = 16;
+    digitChars = "0123456789ABCDEF";
+    break;
+  case 'u': break;
+  default:  isSigned = true; break; // 'd', 'i' and mismatched conversions
+  }
+
+  bool isNegative = false;
+  if (isSigned)
+  {
+    // Sign-extend value truncated to argument width
+    if (bits < 64 && ((value >> (bits - 1)) & 1) != 0)
+      value |= ~mask;
+    if ((int64_t)value < 0)
+    {
+      isNegative = true;
+      value      = 0 - value;
+    }
+  }
+
+  const bool isZero = value == 0;
+
+  char   digits[24];
+  size_t digitCount = 0;
+  // Zero with zero precision is rendered as empty string
+  if (!isZero || conversion.precision != 0)
+  {
+    do
+    {
+      digits[sizeof(digits) - 1 - digitCount++] = digitChars[value % base];
+      value /= base;
+    } while (value != 0);
+  }
+
+  const size_t precision = conversion.precision > 0
+                               ? (size_t)conversion.precision
+                               : 0;
+  size_t zeroCount = precision > digitCount ? precision - digitCount : 0;
+
+  char   prefix[2];
+  size_t prefixLen = 0;
+  if (isNegative)
+    prefix[prefixLen++] = '-';
+  else if (isSigned && conversion.signChar != '\0')
+    prefix[prefixLen++] = conversion.signChar;
+
+  if (conversion.isAlternate && base == 16 && !isZero)
+  {
+    prefix[prefixLen++] = '0';
+    prefix[prefixLen++] = conversion.type;
+  }
+  if (conversion.isAlternate && base == 8 && zeroCount == 0 &&
+      (digitCount == 0 || digits[sizeof(digits) - digitCount] != '0'))
+  {
+    zeroCount = 1;
+  }
+
+  appendPadded(conversion, prefix, prefixLen,
+               digits + sizeof(digits) - digitCount, digitCount, zeroCount,
+               conversion.precision < 0);
+}
+
+void SignalSafeWriter::appendDoubleConversion(const Conversion& conversion,
+                                              double            value)
+{
+  char   prefix[1];
+  size_t prefixLen = 0;
+  if (std::signbit(value))
+  {
+    prefix[prefixLen++] = '-';
+    value               = -value;
+  }
+  else if (conversion.signChar != '\0')
+  {
+    prefix[prefixLen++] = conversion.signChar;
+  }
+
+  const bool isUpper = 'A' <= conversion.type && conversion.type <= 'Z';
+  if (std::isnan(value))
+  {
+    appendPadded(conversion, prefix, prefixLen, isUpper ? "NAN" : "nan", 3, 0,
+                 false);
+    return;
+  }
+  if (value > DBL_MAX)
+  {
+    appendPadded(conversion, prefix, prefixLen, isUpper ? "INF" : "inf", 3, 0,
+                 false);
+    return;
+  }
+
+  const int  precision = conversion.precision < 0 ? 6 : conversion.precision;
+  const char exponentLetter = isUpper ? 'E' : 'e';
+
+  char   body[DOUBLE_LEN_MAX + FIELD_LEN_MAX];
+  size_t bodyLen = 0;
+
+  switch (conversion.type)
+  {
+  case 'f':
+  case 'F':
+    bodyLen = renderFixed(body, value, precision,
+                          precision > 0 || conversion.isAlternate);
+    break;
+
+  case 'g':
+  case 'G':
+  {
+    int significant = precision == 0 ? 1 : precision;
+    if (significant > DOUBLE_DIGITS_MAX)
+      significant = DOUBLE_DIGITS_MAX;
+
+    char      digits[DOUBLE_DIGITS_MAX];
+    const int exponent = getSignificantDigits(value, significant, digits);
+    const bool isZero = std::fpclassify(value) == FP_ZERO;
+    if (isZero || (-4 <= exponent && exponent < significant))
+    {
+      // Fixed notation with `significant` digits in total
+      if (exponent >= 0)
+      {
+        memcpy(body, digits, (size_t)exponent + 1);
+        bodyLen         = (size_t)exponent + 1;
+        body[bodyLen++] = '.';
+        memcpy(body + bodyLen, digits + exponent + 1,
+               (size_t)(significant - exponent - 1));
+        bodyLen += (size_t)(significant - exponent - 1);
+      }
+      else
+      {
+        body[bodyLen++] = '0';
+        body[bodyLen++] = '.';
+        memset(body + bodyLen, '0', (size_t)(-exponent - 1));
+        bodyLen += (size_t)(-exponent - 1);
+        memcpy(body + bodyLen, digits, (size_t)significant);
+        bodyLen += (size_t)significant;
+      }
+    }
+    else
+    {
+      body[bodyLen++] = digits[0];
+      body[bodyLen++] = '.';
+      memcpy(body + bodyLen, digits + 1, (size_t)significant - 1);
+      bodyLen += (size_t)significant - 1;
+    }
+
+    // Trailing zeros are removed unless '#' flag is given
+    if (!conversion.isAlternate)
+    {
+      while (body[bodyLen - 1] == '0')
+        --bodyLen;
+      if (body[bodyLen - 1] == '.')
+        --bodyLen;
+    }
+
+    if (!isZero && (exponent < -4 || exponent >= significant))
+      bodyLen += writeExponent(body + bodyLen, exponentLetter, exponent);
+    break;
+  }
+
+  default: // 'e', 'E'; hexadecimal 'a', 'A' are rendered in decimal too
+  {
+    const int significant = precision + 1 < DOUBLE_DIGITS_MAX
+                                ? precision + 1
+                                : DOUBLE_DIGITS_MAX;
+
+    char      digits[DOUBLE_DIGITS_MAX];
+    const int exponent = getSignificantDigits(value, significant, digits);
+
+    body[bodyLen++] = digits[0];
+    if (precision > 0 || conversion.isAlternate)
+      body[bodyLen++] = '.';
+    memcpy(body + bodyLen, digits + 1, (size_t)significant - 1);
+    bodyLen += (size_t)significant - 1;
+    memset(body + bodyLen, '0', (size_t)(precision + 1 - significant));
+    bodyLen += (size_t)(precision + 1 - significant);
+
+    bodyLen += writeExponent(body + bodyLen, exponentLetter, exponent);
+    break;
+  }
+  }
+
+  appendPadded(conversion, prefix, prefixLen, body, bodyLen, 0, true);
+}
+
+void SignalSafeWriter::appendStringConversion(const Conversion& conversion,
+                                              const char*       str)
+{
+  if (str == nullptr)
+    str = "(null)";
+
+  const size_t length = conversion.precision >= 0
+                            ? strnlen(str, (size_t)conversion.precision)
+                            : strlen(str);
+  appendPadded(conversion, "", 0, str, length, 0, false);
+}
+
+void SignalSafeWriter::appendPointerConversion(const Conversion& conversion,
+                                               const void*       pointer)
+{
+  if (pointer == nullptr)
+  {
+    appendPadded(conversion, "", 0, "(nil)", 5, 0, false);
+    return;
+  }
+
+  Conversion hexConversion  = conversion;
+  hexConversion.type        = 'x';
+  hexConversion.isAlternate = true;
+  hexConversion.valueBits   = 64;
+  appendIntegerConversion(hexConversion, (uint64_t)(uintptr_t)pointer);
+}
+
+void SignalSafeWriter::flush()
+{
+  if (fd < 0)
+    return;
+
+  size_t writtenLen = 0;
+  while (writtenLen < bufferLength)
+  {
+    const ssize_t result =
+        write(fd, bufferData + writtenLen, bufferLength - writtenLen);
+    if (result < 0 && errno == EINTR)
+      continue;
+    // Nothing can be done about failed write in crash handler
+    if (result <= 0)
+      break;
+    writtenLen += (size_t)result;
+  }
+  bufferLength = 0;
+}
+
+} // namespace utils
+
+} // namespace mklog
@@ -0,0 +1,210 @@
+/**
+ * @file SignalSafeWriter.h
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Text output usable inside signal handlers
+ *
+ * @version 0.1
+ * @date 2023-09-14
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#ifndef __MEERKAT_LOGS_UTILS_SIGNALSAFEWRITER_H
+#define __MEERKAT_LOGS_UTILS_SIGNALSAFEWRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "mklog/utils/TimestampFormatter.h"
+
+namespace mklog
+{
+
+namespace utils
+{
+
+/**
+ * @brief Writes text to file descriptor through caller-provided buffer.
+ * Uses no locks, no heap memory and no library functions except `write(2)`
+ * and string functions, so it is async-signal-safe. Buffer is written out
+ * when full; if there is no file descriptor, text not fitting into buffer
+ * is dropped.
+ */
+class SignalSafeWriter
+{
+private:
+  /**
+   * @brief Parsed printf conversion specification
+   */
+  struct Conversion
+  {
+    bool     isLeftAligned;
+    bool     isZeroPadded;
+    bool     isAlternate;
+    char     signChar;  /// '+', ' ' or NUL
+    int      width;
+    int      precision; /// Negative if not given
+    unsigned valueBits; /// Width of integer argument set by length modifier
+    char     type;
+  };
+
+  char*  bufferData;
+  size_t bufferCapacity;
+  size_t bufferLength;
+  int    fd;
+
+  static Conversion parseConversion(const char* conversion, const int* stars,
+                                    size_t starCount);
+
+  void appendRepeated(char ch, size_t count);
+
+  /**
+   * @brief Append conversion result padded to conversion width
+   *
+   * @param[in] conversion  Conversion specification
+   * @param[in] prefix      Sign or radix prefix, placed before zeros
+   * @param[in] prefixLen   Prefix length
+   * @param[in] body        Digits or text
+   * @param[in] bodyLen     Body length
+   * @param[in] zeroCount   Number of zeros required by precision
+   * @param[in] canZeroPad  Whether '0' flag applies to conversion
+   */
+  void appendPadded(const Conversion& conversion, const char* prefix,
+                    size_t prefixLen, const char* body, size_t bodyLen,
+                    size_t zeroCount, bool canZeroPad);
+
+  /**
+   * @brief Append integer. Value is truncated to width given by length
+   * modifier and treated as signed or unsigned according to conversion
+   * type, as printf does
+   */
+  void appendIntegerConversion(const Conversion& conversion, uint64_t value);
+
+  void appendDoubleConversion(const Conversion& conversion, double value);
+
+  void appendStringConversion(const Conversion& conversion, const char* str);
+
+  void appendPointerConversion(const Conversion& conversion,
+                               const void*       pointer);
+
+public:
+  /**
+   * @brief Maximum length of number written by `formatUnsigned()`
+   */
+  static constexpr size_t UNSIGNED_LEN_MAX = 20;
+
+  /**
+   * @brief Create writer
+   *
+   * @param[in] buffer    Buffer for text. Must outlive writer
+   * @param[in] capacity  Buffer size
+   * @param[in] fd        Output file descriptor, -1 to keep text in buffer
+   */
+  SignalSafeWriter(char* buffer, size_t capacity, int fd)
+      : bufferData(buffer), bufferCapacity(capacity), bufferLength(0), fd(fd)
+  {
+  }
+
+  // No copying
+  SignalSafeWriter(const SignalSafeWriter&)            = delete;
+  SignalSafeWriter& operator=(const SignalSafeWriter&) = delete;
+
+  /**
+   * @brief Write number in decimal
+   *
+   * @param[out] buffer   Buffer of at least `UNSIGNED_LEN_MAX` characters
+   * @param[in]  value    Number
+   *
+   * @return Number of written characters. Buffer is not NUL-terminated
+   */
+  static size_t formatUnsigned(char* buffer, uint64_t value);
+
+  /**
+   * @brief Append characters
+   *
+   * @param[in] text    Characters to be appended
+   * @param[in] length  Number of characters
+   */
+  void append(const char* text, size_t length);
+
+  /**
+   * @brief Append NUL-terminated string. Null pointer is written as
+   * "(null)", like printf does
+   */
+  void append(const char* str)
+  {
+    if (str == nullptr)
+      str = "(null)";
+    append(str, strlen(str));
+  }
+
+  void append(char ch) { append(&ch, 1); }
+
+  /**
+   * @brief Append number in decimal, padded with zeros to `minDigits`
+   */
+  void appendUnsigned(uint64_t value, size_t minDigits = 1);
+
+  /**
+   * @brief Append message timestamp, rendered with
+   * `TimestampFormatter::formatSignalSafe()`
+   *
+   * @param[in] ticks       `LogClock` ticks
+   * @param[in] precision   Number of fraction digits
+   */
+  void appendTimestamp(uint64_t ticks, TimestampFormatter::Precision precision);
+
+  /**
+   * @brief Append value rendered with single printf conversion. Supports
+   * flags, width, precision and conversions `diouxXcspfFeEgGaA`. Floating
+   * point values are rendered with at most 15 significant digits (integer
+   * part of '%f' below 1e17 is exact), hexadecimal floating point
+   * conversions are rendered like '%e'
+   *
+   * @param[in] conversion  Conversion specification, e.g. "%-8.3f"
+   * @param[in] stars       Values of '*' width and precision
+   * @param[in] starCount   Number of values in `stars`
+   * @param[in] value       Value to be rendered
+   */
+  template <typename TValue>
+  void appendConversion(const char* conversion, const int* stars,
+                        size_t starCount, TValue value)
+  {
+    const Conversion parsed = parseConversion(conversion, stars, starCount);
+
+    if constexpr (std::is_same_v<TValue, const char*>)
+    {
+      appendStringConversion(parsed, value);
+    }
+    else if constexpr (std::is_pointer_v<TValue>)
+    {
+      appendPointerConversion(parsed, value);
+    }
+    else if constexpr (std::is_floating_point_v<TValue>)
+    {
+      appendDoubleConversion(parsed, (double)value);
+    }
+    else
+    {
+      static_assert(std::is_integral_v<TValue>, "Unsupported value type");
+      appendIntegerConversion(parsed, (uint64_t)value);
+    }
+  }
+
+  /**
+   * @brief Write buffered text to file descriptor
+   */
+  void flush();
+
+  const char* data() const { return bufferData; }
+
+  size_t length() const { return bufferLength; }
+};
+
+} // namespace utils
+
+} // namespace mklog
+
+#endif /* SignalSafeWriter.h */
@@ -52,14 +52,17 @@ public:
     friend class SimpleList;
 
     iterator(const iterator& other)
-        : lastNode(other.lastNode), curNode(other.curNode)
+        : parentList(other.parentList),
+          lastNode(other.lastNode),
+          curNode(other.curNode)
     {
     }
 
     iterator& operator=(const iterator& other)
     {
-      curNode  = other.curNode;
-      lastNode = other.lastNode;
+      parentList = other.parentList;
+      curNode    = other.curNode;
+      lastNode   = other.lastNode;
       return *this;
     }
 
@@ -78,7 +81,8 @@ public:
     iterator& operator++()
     {
       assert(curNode != nullptr && "Cannot increment end iterator");
-      curNode = curNode->next;
+      lastNode = curNode;
+      curNode  = curNode->next;
 
       if (curNode == nullptr)
         lastNode = nullptr;
@@ -90,13 +94,10 @@ public:
     {
       assert(curNode != nullptr && "Cannot increment end iterator");
 
-      ListNode* oldNode = curNode;
-      curNode           = curNode->next;
+      iterator oldIt = *this;
+      ++*this;
 
-      if (curNode == nullptr)
-        lastNode = nullptr;
-
-      return iterator(oldNode);
+      return oldIt;
     }
 
     bool operator==(const iterator& other) const
@@ -108,7 +109,7 @@ public:
     ~iterator() {}
   };
 
-  SimpleList() : listHead(nullptr) {}
+  SimpleList() : listHead(nullptr), listSize(0) {}
 
   void pushFront(TValue value)
   {
@@ -140,6 +141,9 @@ public:
     --listSize;
   }
 
+  /**
+   * @brief Remove element. Iterator is moved to the next element
+   */
   void erase(iterator& it)
   {
     assert(it != end() && "Cannot erase element at end()");
@@ -157,6 +161,10 @@ public:
       it.lastNode->next = curNode->next;
     }
 
+    it.curNode = curNode->next;
+    if (it.curNode == nullptr)
+      it.lastNode = nullptr;
+
     delete curNode;
     --listSize;
   }
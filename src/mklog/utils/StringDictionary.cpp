@@ -0,0 +1,131 @@
+#include "mklog/utils/StringDictionary.h"
+
+#include <cstring>
+
+namespace mklog
+{
+
+namespace utils
+{
+
+uint64_t StringDictionary::getHash(const char* str, size_t length)
+{
+  // FNV-1a
+  uint64_t hash = 0xCBF29CE484222325;
+  for (size_t i = 0; i < length; ++i)
+  {
+    hash = (hash ^ (uint8_t)str[i]) * 0x100000001B3;
+  }
+  return hash;
+}
+
+StringDictionary::Entry& StringDictionary::findEntry(const char* str,
+                                                     size_t      length,
+                                                     uint64_t    hash) const
+{
+  size_t index = (size_t)hash & (capacity - 1);
+  while (true)
+  {
+    Entry& entry = entries[index];
+    if (entry.str == nullptr ||
+        (entry.hash == hash && entry.length == length &&
+         memcmp(entry.str, str, length) == 0))
+    {
+      return entry;
+    }
+    index = (index + 1) & (capacity - 1);
+  }
+}
+
+void StringDictionary::grow()
+{
+  Entry* const oldEntries  = entries;
+  const size_t oldCapacity = capacity;
+
+  capacity = capacity == 0 ? CAPACITY_INITIAL : 2 * capacity;
+  entries  = new Entry[capacity]();
+
+  for (size_t i = 0; i < oldCapacity; ++i)
+  {
+    const Entry& entry = oldEntries[i];
+    if (entry.str != nullptr)
+    {
+      findEntry(entry.str, entry.length, entry.hash) = entry;
+    }
+  }
+  delete[] oldEntries;
+
+  // Cached entries have moved
+  for (CachedString& cached : cache)
+  {
+    cached = {};
+  }
+}
+
+StringDictionary::Entry& StringDictionary::insert(const char* str,
+                                                  size_t      length,
+                                                  bool*       isNew)
+{
+  // Keep table at most half full
+  if (2 * ((size_t)count + 1) > capacity)
+  {
+    grow();
+  }
+
+  const uint64_t hash  = getHash(str, length);
+  Entry&         entry = findEntry(str, length, hash);
+  *isNew               = entry.str == nullptr;
+  if (*isNew)
+  {
+    entry.hash   = hash;
+    entry.str    = new char[length + 1];
+    entry.length = length;
+    entry.id     = ++count;
+    memcpy(entry.str, str, length);
+    entry.str[length] = '\0';
+  }
+
+  return entry;
+}
+
+uint32_t StringDictionary::getId(const char* str, bool* isNew)
+{
+  CachedString& cached =
+      cache[((uintptr_t)str >> 3 ^ (uintptr_t)str >> 11) % CACHE_SIZE];
+
+  // Memory at cached address may hold different string now
+  if (cached.address == str && cached.entry != nullptr &&
+      strcmp(cached.entry->str, str) == 0)
+  {
+    *isNew = false;
+    return cached.entry->id;
+  }
+
+  const Entry& entry = insert(str, strlen(str), isNew);
+  cached             = {.address = str, .entry = &entry};
+  return entry.id;
+}
+
+void StringDictionary::clear()
+{
+  for (size_t i = 0; i < capacity; ++i)
+  {
+    delete[] entries[i].str;
+    entries[i] = {};
+  }
+  for (CachedString& cached : cache)
+  {
+    cached = {};
+  }
+  count = 0;
+}
+
+StringDictionary::~StringDictionary()
+{
+  clear();
+  delete[] entries;
+}
+
+} // namespace utils
+
+} // namespace mklog
@@ -0,0 +1,119 @@
+/**
+ * @file StringDictionary.h
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Assignment of numeric ids to strings
+ *
+ * @version 0.1
+ * @date 2023-09-17
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#ifndef __MEERKAT_LOGS_UTILS_STRINGDICTIONARY_H
+#define __MEERKAT_LOGS_UTILS_STRINGDICTIONARY_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace mklog
+{
+
+namespace utils
+{
+
+/**
+ * @brief Hash table mapping strings to ids assigned in insertion order,
+ * starting from 1. Strings are looked up by content, so that ids stay
+ * correct when string memory is reused. Not thread-safe.
+ */
+class StringDictionary
+{
+public:
+  static constexpr uint32_t ID_NONE = 0;
+
+private:
+  struct Entry
+  {
+    uint64_t hash;
+    char*    str; /// Copy of string, `nullptr` if entry is empty
+    size_t   length;
+    uint32_t id;
+  };
+
+  /**
+   * @brief Recently looked up string. Strings are mostly passed at the same
+   * addresses, so cached id is checked with comparison instead of hashing
+   */
+  struct CachedString
+  {
+    const char* address;
+    const Entry* entry;
+  };
+
+  static constexpr size_t CAPACITY_INITIAL = 64;
+  static constexpr size_t CACHE_SIZE       = 256;
+
+  Entry*   entries;
+  size_t   capacity;
+  uint32_t count;
+
+  CachedString cache[CACHE_SIZE];
+
+  static uint64_t getHash(const char* str, size_t length);
+
+  /**
+   * @brief Find entry holding string or empty entry where it belongs
+   */
+  Entry& findEntry(const char* str, size_t length, uint64_t hash) const;
+
+  void grow();
+
+  /**
+   * @brief Find entry of string, adding it if it is new
+   */
+  Entry& insert(const char* str, size_t length, bool* isNew);
+
+public:
+  StringDictionary() : entries(nullptr), capacity(0), count(0), cache() {}
+
+  // No copying
+  StringDictionary(const StringDictionary&)            = delete;
+  StringDictionary& operator=(const StringDictionary&) = delete;
+
+  /**
+   * @brief Get id of string, adding it if it is new
+   *
+   * @param[in]  str      String
+   * @param[in]  length   String length
+   * @param[out] isNew    Whether string was added by this call
+   *
+   * @return String id
+   */
+  uint32_t getId(const char* str, size_t length, bool* isNew)
+  {
+    return insert(str, length, isNew).id;
+  }
+
+  /**
+   * @brief Get id of NUL-terminated string, adding it if it is new
+   *
+   * @param[in]  str      String
+   * @param[out] isNew    Whether string was added by this call
+   *
+   * @return String id
+   */
+  uint32_t getId(const char* str, bool* isNew);
+
+  /**
+   * @brief Remove all strings. Ids are assigned from 1 again
+   */
+  void clear();
+
+  ~StringDictionary();
+};
+
+} // namespace utils
+
+} // namespace mklog
+
+#endif /* StringDictionary.h */
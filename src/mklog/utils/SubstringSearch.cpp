@@ -0,0 +1,222 @@
+#include "mklog/utils/SubstringSearch.h"
+
+#include <cassert>
+#include <cstring>
+#include <immintrin.h>
+
+namespace mklog
+{
+
+namespace utils
+{
+
+/**
+ * @brief Find pattern with C library
+ */
+static size_t findScalar(const char* text, size_t length, const char* pattern,
+                         size_t patternLen)
+{
+  const void* found = memmem(text, length, pattern, patternLen);
+  return found != nullptr
+             ? (size_t)(static_cast<const char*>(found) - text)
+             : SubstringSearch::NOT_FOUND;
+}
+
+/**
+ * @brief Find pattern checking `TSearch::WIDTH` positions at once. Block at
+ * position is compared with the first pattern character and block at the
+ * same position shifted by pattern length is compared with the last one, so
+ * that few false candidates are left.
+ *
+ * @tparam TSearch  Class with static `findCandidates(firstBlock, lastBlock,
+ *                  first, last)` returning bit mask of positions where both
+ *                  blocks hold respective characters
+ */
+template <typename TSearch>
+static size_t findText(const char* text, size_t length, const char* pattern,
+                       size_t patternLen)
+{
+  // Single character is found by `memchr()` as fast
+  if (patternLen < 2 || patternLen > length)
+  {
+    return findScalar(text, length, pattern, patternLen);
+  }
+
+  const char   first         = pattern[0];
+  const char   last          = pattern[patternLen - 1];
+  const size_t positionCount = length - patternLen + 1;
+
+  size_t pos = 0;
+  for (; positionCount - pos >= TSearch::WIDTH; pos += TSearch::WIDTH)
+  {
+    uint64_t found = TSearch::findCandidates(
+        text + pos, text + pos + patternLen - 1, first, last);
+    while (found != 0)
+    {
+      const size_t index = __builtin_ctzll(found);
+      found &= found - 1;
+
+      if (memcmp(text + pos + index + 1, pattern + 1, patternLen - 2) == 0)
+        return pos + index;
+    }
+  }
+
+  // Check remaining positions with C library
+  const size_t found =
+      findScalar(text + pos, length - pos, pattern, patternLen);
+  return found != SubstringSearch::NOT_FOUND ? pos + found : found;
+}
+
+struct Sse2Search
+{
+  static constexpr size_t WIDTH = 16;
+
+  __attribute__((target("sse2"))) static uint64_t
+  findCandidates(const char* firstBlock, const char* lastBlock, char first,
+                 char last)
+  {
+    const __m128i firstData =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(firstBlock));
+    const __m128i lastData =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(lastBlock));
+
+    const __m128i found =
+        _mm_and_si128(_mm_cmpeq_epi8(firstData, _mm_set1_epi8(first)),
+                      _mm_cmpeq_epi8(lastData, _mm_set1_epi8(last)));
+    return (uint32_t)_mm_movemask_epi8(found);
+  }
+};
+
+struct Avx2Search
+{
+  static constexpr size_t WIDTH = 32;
+
+  __attribute__((target("avx2"))) static uint64_t
+  findCandidates(const char* firstBlock, const char* lastBlock, char first,
+                 char last)
+  {
+    const __m256i firstData =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(firstBlock));
+    const __m256i lastData =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lastBlock));
+
+    const __m256i found =
+        _mm256_and_si256(_mm256_cmpeq_epi8(firstData, _mm256_set1_epi8(first)),
+                         _mm256_cmpeq_epi8(lastData, _mm256_set1_epi8(last)));
+    return (uint32_t)_mm256_movemask_epi8(found);
+  }
+};
+
+struct Avx512Search
+{
+  static constexpr size_t WIDTH = 64;
+
+  __attribute__((target("avx512f,avx512bw"))) static uint64_t
+  findCandidates(const char* firstBlock, const char* lastBlock, char first,
+                 char last)
+  {
+    const __m512i firstData = _mm512_loadu_si512(firstBlock);
+    const __m512i lastData  = _mm512_loadu_si512(lastBlock);
+
+    return _mm512_cmpeq_epi8_mask(firstData, _mm512_set1_epi8(first)) &
+           _mm512_cmpeq_epi8_mask(lastData, _mm512_set1_epi8(last));
+  }
+};
+
+// Entry points are flattened so that search functions are inlined into code
+// compiled for their instruction set
+
+__attribute__((target("sse2"), flatten)) static size_t
+findSse2(const char* text, size_t length, const char* pattern,
+         size_t patternLen)
+{
+  return findText<Sse2Search>(text, length, pattern, patternLen);
+}
+
+__attribute__((target("avx2"), flatten)) static size_t
+findAvx2(const char* text, size_t length, const char* pattern,
+         size_t patternLen)
+{
+  return findText<Avx2Search>(text, length, pattern, patternLen);
+}
+
+__attribute__((target("avx512f,avx512bw"), flatten)) static size_t
+findAvx512(const char* text, size_t length, const char* pattern,
+           size_t patternLen)
+{
+  return findText<Avx512Search>(text, length, pattern, patternLen);
+}
+
+std::atomic<SubstringSearch::FindFunction> SubstringSearch::s_findFunction(
+    &SubstringSearch::findFirstCall);
+
+SubstringSearch::FindFunction
+SubstringSearch::getFindFunction(Implementation implementation)
+{
+  switch (implementation)
+  {
+  case Implementation::AVX512:
+    return &findAvx512;
+  case Implementation::AVX2:
+    return &findAvx2;
+  case Implementation::SSE2:
+    return &findSse2;
+  case Implementation::SCALAR:
+  default:
+    return &findScalar;
+  }
+}
+
+bool SubstringSearch::isSupported(Implementation implementation)
+{
+  __builtin_cpu_init();
+
+  switch (implementation)
+  {
+  case Implementation::AVX512:
+    return __builtin_cpu_supports("avx512f") &&
+           __builtin_cpu_supports("avx512bw");
+  case Implementation::AVX2:
+    return __builtin_cpu_supports("avx2");
+  case Implementation::SSE2:
+    return __builtin_cpu_supports("sse2");
+  case Implementation::SCALAR:
+    return true;
+  default:
+    return false;
+  }
+}
+
+SubstringSearch::Implementation SubstringSearch::detectImplementation()
+{
+  constexpr Implementation PREFERENCE_ORDER[] = {
+      Implementation::AVX512, Implementation::AVX2, Implementation::SSE2};
+
+  for (Implementation implementation : PREFERENCE_ORDER)
+  {
+    if (isSupported(implementation))
+      return implementation;
+  }
+  return Implementation::SCALAR;
+}
+
+size_t SubstringSearch::findFirstCall(const char* text, size_t length,
+                                      const char* pattern, size_t patternLen)
+{
+  const FindFunction find = getFindFunction(detectImplementation());
+  s_findFunction.store(find, std::memory_order_relaxed);
+  return find(text, length, pattern, patternLen);
+}
+
+void SubstringSearch::useImplementation(Implementation implementation)
+{
+  assert(isSupported(implementation) &&
+         "Implementation is not supported by CPU");
+
+  s_findFunction.store(getFindFunction(implementation),
+                       std::memory_order_relaxed);
+}
+
+} // namespace utils
+
+} // namespace mklog
@@ -0,0 +1,110 @@
+/**
+ * @file SubstringSearch.h
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Vectorized search of substring in large text
+ *
+ * @version 0.1
+ * @date 2023-09-19
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#ifndef __MEERKAT_LOGS_UTILS_SUBSTRINGSEARCH_H
+#define __MEERKAT_LOGS_UTILS_SUBSTRINGSEARCH_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace mklog
+{
+
+namespace utils
+{
+
+/**
+ * @brief Finds occurrences of pattern in text. Positions where both the
+ * first and the last pattern character match are found for a whole vector
+ * of positions at once, with the widest vector instructions supported by
+ * CPU; only those are compared with the rest of pattern.
+ */
+class SubstringSearch
+{
+public:
+  /**
+   * @brief Instruction set used to find candidate positions
+   */
+  enum class Implementation
+  {
+    SCALAR,
+    SSE2,
+    AVX2,
+    AVX512,
+  };
+
+  /**
+   * @brief Returned if text does not contain pattern
+   */
+  static constexpr size_t NOT_FOUND = SIZE_MAX;
+
+private:
+  using FindFunction = size_t (*)(const char* text, size_t length,
+                                  const char* pattern, size_t patternLen);
+
+  /**
+   * @brief Selected implementation. Resolved on first call
+   */
+  static std::atomic<FindFunction> s_findFunction;
+
+  static FindFunction getFindFunction(Implementation implementation);
+
+  /**
+   * @brief Select best implementation supported by CPU
+   */
+  static Implementation detectImplementation();
+
+  /**
+   * @brief Initial value of `s_findFunction`. Select implementation and
+   * search with it
+   */
+  static size_t findFirstCall(const char* text, size_t length,
+                              const char* pattern, size_t patternLen);
+
+public:
+  // Forbid construction of static class
+  SubstringSearch() = delete;
+
+  /**
+   * @brief Find the first occurrence of pattern in text
+   *
+   * @param[in] text        Searched text
+   * @param[in] length      Text length
+   * @param[in] pattern     Searched pattern
+   * @param[in] patternLen  Pattern length
+   *
+   * @return Position of occurrence, `NOT_FOUND` if there is none
+   */
+  static size_t find(const char* text, size_t length, const char* pattern,
+                     size_t patternLen)
+  {
+    return s_findFunction.load(std::memory_order_relaxed)(text, length,
+                                                          pattern, patternLen);
+  }
+
+  /**
+   * @brief Check if implementation can run on this CPU
+   */
+  static bool isSupported(Implementation implementation);
+
+  /**
+   * @brief Override automatically selected implementation. Implementation
+   * must be supported by CPU
+   */
+  static void useImplementation(Implementation implementation);
+};
+
+} // namespace utils
+
+} // namespace mklog
+
+#endif /* SubstringSearch.h */
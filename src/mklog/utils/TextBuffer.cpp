@@ -0,0 +1,106 @@
+#include "mklog/utils/TextBuffer.h"
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+
+namespace mklog
+{
+
+namespace utils
+{
+
+void TextBuffer::reserve(size_t length)
+{
+  // Leave space for NUL terminator
+  const size_t requiredCapacity = bufferLength + length + 1;
+  if (requiredCapacity <= bufferCapacity)
+  {
+    return;
+  }
+
+  size_t newCapacity =
+      bufferCapacity > 0 ? bufferCapacity : CAPACITY_INITIAL;
+  while (newCapacity < requiredCapacity)
+  {
+    newCapacity *= 2;
+  }
+
+  char* newData = new char[newCapacity];
+  memcpy(newData, data(), bufferLength + 1);
+
+  delete[] bufferData;
+  bufferData     = newData;
+  bufferCapacity = newCapacity;
+}
+
+void TextBuffer::append(const char* str, size_t length)
+{
+  reserve(length);
+
+  memcpy(bufferData + bufferLength, str, length);
+  bufferLength += length;
+  bufferData[bufferLength] = '\0';
+}
+
+void TextBuffer::appendf(const char* format, ...)
+{
+  va_list args = {};
+  va_start(args, format);
+  vappendf(format, args);
+  va_end(args);
+}
+
+void TextBuffer::vappendf(const char* format, va_list args)
+{
+  reserve(0);
+
+  // Try to format in place
+  va_list argsCopy = {};
+  va_copy(argsCopy, args);
+  const size_t available = bufferCapacity - bufferLength;
+  const int    printed =
+      vsnprintf(bufferData + bufferLength, available, format, argsCopy);
+  va_end(argsCopy);
+
+  if (printed < 0)
+  {
+    bufferData[bufferLength] = '\0';
+    return;
+  }
+
+  // Grow buffer and format again if output was truncated
+  if ((size_t)printed >= available)
+  {
+    reserve(printed);
+    vsnprintf(bufferData + bufferLength, printed + 1, format, args);
+  }
+
+  bufferLength += printed;
+}
+
+void TextBuffer::consume(size_t length)
+{
+  assert(length <= bufferLength && "Consumed more than buffer content");
+
+  if (length == 0)
+  {
+    return;
+  }
+
+  bufferLength -= length;
+  memmove(bufferData, bufferData + length, bufferLength + 1);
+}
+
+void TextBuffer::clear()
+{
+  bufferLength = 0;
+  if (bufferData != nullptr)
+  {
+    bufferData[0] = '\0';
+  }
+}
+
+} // namespace utils
+
+} // namespace mklog
@@ -0,0 +1,131 @@
+/**
+ * @file TextBuffer.h
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Growable character buffer
+ *
+ * @version 0.1
+ * @date 2023-09-05
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#ifndef __MEERKAT_LOGS_UTILS_TEXTBUFFER_H
+#define __MEERKAT_LOGS_UTILS_TEXTBUFFER_H
+
+#include <cstdarg>
+#include <cstddef>
+
+namespace mklog
+{
+
+namespace utils
+{
+
+/**
+ * @brief Character buffer which grows on append. Content is always
+ * NUL-terminated. Memory is kept between `clear()` calls.
+ */
+class TextBuffer
+{
+private:
+  char*  bufferData;
+  size_t bufferLength;
+  size_t bufferCapacity;
+
+public:
+  static constexpr size_t CAPACITY_INITIAL = 256;
+
+  TextBuffer() : bufferData(nullptr), bufferLength(0), bufferCapacity(0) {}
+
+  // No copying
+  TextBuffer(const TextBuffer&)            = delete;
+  TextBuffer& operator=(const TextBuffer&) = delete;
+
+  /**
+   * @brief Ensure that at least `length` more characters can be appended
+   * without reallocation
+   *
+   * @param[in] length  Number of characters to be appended
+   */
+  void reserve(size_t length);
+
+  /**
+   * @brief Append characters to buffer
+   *
+   * @param[in] str     Characters to be appended
+   * @param[in] length  Number of characters
+   */
+  void append(const char* str, size_t length);
+
+  /**
+   * @brief Append single character to buffer
+   *
+   * @param[in] ch  Character to be appended
+   */
+  void append(char ch) { append(&ch, 1); }
+
+  /**
+   * @brief Append printf-formatted text to buffer
+   *
+   * @param[in] format  Printf format string
+   * @param[in] ...     Printf format arguments
+   */
+  void appendf(const char* format, ...)
+      __attribute__((__format__(__printf__, 2, 3)));
+
+  /**
+   * @brief Append printf-formatted text to buffer
+   *
+   * @param[in] format  Printf format string
+   * @param[in] args    Printf format arguments
+   */
+  void vappendf(const char* format, va_list args)
+      __attribute__((__format__(__printf__, 2, 0)));
+
+  /**
+   * @brief Get free space after content. Number of characters which may be
+   * written there is determined by the last `reserve()` call
+   */
+  char* tail() { return bufferData + bufferLength; }
+
+  /**
+   * @brief Append characters written to `tail()` to content
+   *
+   * @param[in] length  Number of written characters
+   */
+  void extend(size_t length)
+  {
+    bufferLength += length;
+    bufferData[bufferLength] = '\0';
+  }
+
+  /**
+   * @brief Remove characters from start of content
+   *
+   * @param[in] length  Number of removed characters
+   */
+  void consume(size_t length);
+
+  /**
+   * @brief Remove all content, keep allocated memory
+   */
+  void clear();
+
+  const char* data() const { return bufferData != nullptr ? bufferData : ""; }
+
+  size_t length() const { return bufferLength; }
+
+  /**
+   * @brief Get allocated size, including NUL terminator. Appending beyond it
+   * moves content
+   */
+  size_t capacity() const { return bufferCapacity; }
+
+  ~TextBuffer() { delete[] bufferData; }
+};
+
+} // namespace utils
+
+} // namespace mklog
+
+#endif /* TextBuffer.h */
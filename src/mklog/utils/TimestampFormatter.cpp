@@ -0,0 +1,221 @@
+#include "mklog/utils/TimestampFormatter.h"
+
+#include <cassert>
+#include <cstring>
+
+namespace mklog
+{
+
+namespace utils
+{
+
+/**
+ * @brief Parts of timestamp which stay the same for a whole minute
+ */
+struct CachedMinute
+{
+  static constexpr size_t PREFIX_LEN_MAX = 32;
+  static constexpr size_t ZONE_LEN_MAX   = 8;
+
+  time_t minuteStart; /// First second of cached minute
+  time_t minuteEnd;   /// First second after cached minute
+
+  char   prefix[PREFIX_LEN_MAX]; /// 'YYYY-MM-DD hh:mm:'
+  size_t prefixLen;
+  char   zone[ZONE_LEN_MAX]; /// '+zzzz'
+  size_t zoneLen;
+};
+
+static thread_local CachedMinute t_cachedMinute = {};
+
+std::atomic<long> TimestampFormatter::s_utcOffset(0);
+
+static constexpr long SECONDS_PER_DAY = 24 * 60 * 60;
+
+/**
+ * @brief Fill cache with minute containing given time
+ */
+static void updateCachedMinute(CachedMinute& cache, time_t seconds,
+                               std::atomic<long>& utcOffset)
+{
+  struct tm localTime = {};
+  localtime_r(&seconds, &localTime);
+  utcOffset.store(localTime.tm_gmtoff, std::memory_order_relaxed);
+
+  cache.prefixLen = strftime(cache.prefix, CachedMinute::PREFIX_LEN_MAX,
+                             "%F %H:%M:", &localTime);
+  cache.zoneLen =
+      strftime(cache.zone, CachedMinute::ZONE_LEN_MAX, "%z", &localTime);
+
+  // Offsets and DST switches are whole minutes in local time, so measure
+  // minute from local seconds rather than from Epoch
+  const int second  = localTime.tm_sec < 60 ? localTime.tm_sec : 59;
+  cache.minuteStart = seconds - second;
+  cache.minuteEnd   = cache.minuteStart + 60;
+}
+
+/**
+ * @brief Write number with fixed number of decimal digits
+ */
+static void writeDigits(char* buffer, uint32_t value, size_t digitCount)
+{
+  for (size_t i = digitCount; i > 0; --i)
+  {
+    buffer[i - 1] = (char)('0' + value % 10);
+    value /= 10;
+  }
+}
+
+/**
+ * @brief Convert days since Epoch to proleptic Gregorian calendar date
+ */
+static void getCivilDate(long days, long* year, unsigned* month,
+                         unsigned* day)
+{
+  // Count from 0000-03-01, so that leap day is the last day of year
+  days += 719468;
+  const long     era       = (days >= 0 ? days : days - 146096) / 146097;
+  const unsigned dayOfEra  = (unsigned)(days - era * 146097);
+  const unsigned yearOfEra =
+      (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) /
+      365;
+  const unsigned dayOfYear =
+      dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+  const unsigned monthIndex = (5 * dayOfYear + 2) / 153; // March is 0
+
+  *day   = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+  *month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+  *year  = (long)yearOfEra + era * 400 + (*month <= 2 ? 1 : 0);
+}
+
+static size_t getFractionDigitCount(TimestampFormatter::Precision precision)
+{
+  using Precision = TimestampFormatter::Precision;
+
+  switch (precision)
+  {
+  case Precision::MILLISECONDS: return 3;
+  case Precision::MICROSECONDS: return 6;
+  case Precision::NANOSECONDS:  return 9;
+  case Precision::SECONDS:
+  default:                      return 0;
+  }
+}
+
+size_t TimestampFormatter::format(char* buffer, time_t seconds,
+                                  uint32_t nanoseconds, Precision precision)
+{
+  assert(nanoseconds < 1000000000 && "Invalid nanoseconds value");
+
+  CachedMinute& cache = t_cachedMinute;
+  if (seconds < cache.minuteStart || seconds >= cache.minuteEnd)
+  {
+    updateCachedMinute(cache, seconds, s_utcOffset);
+  }
+
+  size_t length = 0;
+
+  memcpy(buffer, cache.prefix, cache.prefixLen);
+  length += cache.prefixLen;
+
+  writeDigits(buffer + length, (uint32_t)(seconds - cache.minuteStart), 2);
+  length += 2;
+
+  const size_t fractionDigitCount = getFractionDigitCount(precision);
+  if (fractionDigitCount > 0)
+  {
+    uint32_t fraction = nanoseconds;
+    for (size_t i = fractionDigitCount; i < 9; ++i)
+    {
+      fraction /= 10;
+    }
+
+    buffer[length++] = '.';
+    writeDigits(buffer + length, fraction, fractionDigitCount);
+    length += fractionDigitCount;
+  }
+
+  memcpy(buffer + length, cache.zone, cache.zoneLen);
+  length += cache.zoneLen;
+
+  buffer[length] = '\0';
+  return length;
+}
+
+void TimestampFormatter::captureUtcOffset()
+{
+  const time_t seconds   = time(nullptr);
+  struct tm    localTime = {};
+  localtime_r(&seconds, &localTime);
+  s_utcOffset.store(localTime.tm_gmtoff, std::memory_order_relaxed);
+}
+
+size_t TimestampFormatter::formatSignalSafe(char* buffer, time_t seconds,
+                                            uint32_t  nanoseconds,
+                                            Precision precision)
+{
+  const long utcOffset = s_utcOffset.load(std::memory_order_relaxed);
+  const long localTime = (long)seconds + utcOffset;
+
+  long daySecond = localTime % SECONDS_PER_DAY;
+  long days      = localTime / SECONDS_PER_DAY;
+  if (daySecond < 0)
+  {
+    daySecond += SECONDS_PER_DAY;
+    --days;
+  }
+
+  long     year  = 0;
+  unsigned month = 0, day = 0;
+  getCivilDate(days, &year, &month, &day);
+  if (year < 0 || year > 9999)
+    year = 0;
+
+  size_t length = 0;
+
+  writeDigits(buffer + length, (uint32_t)year, 4);
+  length += 4;
+  buffer[length++] = '-';
+  writeDigits(buffer + length, month, 2);
+  length += 2;
+  buffer[length++] = '-';
+  writeDigits(buffer + length, day, 2);
+  length += 2;
+  buffer[length++] = ' ';
+  writeDigits(buffer + length, (uint32_t)(daySecond / 3600), 2);
+  length += 2;
+  buffer[length++] = ':';
+  writeDigits(buffer + length, (uint32_t)(daySecond / 60 % 60), 2);
+  length += 2;
+  buffer[length++] = ':';
+  writeDigits(buffer + length, (uint32_t)(daySecond % 60), 2);
+  length += 2;
+
+  const size_t fractionDigitCount = getFractionDigitCount(precision);
+  if (fractionDigitCount > 0)
+  {
+    uint32_t fraction = nanoseconds;
+    for (size_t i = fractionDigitCount; i < 9; ++i)
+    {
+      fraction /= 10;
+    }
+
+    buffer[length++] = '.';
+    writeDigits(buffer + length, fraction, fractionDigitCount);
+    length += fractionDigitCount;
+  }
+
+  const long zoneMinutes = (utcOffset >= 0 ? utcOffset : -utcOffset) / 60;
+  buffer[length++]       = utcOffset >= 0 ? '+' : '-';
+  writeDigits(buffer + length, (uint32_t)(zoneMinutes / 60 * 100 +
+                                          zoneMinutes % 60),
+              4);
+  length += 4;
+
+  buffer[length] = '\0';
+  return length;
+}
+
+} // namespace utils
+
+} // namespace mklog
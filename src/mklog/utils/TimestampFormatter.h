@@ -0,0 +1,102 @@
+/**
+ * @file TimestampFormatter.h
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Rendering of message timestamps shared by writers
+ *
+ * @version 0.1
+ * @date 2023-09-10
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#ifndef __MEERKAT_LOGS_UTILS_TIMESTAMPFORMATTER_H
+#define __MEERKAT_LOGS_UTILS_TIMESTAMPFORMATTER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+namespace mklog
+{
+
+namespace utils
+{
+
+/**
+ * @brief Renders local time as 'YYYY-MM-DD hh:mm:ss[.fraction]+zzzz'.
+ *
+ * Date, hour, minute and time zone are computed with `localtime_r` once per
+ * minute and cached per thread; seconds and fraction digits are written
+ * directly. Safe to use from several threads at once.
+ */
+class TimestampFormatter
+{
+private:
+  /// Offset of local time from UTC in seconds, last seen by formatter
+  static std::atomic<long> s_utcOffset;
+
+public:
+  /**
+   * @brief Number of fraction digits written after seconds
+   */
+  enum class Precision
+  {
+    SECONDS,      /// No fraction
+    MILLISECONDS, /// 3 digits
+    MICROSECONDS, /// 6 digits
+    NANOSECONDS,  /// 9 digits
+  };
+
+  /**
+   * @brief Maximum length of rendered timestamp, excluding NUL terminator
+   */
+  static constexpr size_t TIMESTAMP_LEN_MAX = 48;
+
+  // Forbid construction of static class
+  TimestampFormatter() = delete;
+
+  /**
+   * @brief Render timestamp to buffer
+   *
+   * @param[out] buffer       Buffer of at least `TIMESTAMP_LEN_MAX + 1`
+   *                          characters
+   * @param[in]  seconds      Seconds since Epoch
+   * @param[in]  nanoseconds  Nanoseconds since start of second
+   * @param[in]  precision    Number of fraction digits
+   *
+   * @return Length of rendered timestamp. Buffer is NUL-terminated
+   */
+  static size_t format(char* buffer, time_t seconds, uint32_t nanoseconds,
+                       Precision precision = Precision::SECONDS);
+
+  /**
+   * @brief Remember current offset of local time from UTC for
+   * `formatSignalSafe()`. Offset is also updated by `format()` once per
+   * minute
+   */
+  static void captureUtcOffset();
+
+  /**
+   * @brief Render timestamp like `format()`, but without calling into
+   * C library. Uses last captured UTC offset, so time zone transitions are
+   * noticed late. Async-signal-safe
+   *
+   * @param[out] buffer       Buffer of at least `TIMESTAMP_LEN_MAX + 1`
+   *                          characters
+   * @param[in]  seconds      Seconds since Epoch
+   * @param[in]  nanoseconds  Nanoseconds since start of second
+   * @param[in]  precision    Number of fraction digits
+   *
+   * @return Length of rendered timestamp. Buffer is NUL-terminated
+   */
+  static size_t formatSignalSafe(char* buffer, time_t seconds,
+                                 uint32_t  nanoseconds,
+                                 Precision precision = Precision::SECONDS);
+};
+
+} // namespace utils
+
+} // namespace mklog
+
+#endif /* TimestampFormatter.h */
@@ -0,0 +1,343 @@
+#include "mklog/writers/BinaryLogWriter.h"
+
+#include <cstring>
+#include <ctime>
+
+#include "mklog/utils/BinaryLogFormat.h"
+#include "mklog/utils/Crc32c.h"
+#include "mklog/utils/LogClock.h"
+
+namespace mklog
+{
+
+using utils::BinaryLogFormat;
+
+/// Longest name written by crash handler
+static constexpr size_t SIGNAL_SAFE_NAME_LEN_MAX = 1024;
+
+/**
+ * @brief Longest encoding of record entry without strings and content
+ */
+static constexpr size_t RECORD_FIXED_LEN_MAX =
+    1 + 3 + 7 * BinaryLogFormat::VARINT_LEN_MAX;
+
+static uint64_t getTimeMs()
+{
+  struct timespec time = {};
+  clock_gettime(CLOCK_MONOTONIC_COARSE, &time);
+  return (uint64_t)time.tv_sec * 1000 + (uint64_t)time.tv_nsec / 1000000;
+}
+
+static const char* getName(const char* name)
+{
+  // Rendered like printf renders null strings
+  return name != nullptr ? name : "(null)";
+}
+
+/**
+ * @brief Encode start of record entry: tag, timestamp, severity, content
+ * type, part and long message id
+ *
+ * @return Number of written bytes
+ */
+static size_t encodeRecordStart(char* output, const LogMessage& message,
+                                int64_t timestampDelta)
+{
+  size_t length    = 0;
+  output[length++] = (char)BinaryLogFormat::Tag::RECORD;
+  length += BinaryLogFormat::encodeVarint(
+      output + length, BinaryLogFormat::encodeZigzag(timestampDelta));
+  output[length++] = (char)message.severity;
+  output[length++] = (char)message.contentType;
+  output[length++] = (char)message.part;
+  if (message.part != LogMessage::Part::WHOLE)
+  {
+    length += BinaryLogFormat::encodeVarint(output + length,
+                                            message.longMessageId);
+  }
+  return length;
+}
+
+BinaryLogWriter::BinaryLogWriter()
+    : LogWriter(),
+      sink(),
+      mutex(),
+      dictionary(),
+      block(),
+      blockSeverity(LogMessage::Severity::MIN_LEVEL),
+      blockStartMs(0),
+      prevTimestampNs(0),
+      policy(BufferedFileSink::FLUSH_POLICY_DEFAULT),
+      blockSummary(utils::CompressedLogFormat::BLOCK_SUMMARY_EMPTY),
+      sessionBlockCount(0),
+      committedData(nullptr),
+      committedLen(0),
+      blockTimer(&BinaryLogWriter::onBlockTimer, this)
+{
+  // Blocks are already batched, sink writes them as soon as they end
+  sink.setFlushPolicy({.bufferSize    = 0,
+                       .maxAgeMs      = 0,
+                       .flushSeverity = LogMessage::Severity::MIN_LEVEL});
+}
+
+BinaryLogWriter& BinaryLogWriter::setFile(const char*                  filename,
+                                          BufferedFileSink::OutputMode mode)
+{
+  if (!sink.open(filename, mode))
+  {
+    return *this;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    block.clear();
+    startSession();
+  }
+
+  notifyConfigChanged();
+  return *this;
+}
+
+void BinaryLogWriter::startSession()
+{
+  char   session[1 + BinaryLogFormat::VARINT_LEN_MAX] = {};
+  size_t sessionLen = 0;
+  session[sessionLen++] = (char)BinaryLogFormat::Tag::SESSION;
+  sessionLen +=
+      BinaryLogFormat::encodeVarint(session + sessionLen,
+                                    BinaryLogFormat::VERSION);
+
+  dictionary.clear();
+  block.append(session, sessionLen);
+  blockStartMs      = getTimeMs();
+  prevTimestampNs   = 0;
+  sessionBlockCount = sink.getBlockCount();
+  blockTimer.schedule(policy.maxAgeMs);
+}
+
+BinaryLogWriter&
+BinaryLogWriter::setFlushPolicy(const BufferedFileSink::FlushPolicy& policy)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  this->policy = policy;
+  return *this;
+}
+
+uint32_t BinaryLogWriter::defineString(const char* str)
+{
+  bool           isNew = false;
+  const uint32_t id    = dictionary.getId(str, &isNew);
+  if (isNew)
+  {
+    const size_t length = strlen(str);
+
+    char   definition[1 + 2 * BinaryLogFormat::VARINT_LEN_MAX] = {};
+    size_t definitionLen = 0;
+    definition[definitionLen++] = (char)BinaryLogFormat::Tag::STRING;
+    definitionLen +=
+        BinaryLogFormat::encodeVarint(definition + definitionLen, id);
+    definitionLen +=
+        BinaryLogFormat::encodeVarint(definition + definitionLen, length);
+    block.append(definition, definitionLen);
+    block.append(str, length);
+  }
+  return id;
+}
+
+LogWriter::Status BinaryLogWriter::writeMessage(const LogMessage& message)
+{
+  time_t   seconds     = 0;
+  uint32_t nanoseconds = 0;
+  utils::LogClock::toRealtime(message.timestamp, &seconds, &nanoseconds);
+  const uint64_t timestampNs =
+      (uint64_t)seconds * utils::LogClock::NS_PER_SECOND + nanoseconds;
+  const size_t contentLen = strnlen(message.content, message.contentLen);
+
+  std::lock_guard<std::mutex> lock(mutex);
+
+  // Strings defined in previous compressed block are defined again
+  if (block.length() == 0 && sink.getBlockCount() != sessionBlockCount)
+  {
+    startSession();
+  }
+  if (blockStartMs == 0)
+  {
+    blockStartMs = getTimeMs();
+    blockTimer.schedule(policy.maxAgeMs);
+  }
+
+  // Names must be defined before record referencing them
+  const uint32_t loggerId   = defineString(getName(message.source.logger));
+  const uint32_t functionId = defineString(getName(message.source.function));
+  const uint32_t fileId     = defineString(getName(message.source.file));
+
+  char   fixed[RECORD_FIXED_LEN_MAX] = {};
+  size_t fixedLen                    = encodeRecordStart(
+      fixed, message, (int64_t)(timestampNs - prevTimestampNs));
+  fixedLen += BinaryLogFormat::encodeVarint(fixed + fixedLen, loggerId);
+  fixedLen += BinaryLogFormat::encodeVarint(fixed + fixedLen, functionId);
+  fixedLen += BinaryLogFormat::encodeVarint(fixed + fixedLen, fileId);
+  fixedLen +=
+      BinaryLogFormat::encodeVarint(fixed + fixedLen, message.source.line);
+  fixedLen += BinaryLogFormat::encodeVarint(fixed + fixedLen, contentLen);
+
+  block.append(fixed, fixedLen);
+  block.append(message.content, contentLen);
+  prevTimestampNs = timestampNs;
+  blockSummary.add(message.severity, timestampNs);
+  if (message.severity > blockSeverity)
+  {
+    blockSeverity = message.severity;
+  }
+
+  // Publish data first, so that length never covers unpublished buffer
+  committedLen.store(0, std::memory_order_relaxed);
+  committedData.store(block.data(), std::memory_order_release);
+  committedLen.store(block.length(), std::memory_order_release);
+
+  if (block.length() >= BLOCK_SIZE || block.length() >= policy.bufferSize ||
+      message.severity >= policy.flushSeverity ||
+      getTimeMs() - blockStartMs >= policy.maxAgeMs)
+  {
+    endBlock();
+  }
+
+  return Status::OK;
+}
+
+void BinaryLogWriter::endBlock()
+{
+  committedLen.store(0, std::memory_order_release);
+  if (block.length() == 0)
+  {
+    return;
+  }
+
+  char header[BinaryLogFormat::BLOCK_HEADER_SIZE] = {};
+  BinaryLogFormat::encodeBlockHeader(
+      header, (uint32_t)block.length(),
+      utils::Crc32c::compute(block.data(), block.length()));
+
+  sink.beginRecord().append(header, sizeof(header));
+  sink.appendContent(block.data(), block.length());
+  sink.indexMessages(blockSummary);
+  sink.endRecord(blockSeverity);
+
+  block.clear();
+  blockSummary    = utils::CompressedLogFormat::BLOCK_SUMMARY_EMPTY;
+  blockSeverity   = LogMessage::Severity::MIN_LEVEL;
+  blockStartMs    = 0;
+  prevTimestampNs = 0;
+}
+
+void BinaryLogWriter::flush()
+{
+  // Sink may end compressed block only between blocks of writer, which
+  // must not refer to strings defined in previous compressed block
+  std::lock_guard<std::mutex> lock(mutex);
+  endBlock();
+  sink.flush();
+}
+
+void BinaryLogWriter::endExpiredBlock()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+
+  // Next message schedules timer again
+  if (blockStartMs == 0)
+    return;
+
+  const uint64_t age = getTimeMs() - blockStartMs;
+  if (age >= policy.maxAgeMs)
+  {
+    endBlock();
+    return;
+  }
+
+  // Block was ended and started again since timer was scheduled
+  blockTimer.schedule(policy.maxAgeMs - (uint32_t)age);
+}
+
+void BinaryLogWriter::onBlockTimer(void* writer)
+{
+  static_cast<BinaryLogWriter*>(writer)->endExpiredBlock();
+}
+
+void BinaryLogWriter::flushSignalSafe()
+{
+  sink.flushSignalSafe();
+
+  const size_t length = committedLen.exchange(0, std::memory_order_acquire);
+  const char*  data   = committedData.load(std::memory_order_acquire);
+  if (!sink.isOpen() || length == 0 || data == nullptr)
+    return;
+
+  char header[BinaryLogFormat::BLOCK_HEADER_SIZE] = {};
+  BinaryLogFormat::encodeBlockHeader(header, (uint32_t)length,
+                                     utils::Crc32c::compute(data, length));
+  sink.writeSignalSafe(header, sizeof(header));
+  sink.writeSignalSafe(data, length);
+}
+
+void BinaryLogWriter::writeMessageSignalSafe(const LogMessage& message,
+                                             char* buffer, size_t bufferSize)
+{
+  const size_t namesLenMax =
+      3 * (1 + 2 * BinaryLogFormat::VARINT_LEN_MAX + SIGNAL_SAFE_NAME_LEN_MAX);
+  if (!sink.isOpen() || bufferSize < BinaryLogFormat::BLOCK_HEADER_SIZE +
+                                         RECORD_FIXED_LEN_MAX + namesLenMax)
+  {
+    return;
+  }
+
+  // Single-record block with names written in place, since dictionary may
+  // be modified by interrupted thread
+  time_t   seconds     = 0;
+  uint32_t nanoseconds = 0;
+  utils::LogClock::toRealtimeSignalSafe(message.timestamp, &seconds,
+                                        &nanoseconds);
+  const uint64_t timestampNs =
+      (uint64_t)seconds * utils::LogClock::NS_PER_SECOND + nanoseconds;
+
+  char* const payload = buffer + BinaryLogFormat::BLOCK_HEADER_SIZE;
+  size_t      length  = encodeRecordStart(payload, message, (int64_t)timestampNs);
+
+  const char* const names[] = {getName(message.source.logger),
+                               getName(message.source.function),
+                               getName(message.source.file)};
+  for (const char* name : names)
+  {
+    const size_t nameLen = strnlen(name, SIGNAL_SAFE_NAME_LEN_MAX);
+    length += BinaryLogFormat::encodeVarint(payload + length,
+                                            BinaryLogFormat::STRING_INLINE);
+    length += BinaryLogFormat::encodeVarint(payload + length, nameLen);
+    memcpy(payload + length, name, nameLen);
+    length += nameLen;
+  }
+  length += BinaryLogFormat::encodeVarint(payload + length,
+                                          message.source.line);
+
+  // Content which does not fit into buffer is truncated
+  const size_t space = bufferSize - BinaryLogFormat::BLOCK_HEADER_SIZE -
+                       length - BinaryLogFormat::VARINT_LEN_MAX;
+  size_t contentLen = strnlen(message.content, message.contentLen);
+  if (contentLen > space)
+  {
+    contentLen = space;
+  }
+  length += BinaryLogFormat::encodeVarint(payload + length, contentLen);
+  memcpy(payload + length, message.content, contentLen);
+  length += contentLen;
+
+  BinaryLogFormat::encodeBlockHeader(buffer, (uint32_t)length,
+                                     utils::Crc32c::compute(payload, length));
+  sink.writeSignalSafe(buffer, BinaryLogFormat::BLOCK_HEADER_SIZE + length);
+}
+
+BinaryLogWriter::~BinaryLogWriter()
+{
+  blockTimer.stop();
+  flush();
+}
+
+} // namespace mklog
@@ -0,0 +1,156 @@
+/**
+ * @file BinaryLogWriter.h
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Log writer for compact binary files
+ *
+ * @version 0.1
+ * @date 2023-09-17
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#ifndef __MEERKAT_LOGS_WRITERS_BINARYLOGWRITER_H
+#define __MEERKAT_LOGS_WRITERS_BINARYLOGWRITER_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+#include "mklog/LogWriter.h"
+#include "mklog/utils/FlushTimer.h"
+#include "mklog/utils/CompressedLogFormat.h"
+#include "mklog/utils/StringDictionary.h"
+#include "mklog/utils/TextBuffer.h"
+#include "mklog/writers/BufferedFileSink.h"
+
+namespace mklog
+{
+
+/**
+ * @brief Writes messages in format described by `utils::BinaryLogFormat`.
+ * Messages are collected into blocks of about `BLOCK_SIZE` bytes; logger,
+ * function and file names are written once per file and then referenced by
+ * id. Files are rendered to text or HTML by `LogDecode` tool.
+ *
+ * In compressed file each compressed block starts new session, so that
+ * blocks can be decoded independently.
+ */
+class BinaryLogWriter : public LogWriter
+{
+public:
+  static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+private:
+  BufferedFileSink sink;
+
+  /// Guards block and dictionary
+  std::mutex mutex;
+
+  utils::StringDictionary       dictionary;
+  utils::TextBuffer             block;
+  LogMessage::Severity          blockSeverity;
+  uint64_t                      blockStartMs; /// Zero if block is empty
+  uint64_t                      prevTimestampNs;
+  BufferedFileSink::FlushPolicy policy;
+
+  /// Messages of current block, for index of compressed file
+  utils::CompressedLogFormat::BlockSummary blockSummary;
+
+  /// Number of compressed blocks written by sink when session started
+  uint64_t sessionBlockCount;
+
+  /// Encoded entries of current block, for `flushSignalSafe()`
+  std::atomic<const char*> committedData;
+  std::atomic<size_t>      committedLen;
+
+  /// Ends blocks which exceed maximum age when no more messages are logged
+  utils::FlushTimer blockTimer;
+
+  /**
+   * @brief Start session, forgetting defined strings. Block must be empty
+   * and writer locked
+   */
+  void startSession();
+
+  /**
+   * @brief Get dictionary id of string, adding its definition to block if
+   * string is new. Writer must be locked
+   */
+  uint32_t defineString(const char* str);
+
+  /**
+   * @brief Pass current block to sink. Writer must be locked
+   */
+  void endBlock();
+
+  /**
+   * @brief End current block if it exceeds maximum age, otherwise schedule
+   * block timer for the remaining time
+   */
+  void endExpiredBlock();
+
+  /**
+   * @brief Block timer callback
+   *
+   * @param[in] writer  Writer owning timer
+   */
+  static void onBlockTimer(void* writer);
+
+protected:
+  bool canAcceptContentType(LogMessage::ContentType contentType) const override
+  {
+    // Content is stored as is
+    (void)contentType;
+    return sink.isOpen();
+  }
+
+  Status writeMessage(const LogMessage& message) override;
+
+  void writeMessageSignalSafe(const LogMessage& message, char* buffer,
+                              size_t bufferSize) override;
+
+public:
+  BinaryLogWriter();
+
+  /**
+   * @brief Open log file. New session is started in file, so it may
+   * already contain binary log
+   *
+   * @param[in] filename  Log file name
+   * @param[in] mode      How blocks are written, see
+   *                      `BufferedFileSink::OutputMode`
+   */
+  BinaryLogWriter& setFile(
+      const char*                  filename,
+      BufferedFileSink::OutputMode mode = BufferedFileSink::OutputMode::WRITE);
+
+  /**
+   * @brief Set flush policy. Blocks are ended when they exceed buffer size
+   * or maximum age, or after message with flush severity
+   */
+  BinaryLogWriter& setFlushPolicy(const BufferedFileSink::FlushPolicy& policy);
+
+  /**
+   * @brief Compress log file in blocks, see
+   * `BufferedFileSink::CompressionPolicy`. Must be called before
+   * `setFile()`
+   */
+  BinaryLogWriter&
+  setCompressionPolicy(const BufferedFileSink::CompressionPolicy& policy)
+  {
+    sink.setCompressionPolicy(policy);
+    return *this;
+  }
+
+  void flush() override;
+
+  void flushSignalSafe() override;
+
+  bool valid() { return sink.isOpen(); }
+
+  ~BinaryLogWriter() override;
+};
+
+} // namespace mklog
+
+#endif /* BinaryLogWriter.h */
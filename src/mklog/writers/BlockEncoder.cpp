@@ -0,0 +1,133 @@
+#include "mklog/writers/BlockEncoder.h"
+
+#include <cstring>
+
+#include "mklog/utils/BinaryLogFormat.h"
+#include "mklog/utils/Crc32c.h"
+
+namespace mklog
+{
+
+using utils::CompressedLogFormat;
+
+BlockEncoder::BlockEncoder()
+    : blockSummary(CompressedLogFormat::BLOCK_SUMMARY_EMPTY),
+      frame(),
+      blockIndex(),
+      sessionStart(0),
+      blockCount(0)
+{
+}
+
+void BlockEncoder::startSession(uint64_t fileSize)
+{
+  sessionStart = fileSize;
+  blockIndex.clear();
+}
+
+const utils::TextBuffer& BlockEncoder::encodeBlock(const char* records,
+                                                   size_t      length,
+                                                   int         level,
+                                                   uint64_t    fileOffset)
+{
+  frame.clear();
+  frame.reserve(CompressedLogFormat::FRAME_HEADER_SIZE +
+                CompressedLogFormat::getCompressedLenMax(length));
+  char* const header  = frame.tail();
+  char* const payload = header + CompressedLogFormat::FRAME_HEADER_SIZE;
+
+  CompressedLogFormat::Method method = CompressedLogFormat::Method::DEFLATE;
+  size_t storedLen =
+      CompressedLogFormat::compress(payload, records, length, level);
+  if (storedLen == 0 || storedLen >= length)
+  {
+    // Block does not compress
+    method    = CompressedLogFormat::Method::STORED;
+    storedLen = length;
+    memcpy(payload, records, length);
+  }
+
+  const CompressedLogFormat::FrameHeader frameHeader = {
+      .method    = method,
+      .flags     = 0,
+      .storedLen = (uint32_t)storedLen,
+      .rawLen    = (uint32_t)length,
+      .checksum  = utils::Crc32c::compute(payload, storedLen),
+      .summary   = blockSummary,
+  };
+  CompressedLogFormat::encodeFrameHeader(header, frameHeader);
+  frame.extend(CompressedLogFormat::FRAME_HEADER_SIZE + storedLen);
+
+  // Index entry is block offset followed by copy of its header
+  char offset[sizeof(uint64_t)] = {};
+  utils::BinaryLogFormat::encodeUint64(offset, fileOffset);
+  blockIndex.append(offset, sizeof(offset));
+  blockIndex.append(frame.data(), CompressedLogFormat::FRAME_HEADER_SIZE);
+
+  discardBlock();
+  blockCount.fetch_add(1, std::memory_order_release);
+
+  return frame;
+}
+
+void BlockEncoder::writeIndex(FileOutput& output)
+{
+  if (blockIndex.length() == 0)
+  {
+    return;
+  }
+
+  char indexHeader[CompressedLogFormat::INDEX_HEADER_SIZE] = {};
+  utils::BinaryLogFormat::encodeUint64(indexHeader, sessionStart);
+  utils::BinaryLogFormat::encodeUint32(
+      indexHeader + sizeof(uint64_t),
+      (uint32_t)(blockIndex.length() / CompressedLogFormat::INDEX_ENTRY_SIZE));
+
+  const size_t indexLen = sizeof(indexHeader) + blockIndex.length();
+  CompressedLogFormat::FrameHeader frameHeader = {
+      .method    = CompressedLogFormat::Method::INDEX,
+      .flags     = 0,
+      .storedLen = (uint32_t)indexLen,
+      .rawLen    = (uint32_t)indexLen,
+      .checksum  = utils::Crc32c::update(
+          utils::Crc32c::compute(indexHeader, sizeof(indexHeader)),
+          blockIndex.data(), blockIndex.length()),
+      .summary   = CompressedLogFormat::BLOCK_SUMMARY_EMPTY,
+  };
+
+  char header[CompressedLogFormat::FRAME_HEADER_SIZE] = {};
+  CompressedLogFormat::encodeFrameHeader(header, frameHeader);
+
+  char trailer[CompressedLogFormat::TRAILER_SIZE] = {};
+  CompressedLogFormat::encodeTrailer(trailer, output.getSize());
+
+  struct iovec parts[] = {
+      {.iov_base = header, .iov_len = sizeof(header)},
+      {.iov_base = indexHeader, .iov_len = sizeof(indexHeader)},
+      {.iov_base = const_cast<char*>(blockIndex.data()),
+       .iov_len  = blockIndex.length()},
+      {.iov_base = trailer, .iov_len = sizeof(trailer)},
+  };
+  output.write(parts, sizeof(parts) / sizeof(*parts));
+
+  // Blocks written later start new session
+  startSession(output.getSize());
+}
+
+void BlockEncoder::encodeStoredFrameHeader(char* header, const char* records,
+                                           size_t length)
+{
+  // Compressing is not async-signal-safe, and summary of current block may
+  // be modified by interrupted thread
+  const CompressedLogFormat::FrameHeader frameHeader = {
+      .method    = CompressedLogFormat::Method::STORED,
+      .flags     = CompressedLogFormat::FLAG_UNINDEXED,
+      .storedLen = (uint32_t)length,
+      .rawLen    = (uint32_t)length,
+      .checksum  = utils::Crc32c::compute(records, length),
+      .summary   = CompressedLogFormat::BLOCK_SUMMARY_EMPTY,
+  };
+  CompressedLogFormat::encodeFrameHeader(header, frameHeader);
+}
+
+} // namespace mklog
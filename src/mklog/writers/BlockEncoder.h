@@ -0,0 +1,142 @@
+/**
+ * @file BlockEncoder.h
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Encoding of buffered records into compressed blocks
+ *
+ * @version 0.1
+ * @date 2023-09-21
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#ifndef __MEERKAT_LOGS_WRITERS_BLOCKENCODER_H
+#define __MEERKAT_LOGS_WRITERS_BLOCKENCODER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "mklog/LogMessage.h"
+#include "mklog/utils/CompressedLogFormat.h"
+#include "mklog/utils/TextBuffer.h"
+#include "mklog/writers/FileOutput.h"
+
+namespace mklog
+{
+
+/**
+ * @brief Encoder of log file in format described by
+ * `utils::CompressedLogFormat`. Compresses blocks of records, summarizes
+ * their messages and writes index of blocks written in this session. Not
+ * thread-safe, except for `getBlockCount()` and
+ * `encodeStoredFrameHeader()`.
+ */
+class BlockEncoder
+{
+public:
+  using BlockSummary = utils::CompressedLogFormat::BlockSummary;
+
+private:
+  /// Messages of records in current block
+  BlockSummary blockSummary;
+
+  /// Compressed block with its frame header
+  utils::TextBuffer frame;
+
+  /// Index entries of blocks written in this session
+  utils::TextBuffer blockIndex;
+
+  /// File offset of the first block of this session
+  uint64_t sessionStart;
+
+  /// Number of blocks encoded since encoder was created
+  std::atomic<uint64_t> blockCount;
+
+public:
+  BlockEncoder();
+
+  // No copying
+  BlockEncoder(const BlockEncoder&)            = delete;
+  BlockEncoder& operator=(const BlockEncoder&) = delete;
+
+  /**
+   * @brief Start new session at the end of file, which may already hold
+   * blocks of earlier sessions
+   *
+   * @param[in] fileSize  Current size of log file
+   */
+  void startSession(uint64_t fileSize);
+
+  /**
+   * @brief Account message of record in current block
+   *
+   * @param[in] severity  Message severity
+   * @param[in] timeNs    Message wall-clock time in nanoseconds since Epoch
+   */
+  void addMessage(LogMessage::Severity severity, uint64_t timeNs)
+  {
+    blockSummary.add(severity, timeNs);
+  }
+
+  /**
+   * @brief Account several messages of record in current block
+   */
+  void addMessages(const BlockSummary& summary)
+  {
+    blockSummary.merge(summary);
+  }
+
+  /**
+   * @brief Compress records of current block with frame header and add
+   * block to index. Summary of current block is reset
+   *
+   * @param[in] records     Text of records
+   * @param[in] length      Text length
+   * @param[in] level       Deflate level, 1 to 9
+   * @param[in] fileOffset  Offset at which block will be written
+   *
+   * @return Encoded block, valid until next call
+   */
+  const utils::TextBuffer& encodeBlock(const char* records, size_t length,
+                                       int level, uint64_t fileOffset);
+
+  /**
+   * @brief Forget messages of current block, which is not written
+   */
+  void discardBlock()
+  {
+    blockSummary = utils::CompressedLogFormat::BLOCK_SUMMARY_EMPTY;
+  }
+
+  /**
+   * @brief Write index of blocks written in this session and file trailer,
+   * then start new session. Does nothing if no block was written
+   *
+   * @param[inout] output   Log file
+   */
+  void writeIndex(FileOutput& output);
+
+  /**
+   * @brief Get number of blocks encoded so far
+   */
+  uint64_t getBlockCount() const
+  {
+    return blockCount.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief Encode header of uncompressed block which is left out of index,
+   * e.g. one written by crash handler. Async-signal-safe
+   *
+   * @param[out] header   Buffer of `CompressedLogFormat::FRAME_HEADER_SIZE`
+   *                      bytes
+   * @param[in]  records  Text of records
+   * @param[in]  length   Text length
+   */
+  static void encodeStoredFrameHeader(char* header, const char* records,
+                                      size_t length);
+};
+
+} // namespace mklog
+
+#endif /* BlockEncoder.h */
@@ -0,0 +1,499 @@
+#include "mklog/writers/BufferedFileSink.h"
+
+#include <cassert>
+#include <cstdio>
+#include <ctime>
+#include <cstring>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace mklog
+{
+
+BufferedFileSink::BufferedFileSink()
+    : policy(FLUSH_POLICY_DEFAULT),
+      mutex(),
+      output(),
+      rotationPolicy(ROTATION_POLICY_NONE),
+      rotationBaseSize(0),
+      nextRotationTime(0),
+      segmentFooter(nullptr),
+      segmentHeader(nullptr),
+      compressor(),
+      compression(COMPRESSION_POLICY_NONE),
+      encoder(),
+      indexPolicy(INDEX_POLICY_NONE),
+      index(),
+      buffer(),
+      externalParts(),
+      externalPartCount(0),
+      record(),
+      bufferedSinceMs(0),
+      committedData(nullptr),
+      committedLen(0),
+      isAbandoned(false),
+      flushTimer(&BufferedFileSink::onFlushTimer, this)
+{
+}
+
+uint64_t BufferedFileSink::getTimeMs()
+{
+  struct timespec time = {};
+  clock_gettime(CLOCK_MONOTONIC_COARSE, &time);
+  return (uint64_t)time.tv_sec * 1000 + (uint64_t)time.tv_nsec / 1000000;
+}
+
+bool BufferedFileSink::open(const char* filename, OutputMode mode)
+{
+  if (!output.open(filename, mode))
+  {
+    return false;
+  }
+
+  // File may already hold blocks of earlier sessions
+  encoder.startSession(output.getSize());
+
+  // Compressed files have index of their own
+  index.setChunkSize(isCompressed() ? 0 : indexPolicy.chunkSize);
+  index.open(filename, output.getSize());
+
+  rotationBaseSize = 0;
+  scheduleRotation();
+
+  return true;
+}
+
+void BufferedFileSink::scheduleRotation()
+{
+  if (rotationPolicy.intervalSec == 0)
+  {
+    nextRotationTime = 0;
+    return;
+  }
+
+  const time_t now       = time(nullptr);
+  struct tm    localTime = {};
+  localtime_r(&now, &localTime);
+
+  // Align rotations to local time, so that daily segments start at midnight
+  const time_t interval = (time_t)rotationPolicy.intervalSec;
+  const time_t localNow = now + localTime.tm_gmtoff;
+  nextRotationTime = (localNow / interval + 1) * interval - localTime.tm_gmtoff;
+}
+
+bool BufferedFileSink::isRotationDue() const
+{
+  return (rotationPolicy.maxSize > 0 &&
+          output.getSize() - rotationBaseSize >= rotationPolicy.maxSize) ||
+         (nextRotationTime != 0 && time(nullptr) >= nextRotationTime);
+}
+
+char* BufferedFileSink::makeSegmentName() const
+{
+  const char* const filename = output.getFilename();
+
+  const time_t now       = time(nullptr);
+  struct tm    localTime = {};
+  localtime_r(&now, &localTime);
+
+  char timeSuffix[32] = "";
+  strftime(timeSuffix, sizeof(timeSuffix), "-%Y%m%d-%H%M%S", &localTime);
+
+  // Rotation time goes before extension, so that segments keep file type
+  const char* baseName  = strrchr(filename, '/');
+  baseName              = baseName != nullptr ? baseName + 1 : filename;
+  const char* extension = strrchr(baseName, '.');
+  if (extension == nullptr || extension == baseName)
+  {
+    extension = baseName + strlen(baseName);
+  }
+
+  constexpr size_t COUNTER_LEN_MAX = 24;
+  const size_t     capacity        = strlen(filename) + strlen(timeSuffix) +
+                                     COUNTER_LEN_MAX + sizeof(".gz");
+  char* const      segmentName     = new char[capacity];
+
+  // Several rotations within one second get numbered segments
+  for (unsigned counter = 0;; ++counter)
+  {
+    char counterSuffix[COUNTER_LEN_MAX] = "";
+    if (counter > 0)
+    {
+      snprintf(counterSuffix, sizeof(counterSuffix), "-%u", counter);
+    }
+
+    const int length =
+        snprintf(segmentName, capacity, "%.*s%s%s%s",
+                 (int)(extension - filename), filename, timeSuffix,
+                 counterSuffix, extension);
+    if (access(segmentName, F_OK) == 0)
+      continue;
+
+    // Segment may have been compressed already
+    memcpy(segmentName + length, ".gz", sizeof(".gz"));
+    const bool isCompressedUsed = access(segmentName, F_OK) == 0;
+    segmentName[length]         = '\0';
+    if (!isCompressedUsed)
+      break;
+  }
+
+  return segmentName;
+}
+
+void BufferedFileSink::rotateLocked()
+{
+  if (segmentFooter != nullptr)
+  {
+    buffer.append(segmentFooter, strlen(segmentFooter));
+  }
+  flushLocked();
+  writeIndexLocked();
+  endChunkLocked();
+  scheduleRotation();
+
+  char* const segmentName = makeSegmentName();
+  if (output.rename(segmentName))
+  {
+    rotationBaseSize = 0;
+    encoder.startSession(output.getSize());
+    index.rotate(output.getFilename(), segmentName,
+                 rotationPolicy.isCompressed, output.getSize());
+
+    if (rotationPolicy.isCompressed)
+    {
+      compressor.enqueue(segmentName);
+    }
+  }
+  else
+  {
+    // Keep writing current segment, retry after another size limit
+    rotationBaseSize = output.getSize();
+  }
+  delete[] segmentName;
+
+  if (segmentHeader != nullptr)
+  {
+    buffer.append(segmentHeader, strlen(segmentHeader));
+  }
+}
+
+void BufferedFileSink::setSpliceEnabled(bool isEnabled)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  if (isOpen())
+  {
+    flushLocked();
+  }
+  output.setSpliceEnabled(isEnabled);
+}
+
+void BufferedFileSink::setFlushPolicy(const FlushPolicy& flushPolicy)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  policy = flushPolicy;
+  if (buffer.length() >= policy.bufferSize)
+  {
+    flushLocked();
+  }
+  else if (bufferedSinceMs.load(std::memory_order_relaxed) != 0)
+  {
+    flushTimer.schedule(getMaxAgeMs());
+  }
+}
+
+void BufferedFileSink::setRotationPolicy(const RotationPolicy& rotation)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  rotationPolicy = rotation;
+  scheduleRotation();
+}
+
+void BufferedFileSink::setCompressionPolicy(const CompressionPolicy& policy)
+{
+  assert(!isOpen() && "Cannot change format of open log file");
+
+  std::lock_guard<std::mutex> lock(mutex);
+  compression = policy;
+}
+
+void BufferedFileSink::setIndexPolicy(const IndexPolicy& policy)
+{
+  assert(!isOpen() && "Cannot change format of open log file");
+
+  std::lock_guard<std::mutex> lock(mutex);
+  indexPolicy = policy;
+}
+
+void BufferedFileSink::setSegmentMarkers(const char* footer,
+                                         const char* header)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  segmentFooter = footer;
+  segmentHeader = header;
+}
+
+utils::TextBuffer& BufferedFileSink::beginRecord()
+{
+  mutex.lock();
+  // Record is built aside, so completed records stay visible to crash
+  // handler
+  return record;
+}
+
+void BufferedFileSink::appendContent(const char* text, size_t length)
+{
+  // Compressed block is built in buffer
+  if (length < EXTERNAL_PART_LEN_MIN || isCompressed() ||
+      externalPartCount == EXTERNAL_PART_COUNT_MAX)
+  {
+    record.append(text, length);
+    return;
+  }
+
+  externalParts[externalPartCount++] = {
+      .offset = buffer.length() + record.length(),
+      .data   = text,
+      .length = length};
+}
+
+void BufferedFileSink::appendPipedContent(int pipeFd, size_t length,
+                                          bool consume)
+{
+  assert(canSplice() && "Splicing is not enabled");
+
+  // Record text preceding piped content must reach file first
+  commitRecordLocked();
+  flushLocked();
+
+  output.splice(pipeFd, length, consume);
+}
+
+void BufferedFileSink::endRecord(LogMessage::Severity severity)
+{
+  commitRecordLocked();
+
+  // Small blocks compress poorly, so severity does not end compressed
+  // block; crash handler writes buffered records anyway. Copying record to
+  // mapping is cheap, so mapped records are not batched
+  const bool isFull =
+      isCompressed() ? buffer.length() >= compression.blockSize
+                     : isMapped() || externalPartCount > 0 ||
+                           severity >= policy.flushSeverity ||
+                           buffer.length() >= policy.bufferSize;
+  if (isFull)
+  {
+    flushLocked();
+  }
+  else
+  {
+    const uint64_t now       = getTimeMs();
+    const uint64_t firstTime = bufferedSinceMs.load(std::memory_order_relaxed);
+    if (firstTime == 0)
+    {
+      bufferedSinceMs.store(now, std::memory_order_relaxed);
+      flushTimer.schedule(getMaxAgeMs());
+    }
+    else if (now - firstTime >= getMaxAgeMs())
+    {
+      flushLocked();
+    }
+  }
+
+  if (isChunkComplete())
+  {
+    endChunkLocked();
+  }
+
+  if (isOpen() && !isAbandoned.load(std::memory_order_relaxed) &&
+      isRotationDue())
+  {
+    rotateLocked();
+  }
+
+  // Publish data first, so that length never covers unpublished buffer
+  if (buffer.length() > 0)
+  {
+    committedData.store(buffer.data(), std::memory_order_release);
+    committedLen.store(buffer.length(), std::memory_order_release);
+  }
+
+  mutex.unlock();
+}
+
+void BufferedFileSink::commitRecordLocked()
+{
+  // Growing buffer moves its text, so crash handler must not read it
+  if (buffer.length() + record.length() + 1 > buffer.capacity())
+  {
+    committedLen.store(0, std::memory_order_release);
+  }
+
+  buffer.append(record.data(), record.length());
+  record.clear();
+}
+
+void BufferedFileSink::flushLocked()
+{
+  bufferedSinceMs.store(0, std::memory_order_relaxed);
+  committedLen.store(0, std::memory_order_release);
+
+  if (buffer.length() == 0 && externalPartCount == 0)
+    return;
+
+  // Interleave buffered text with external parts
+  struct iovec parts[2 * EXTERNAL_PART_COUNT_MAX + 1] = {};
+  size_t       partCount  = 0;
+  size_t       offset     = 0;
+  char*        bufferData = const_cast<char*>(buffer.data());
+  for (size_t i = 0; i < externalPartCount; ++i)
+  {
+    const ExternalPart& part = externalParts[i];
+    if (part.offset > offset)
+    {
+      parts[partCount++] = {.iov_base = bufferData + offset,
+                            .iov_len  = part.offset - offset};
+      offset             = part.offset;
+    }
+    parts[partCount++] = {.iov_base = const_cast<char*>(part.data),
+                          .iov_len  = part.length};
+  }
+  if (buffer.length() > offset)
+  {
+    parts[partCount++] = {.iov_base = bufferData + offset,
+                          .iov_len  = buffer.length() - offset};
+  }
+
+  if (isOpen() && !isAbandoned.load(std::memory_order_relaxed))
+  {
+    if (isCompressed())
+    {
+      // Whole buffer becomes single block
+      const utils::TextBuffer& frame =
+          encoder.encodeBlock(buffer.data(), buffer.length(),
+                              compression.level, output.getSize());
+      parts[0]  = {.iov_base = const_cast<char*>(frame.data()),
+                   .iov_len  = frame.length()};
+      partCount = 1;
+    }
+
+    output.write(parts, partCount);
+  }
+
+  buffer.clear();
+  externalPartCount = 0;
+  encoder.discardBlock();
+}
+
+void BufferedFileSink::writeIndexLocked()
+{
+  if (!isOpen() || !isCompressed() ||
+      isAbandoned.load(std::memory_order_relaxed))
+  {
+    return;
+  }
+
+  encoder.writeIndex(output);
+}
+
+bool BufferedFileSink::isChunkComplete() const
+{
+  return buffer.length() == 0 && externalPartCount == 0 &&
+         index.isChunkComplete(output.getSize());
+}
+
+void BufferedFileSink::endChunkLocked()
+{
+  if (isAbandoned.load(std::memory_order_relaxed))
+  {
+    return;
+  }
+
+  index.endChunk(output.getSize());
+}
+
+void BufferedFileSink::flush()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  flushLocked();
+  if (isChunkComplete())
+  {
+    endChunkLocked();
+  }
+  output.wait();
+}
+
+void BufferedFileSink::flushExpired()
+{
+  // Next buffered record schedules timer again
+  if (bufferedSinceMs.load(std::memory_order_relaxed) == 0)
+    return;
+
+  std::lock_guard<std::mutex> lock(mutex);
+
+  const uint64_t firstTime = bufferedSinceMs.load(std::memory_order_relaxed);
+  if (firstTime == 0)
+    return;
+
+  const uint64_t age = getTimeMs() - firstTime;
+  if (age >= getMaxAgeMs())
+  {
+    flushLocked();
+    if (isChunkComplete())
+    {
+      endChunkLocked();
+    }
+    return;
+  }
+
+  // Buffer was flushed and refilled since timer was scheduled
+  flushTimer.schedule(getMaxAgeMs() - (uint32_t)age);
+}
+
+void BufferedFileSink::onFlushTimer(void* sink)
+{
+  static_cast<BufferedFileSink*>(sink)->flushExpired();
+}
+
+void BufferedFileSink::flushSignalSafe()
+{
+  isAbandoned.store(true, std::memory_order_relaxed);
+
+  output.abandonSignalSafe();
+
+  // Mapped records are already in file, except for records of unfinished
+  // compressed block
+  if (isMapped() && !isCompressed())
+    return;
+
+  const size_t length = committedLen.exchange(0, std::memory_order_acquire);
+  const char*  data   = committedData.load(std::memory_order_acquire);
+  if (!isOpen() || length == 0 || data == nullptr)
+    return;
+
+  writeSignalSafe(data, length);
+}
+
+void BufferedFileSink::writeSignalSafe(const char* record, size_t length)
+{
+  if (!isOpen())
+    return;
+
+  if (isCompressed())
+  {
+    char header[utils::CompressedLogFormat::FRAME_HEADER_SIZE] = {};
+    BlockEncoder::encodeStoredFrameHeader(header, record, length);
+    output.writeSignalSafe(header, sizeof(header));
+  }
+  output.writeSignalSafe(record, length);
+}
+
+BufferedFileSink::~BufferedFileSink()
+{
+  // Timer callback locks sink
+  flushTimer.stop();
+  flush();
+  writeIndexLocked();
+  endChunkLocked();
+}
+
+} // namespace mklog
@@ -0,0 +1,480 @@
+/**
+ * @file BufferedFileSink.h
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Buffered output to log file shared by file writers
+ *
+ * @version 0.1
+ * @date 2023-09-08
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#ifndef __MEERKAT_LOGS_WRITERS_BUFFEREDFILESINK_H
+#define __MEERKAT_LOGS_WRITERS_BUFFEREDFILESINK_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+
+#include "mklog/LogMessage.h"
+#include "mklog/utils/FlushTimer.h"
+#include "mklog/utils/SegmentCompressor.h"
+#include "mklog/utils/TextBuffer.h"
+#include "mklog/writers/BlockEncoder.h"
+#include "mklog/writers/ChunkIndex.h"
+#include "mklog/writers/FileOutput.h"
+
+namespace mklog
+{
+
+/**
+ * @brief Log file collecting rendered records in memory and writing them in
+ * batches. Records are built between `beginRecord()` and `endRecord()`, sink
+ * is locked in between. Records with piped content are written with several
+ * calls, so spliced log file must not be shared with other processes.
+ * Completed records are published without locking for `flushSignalSafe()`.
+ * In mapped output mode records are copied to file mapping as soon as they
+ * are complete, see `FileOutput::Mode`.
+ * In io_uring output modes batches are written asynchronously.
+ * Log file may be rotated between records, see `RotationPolicy`.
+ * Compressed files are written in blocks by `BlockEncoder`, see
+ * `CompressionPolicy`. Uncompressed files may get sparse index written by
+ * `ChunkIndex`, see `IndexPolicy`.
+ */
+class BufferedFileSink
+{
+public:
+  /**
+   * @brief Conditions on which buffered records are written to file
+   */
+  struct FlushPolicy
+  {
+    /// Flush when this many bytes are buffered. Zero disables buffering
+    size_t bufferSize;
+
+    /// Flush records buffered for this many milliseconds
+    uint32_t maxAgeMs;
+
+    /// Flush immediately after record with at least this severity
+    LogMessage::Severity flushSeverity;
+  };
+
+  /**
+   * @brief Conditions on which log file is rotated
+   */
+  struct RotationPolicy
+  {
+    /// Rotate when file reaches this many bytes. Zero disables size limit
+    uint64_t maxSize;
+
+    /// Rotate when local time crosses multiple of this many seconds, e.g.
+    /// at midnight for 86400. Zero disables time-based rotation
+    uint32_t intervalSec;
+
+    /// Replace rotated segments with gzip-compressed ones
+    bool isCompressed;
+  };
+
+  /**
+   * @brief Block compression of log file
+   */
+  struct CompressionPolicy
+  {
+    /// Compress records in blocks of about this many bytes. Zero disables
+    /// compression
+    size_t blockSize;
+
+    /// Write block holding records for this many milliseconds
+    uint32_t maxAgeMs;
+
+    /// Deflate level, 1 to 9
+    int level;
+  };
+
+  /**
+   * @brief Sparse index of log file
+   */
+  struct IndexPolicy
+  {
+    /// Describe each this many bytes of file with index entry. Zero
+    /// disables index
+    uint64_t chunkSize;
+  };
+
+  /**
+   * @brief How records reach log file, see `FileOutput::Mode`
+   */
+  using OutputMode = FileOutput::Mode;
+
+  using BlockSummary = BlockEncoder::BlockSummary;
+
+  static constexpr FlushPolicy FLUSH_POLICY_DEFAULT = {
+      .bufferSize    = 64 * 1024,
+      .maxAgeMs      = 100,
+      .flushSeverity = LogMessage::Severity::ERROR,
+  };
+
+  static constexpr CompressionPolicy COMPRESSION_POLICY_NONE = {
+      .blockSize = 0,
+      .maxAgeMs  = 0,
+      .level     = 0,
+  };
+
+  static constexpr CompressionPolicy COMPRESSION_POLICY_DEFAULT = {
+      .blockSize = 256 * 1024,
+      .maxAgeMs  = 5000,
+      .level     = 1,
+  };
+
+  static constexpr IndexPolicy INDEX_POLICY_NONE = {
+      .chunkSize = 0,
+  };
+
+  static constexpr IndexPolicy INDEX_POLICY_DEFAULT = {
+      .chunkSize = 1024 * 1024,
+  };
+
+  static constexpr RotationPolicy ROTATION_POLICY_NONE = {
+      .maxSize      = 0,
+      .intervalSec  = 0,
+      .isCompressed = false,
+  };
+
+  /**
+   * @brief Minimum length of record part which is written directly from
+   * caller memory instead of being copied
+   */
+  static constexpr size_t EXTERNAL_PART_LEN_MIN = 4096;
+
+private:
+  /**
+   * @brief Maximum number of record parts written from caller memory
+   */
+  static constexpr size_t EXTERNAL_PART_COUNT_MAX = 4;
+
+  /**
+   * @brief Part of record which is not copied to buffer
+   */
+  struct ExternalPart
+  {
+    size_t      offset; /// Buffer length at the moment part was appended
+    const char* data;
+    size_t      length;
+  };
+
+  FlushPolicy policy;
+  std::mutex  mutex;
+
+  FileOutput output;
+
+  RotationPolicy rotationPolicy;
+
+  /// File size from which size limit is counted, moved forward when
+  /// rotation fails
+  uint64_t rotationBaseSize;
+
+  /// Wall-clock time of next time-based rotation, zero if none
+  time_t nextRotationTime;
+
+  /// Text closing each segment and opening next one, `nullptr` if none
+  const char* segmentFooter;
+  const char* segmentHeader;
+
+  utils::SegmentCompressor compressor;
+
+  CompressionPolicy compression;
+  BlockEncoder      encoder;
+
+  IndexPolicy indexPolicy;
+  ChunkIndex  index;
+
+  utils::TextBuffer buffer;
+  ExternalPart      externalParts[EXTERNAL_PART_COUNT_MAX];
+  size_t            externalPartCount;
+
+  /// Record being built, appended to `buffer` when it ends
+  utils::TextBuffer record;
+
+  /// Time of oldest buffered record in milliseconds, zero if none
+  std::atomic<uint64_t> bufferedSinceMs;
+
+  /// Buffered text of completed records, for `flushSignalSafe()`. Length
+  /// is reset before buffer is reallocated
+  std::atomic<const char*> committedData;
+  std::atomic<size_t>      committedLen;
+
+  /// Buffer was written by `flushSignalSafe()`, further flushes would
+  /// duplicate records
+  std::atomic<bool> isAbandoned;
+
+  /// Writes records which exceed maximum age when no more are logged
+  utils::FlushTimer flushTimer;
+
+  /**
+   * @brief Get current monotonic time in milliseconds
+   */
+  static uint64_t getTimeMs();
+
+  /**
+   * @brief Append current record to buffered data. Sink must be locked
+   */
+  void commitRecordLocked();
+
+  /**
+   * @brief Write all buffered data. Sink must be locked
+   */
+  void flushLocked();
+
+  /**
+   * @brief Get time for which records may stay in buffer, which is longer
+   * for compressed blocks
+   */
+  uint32_t getMaxAgeMs() const
+  {
+    return isCompressed() ? compression.maxAgeMs : policy.maxAgeMs;
+  }
+
+  /**
+   * @brief Write index of blocks written in this session and file trailer.
+   * Sink must be locked and contain no buffered records
+   */
+  void writeIndexLocked();
+
+  /**
+   * @brief Check if current index chunk is large enough and ends between
+   * records. Sink must be locked
+   */
+  bool isChunkComplete() const;
+
+  /**
+   * @brief Append entry of current chunk to index and start new chunk. Sink
+   * must be locked and contain no buffered records
+   */
+  void endChunkLocked();
+
+  /**
+   * @brief Write buffered records if the oldest one exceeds maximum age,
+   * otherwise schedule flush timer for the remaining time
+   */
+  void flushExpired();
+
+  /**
+   * @brief Flush timer callback
+   *
+   * @param[in] sink  Sink owning timer
+   */
+  static void onFlushTimer(void* sink);
+
+  /**
+   * @brief Compute time of next time-based rotation from current time
+   */
+  void scheduleRotation();
+
+  /**
+   * @brief Check if rotation policy requires rotating log file now
+   */
+  bool isRotationDue() const;
+
+  /**
+   * @brief Close current segment and continue in new log file. Sink must be
+   * locked and contain no record being built
+   */
+  void rotateLocked();
+
+  /**
+   * @brief Choose name of rotated segment which is not used by existing
+   * file or its compressed version
+   *
+   * @return Allocated name, must be freed with `delete[]`
+   */
+  char* makeSegmentName() const;
+
+public:
+  BufferedFileSink();
+
+  // No copying
+  BufferedFileSink(const BufferedFileSink&)            = delete;
+  BufferedFileSink& operator=(const BufferedFileSink&) = delete;
+
+  /**
+   * @brief Open log file for appending
+   *
+   * @param[in] filename  Log file name
+   * @param[in] mode      How records are written to file
+   *
+   * @return `true` if file was opened, `false` otherwise
+   */
+  bool open(const char* filename, OutputMode mode = OutputMode::WRITE);
+
+  bool isOpen() const { return output.isOpen(); }
+
+  bool isMapped() const { return output.isMapped(); }
+
+  /**
+   * @brief Check if file is written at offsets tracked by sink rather than
+   * appended to. Records written by crash handler must then be passed to
+   * `writeSignalSafe()`
+   */
+  bool isWrittenAtOffsets() const { return output.isWrittenAtOffsets(); }
+
+  /**
+   * @brief Get log file descriptor, -1 if file is not open
+   */
+  int getFd() const { return output.getFd(); }
+
+  bool isCompressed() const { return compression.blockSize > 0; }
+
+  bool isIndexed() const { return index.isOpen(); }
+
+  /**
+   * @brief Check if crash handler must pass records to `writeSignalSafe()`
+   * rather than write them to file descriptor. True for files written at
+   * offsets and for compressed files
+   */
+  bool needsWholeRecords() const
+  {
+    return isWrittenAtOffsets() || isCompressed();
+  }
+
+  /**
+   * @brief Get number of compressed blocks written so far. Block boundary
+   * lies between records, writers which make records depend on each other
+   * may start over when this number changes
+   */
+  uint64_t getBlockCount() const { return encoder.getBlockCount(); }
+
+  void setFlushPolicy(const FlushPolicy& flushPolicy);
+
+  void setRotationPolicy(const RotationPolicy& rotation);
+
+  /**
+   * @brief Enable or disable block compression. Must be called before file
+   * is opened
+   */
+  void setCompressionPolicy(const CompressionPolicy& policy);
+
+  /**
+   * @brief Enable or disable sparse index. Must be called before file is
+   * opened. Compressed files have index of their own and ignore this policy
+   */
+  void setIndexPolicy(const IndexPolicy& policy);
+
+  /**
+   * @brief Set text written at the end of each rotated segment and at the
+   * start of each new log file, e.g. closing and opening tags of document.
+   * Strings must outlive sink
+   *
+   * @param[in] footer  Text closing segment, `nullptr` if none
+   * @param[in] header  Text opening new file, `nullptr` if none
+   */
+  void setSegmentMarkers(const char* footer, const char* header);
+
+  /**
+   * @brief Allow or forbid appending piped content to records. Enabling
+   * splicing removes `O_APPEND` from log file
+   *
+   * @param[in] isEnabled   Whether `appendPipedContent()` may be used
+   */
+  void setSpliceEnabled(bool isEnabled);
+
+  /**
+   * @brief Check if piped content can be appended. Only uncompressed
+   * `WRITE` mode supports splicing, otherwise such content is copied
+   */
+  bool canSplice() const { return output.canSplice() && !isCompressed(); }
+
+  /**
+   * @brief Start new record and lock sink until `endRecord()` is called
+   *
+   * @return Buffer to which record text must be appended
+   */
+  utils::TextBuffer& beginRecord();
+
+  /**
+   * @brief Append text to current record. Long text is not copied and must
+   * stay valid until `endRecord()` returns
+   *
+   * @param[in] text    Text to be appended
+   * @param[in] length  Text length
+   */
+  void appendContent(const char* text, size_t length);
+
+  /**
+   * @brief Move content from pipe to file as next part of current record.
+   * Record text appended so far is written first. Splicing must be enabled
+   *
+   * @param[in] pipeFd    Read end of pipe
+   * @param[in] length    Number of bytes to move
+   * @param[in] consume   Whether content may be removed from pipe
+   */
+  void appendPipedContent(int pipeFd, size_t length, bool consume);
+
+  /**
+   * @brief Account message of current record in index of compressed file or
+   * in sparse index
+   *
+   * @param[in] message   Message of record
+   * @param[in] timeNs    Message wall-clock time in nanoseconds since Epoch
+   */
+  void indexMessage(const LogMessage& message, uint64_t timeNs)
+  {
+    if (isCompressed())
+    {
+      encoder.addMessage(message.severity, timeNs);
+    }
+    if (isIndexed())
+    {
+      index.addMessage(message, timeNs);
+    }
+  }
+
+  /**
+   * @brief Account several messages of current record in index of
+   * compressed file
+   */
+  void indexMessages(const BlockSummary& summary)
+  {
+    if (isCompressed())
+    {
+      encoder.addMessages(summary);
+    }
+  }
+
+  /**
+   * @brief Finish current record, flush it if required by flush policy,
+   * rotate log file if required by rotation policy and unlock sink
+   *
+   * @param[in] severity  Severity of message in record
+   */
+  void endRecord(LogMessage::Severity severity);
+
+  /**
+   * @brief Write all buffered records, waiting for asynchronous writes
+   */
+  void flush();
+
+  /**
+   * @brief Write completed buffered records without locking sink.
+   * Async-signal-safe. Record being built by interrupted thread is lost, as
+   * are records buffered at the moment buffer was growing. Sink stops
+   * writing buffered records afterwards, since they stay in buffer
+   */
+  void flushSignalSafe();
+
+  /**
+   * @brief Write complete record without locking sink. Async-signal-safe.
+   * Compressed file gets record as separate uncompressed block
+   *
+   * @param[in] record  Record text
+   * @param[in] length  Record length
+   */
+  void writeSignalSafe(const char* record, size_t length);
+
+  ~BufferedFileSink();
+};
+
+} // namespace mklog
+
+#endif /* BufferedFileSink.h */
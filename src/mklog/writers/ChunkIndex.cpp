@@ -0,0 +1,138 @@
+#include "mklog/writers/ChunkIndex.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "mklog/writers/FileOutput.h"
+
+namespace mklog
+{
+
+using utils::LogIndexFormat;
+
+ChunkIndex::ChunkIndex()
+    : chunkSize(0),
+      fd(-1),
+      chunkStart(0),
+      chunkSummary(LogIndexFormat::CHUNK_SUMMARY_EMPTY),
+      lastLogger(nullptr),
+      lastLoggerBits(0),
+      lastFile(nullptr),
+      lastFileBits(0)
+{
+}
+
+char* ChunkIndex::makeIndexName(const char* logName)
+{
+  const size_t logNameLen = strlen(logName);
+  char* const  indexName =
+      new char[logNameLen + sizeof(LogIndexFormat::FILE_SUFFIX)];
+  memcpy(indexName, logName, logNameLen);
+  memcpy(indexName + logNameLen, LogIndexFormat::FILE_SUFFIX,
+         sizeof(LogIndexFormat::FILE_SUFFIX));
+  return indexName;
+}
+
+void ChunkIndex::open(const char* logName, uint64_t logSize)
+{
+  chunkStart   = logSize;
+  chunkSummary = LogIndexFormat::CHUNK_SUMMARY_EMPTY;
+
+  if (chunkSize == 0)
+    return;
+
+  // Entries of empty log file are stale
+  char* const indexName = makeIndexName(logName);
+  fd = ::open(indexName,
+              O_CREAT | O_WRONLY | O_APPEND | O_CLOEXEC |
+                  (logSize == 0 ? O_TRUNC : 0),
+              S_IRUSR | S_IWUSR);
+  delete[] indexName;
+
+  if (isOpen() && lseek(fd, 0, SEEK_END) == 0)
+  {
+    char header[LogIndexFormat::FILE_HEADER_SIZE] = {};
+    LogIndexFormat::encodeFileHeader(header);
+    FileOutput::writeAll(fd, header, sizeof(header), -1);
+  }
+}
+
+void ChunkIndex::addMessage(const LogMessage& message, uint64_t timeNs)
+{
+  if (message.source.logger != lastLogger)
+  {
+    lastLogger = message.source.logger;
+    lastLoggerBits =
+        LogIndexFormat::getNameBits(lastLogger, strlen(lastLogger));
+  }
+  if (message.source.file != lastFile)
+  {
+    lastFile = message.source.file;
+
+    const char* baseName = LogIndexFormat::getBaseName(lastFile);
+    lastFileBits = LogIndexFormat::getNameBits(baseName, strlen(baseName));
+  }
+
+  chunkSummary.add(message.severity, timeNs, lastLoggerBits, lastFileBits);
+}
+
+void ChunkIndex::endChunk(uint64_t logSize)
+{
+  if (!isOpen() || logSize == chunkStart)
+  {
+    return;
+  }
+
+  const LogIndexFormat::Entry entry = {
+      .offset  = chunkStart,
+      .length  = logSize - chunkStart,
+      .summary = chunkSummary,
+  };
+  char encoded[LogIndexFormat::ENTRY_SIZE] = {};
+  LogIndexFormat::encodeEntry(encoded, entry);
+  FileOutput::writeAll(fd, encoded, sizeof(encoded), -1);
+
+  chunkStart   = logSize;
+  chunkSummary = LogIndexFormat::CHUNK_SUMMARY_EMPTY;
+}
+
+void ChunkIndex::rotate(const char* logName, const char* segmentName,
+                        bool isDiscarded, uint64_t logSize)
+{
+  if (!isOpen())
+  {
+    chunkStart   = logSize;
+    chunkSummary = LogIndexFormat::CHUNK_SUMMARY_EMPTY;
+    return;
+  }
+
+  close(fd);
+  fd = -1;
+
+  char* const indexName = makeIndexName(logName);
+  if (isDiscarded)
+  {
+    unlink(indexName);
+  }
+  else
+  {
+    char* const segmentIndexName = makeIndexName(segmentName);
+    rename(indexName, segmentIndexName);
+    delete[] segmentIndexName;
+  }
+  delete[] indexName;
+
+  open(logName, logSize);
+}
+
+ChunkIndex::~ChunkIndex()
+{
+  if (isOpen())
+  {
+    close(fd);
+  }
+}
+
+} // namespace mklog
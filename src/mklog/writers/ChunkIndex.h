@@ -0,0 +1,131 @@
+/**
+ * @file ChunkIndex.h
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Sparse index file written alongside uncompressed log file
+ *
+ * @version 0.1
+ * @date 2023-09-21
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#ifndef __MEERKAT_LOGS_WRITERS_CHUNKINDEX_H
+#define __MEERKAT_LOGS_WRITERS_CHUNKINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "mklog/LogMessage.h"
+#include "mklog/utils/LogIndexFormat.h"
+
+namespace mklog
+{
+
+/**
+ * @brief Writer of sparse index described by `utils::LogIndexFormat`. Log
+ * file is split into chunks ending between records, and summary of
+ * messages of each chunk is appended to index file once chunk is complete.
+ * Not thread-safe.
+ */
+class ChunkIndex
+{
+private:
+  using ChunkSummary = utils::LogIndexFormat::ChunkSummary;
+
+  /// Describe each this many bytes of log file with index entry. Zero
+  /// disables index
+  uint64_t chunkSize;
+
+  /// Index file, -1 if log file is not indexed
+  int fd;
+
+  /// Log file offset of current chunk and its messages, including ones of
+  /// records not yet written
+  uint64_t     chunkStart;
+  ChunkSummary chunkSummary;
+
+  /// Names of the last indexed message and their bits. Names usually come
+  /// from string literals, so pointers are compared instead of hashing
+  const char* lastLogger;
+  uint64_t    lastLoggerBits;
+  const char* lastFile;
+  uint64_t    lastFileBits;
+
+  /**
+   * @brief Get name of index file of log file
+   *
+   * @return Allocated name, must be freed with `delete[]`
+   */
+  static char* makeIndexName(const char* logName);
+
+public:
+  ChunkIndex();
+
+  // No copying
+  ChunkIndex(const ChunkIndex&)            = delete;
+  ChunkIndex& operator=(const ChunkIndex&) = delete;
+
+  /**
+   * @brief Set size of chunks. Must be called before index is opened
+   *
+   * @param[in] size  Chunk size in bytes, zero disables index
+   */
+  void setChunkSize(uint64_t size) { chunkSize = size; }
+
+  bool isOpen() const { return fd >= 0; }
+
+  /**
+   * @brief Open index of log file, if it is enabled, and start chunk at
+   * the end of log file. Index of empty log file is started over
+   *
+   * @param[in] logName   Log file name
+   * @param[in] logSize   Current size of log file
+   */
+  void open(const char* logName, uint64_t logSize);
+
+  /**
+   * @brief Account message of record in current chunk
+   *
+   * @param[in] message   Message of record
+   * @param[in] timeNs    Message wall-clock time in nanoseconds since Epoch
+   */
+  void addMessage(const LogMessage& message, uint64_t timeNs);
+
+  /**
+   * @brief Check if current chunk is large enough. Caller makes sure chunk
+   * ends between records
+   *
+   * @param[in] logSize   Current size of log file
+   */
+  bool isChunkComplete(uint64_t logSize) const
+  {
+    return isOpen() && logSize - chunkStart >= chunkSize;
+  }
+
+  /**
+   * @brief Append entry of current chunk to index and start new chunk. All
+   * records of chunk must be written
+   *
+   * @param[in] logSize   Current size of log file
+   */
+  void endChunk(uint64_t logSize);
+
+  /**
+   * @brief Move index to rotated segment of log file and start index of
+   * new log file
+   *
+   * @param[in] logName       Log file name
+   * @param[in] segmentName   Name of rotated segment
+   * @param[in] isDiscarded   Remove index instead, since segment is going
+   *                          to be compressed
+   * @param[in] logSize       Size of new log file
+   */
+  void rotate(const char* logName, const char* segmentName,
+              bool isDiscarded, uint64_t logSize);
+
+  ~ChunkIndex();
+};
+
+} // namespace mklog
+
+#endif /* ChunkIndex.h */
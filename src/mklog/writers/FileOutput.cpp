@@ -0,0 +1,487 @@
+#include "mklog/writers/FileOutput.h"
+
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace mklog
+{
+
+/**
+ * @brief Write all parts, continuing after short writes
+ */
+static void writeParts(int fd, struct iovec* parts, size_t partCount)
+{
+  while (partCount > 0)
+  {
+    ssize_t written = writev(fd, parts, (int)partCount);
+    if (written < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      return;
+    }
+
+    // Skip written parts
+    while (partCount > 0 && (size_t)written >= parts->iov_len)
+    {
+      written -= (ssize_t)parts->iov_len;
+      ++parts;
+      --partCount;
+    }
+    if (partCount > 0)
+    {
+      parts->iov_base = (char*)parts->iov_base + written;
+      parts->iov_len -= (size_t)written;
+    }
+  }
+}
+
+/**
+ * @brief Move content between pipe and file with `splice()`
+ *
+ * @return Number of bytes moved
+ */
+static size_t spliceAll(int inFd, int outFd, size_t length)
+{
+  size_t moved = 0;
+  while (moved < length)
+  {
+    const ssize_t splicedLen =
+        ::splice(inFd, nullptr, outFd, nullptr, length - moved, SPLICE_F_MOVE);
+    if (splicedLen < 0 && errno == EINTR)
+      continue;
+    if (splicedLen <= 0)
+      break;
+
+    moved += (size_t)splicedLen;
+  }
+  return moved;
+}
+
+/**
+ * @brief Read and drop pipe content
+ */
+static void discardPipeContent(int pipeFd, size_t length)
+{
+  char discarded[4096];
+  while (length > 0)
+  {
+    const size_t  chunkLen = length < sizeof(discarded) ? length
+                                                         : sizeof(discarded);
+    const ssize_t readLen  = read(pipeFd, discarded, chunkLen);
+    if (readLen < 0 && errno == EINTR)
+      continue;
+    if (readLen <= 0)
+      break;
+
+    length -= (size_t)readLen;
+  }
+}
+
+void FileOutput::writeAll(int fd, const char* data, size_t length,
+                          off_t offset)
+{
+  size_t writtenLen = 0;
+  while (writtenLen < length)
+  {
+    const ssize_t result =
+        offset < 0 ? ::write(fd, data + writtenLen, length - writtenLen)
+                   : pwrite(fd, data + writtenLen, length - writtenLen,
+                            offset + (off_t)writtenLen);
+    if (result < 0 && errno == EINTR)
+      continue;
+    if (result <= 0)
+      break;
+    writtenLen += (size_t)result;
+  }
+}
+
+FileOutput::FileOutput()
+    : fd(-1),
+      mode(Mode::WRITE),
+      filename(nullptr),
+      fileSize(0),
+      mapping(nullptr),
+      mappingOffset(0),
+      ring(),
+      reservedEnd(0),
+      isSpliceEnabled(false),
+      teePipeFds{-1, -1},
+      teePipeCapacity(0)
+{
+}
+
+bool FileOutput::open(const char* filename, Mode mode)
+{
+  assert(!isOpen() && "Cannot reset log file");
+
+  this->mode = mode;
+
+  const size_t filenameLen = strlen(filename);
+  this->filename           = new char[filenameLen + 1];
+  memcpy(this->filename, filename, filenameLen + 1);
+
+  fd = openFile();
+  if (!isOpen())
+  {
+    delete[] this->filename;
+    this->filename = nullptr;
+    return false;
+  }
+
+  setup();
+  return true;
+}
+
+int FileOutput::getOpenFlags() const
+{
+  return isSpliceEnabled || isWrittenAtOffsets() ? 0 : O_APPEND;
+}
+
+int FileOutput::openFile() const
+{
+  // Shared writable mapping requires file open for reading
+  return ::open(filename,
+                O_CREAT | (isMapped() ? O_RDWR : O_WRONLY) | getOpenFlags(),
+                S_IRUSR | S_IWUSR);
+}
+
+void FileOutput::setup()
+{
+  const bool isUring = mode == Mode::URING || mode == Mode::URING_POLLED;
+  if (isUring && !ring.open(fd, mode == Mode::URING_POLLED))
+  {
+    mode = Mode::WRITE;
+
+    const int flags = fcntl(fd, F_GETFL);
+    fcntl(fd, F_SETFL, flags | getOpenFlags());
+  }
+
+  // Files without `O_APPEND` are written from their end as well
+  const off_t fileEnd = lseek(fd, 0, SEEK_END);
+  fileSize            = fileEnd > 0 ? (uint64_t)fileEnd : 0;
+  if (isWrittenAtOffsets())
+  {
+    reservedEnd.store(fileSize, std::memory_order_relaxed);
+  }
+}
+
+void FileOutput::setSpliceEnabled(bool isEnabled)
+{
+  isSpliceEnabled = isEnabled;
+  if (!isOpen() || isWrittenAtOffsets())
+  {
+    return;
+  }
+
+  const int flags = fcntl(fd, F_GETFL);
+  fcntl(fd, F_SETFL, (flags & ~O_APPEND) | getOpenFlags());
+  if (isSpliceEnabled)
+  {
+    lseek(fd, 0, SEEK_END);
+  }
+}
+
+bool FileOutput::mapExtent(uint64_t offset)
+{
+  unmapExtent();
+
+  const uint64_t pageSize = (uint64_t)sysconf(_SC_PAGESIZE);
+  const uint64_t start    = offset - offset % pageSize;
+
+  // Allocated blocks keep writes to mapping from failing with SIGBUS when
+  // disk is full
+  if (posix_fallocate(fd, (off_t)start, MAPPED_EXTENT_SIZE) != 0)
+  {
+    return false;
+  }
+
+  void* extent = mmap(nullptr, MAPPED_EXTENT_SIZE, PROT_READ | PROT_WRITE,
+                      MAP_SHARED, fd, (off_t)start);
+  if (extent == MAP_FAILED)
+  {
+    return false;
+  }
+  madvise(extent, MAPPED_EXTENT_SIZE, MADV_SEQUENTIAL);
+
+  mapping       = static_cast<char*>(extent);
+  mappingOffset = start;
+  return true;
+}
+
+void FileOutput::unmapExtent()
+{
+  if (mapping == nullptr)
+  {
+    return;
+  }
+
+  // Filled extent is not touched again, start its writeback early
+  msync(mapping, MAPPED_EXTENT_SIZE, MS_ASYNC);
+  munmap(mapping, MAPPED_EXTENT_SIZE);
+  mapping = nullptr;
+}
+
+void FileOutput::truncateMapped()
+{
+  ftruncate(fd, (off_t)(reservedEnd.load(std::memory_order_relaxed) &
+                        ~RESERVED_END_ABANDONED));
+}
+
+void FileOutput::writeMapped(const struct iovec* parts, size_t partCount)
+{
+  size_t totalLen = 0;
+  for (size_t i = 0; i < partCount; ++i)
+  {
+    totalLen += parts[i].iov_len;
+  }
+
+  uint64_t offset = reservedEnd.load(std::memory_order_relaxed);
+  do
+  {
+    if ((offset & RESERVED_END_ABANDONED) != 0)
+      return;
+  } while (!reservedEnd.compare_exchange_weak(offset, offset + totalLen,
+                                            std::memory_order_relaxed));
+
+  for (size_t i = 0; i < partCount; ++i)
+  {
+    const char* data   = static_cast<const char*>(parts[i].iov_base);
+    size_t      length = parts[i].iov_len;
+    while (length > 0)
+    {
+      const bool isInExtent = mapping != nullptr && offset >= mappingOffset &&
+                              offset < mappingOffset + MAPPED_EXTENT_SIZE;
+      if (!isInExtent && !mapExtent(offset))
+      {
+        // Disk is full or address space is exhausted
+        writeAll(fd, data, length, (off_t)offset);
+        offset += length;
+        break;
+      }
+
+      const size_t available =
+          (size_t)(mappingOffset + MAPPED_EXTENT_SIZE - offset);
+      const size_t copiedLen = length < available ? length : available;
+      memcpy(mapping + (offset - mappingOffset), data, copiedLen);
+
+      data   += copiedLen;
+      length -= copiedLen;
+      offset += copiedLen;
+    }
+  }
+}
+
+void FileOutput::writeUring(const struct iovec* parts, size_t partCount)
+{
+  size_t totalLen = 0;
+  for (size_t i = 0; i < partCount; ++i)
+  {
+    totalLen += parts[i].iov_len;
+  }
+
+  uint64_t offset =
+      reservedEnd.fetch_add(totalLen, std::memory_order_relaxed);
+
+  size_t partIndex  = 0;
+  size_t partOffset = 0;
+  while (partIndex < partCount)
+  {
+    size_t bufferIndex = 0;
+    char*  buffer      = ring.acquireBuffer(&bufferIndex);
+    size_t bufferLen   = 0;
+
+    // Fill buffer with as many parts as fit
+    while (partIndex < partCount && bufferLen < utils::IoUring::BUFFER_SIZE)
+    {
+      const char*  data = static_cast<const char*>(parts[partIndex].iov_base);
+      const size_t left = parts[partIndex].iov_len - partOffset;
+      const size_t space  = utils::IoUring::BUFFER_SIZE - bufferLen;
+      const size_t copied = left < space ? left : space;
+      memcpy(buffer + bufferLen, data + partOffset, copied);
+
+      bufferLen  += copied;
+      partOffset += copied;
+      if (partOffset == parts[partIndex].iov_len)
+      {
+        ++partIndex;
+        partOffset = 0;
+      }
+    }
+
+    ring.submitWrite(bufferIndex, bufferLen, offset);
+    offset += bufferLen;
+  }
+}
+
+void FileOutput::write(struct iovec* parts, size_t partCount)
+{
+  for (size_t i = 0; i < partCount; ++i)
+  {
+    fileSize += parts[i].iov_len;
+  }
+
+  switch (mode)
+  {
+  case Mode::MAPPED:
+    writeMapped(parts, partCount);
+    break;
+  case Mode::URING:
+  case Mode::URING_POLLED:
+    writeUring(parts, partCount);
+    break;
+  case Mode::WRITE:
+  default:
+    writeParts(fd, parts, partCount);
+    break;
+  }
+}
+
+bool FileOutput::prepareTeePipe(int pipeFd)
+{
+  if (teePipeFds[0] < 0 && pipe2(teePipeFds, O_CLOEXEC) != 0)
+  {
+    teePipeFds[0] = teePipeFds[1] = -1;
+    return false;
+  }
+
+  const int sourceCapacity = fcntl(pipeFd, F_GETPIPE_SZ);
+  if (sourceCapacity > 0 && (size_t)sourceCapacity > teePipeCapacity)
+  {
+    const int capacity = fcntl(teePipeFds[1], F_SETPIPE_SZ, sourceCapacity);
+    if (capacity > 0)
+    {
+      teePipeCapacity = (size_t)capacity;
+    }
+  }
+
+  return true;
+}
+
+void FileOutput::splice(int pipeFd, size_t length, bool consume)
+{
+  assert(canSplice() && "Splicing is not enabled");
+
+  if (consume)
+  {
+    const size_t moved = spliceAll(pipeFd, fd, length);
+    fileSize += moved;
+
+    // Pipe must not keep content of this message after failed write
+    discardPipeContent(pipeFd, length - moved);
+    return;
+  }
+
+  if (!prepareTeePipe(pipeFd))
+  {
+    return;
+  }
+
+  // Tee pipe is as large as source pipe and empty, so single `tee()`
+  // duplicates all content
+  ssize_t teeLen = 0;
+  do
+  {
+    teeLen = tee(pipeFd, teePipeFds[1], length, 0);
+  } while (teeLen < 0 && errno == EINTR);
+  if (teeLen <= 0)
+  {
+    return;
+  }
+
+  const size_t moved = spliceAll(teePipeFds[0], fd, (size_t)teeLen);
+  fileSize += moved;
+  discardPipeContent(teePipeFds[0], (size_t)teeLen - moved);
+}
+
+bool FileOutput::rename(const char* newName)
+{
+  ring.waitAll();
+  if (isMapped())
+  {
+    unmapExtent();
+    truncateMapped();
+  }
+
+  const int newFd = ::rename(filename, newName) == 0 ? openFile() : -1;
+  if (newFd < 0)
+  {
+    return false;
+  }
+
+  // New file takes descriptor number of the old one, so crash handler
+  // never sees closed descriptor
+  dup2(newFd, fd);
+  close(newFd);
+
+  // Registered file refers to old one
+  ring.close();
+  setup();
+  return true;
+}
+
+void FileOutput::poll()
+{
+  if (ring.isOpen())
+  {
+    ring.poll();
+  }
+}
+
+void FileOutput::abandonSignalSafe()
+{
+  if (isOpen() && isMapped())
+  {
+    // Space reserved by other threads stays below truncated length, so
+    // their copies cannot fault
+    const uint64_t end =
+        reservedEnd.fetch_or(RESERVED_END_ABANDONED, std::memory_order_acq_rel);
+    ftruncate(fd, (off_t)(end & ~RESERVED_END_ABANDONED));
+  }
+
+  // Submitted batches precede data written by crash handler
+  ring.waitSignalSafe();
+}
+
+void FileOutput::writeSignalSafe(const char* data, size_t length)
+{
+  if (!isWrittenAtOffsets())
+  {
+    writeAll(fd, data, length, -1);
+    return;
+  }
+
+  // Mapping and io_uring buffers may be used by interrupted thread, so
+  // data is written to file at reserved position instead
+  const uint64_t offset =
+      reservedEnd.fetch_add(length, std::memory_order_relaxed) &
+      ~RESERVED_END_ABANDONED;
+  writeAll(fd, data, length, (off_t)offset);
+}
+
+FileOutput::~FileOutput()
+{
+  unmapExtent();
+  ring.close();
+  if (isOpen())
+  {
+    if (isMapped())
+    {
+      truncateMapped();
+    }
+    close(fd);
+  }
+  delete[] filename;
+  if (teePipeFds[0] >= 0)
+  {
+    close(teePipeFds[0]);
+    close(teePipeFds[1]);
+  }
+}
+
+} // namespace mklog
@@ -0,0 +1,277 @@
+/**
+ * @file FileOutput.h
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Writing batches of log records to file
+ *
+ * @version 0.1
+ * @date 2023-09-21
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#ifndef __MEERKAT_LOGS_WRITERS_FILEOUTPUT_H
+#define __MEERKAT_LOGS_WRITERS_FILEOUTPUT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include "mklog/utils/IoUring.h"
+
+namespace mklog
+{
+
+/**
+ * @brief Log file to which batches of records are written with `writev()`,
+ * copied to memory-mapped preallocated extents or written asynchronously
+ * through io_uring. Knows nothing about records themselves, see
+ * `BufferedFileSink`. Not thread-safe, except for async-signal-safe
+ * methods, which may run concurrently with others.
+ */
+class FileOutput
+{
+public:
+  /**
+   * @brief How batches reach log file
+   */
+  enum class Mode
+  {
+    WRITE,  /// Batches are written with `writev()`, file is appended to
+    MAPPED, /// Batches are copied to memory-mapped preallocated file
+    URING,  /// Batches are written asynchronously through io_uring
+
+    /// Like `URING`, with kernel thread polling for submitted writes
+    URING_POLLED,
+  };
+
+  /**
+   * @brief Size of file extent allocated and mapped at once in mapped mode
+   */
+  static constexpr size_t MAPPED_EXTENT_SIZE = 64 * 1024 * 1024;
+
+private:
+  /**
+   * @brief Bit of `reservedEnd` set after crash, when mapped file is
+   * truncated. Batches of other threads are not copied to mapping
+   * afterwards
+   */
+  static constexpr uint64_t RESERVED_END_ABANDONED = UINT64_C(1) << 63;
+
+  int  fd;
+  Mode mode;
+
+  /// Name under which log file is reopened after rotation
+  char* filename;
+
+  /// Number of bytes in log file, including ones written before it was
+  /// opened
+  uint64_t fileSize;
+
+  /// Mapped extent of file, if mode is `MAPPED`
+  char*    mapping;
+  uint64_t mappingOffset;
+
+  /// Asynchronous writes, if mode is `URING` or `URING_POLLED`
+  utils::IoUring ring;
+
+  /// Length of file written at offsets tracked by output. Space is reserved
+  /// before data is copied, so that crash handler can write concurrently
+  std::atomic<uint64_t> reservedEnd;
+
+  /// Piped content may be moved to file
+  bool isSpliceEnabled;
+
+  /// Pipe to which content is duplicated with `tee()` before being moved
+  /// to file, if it must be left in source pipe
+  int    teePipeFds[2];
+  size_t teePipeCapacity;
+
+  /**
+   * @brief Get file status flags used for log file
+   */
+  int getOpenFlags() const;
+
+  /**
+   * @brief Open log file under its name with flags required by mode
+   *
+   * @return File descriptor, -1 on failure
+   */
+  int openFile() const;
+
+  /**
+   * @brief Prepare freshly opened file for mode. Falls back to `WRITE` mode
+   * if io_uring is unavailable
+   */
+  void setup();
+
+  /**
+   * @brief Allocate and map extent of file containing given position,
+   * replacing current one
+   *
+   * @param[in] offset  Position in file
+   *
+   * @return `true` if extent is mapped, `false` otherwise
+   */
+  bool mapExtent(uint64_t offset);
+
+  /**
+   * @brief Schedule writeback of mapped extent and unmap it
+   */
+  void unmapExtent();
+
+  /**
+   * @brief Drop unused part of preallocated extent
+   */
+  void truncateMapped();
+
+  /**
+   * @brief Copy parts to mapped file
+   */
+  void writeMapped(const struct iovec* parts, size_t partCount);
+
+  /**
+   * @brief Copy parts to io_uring buffers and submit them
+   */
+  void writeUring(const struct iovec* parts, size_t partCount);
+
+  /**
+   * @brief Create or grow pipe used for `tee()` so that it can hold all
+   * content of source pipe
+   *
+   * @param[in] pipeFd  Source pipe
+   *
+   * @return `true` if pipe is ready, `false` otherwise
+   */
+  bool prepareTeePipe(int pipeFd);
+
+public:
+  /**
+   * @brief Write all data, at given offset if it is not negative.
+   * Async-signal-safe
+   *
+   * @param[in] fd      File descriptor
+   * @param[in] data    Data to be written
+   * @param[in] length  Data length
+   * @param[in] offset  File offset, negative to write at current position
+   */
+  static void writeAll(int fd, const char* data, size_t length,
+                       off_t offset);
+
+  FileOutput();
+
+  // No copying
+  FileOutput(const FileOutput&)            = delete;
+  FileOutput& operator=(const FileOutput&) = delete;
+
+  /**
+   * @brief Open log file for appending
+   *
+   * @param[in] filename  Log file name
+   * @param[in] mode      How batches are written to file
+   *
+   * @return `true` if file was opened, `false` otherwise
+   */
+  bool open(const char* filename, Mode mode);
+
+  bool isOpen() const { return fd >= 0; }
+
+  bool isMapped() const { return mode == Mode::MAPPED; }
+
+  /**
+   * @brief Check if file is written at offsets tracked by output rather
+   * than appended to
+   */
+  bool isWrittenAtOffsets() const { return mode != Mode::WRITE; }
+
+  /**
+   * @brief Check if piped content can be moved to file. Only `WRITE` mode
+   * supports splicing
+   */
+  bool canSplice() const
+  {
+    return isOpen() && isSpliceEnabled && !isWrittenAtOffsets();
+  }
+
+  /**
+   * @brief Get log file descriptor, -1 if file is not open
+   */
+  int getFd() const { return fd; }
+
+  /**
+   * @brief Get name of log file, `nullptr` if file is not open
+   */
+  const char* getFilename() const { return filename; }
+
+  /**
+   * @brief Get number of bytes in log file, including submitted writes
+   */
+  uint64_t getSize() const { return fileSize; }
+
+  /**
+   * @brief Allow or forbid moving piped content to file. Enabling splicing
+   * removes `O_APPEND` from log file
+   */
+  void setSpliceEnabled(bool isEnabled);
+
+  /**
+   * @brief Write parts to file in current mode, as a single `writev()` call
+   * in `WRITE` mode
+   *
+   * @param[inout] parts      Parts to be written, modified on short writes
+   * @param[in]    partCount  Number of parts
+   */
+  void write(struct iovec* parts, size_t partCount);
+
+  /**
+   * @brief Move content from pipe to file. Splicing must be enabled
+   *
+   * @param[in] pipeFd    Read end of pipe
+   * @param[in] length    Number of bytes to move
+   * @param[in] consume   Whether content may be removed from pipe
+   */
+  void splice(int pipeFd, size_t length, bool consume);
+
+  /**
+   * @brief Wait for asynchronous writes, rename log file and open new file
+   * under the original name. Descriptor number stays the same
+   *
+   * @param[in] newName   Name of closed file
+   *
+   * @return `true` if new file is open, `false` if old one is kept
+   */
+  bool rename(const char* newName);
+
+  /**
+   * @brief Wait for all asynchronous writes
+   */
+  void wait() { ring.waitAll(); }
+
+  /**
+   * @brief Reap completed asynchronous writes without waiting
+   */
+  void poll();
+
+  /**
+   * @brief Prepare file for writes of crash handler. Mapped file is
+   * truncated to written length and mapping is no longer written.
+   * Async-signal-safe
+   */
+  void abandonSignalSafe();
+
+  /**
+   * @brief Write data without waiting for mapping or io_uring buffers,
+   * which may be used by interrupted thread. Async-signal-safe
+   *
+   * @param[in] data    Data to be written
+   * @param[in] length  Data length
+   */
+  void writeSignalSafe(const char* data, size_t length);
+
+  ~FileOutput();
+};
+
+} // namespace mklog
+
+#endif /* FileOutput.h */
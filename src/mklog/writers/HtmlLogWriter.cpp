@@ -1,127 +1,46 @@
 #include "mklog/writers/HtmlLogWriter.h"
 
 #include <cassert>
+#include <cinttypes>
 #include <cstdio>
 #include <cstring>
-#include <fcntl.h>
-#include <unistd.h>
 
 #include "mklog/LogMessage.h"
 #include "mklog/LogWriter.h"
+#include "mklog/utils/HtmlEscaper.h"
+#include "mklog/utils/LogClock.h"
+#include "mklog/utils/SignalSafeWriter.h"
+#include "mklog/utils/TimestampFormatter.h"
 
 namespace mklog
 {
 
 static constexpr char PREAMBLE[] = "<body><pre>";
+static constexpr char CLOSING[]  = "</pre></body>\n";
 
-HtmlLogWriter& HtmlLogWriter::setFile(const char* filename)
-{
-  assert(!isValid && "Cannot reset log file");
+// Sink destructor is large, keep it out of every caller
+HtmlLogWriter::~HtmlLogWriter() = default;
 
-  int fd = open(filename, O_CREAT | O_APPEND | O_WRONLY, S_IRUSR | S_IWUSR);
+HtmlLogWriter& HtmlLogWriter::setFile(const char*                  filename,
+                                      BufferedFileSink::OutputMode mode)
+{
+  // Rotated segment is closed, and new file starts with preamble again
+  sink.setSegmentMarkers(CLOSING, PREAMBLE);
 
-  if (fd >= 0)
+  if (sink.open(filename, mode))
   {
-    logFd   = fd;
-    isValid = true;
-    write(fd, PREAMBLE, sizeof(PREAMBLE) - 1);
+    notifyConfigChanged();
+    sink.beginRecord().append(PREAMBLE, sizeof(PREAMBLE) - 1);
+    sink.endRecord(LogMessage::Severity::MAX_LEVEL);
   }
 
   return *this;
 }
 
-struct CharEscapeSeq
-{
-  char        toEscape;
-  const char* escapeSeq;
-  size_t      escapeSeqLen;
-};
-
-#define CHAR_ESCAPE_SEQ(ch, str)                                               \
-  {                                                                            \
-    .toEscape = ch, .escapeSeq = str, .escapeSeqLen = sizeof(str) - 1          \
-  }
-
-static constexpr CharEscapeSeq ESCAPED_CHARS[] = {
-    CHAR_ESCAPE_SEQ('<', "&lt;"), CHAR_ESCAPE_SEQ('>', "&gt;"),
-    CHAR_ESCAPE_SEQ('&', "&amp;")};
-
-static bool needEscape(const char* content, size_t contentLen)
+template <size_t Length>
+static void appendLiteral(utils::TextBuffer& buffer, const char (&str)[Length])
 {
-  // For each character in string
-  for (size_t i = 0; i < contentLen; ++i)
-  {
-    // For each escape sequence
-    for (const CharEscapeSeq& escape : ESCAPED_CHARS)
-    {
-      // If character needs to be escaped
-      if (content[i] == escape.toEscape)
-      {
-        return true;
-      }
-    }
-  }
-  return false;
-}
-
-static size_t getEscapedLen(const char* content, size_t contentLen)
-{
-  size_t length = 0;
-  // For each character in string
-  for (size_t i = 0; i < contentLen; ++i)
-  {
-    bool isEscaped = false;
-    // For each escape sequence
-    for (const CharEscapeSeq& escape : ESCAPED_CHARS)
-    {
-      // If character needs to be escaped
-      if (content[i] == escape.toEscape)
-      {
-        // Add escape sequence length to result
-        length += escape.escapeSeqLen;
-        isEscaped = true;
-        break;
-      }
-    }
-    // If character is not escaped
-    if (!isEscaped)
-    {
-      // Increase result by 1
-      length += 1;
-    }
-  }
-  return length;
-}
-
-static void getEscapedString(char* result, const char* original,
-                             size_t originalLen)
-{
-  char* resultTail = result;
-  // For each original character
-  for (size_t i = 0; i < originalLen; ++i)
-  {
-    bool isEscaped = false;
-    // For each escape sequence
-    for (const CharEscapeSeq& escape : ESCAPED_CHARS)
-    {
-      // If character needs to be escaped
-      if (original[i] == escape.toEscape)
-      {
-        // Append escape sequence to to result
-        memcpy(resultTail, escape.escapeSeq, escape.escapeSeqLen);
-        resultTail += escape.escapeSeqLen;
-        isEscaped = true;
-        break;
-      }
-    }
-    // If character is not escaped
-    if (!isEscaped)
-    {
-      // Append original character to result
-      *resultTail = original[i];
-      resultTail += 1;
-    }
-  }
+  buffer.append(str, Length - 1);
 }
 
 static const char* getSeverityString(LogMessage::Severity severity)
@@ -147,85 +66,212 @@ static const char* getSeverityString(LogMessage::Severity severity)
   }
 }
 
-static const char* getTimeString(time_t timestamp)
+static const char* getPartString(LogMessage::Part part)
 {
-  constexpr size_t      MAX_TIME_STR_LEN = 32;
-  constexpr const char* TIME_STR_FORMAT  = "%F %T%z";
+  using Part = LogMessage::Part;
 
-  static char s_timeStr[MAX_TIME_STR_LEN + 1] = "";
-
-  struct tm* time = localtime(&timestamp);
+  switch (part)
+  {
+  case Part::BEGIN:
+    return "begin";
+  case Part::CONTINUE:
+    return "continued";
+  case Part::END:
+    return "end";
+  case Part::WHOLE:
+  default:
+    return "";
+  }
+}
 
-  strftime(s_timeStr, MAX_TIME_STR_LEN, TIME_STR_FORMAT, time);
+/**
+ * @brief Escape text like `utils::HtmlEscaper`, without vector code which
+ * may not have been selected yet
+ */
+static void appendEscapedSignalSafe(utils::SignalSafeWriter& output,
+                                    const char* text, size_t length,
+                                    bool escapeQuotes)
+{
+  const char* plainStart = text;
+  for (const char* cur = text; cur < text + length; ++cur)
+  {
+    const char* entity = nullptr;
+    switch (*cur)
+    {
+    case '<': entity = "&lt;"; break;
+    case '>': entity = "&gt;"; break;
+    case '&': entity = "&amp;"; break;
+    case '"': entity = escapeQuotes ? "&quot;" : nullptr; break;
+    default:  break;
+    }
 
-  return s_timeStr;
+    if (entity != nullptr)
+    {
+      output.append(plainStart, (size_t)(cur - plainStart));
+      output.append(entity);
+      plainStart = cur + 1;
+    }
+  }
+  output.append(plainStart, (size_t)(text + length - plainStart));
 }
 
 LogWriter::Status HtmlLogWriter::writeMessage(const LogMessage& message)
+{
+  time_t   seconds     = 0;
+  uint32_t nanoseconds = 0;
+  utils::LogClock::toRealtime(message.timestamp, &seconds, &nanoseconds);
+
+  writeRecord(message, seconds, nanoseconds);
+  return Status::OK;
+}
+
+LogWriter::Status HtmlLogWriter::writeMessageAt(const LogMessage& message,
+                                                time_t             seconds,
+                                                uint32_t nanoseconds)
+{
+  if (!canAcceptContentType(message.contentType))
+  {
+    return Status::CONTENT_TYPE_NOT_ALLOWED;
+  }
+
+  writeRecord(message, seconds, nanoseconds);
+  return Status::OK;
+}
+
+void HtmlLogWriter::writeRecord(const LogMessage& message, time_t seconds,
+                                uint32_t nanoseconds)
 {
   // Check file descriptor validity
-  assert(isValid && "Attempted write to invalid log file");
+  assert(sink.isOpen() && "Attempted write to invalid log file");
   // Check content type
   assert(message.contentType == LogMessage::ContentType::TEXT ||
          message.contentType == LogMessage::ContentType::CODE ||
          message.contentType == LogMessage::ContentType::IMAGE);
 
-  const char* timestamp = getTimeString(message.timestamp);
-  const char* severity  = getSeverityString(message.severity);
+  utils::TextBuffer& record = sink.beginRecord();
+  sink.indexMessage(message,
+                    (uint64_t)seconds * utils::LogClock::NS_PER_SECOND +
+                        nanoseconds);
+
+  char timestamp[utils::TimestampFormatter::TIMESTAMP_LEN_MAX + 1] = "";
+  utils::TimestampFormatter::format(timestamp, seconds, nanoseconds, timePrecision);
+
+  const char* severity = getSeverityString(message.severity);
   // Write message header
-  dprintf(logFd,
-          "<p class=\"message\">"                 // Message start
-          "<span class=\"timestamp\">%s</span>"   // Timestamp
-          "<span class=\"severity %s\">%s</span>" // Severity
-          "<span class=\"source\">'%s' in '%s' at '%s:%zu'</span>", // Source
-          timestamp, severity, severity, message.source.logger,
-          message.source.function, message.source.file, message.source.line);
+  record.appendf(
+      "<p class=\"message\">"                 // Message start
+      "<span class=\"timestamp\">%s</span>"   // Timestamp
+      "<span class=\"severity %s\">%s</span>" // Severity
+      "<span class=\"source\">'%s' in '%s' at '%s:%zu'</span>", // Source
+      timestamp, severity, severity, message.source.logger,
+      message.source.function, message.source.file, message.source.line);
+
+  // Mark parts of long message
+  if (message.part != LogMessage::Part::WHOLE)
+  {
+    record.appendf("<span class=\"part %s\">#%" PRIu32 "</span>",
+                   getPartString(message.part), message.longMessageId);
+  }
+
+  const size_t contentLen = strnlen(message.content, message.contentLen);
 
   // If message content is image
   if (message.contentType == MessageContentType::IMAGE)
   {
     // Enclose content in <img\> tag
-    dprintf(logFd, "<img src=\"%.*s\"/>", (int)message.contentLen,
-            message.content);
+    appendLiteral(record, "<img src=\"");
+    utils::HtmlEscaper::append(record, message.content, contentLen, true);
+    appendLiteral(record, "\"/>");
+  }
+  // If message content is code
+  else if (message.contentType == MessageContentType::CODE)
+  {
+    // Write content in <code> tag
+    appendLiteral(record, "<code\n>");
+    utils::HtmlEscaper::append(record, message.content, contentLen);
+    appendLiteral(record, "</code>");
   }
   else
   {
-    const char* content          = message.content;
-    size_t      contentLen       = message.contentLen;
-    bool        isContentEscaped = needEscape(content, contentLen);
+    // Write content in <span class="text"> tag
+    appendLiteral(record, "<span class=\"text\">");
+    utils::HtmlEscaper::append(record, message.content, contentLen);
+    appendLiteral(record, "</span>");
+  }
 
-    // If message content must be escaped
-    if (isContentEscaped)
-    {
-      // Generate escaped content
-      size_t escapedLen     = getEscapedLen(content, contentLen);
-      char*  escapedContent = new char[escapedLen];
-      getEscapedString(escapedContent, content, contentLen);
-      // Replace original content with escaped
-      content    = escapedContent;
-      contentLen = escapedLen;
-    }
+  // Close message tag
+  appendLiteral(record, "</p>\n");
+  sink.endRecord(message.severity);
+}
 
-    // If message content is code
-    if (message.contentType == MessageContentType::CODE)
-    {
-      // Write content in <code> tag
-      dprintf(logFd, "<code\n>%.*s</code>", (int)contentLen, content);
-    }
-    else
-    {
-      // Write content in <span class="text"> tag
-      dprintf(logFd, "<span class=\"text\">%.*s</span>", (int)contentLen,
-              content);
-    }
+void HtmlLogWriter::writeMessageSignalSafe(const LogMessage& message,
+                                           char* buffer, size_t bufferSize)
+{
+  if (!sink.isOpen())
+  {
+    return;
+  }
+
+  // Same layout as `writeMessage()`, rendered without C library
+  const char* severity = getSeverityString(message.severity);
+
+  // File written at offsets or compressed gets the record from sink whole
+  const int fd = sink.needsWholeRecords() ? -1 : sink.getFd();
+  utils::SignalSafeWriter output(buffer, bufferSize, fd);
+  output.append("<p class=\"message\"><span class=\"timestamp\">");
+  output.appendTimestamp(message.timestamp, timePrecision);
+  output.append("</span><span class=\"severity ");
+  output.append(severity);
+  output.append("\">");
+  output.append(severity);
+  output.append("</span><span class=\"source\">'");
+  output.append(message.source.logger);
+  output.append("' in '");
+  output.append(message.source.function);
+  output.append("' at '");
+  output.append(message.source.file);
+  output.append(':');
+  output.appendUnsigned(message.source.line);
+  output.append("'</span>");
 
-    if (isContentEscaped)
-      delete[] content;
+  if (message.part != LogMessage::Part::WHOLE)
+  {
+    output.append("<span class=\"part ");
+    output.append(getPartString(message.part));
+    output.append("\">#");
+    output.appendUnsigned(message.longMessageId);
+    output.append("</span>");
   }
 
-  // Close message tag
-  dprintf(logFd, "</p>\n");
-  return LogWriter::Status::OK;
+  const size_t contentLen = strnlen(message.content, message.contentLen);
+  if (message.contentType == MessageContentType::IMAGE)
+  {
+    output.append("<img src=\"");
+    appendEscapedSignalSafe(output, message.content, contentLen, true);
+    output.append("\"/>");
+  }
+  else if (message.contentType == MessageContentType::CODE)
+  {
+    output.append("<code\n>");
+    appendEscapedSignalSafe(output, message.content, contentLen, false);
+    output.append("</code>");
+  }
+  else
+  {
+    output.append("<span class=\"text\">");
+    appendEscapedSignalSafe(output, message.content, contentLen, false);
+    output.append("</span>");
+  }
+
+  output.append("</p>\n");
+  if (fd < 0)
+  {
+    sink.writeSignalSafe(output.data(), output.length());
+  }
+  else
+  {
+    output.flush();
+  }
 }
 
 } // namespace mklog
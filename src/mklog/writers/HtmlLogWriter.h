@@ -14,6 +14,8 @@
 
 #include "mklog/LogMessage.h"
 #include "mklog/LogWriter.h"
+#include "mklog/utils/TimestampFormatter.h"
+#include "mklog/writers/BufferedFileSink.h"
 
 namespace mklog
 {
@@ -37,25 +39,104 @@ namespace mklog
 class HtmlLogWriter : public LogWriter
 {
 private:
-  int  logFd;
-  bool isValid;
+  BufferedFileSink sink;
+
+  utils::TimestampFormatter::Precision timePrecision;
 
 protected:
   bool canAcceptContentType(LogMessage::ContentType contentType) const override
   {
-    return isValid && (contentType == LogMessage::ContentType::TEXT ||
-                       contentType == LogMessage::ContentType::CODE ||
-                       contentType == LogMessage::ContentType::IMAGE);
+    return sink.isOpen() && (contentType == LogMessage::ContentType::TEXT ||
+                             contentType == LogMessage::ContentType::CODE ||
+                             contentType == LogMessage::ContentType::IMAGE);
   }
 
   Status writeMessage(const LogMessage& message) override;
 
+  /**
+   * @brief Write record of message with given wall-clock time
+   */
+  void writeRecord(const LogMessage& message, time_t seconds,
+                   uint32_t nanoseconds);
+
+  void writeMessageSignalSafe(const LogMessage& message, char* buffer,
+                              size_t bufferSize) override;
+
 public:
-  HtmlLogWriter() : LogWriter(), logFd(-1), isValid(false) {}
+  HtmlLogWriter()
+      : LogWriter(),
+        sink(),
+        timePrecision(utils::TimestampFormatter::Precision::MICROSECONDS)
+  {
+  }
+
+  ~HtmlLogWriter() override;
+
+  /**
+   * @brief Open log file
+   *
+   * @param[in] filename  Log file name
+   * @param[in] mode      How records are written, see
+   *                      `BufferedFileSink::OutputMode`
+   */
+  HtmlLogWriter& setFile(
+      const char*                  filename,
+      BufferedFileSink::OutputMode mode = BufferedFileSink::OutputMode::WRITE);
+
+  HtmlLogWriter& setFlushPolicy(const BufferedFileSink::FlushPolicy& policy)
+  {
+    sink.setFlushPolicy(policy);
+    return *this;
+  }
+
+  /**
+   * @brief Compress log file in blocks, see
+   * `BufferedFileSink::CompressionPolicy`. Must be called before
+   * `setFile()`
+   */
+  HtmlLogWriter& setCompressionPolicy(
+      const BufferedFileSink::CompressionPolicy& policy)
+  {
+    sink.setCompressionPolicy(policy);
+    return *this;
+  }
+
+  /**
+   * @brief Rotate log file by size or wall-clock interval, see
+   * `BufferedFileSink::RotationPolicy`. Each
+   * rotated segment is complete HTML document
+   */
+  HtmlLogWriter& setRotationPolicy(const BufferedFileSink::RotationPolicy& policy)
+  {
+    sink.setRotationPolicy(policy);
+    return *this;
+  }
+
+  /**
+   * @brief Set number of fraction digits in message timestamps
+   */
+  HtmlLogWriter& setTimePrecision(utils::TimestampFormatter::Precision precision)
+  {
+    timePrecision = precision;
+    return *this;
+  }
+
+  /**
+   * @brief Write message whose wall-clock time is already known, e.g. one
+   * decoded from binary log. Routing rules are not applied
+   *
+   * @param[in] message       Message, its timestamp is ignored
+   * @param[in] seconds       Message wall-clock time
+   * @param[in] nanoseconds   Nanoseconds since start of second
+   */
+  Status writeMessageAt(const LogMessage& message, time_t seconds,
+                        uint32_t nanoseconds);
+
+  void flush() override { sink.flush(); }
 
-  HtmlLogWriter& setFile(const char* filename);
+  void flushSignalSafe() override { sink.flushSignalSafe(); }
 
-  bool valid() { return isValid; }
+  bool valid() { return sink.isOpen(); }
 };
 
 } // namespace mklog
@@ -0,0 +1,45 @@
+#include "mklog/writers/MappedRingLogWriter.h"
+
+#include "mklog/utils/LogClock.h"
+
+namespace mklog
+{
+
+MappedRingLogWriter& MappedRingLogWriter::setFile(const char* filename,
+                                                  size_t      capacity)
+{
+  if (ring.open(filename, capacity))
+  {
+    notifyConfigChanged();
+  }
+
+  return *this;
+}
+
+LogWriter::Status MappedRingLogWriter::writeMessage(const LogMessage& message)
+{
+  time_t   seconds     = 0;
+  uint32_t nanoseconds = 0;
+  utils::LogClock::toRealtime(message.timestamp, &seconds, &nanoseconds);
+
+  ring.append(message, seconds, nanoseconds);
+  return Status::OK;
+}
+
+void MappedRingLogWriter::writeMessageSignalSafe(const LogMessage& message,
+                                                 char* buffer,
+                                                 size_t bufferSize)
+{
+  // Records are copied to ring directly
+  (void)buffer;
+  (void)bufferSize;
+
+  time_t   seconds     = 0;
+  uint32_t nanoseconds = 0;
+  utils::LogClock::toRealtimeSignalSafe(message.timestamp, &seconds,
+                                        &nanoseconds);
+
+  ring.append(message, seconds, nanoseconds);
+}
+
+} // namespace mklog
@@ -0,0 +1,65 @@
+/**
+ * @file MappedRingLogWriter.h
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Writer keeping recent messages in crash-persistent ring file
+ *
+ * @version 0.1
+ * @date 2023-09-15
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#ifndef __MEERKAT_LOGS_WRITERS_MAPPEDRINGLOGWRITER_H
+#define __MEERKAT_LOGS_WRITERS_MAPPEDRINGLOGWRITER_H
+
+#include "mklog/LogMessage.h"
+#include "mklog/LogWriter.h"
+#include "mklog/utils/MappedRing.h"
+
+namespace mklog
+{
+
+/**
+ * @brief Keeps the most recent messages in `utils::MappedRing` file.
+ * Messages reach page cache as soon as they are written, so they are not
+ * lost when process is killed with `SIGKILL` or by OOM killer. Records are
+ * restored with `utils::MappedRingReader`, e.g. by `RingRecover` tool or by
+ * application on next start, before ring is opened for writing.
+ */
+class MappedRingLogWriter : public LogWriter
+{
+private:
+  utils::MappedRing ring;
+
+protected:
+  bool canAcceptContentType(LogMessage::ContentType contentType) const override
+  {
+    // Content is stored as is
+    (void)contentType;
+    return ring.isOpen();
+  }
+
+  Status writeMessage(const LogMessage& message) override;
+
+  void writeMessageSignalSafe(const LogMessage& message, char* buffer,
+                              size_t bufferSize) override;
+
+public:
+  MappedRingLogWriter() : LogWriter(), ring() {}
+
+  /**
+   * @brief Open ring file. Records left in existing ring are kept
+   *
+   * @param[in] filename  Ring file name
+   * @param[in] capacity  Ring size in bytes, if ring is created
+   */
+  MappedRingLogWriter&
+  setFile(const char* filename,
+          size_t      capacity = utils::MappedRing::CAPACITY_DEFAULT);
+
+  bool valid() { return ring.isOpen(); }
+};
+
+} // namespace mklog
+
+#endif /* MappedRingLogWriter.h */
@@ -1,9 +1,12 @@
 #include "mklog/writers/StderrLogWriter.h"
 
 #include <cstdio>
+#include <cstring>
+#include <unistd.h>
 
 #include "mklog/LogMessage.h"
 #include "mklog/LogWriter.h"
+#include "mklog/utils/SignalSafeWriter.h"
 
 namespace mklog
 {
@@ -109,4 +112,29 @@ LogWriter::Status StderrLogWriter::writeMessage(const LogMessage& message)
   return LogWriter::Status::OK;
 }
 
+void StderrLogWriter::writeMessageSignalSafe(const LogMessage& message,
+                                             char* buffer, size_t bufferSize)
+{
+  utils::SignalSafeWriter output(buffer, bufferSize, STDERR_FILENO);
+  if (useEscapeCodes)
+  {
+    output.append(EscapeCodes::SET_FG);
+    output.append(getSeverityColorCode(message.severity));
+    output.append('[');
+    output.append(getSeverityString(message.severity));
+    output.append(']');
+    output.append(EscapeCodes::CLEAR);
+  }
+  else
+  {
+    output.append('[');
+    output.append(getSeverityString(message.severity));
+    output.append(']');
+  }
+  output.append(' ');
+  output.append(message.content, strnlen(message.content, message.contentLen));
+  output.append('\n');
+  output.flush();
+}
+
 } // namespace mklog
@@ -35,6 +35,9 @@ protected:
 
   Status writeMessage(const LogMessage& message) override;
 
+  void writeMessageSignalSafe(const LogMessage& message, char* buffer,
+                              size_t bufferSize) override;
+
 public:
   StderrLogWriter(bool useEscapeCodes = false)
       : LogWriter(), useEscapeCodes(useEscapeCodes)
@@ -1,26 +1,27 @@
 #include "mklog/writers/TextLogWriter.h"
 
 #include <cassert>
+#include <cinttypes>
 #include <cstdio>
-#include <ctime>
-#include <fcntl.h>
-#include <unistd.h>
+#include <cstring>
 
 #include "mklog/LogWriter.h"
+#include "mklog/utils/LogClock.h"
+#include "mklog/utils/SignalSafeWriter.h"
+#include "mklog/utils/TimestampFormatter.h"
 
 namespace mklog
 {
 
-TextLogWriter& TextLogWriter::setFile(const char* filename)
-{
-  assert(!isValid && "Cannot reset log file");
-
-  int fd = open(filename, O_CREAT | O_APPEND | O_WRONLY, S_IRUSR | S_IWUSR);
+// Sink destructor is large, keep it out of every caller
+TextLogWriter::~TextLogWriter() = default;
 
-  if (fd >= 0)
+TextLogWriter& TextLogWriter::setFile(const char*                  filename,
+                                      BufferedFileSink::OutputMode mode)
+{
+  if (sink.open(filename, mode))
   {
-    logFd   = fd;
-    isValid = true;
+    notifyConfigChanged();
   }
 
   return *this;
@@ -42,30 +43,150 @@ static const char* getSeverityString(LogMessage::Severity severity)
   }
 }
 
-static const char* getTimeString(time_t timestamp)
+static const char* getPartString(LogMessage::Part part)
 {
-  constexpr size_t      MAX_TIME_STR_LEN = 32;
-  constexpr const char* TIME_STR_FORMAT  = "%F %T%z";
+  using Part = LogMessage::Part;
+
+  switch (part)
+  {
+  case Part::BEGIN:    return "begin";
+  case Part::CONTINUE: return "continued";
+  case Part::END:      return "end";
+  case Part::WHOLE:
+  default:             return "";
+  }
+}
+
+utils::TextBuffer& TextLogWriter::beginRecord(const LogMessage& message,
+                                              time_t             seconds,
+                                              uint32_t           nanoseconds)
+{
+  assert(sink.isOpen() && "Attempted write to invalid file");
+
+  utils::TextBuffer& record = sink.beginRecord();
+  sink.indexMessage(message,
+                    (uint64_t)seconds * utils::LogClock::NS_PER_SECOND +
+                        nanoseconds);
+
+  char time[utils::TimestampFormatter::TIMESTAMP_LEN_MAX + 1] = "";
+  utils::TimestampFormatter::format(time, seconds, nanoseconds, timePrecision);
 
-  static char s_timeStr[MAX_TIME_STR_LEN + 1] = "";
+  const char* severity = getSeverityString(message.severity);
+  record.appendf("<%s> [%s] '%s' in '%s' at '%s:%zu'", time, severity,
+                 message.source.logger, message.source.function,
+                 message.source.file, message.source.line);
+
+  // Mark parts of long message, so that they can be matched if other
+  // messages are written between them
+  if (message.part != LogMessage::Part::WHOLE)
+  {
+    record.appendf(" [#%" PRIu32 " %s]", message.longMessageId,
+                   getPartString(message.part));
+  }
+  record.append(":\n\t", 3);
 
-  struct tm* time = localtime(&timestamp);
+  return record;
+}
 
-  strftime(s_timeStr, MAX_TIME_STR_LEN, TIME_STR_FORMAT, time);
+void TextLogWriter::writeRecord(const LogMessage& message, time_t seconds,
+                                uint32_t nanoseconds)
+{
+  utils::TextBuffer& record = beginRecord(message, seconds, nanoseconds);
 
-  return s_timeStr;
+  sink.appendContent(message.content,
+                     strnlen(message.content, message.contentLen));
+  record.append('\n');
+
+  sink.endRecord(message.severity);
 }
 
 LogWriter::Status TextLogWriter::writeMessage(const LogMessage& message)
 {
-  assert(isValid && "Attempted write to invalid file");
+  time_t   seconds     = 0;
+  uint32_t nanoseconds = 0;
+  utils::LogClock::toRealtime(message.timestamp, &seconds, &nanoseconds);
 
-  const char* time     = getTimeString(message.timestamp);
-  const char* severity = getSeverityString(message.severity);
-  dprintf(logFd, "<%s> [%s] '%s' in '%s' at '%s:%zu':\n\t%.*s\n", time, severity,
-          message.source.logger, message.source.function, message.source.file,
-          message.source.line, (int)message.contentLen, message.content);
+  writeRecord(message, seconds, nanoseconds);
   return Status::OK;
 }
 
+LogWriter::Status TextLogWriter::writeMessageAt(const LogMessage& message,
+                                                time_t             seconds,
+                                                uint32_t nanoseconds)
+{
+  if (!canAcceptContentType(message.contentType))
+  {
+    return Status::CONTENT_TYPE_NOT_ALLOWED;
+  }
+
+  writeRecord(message, seconds, nanoseconds);
+  return Status::OK;
+}
+
+LogWriter::Status TextLogWriter::spliceMessage(const LogMessage&   message,
+                                               const PipedContent& piped)
+{
+  time_t   seconds     = 0;
+  uint32_t nanoseconds = 0;
+  utils::LogClock::toRealtime(message.timestamp, &seconds, &nanoseconds);
+  utils::TextBuffer& record = beginRecord(message, seconds, nanoseconds);
+
+  // Only header and content preceding pipe are copied
+  sink.appendContent(message.content,
+                     strnlen(message.content, message.contentLen));
+  sink.appendPipedContent(piped.fd, piped.length, piped.consume);
+  record.append('\n');
+
+  sink.endRecord(message.severity);
+  return Status::OK;
+}
+
+void TextLogWriter::writeMessageSignalSafe(const LogMessage& message,
+                                           char* buffer, size_t bufferSize)
+{
+  if (!sink.isOpen())
+  {
+    return;
+  }
+
+  // Same layout as `beginRecord()`, rendered without C library. File
+  // written at offsets or compressed gets the record from sink whole
+  const int fd = sink.needsWholeRecords() ? -1 : sink.getFd();
+  utils::SignalSafeWriter output(buffer, bufferSize, fd);
+  output.append('<');
+  output.appendTimestamp(message.timestamp, timePrecision);
+  output.append("> [");
+  output.append(getSeverityString(message.severity));
+  output.append("] '");
+  output.append(message.source.logger);
+  output.append("' in '");
+  output.append(message.source.function);
+  output.append("' at '");
+  output.append(message.source.file);
+  output.append(':');
+  output.appendUnsigned(message.source.line);
+  output.append('\'');
+
+  if (message.part != LogMessage::Part::WHOLE)
+  {
+    output.append(" [#");
+    output.appendUnsigned(message.longMessageId);
+    output.append(' ');
+    output.append(getPartString(message.part));
+    output.append(']');
+  }
+  output.append(":\n\t");
+
+  output.append(message.content, strnlen(message.content, message.contentLen));
+  output.append('\n');
+  if (fd < 0)
+  {
+    sink.writeSignalSafe(output.data(), output.length());
+  }
+  else
+  {
+    output.flush();
+  }
+}
+
 } // namespace mklog
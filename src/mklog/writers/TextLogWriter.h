@@ -16,6 +16,8 @@
 #include <fcntl.h>
 
 #include "mklog/LogWriter.h"
+#include "mklog/utils/TimestampFormatter.h"
+#include "mklog/writers/BufferedFileSink.h"
 
 namespace mklog
 {
@@ -26,23 +28,140 @@ namespace mklog
 class TextLogWriter : public LogWriter
 {
 private:
-  int  logFd;
-  bool isValid;
+  BufferedFileSink sink;
+
+  utils::TimestampFormatter::Precision timePrecision;
+
+  /**
+   * @brief Start record with message header
+   *
+   * @param[in] message       Message
+   * @param[in] seconds       Message wall-clock time
+   * @param[in] nanoseconds   Nanoseconds since start of second
+   */
+  utils::TextBuffer& beginRecord(const LogMessage& message, time_t seconds,
+                                 uint32_t nanoseconds);
+
+  /**
+   * @brief Write record of message with given wall-clock time
+   */
+  void writeRecord(const LogMessage& message, time_t seconds,
+                   uint32_t nanoseconds);
 
 protected:
   bool canAcceptContentType(LogMessage::ContentType contentType) const override
   {
-    return isValid && contentType == LogMessage::ContentType::TEXT;
+    return sink.isOpen() && contentType == LogMessage::ContentType::TEXT;
   }
 
   Status writeMessage(const LogMessage& message) override;
 
+  bool canSpliceContent() const override { return sink.canSplice(); }
+
+  Status spliceMessage(const LogMessage&   message,
+                       const PipedContent& piped) override;
+
+  void writeMessageSignalSafe(const LogMessage& message, char* buffer,
+                              size_t bufferSize) override;
+
 public:
-  TextLogWriter() : LogWriter(), logFd(-1), isValid(false) {}
+  TextLogWriter()
+      : LogWriter(),
+        sink(),
+        timePrecision(utils::TimestampFormatter::Precision::MICROSECONDS)
+  {
+  }
+
+  ~TextLogWriter() override;
+
+  /**
+   * @brief Open log file
+   *
+   * @param[in] filename  Log file name
+   * @param[in] mode      How records are written, see
+   *                      `BufferedFileSink::OutputMode`
+   */
+  TextLogWriter& setFile(
+      const char*                  filename,
+      BufferedFileSink::OutputMode mode = BufferedFileSink::OutputMode::WRITE);
+
+  TextLogWriter& setFlushPolicy(const BufferedFileSink::FlushPolicy& policy)
+  {
+    sink.setFlushPolicy(policy);
+    return *this;
+  }
+
+  /**
+   * @brief Compress log file in blocks, see
+   * `BufferedFileSink::CompressionPolicy`. Must be called before
+   * `setFile()`
+   */
+  TextLogWriter& setCompressionPolicy(
+      const BufferedFileSink::CompressionPolicy& policy)
+  {
+    sink.setCompressionPolicy(policy);
+    return *this;
+  }
+
+  /**
+   * @brief Write sparse index next to log file for `LogQuery` tool, see
+   * `BufferedFileSink::IndexPolicy`. Must be called before `setFile()`
+   */
+  TextLogWriter& setIndexPolicy(const BufferedFileSink::IndexPolicy& policy)
+  {
+    sink.setIndexPolicy(policy);
+    return *this;
+  }
+
+  /**
+   * @brief Rotate log file by size or wall-clock interval, see
+   * `BufferedFileSink::RotationPolicy`
+   */
+  TextLogWriter& setRotationPolicy(const BufferedFileSink::RotationPolicy& policy)
+  {
+    sink.setRotationPolicy(policy);
+    return *this;
+  }
+
+  /**
+   * @brief Move content of long messages written to
+   * `LogManager::beginLongMessage()` descriptors from pipe to log file with
+   * `splice()` instead of copying it through memory. Content is not
+   * inspected, so such messages are split into parts where writes to pipe
+   * end rather than after full lines. Log file is written without
+   * `O_APPEND` then and must not be shared with other processes
+   */
+  TextLogWriter& setSpliceEnabled(bool isEnabled)
+  {
+    sink.setSpliceEnabled(isEnabled);
+    return *this;
+  }
+
+  /**
+   * @brief Set number of fraction digits in message timestamps
+   */
+  TextLogWriter& setTimePrecision(utils::TimestampFormatter::Precision precision)
+  {
+    timePrecision = precision;
+    return *this;
+  }
+
+  /**
+   * @brief Write message whose wall-clock time is already known, e.g. one
+   * decoded from binary log. Routing rules are not applied
+   *
+   * @param[in] message       Message, its timestamp is ignored
+   * @param[in] seconds       Message wall-clock time
+   * @param[in] nanoseconds   Nanoseconds since start of second
+   */
+  Status writeMessageAt(const LogMessage& message, time_t seconds,
+                        uint32_t nanoseconds);
+
+  void flush() override { sink.flush(); }
 
-  TextLogWriter& setFile(const char* filename);
+  void flushSignalSafe() override { sink.flushSignalSafe(); }
 
-  bool valid() { return isValid; }
+  bool valid() { return sink.isOpen(); }
 };
 
 } // namespace mklog
@@ -0,0 +1,100 @@
+/**
+ * @file AcceptMaskTest.cpp
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Tests of skipping messages which no writer accepts
+ *
+ * @version 0.1
+ * @date 2023-09-22
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#include <cstring>
+
+#include "TestRunner.h"
+#include "TestUtils.h"
+#include "mklog/LogManager.h"
+#include "mklog/LogRoute.h"
+#include "mklog/LogRoutingRule.h"
+#include "mklog/Logger.h"
+#include "mklog/writers/TextLogWriter.h"
+
+using mklog::LogManager;
+using mklog::Logger;
+using mklog::MessageContentType;
+using mklog::MessageSeverity;
+
+static int s_evaluatedCount = 0;
+
+static int countEvaluation(int value)
+{
+  ++s_evaluatedCount;
+  return value;
+}
+
+static void setupWarningLog()
+{
+  LogManager::addWriter<mklog::TextLogWriter>()
+      .setFile("log.txt")
+      .setRoute(mklog::LogRoute::makeRoute<mklog::SeverityRoutingRule>(
+          MessageSeverity::WARNING));
+  LogManager::initLogs();
+}
+
+TEST_CASE(acceptMaskSkipsArgumentsOfRejectedMessages)
+{
+  test_assert(!LogManager::isMessageAccepted(MessageSeverity::FATAL,
+                                             MessageContentType::TEXT));
+  setupWarningLog();
+
+  test_assert(!LogManager::isMessageAccepted(MessageSeverity::INFO,
+                                             MessageContentType::TEXT));
+  test_assert(LogManager::isMessageAccepted(MessageSeverity::WARNING,
+                                            MessageContentType::TEXT));
+  test_assert(!LogManager::isMessageAccepted(MessageSeverity::ERROR,
+                                             MessageContentType::IMAGE));
+
+  Logger logger("mask");
+  logger.LOG_INFO(MessageContentType::TEXT, "info %d", countEvaluation(1));
+  logger.LOG_ERROR(MessageContentType::IMAGE, "image %d",
+                   countEvaluation(2));
+  test_assert(s_evaluatedCount == 0);
+
+  logger.LOG_WARNING(MessageContentType::TEXT, "warning %d",
+                     countEvaluation(3));
+  test_assert(s_evaluatedCount == 1);
+  LogManager::flushMessages();
+
+  std::string log;
+  test_assert(mklog::test::readFile("log.txt", log));
+  test_assert(strstr(log.data(), "\twarning 3\n") != nullptr);
+  test_assert(strstr(log.data(), "info") == nullptr);
+}
+
+TEST_CASE(acceptMaskSkipsRejectedLongMessages)
+{
+  setupWarningLog();
+
+  Logger logger("mask");
+
+  LogManager::MessageFd fd = logger.LOG_BEGIN_DEBUG(
+      MessageContentType::TEXT, "long %d", countEvaluation(1));
+  test_assert(fd == LogManager::MESSAGE_FD_INVALID);
+
+  mklog::LongMessage message = logger.LOG_LONG_INFO(
+      MessageContentType::TEXT, "long %d", countEvaluation(2));
+  test_assert(!message.isOpen());
+  test_assert(s_evaluatedCount == 0);
+
+  fd = logger.LOG_BEGIN_ERROR(MessageContentType::TEXT, "long %d",
+                              countEvaluation(3));
+  test_assert(fd != LogManager::MESSAGE_FD_INVALID);
+  test_assert(s_evaluatedCount == 1);
+  dprintf(fd, "accepted content\n");
+  logger.endLongMessage(fd);
+  LogManager::flushMessages();
+
+  std::string log;
+  test_assert(mklog::test::readFile("log.txt", log));
+  test_assert(strstr(log.data(), "\tlong 3\naccepted content\n") != nullptr);
+}
@@ -0,0 +1,127 @@
+/**
+ * @file AsyncDispatchTest.cpp
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Tests of messages dispatched by background thread
+ *
+ * @version 0.1
+ * @date 2023-09-22
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#include "TestRunner.h"
+#include "TestUtils.h"
+#include "mklog/LogManager.h"
+#include "mklog/Logger.h"
+#include "mklog/writers/TextLogWriter.h"
+
+using mklog::LogManager;
+using mklog::Logger;
+using mklog::MessageContentType;
+
+static constexpr int THREAD_COUNT  = 4;
+static constexpr int MESSAGE_COUNT = 2000;
+
+/**
+ * @brief Check that log has every message of every thread exactly once, in
+ * order in which thread logged them
+ */
+static void checkThreadMessages(const char* log)
+{
+  int nextMessage[THREAD_COUNT] = {};
+
+  for (const char* found = strstr(log, "\tthread "); found != nullptr;
+       found             = strstr(found + 1, "\tthread "))
+  {
+    int thread  = 0;
+    int message = 0;
+    test_assert(sscanf(found, "\tthread %d message %d\n", &thread,
+                       &message) == 2);
+    test_assert(0 <= thread && thread < THREAD_COUNT);
+    test_assert(message == nextMessage[thread]);
+    ++nextMessage[thread];
+  }
+
+  for (int thread = 0; thread < THREAD_COUNT; ++thread)
+  {
+    test_assert(nextMessage[thread] == MESSAGE_COUNT);
+  }
+}
+
+TEST_CASE(asyncDispatchWritesAllMessagesInOrder)
+{
+  const int exitCode = mklog::test::runProcess([]() {
+    // Small queue makes producers wait for dispatcher
+    LogManager::useAsyncDispatch(64);
+    LogManager::addWriter<mklog::TextLogWriter>().setFile("log.txt");
+    LogManager::initLogs();
+
+    std::thread threads[THREAD_COUNT];
+    for (int thread = 0; thread < THREAD_COUNT; ++thread)
+    {
+      threads[thread] = std::thread([thread]() {
+        Logger logger("async");
+        for (int i = 0; i < MESSAGE_COUNT; ++i)
+        {
+          logger.LOG_INFO(MessageContentType::TEXT, "thread %d message %d",
+                          thread, i);
+        }
+      });
+    }
+    for (std::thread& thread : threads)
+    {
+      thread.join();
+    }
+  });
+  test_assert(exitCode == 0);
+
+  std::string log;
+  test_assert(mklog::test::readFile("log.txt", log));
+  checkThreadMessages(log.data());
+}
+
+TEST_CASE(asyncDispatchFlushesQueuedMessages)
+{
+  LogManager::useAsyncDispatch();
+  LogManager::addWriter<mklog::TextLogWriter>().setFile("log.txt");
+  LogManager::initLogs();
+
+  Logger logger("async");
+  logger.LOG_WARNING(MessageContentType::TEXT, "queued %s", "message");
+  LogManager::flushMessages();
+
+  std::string log;
+  test_assert(mklog::test::readFile("log.txt", log));
+  test_assert(strstr(log.data(), "[WARNING] 'async'") != nullptr);
+  test_assert(strstr(log.data(), "\tqueued message\n") != nullptr);
+}
+
+TEST_CASE(asyncDispatchWritesQueuedMessagesOnSignal)
+{
+  const int exitCode = mklog::test::runProcess([]() {
+    LogManager::useAsyncDispatch();
+    LogManager::addWriter<mklog::TextLogWriter>().setFile("log.txt");
+    LogManager::initLogs();
+
+    Logger logger("async");
+    for (int i = 0; i < MESSAGE_COUNT; ++i)
+    {
+      logger.LOG_INFO(MessageContentType::TEXT, "thread 0 message %d", i);
+    }
+
+    // Handler writes messages still in queue, then process is terminated
+    raise(SIGTERM);
+  });
+  test_assert(exitCode == 128 + SIGTERM);
+
+  std::string log;
+  test_assert(mklog::test::readFile("log.txt", log));
+  test_assert(mklog::test::countOccurrences(log.data(), "\tthread 0 ") >=
+              MESSAGE_COUNT);
+  test_assert(strstr(log.data(), "\tthread 0 message 1999\n") != nullptr);
+}
@@ -0,0 +1,151 @@
+/**
+ * @file BinaryLogTest.cpp
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Tests of binary logs decoded by `LogDecode` tool
+ *
+ * @version 0.1
+ * @date 2023-09-22
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#include <cstdio>
+#include <cstring>
+
+#include "TestRunner.h"
+#include "TestUtils.h"
+#include "mklog/LogManager.h"
+#include "mklog/Logger.h"
+#include "mklog/LongMessage.h"
+#include "mklog/writers/BinaryLogWriter.h"
+#include "mklog/writers/HtmlLogWriter.h"
+#include "mklog/writers/TextLogWriter.h"
+
+using mklog::BufferedFileSink;
+using mklog::LogManager;
+using mklog::Logger;
+using mklog::MessageContentType;
+
+static constexpr int MESSAGE_COUNT = 20000;
+
+/**
+ * @brief Log messages of different severities, loggers and lengths, with
+ * repeated and unique strings
+ */
+static void logMixedMessages()
+{
+  Logger first("first");
+  Logger second("second");
+  for (int i = 0; i < MESSAGE_COUNT; ++i)
+  {
+    if (i % 3 == 0)
+      first.LOG_INFO(MessageContentType::TEXT, "message %d", i);
+    else if (i % 3 == 1)
+      second.LOG_WARNING(MessageContentType::TEXT, "message %d <%s>", i,
+                         "same");
+    else
+      first.LOG_ERROR(MessageContentType::TEXT, "message %d", i);
+  }
+
+  mklog::LongMessage message =
+      second.LOG_LONG_DEBUG(MessageContentType::TEXT, "long");
+  for (int i = 0; i < 5000; ++i)
+  {
+    message.printf("line %06d\n", i);
+  }
+}
+
+/**
+ * @brief Check that two files have the same content
+ */
+static void checkSameContent(const char* expectedFile, const char* actualFile)
+{
+  std::string expected;
+  std::string actual;
+  test_assert(mklog::test::readFile(expectedFile, expected));
+  test_assert(mklog::test::readFile(actualFile, actual));
+
+  test_assert(expected.length() == actual.length());
+  test_assert(memcmp(expected.data(), actual.data(), expected.length()) == 0);
+}
+
+/**
+ * @brief Log messages to text, HTML and binary files, then check that
+ * decoded binary log matches text and HTML ones
+ */
+static void checkDecodedLog(bool isAsync, bool isCompressed)
+{
+  const int exitCode = mklog::test::runProcess([isAsync, isCompressed]() {
+    if (isAsync)
+    {
+      LogManager::useAsyncDispatch();
+      LogManager::useDeferredFormatting();
+    }
+    LogManager::addWriter<mklog::TextLogWriter>().setFile("log.txt");
+    LogManager::addWriter<mklog::HtmlLogWriter>().setFile("log.html");
+
+    mklog::BinaryLogWriter& writer =
+        LogManager::addWriter<mklog::BinaryLogWriter>();
+    if (isCompressed)
+    {
+      writer.setCompressionPolicy(
+          BufferedFileSink::COMPRESSION_POLICY_DEFAULT);
+    }
+    writer.setFile("log.bin");
+    LogManager::initLogs();
+
+    logMixedMessages();
+  });
+  test_assert(exitCode == 0);
+
+  test_assert(mklog::test::runTool("LogDecode log.bin text decoded.txt",
+                                   nullptr) == 0);
+  test_assert(mklog::test::runTool("LogDecode log.bin html decoded.html",
+                                   nullptr) == 0);
+  checkSameContent("log.txt", "decoded.txt");
+  checkSameContent("log.html", "decoded.html");
+}
+
+TEST_CASE(binaryLogDecodesToText)
+{
+  checkDecodedLog(false, false);
+}
+
+TEST_CASE(binaryLogDecodesToTextAsync)
+{
+  checkDecodedLog(true, false);
+}
+
+TEST_CASE(binaryLogDecodesCompressedBlocks)
+{
+  checkDecodedLog(false, true);
+}
+
+TEST_CASE(binaryLogDecodesAppendedSessions)
+{
+  for (int session = 0; session < 2; ++session)
+  {
+    const int exitCode = mklog::test::runProcess([session]() {
+      LogManager::addWriter<mklog::BinaryLogWriter>().setFile("log.bin");
+      LogManager::initLogs();
+
+      // Strings are defined again in each session
+      Logger logger("session");
+      logger.LOG_INFO(MessageContentType::TEXT, "session %d", session);
+      logger.LOG_INFO(MessageContentType::TEXT, "session %d", session);
+    });
+    test_assert(exitCode == 0);
+  }
+
+  std::string output;
+  test_assert(mklog::test::runTool("LogDecode log.bin text", &output) == 0);
+  test_assert(mklog::test::countOccurrences(output.data(),
+                                            "'session' in ") == 4);
+
+  const char* first  = strstr(output.data(), "\tsession 0\n");
+  const char* second = strstr(output.data(), "\tsession 1\n");
+  test_assert(first != nullptr && second != nullptr && first < second);
+
+  test_assert(mklog::test::runTool("LogDecode missing.bin text 2>/dev/null",
+                                   nullptr) != 0);
+}
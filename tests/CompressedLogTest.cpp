@@ -0,0 +1,170 @@
+/**
+ * @file CompressedLogTest.cpp
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Tests of block-compressed logs unpacked by `LogUnpack` tool
+ *
+ * @version 0.1
+ * @date 2023-09-22
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#include "TestRunner.h"
+#include "TestUtils.h"
+#include "mklog/LogManager.h"
+#include "mklog/Logger.h"
+#include "mklog/writers/HtmlLogWriter.h"
+#include "mklog/writers/TextLogWriter.h"
+
+using mklog::BufferedFileSink;
+using mklog::LogManager;
+using mklog::Logger;
+using mklog::MessageContentType;
+
+static constexpr int MESSAGE_COUNT = 20000;
+
+/// Small blocks, so that log has many of them
+static constexpr BufferedFileSink::CompressionPolicy
+    COMPRESSION_POLICY_SMALL = {
+        .blockSize = 16 * 1024,
+        .maxAgeMs  = 5000,
+        .level     = 1,
+    };
+
+/**
+ * @brief Log numbered messages, with single error in the middle
+ */
+static void logNumberedMessages()
+{
+  Logger logger("compressed");
+  for (int i = 0; i < MESSAGE_COUNT; ++i)
+  {
+    if (i == MESSAGE_COUNT / 2)
+      logger.LOG_ERROR(MessageContentType::TEXT, "error %d", i);
+    else
+      logger.LOG_INFO(MessageContentType::TEXT, "message %d", i);
+  }
+}
+
+/**
+ * @brief Log same messages to plain and compressed text and HTML files
+ */
+static void logToCompressedFiles()
+{
+  LogManager::addWriter<mklog::TextLogWriter>().setFile("log.txt");
+  LogManager::addWriter<mklog::TextLogWriter>()
+      .setCompressionPolicy(COMPRESSION_POLICY_SMALL)
+      .setFile("log.txt.blk");
+  LogManager::addWriter<mklog::HtmlLogWriter>().setFile("log.html");
+  LogManager::addWriter<mklog::HtmlLogWriter>()
+      .setCompressionPolicy(COMPRESSION_POLICY_SMALL)
+      .setFile("log.html.blk");
+  LogManager::initLogs();
+
+  logNumberedMessages();
+}
+
+/**
+ * @brief Check that unpacked compressed log matches plain one
+ */
+static void checkUnpacked(const char* plainFile, const char* compressedFile)
+{
+  std::string plain;
+  test_assert(mklog::test::readFile(plainFile, plain));
+
+  mklog::utils::TextBuffer command;
+  command.appendf("LogUnpack %s 2>/dev/null", compressedFile);
+
+  std::string unpacked;
+  test_assert(mklog::test::runTool(command.data(), &unpacked) == 0);
+  test_assert(plain.length() == unpacked.length());
+  test_assert(memcmp(plain.data(), unpacked.data(), plain.length()) == 0);
+}
+
+TEST_CASE(compressedLogUnpacksToPlainLog)
+{
+  test_assert(mklog::test::runProcess(&logToCompressedFiles) == 0);
+  checkUnpacked("log.txt", "log.txt.blk");
+  checkUnpacked("log.html", "log.html.blk");
+}
+
+TEST_CASE(compressedLogSelectsBlocks)
+{
+  test_assert(mklog::test::runProcess(&logToCompressedFiles) == 0);
+
+  // Header line followed by one line per block
+  std::string output;
+  test_assert(mklog::test::runTool("LogUnpack log.txt.blk --list 2>/dev/null",
+                                   &output) == 0);
+  const size_t blockCount =
+      mklog::test::countOccurrences(output.data(), "\n") - 1;
+  test_assert(blockCount > 1);
+  test_assert(mklog::test::countOccurrences(output.data(), " error:1") == 1);
+
+  // Only block with error is unpacked
+  test_assert(mklog::test::runTool(
+                  "LogUnpack log.txt.blk --severity error 2>/dev/null",
+                  &output) == 0);
+  test_assert(strstr(output.data(), "\terror 10000\n") != nullptr);
+  test_assert(mklog::test::countOccurrences(output.data(), "\tmessage ") <
+              MESSAGE_COUNT / blockCount * 2);
+
+  // No blocks are written in the future
+  test_assert(mklog::test::runTool(
+                  "LogUnpack log.txt.blk --from 4000000000 2>/dev/null",
+                  &output) == 0);
+  test_assert(output.length() == 0);
+
+  test_assert(mklog::test::runTool("LogUnpack log.txt 2>/dev/null",
+                                   nullptr) != 0);
+}
+
+TEST_CASE(compressedLogUnpacksAfterCrash)
+{
+  const int exitCode = mklog::test::runProcess([]() {
+    LogManager::useAsyncDispatch();
+    LogManager::addWriter<mklog::TextLogWriter>()
+        .setCompressionPolicy(COMPRESSION_POLICY_SMALL)
+        .setFile("log.txt.blk");
+    LogManager::initLogs();
+
+    logNumberedMessages();
+    raise(SIGSEGV);
+  });
+  test_assert(exitCode == 128 + SIGSEGV);
+
+  // Records of unfinished block are written without index
+  std::string output;
+  test_assert(mklog::test::runTool("LogUnpack log.txt.blk 2>/dev/null",
+                                   &output) == 0);
+  test_assert(mklog::test::countOccurrences(output.data(), "\tmessage ") ==
+              MESSAGE_COUNT - 1);
+  test_assert(strstr(output.data(), "\tmessage 19999\n") != nullptr);
+}
+
+TEST_CASE(compressedLogWritesExpiredBlock)
+{
+  LogManager::addWriter<mklog::TextLogWriter>()
+      .setCompressionPolicy({.blockSize = 16 * 1024,
+                             .maxAgeMs  = 20,
+                             .level     = 1})
+      .setFile("log.txt.blk");
+  LogManager::initLogs();
+
+  Logger logger("compressed");
+  logger.LOG_INFO(MessageContentType::TEXT, "expiring");
+
+  // No more messages are logged, block is ended by sink timer
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+  std::string output;
+  test_assert(mklog::test::runTool("LogUnpack log.txt.blk 2>/dev/null",
+                                   &output) == 0);
+  test_assert(strstr(output.data(), "\texpiring\n") != nullptr);
+}
@@ -0,0 +1,130 @@
+/**
+ * @file CrashFlushTest.cpp
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Tests of messages written from crash signal handler
+ *
+ * @version 0.1
+ * @date 2023-09-22
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+
+#include "TestRunner.h"
+#include "TestUtils.h"
+#include "mklog/LogManager.h"
+#include "mklog/Logger.h"
+#include "mklog/LongMessage.h"
+#include "mklog/writers/HtmlLogWriter.h"
+#include "mklog/writers/TextLogWriter.h"
+
+using mklog::BufferedFileSink;
+using mklog::LogManager;
+using mklog::Logger;
+using mklog::MessageContentType;
+using mklog::MessageSeverity;
+
+static constexpr int MESSAGE_COUNT = 3000;
+
+/// Keep records buffered until crash
+static constexpr BufferedFileSink::FlushPolicy FLUSH_POLICY_LAZY = {
+    .bufferSize    = 16 * 1024 * 1024,
+    .maxAgeMs      = 60 * 1000,
+    .flushSeverity = MessageSeverity::FATAL,
+};
+
+static void setupCrashLogs()
+{
+  LogManager::addWriter<mklog::TextLogWriter>()
+      .setFlushPolicy(FLUSH_POLICY_LAZY)
+      .setFile("log.txt");
+  LogManager::addWriter<mklog::HtmlLogWriter>()
+      .setFlushPolicy(FLUSH_POLICY_LAZY)
+      .setFile("log.html");
+  LogManager::initLogs();
+}
+
+static void logNumberedMessages()
+{
+  Logger logger("crash");
+  for (int i = 0; i < MESSAGE_COUNT; ++i)
+  {
+    logger.LOG_INFO(MessageContentType::TEXT, "message %d", i);
+  }
+}
+
+/**
+ * @brief Check that every numbered message was written once, in order
+ */
+static void checkNumberedMessages()
+{
+  std::string log;
+  test_assert(mklog::test::readFile("log.txt", log));
+
+  char        message[32] = "";
+  const char* cur         = log.data();
+  for (int i = 0; i < MESSAGE_COUNT; ++i)
+  {
+    snprintf(message, sizeof(message), "\tmessage %d\n", i);
+    cur = strstr(cur, message);
+    test_assert(cur != nullptr);
+  }
+  test_assert(mklog::test::countOccurrences(log.data(), "\tmessage ") ==
+              MESSAGE_COUNT);
+
+  std::string html;
+  test_assert(mklog::test::readFile("log.html", html));
+  test_assert(mklog::test::countOccurrences(html.data(), "message ") ==
+              MESSAGE_COUNT);
+}
+
+TEST_CASE(crashFlushWritesBufferedRecords)
+{
+  const int exitCode = mklog::test::runProcess([]() {
+    setupCrashLogs();
+    logNumberedMessages();
+    raise(SIGSEGV);
+  });
+  test_assert(exitCode == 128 + SIGSEGV);
+  checkNumberedMessages();
+}
+
+TEST_CASE(crashFlushWritesQueuedMessages)
+{
+  const int exitCode = mklog::test::runProcess([]() {
+    LogManager::useAsyncDispatch();
+    LogManager::useDeferredFormatting();
+    setupCrashLogs();
+    logNumberedMessages();
+    raise(SIGBUS);
+  });
+  test_assert(exitCode == 128 + SIGBUS);
+  checkNumberedMessages();
+}
+
+TEST_CASE(crashFlushWritesOpenLongMessages)
+{
+  const int exitCode = mklog::test::runProcess([]() {
+    setupCrashLogs();
+
+    Logger             logger("crash");
+    mklog::LongMessage built =
+        logger.LOG_LONG_ERROR(MessageContentType::TEXT, "built");
+    built << "unfinished built content";
+
+    LogManager::MessageFd fd =
+        logger.LOG_BEGIN_ERROR(MessageContentType::TEXT, "piped");
+    dprintf(fd, "unfinished piped content");
+
+    raise(SIGFPE);
+  });
+  test_assert(exitCode == 128 + SIGFPE);
+
+  std::string log;
+  test_assert(mklog::test::readFile("log.txt", log));
+  test_assert(strstr(log.data(), "unfinished built content") != nullptr);
+  test_assert(strstr(log.data(), "unfinished piped content") != nullptr);
+}
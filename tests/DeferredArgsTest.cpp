@@ -0,0 +1,142 @@
+/**
+ * @file DeferredArgsTest.cpp
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Tests of format arguments captured in binary form
+ *
+ * @version 0.1
+ * @date 2023-09-22
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#include <cstdio>
+#include <cstring>
+
+#include "TestRunner.h"
+#include "TestUtils.h"
+#include "mklog/LogManager.h"
+#include "mklog/Logger.h"
+#include "mklog/utils/DeferredArgs.h"
+#include "mklog/writers/TextLogWriter.h"
+
+using mklog::LogManager;
+using mklog::Logger;
+using mklog::MessageContentType;
+using mklog::utils::DeferredArgs;
+
+/**
+ * @brief Encode arguments, render them and compare result with `snprintf()`
+ */
+#define test_assert_rendered(format, ...)                                      \
+  do                                                                           \
+  {                                                                            \
+    char encoded[256] = {};                                                    \
+    test_assert(DeferredArgs::getEncodedSize(__VA_ARGS__) <= sizeof(encoded)); \
+    DeferredArgs::encode(encoded, __VA_ARGS__);                                \
+                                                                               \
+    mklog::utils::TextBuffer rendered;                                         \
+    DeferredArgs::render(rendered, format, encoded,                            \
+                         DeferredArgs::getEncodedSize(__VA_ARGS__));           \
+                                                                               \
+    char expected[256] = "";                                                   \
+    snprintf(expected, sizeof(expected), format, __VA_ARGS__);                 \
+    test_assert(strcmp(rendered.data(), expected) == 0);                       \
+  } while (0)
+
+enum class Color : short
+{
+  RED = 3,
+};
+
+TEST_CASE(deferredArgsRenderLikePrintf)
+{
+  const short         shortValue = -7;
+  const unsigned char byteValue  = 200;
+  const int           local      = 0;
+
+  test_assert_rendered("%d %i %u %x %#o %c", -42, 17, 42u, 0xBEEFu, 8u, 'z');
+  test_assert_rendered("%ld %lu %lld %llu %zu", -1L, 2UL, -3LL, 4ULL,
+                       sizeof(local));
+  test_assert_rendered("%hd %hhu %d", shortValue, byteValue, (int)Color::RED);
+  test_assert_rendered("%f %.3e %g %Lf", 1.5, 12345.678, 1e-9f, 2.25L);
+  test_assert_rendered("%p %s", (const void*)&local, "text");
+  test_assert_rendered("[%8s] [%-6d] [%+.2f] 100%%", "ab", 5, 3.14159);
+  test_assert_rendered("[%*d] [%.*s] [%*.*f]", 6, 42, 3, "abcdef", 8, 2,
+                       2.5);
+}
+
+TEST_CASE(deferredArgsKeepUnmatchedConversions)
+{
+  char encoded[64] = {};
+  DeferredArgs::encode(encoded, 1);
+
+  mklog::utils::TextBuffer rendered;
+  DeferredArgs::render(rendered, "%d and %s, %", encoded,
+                       DeferredArgs::getEncodedSize(1));
+  test_assert(strcmp(rendered.data(), "1 and %s, %") == 0);
+}
+
+TEST_CASE(deferredArgsCopyStrings)
+{
+  LogManager::useAsyncDispatch();
+  LogManager::useDeferredFormatting();
+  LogManager::addWriter<mklog::TextLogWriter>().setFile("log.txt");
+  LogManager::initLogs();
+  test_assert(LogManager::isFormattingDeferred());
+
+  Logger logger("deferred");
+
+  char  array[]   = "array before";
+  char* heapValue = new char[sizeof("heap string")];
+  strcpy(heapValue, "heap string");
+
+  logger.LOG_INFO(MessageContentType::TEXT, "%s, %s, %d", array, heapValue,
+                  7);
+
+  // Message may still be queued, its arguments must not change
+  strcpy(array, "array after!");
+  delete[] heapValue;
+  LogManager::flushMessages();
+
+  std::string log;
+  test_assert(mklog::test::readFile("log.txt", log));
+  test_assert(strstr(log.data(), "\tarray before, heap string, 7\n") !=
+              nullptr);
+}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+#pragma GCC diagnostic ignored "-Wformat-security"
+
+TEST_CASE(deferredArgsFormatRuntimeFormats)
+{
+  static constexpr int MESSAGE_COUNT = 1000;
+
+  LogManager::useAsyncDispatch();
+  LogManager::useDeferredFormatting();
+  LogManager::addWriter<mklog::TextLogWriter>().setFile("log.txt");
+  LogManager::initLogs();
+
+  Logger logger("deferred");
+  for (int i = 0; i < MESSAGE_COUNT; ++i)
+  {
+    char* format = new char[sizeof("runtime %d")];
+    strcpy(format, "runtime %d");
+
+    logger.LOG_INFO(MessageContentType::TEXT, format, i);
+
+    // Message may still be queued, format must not be used by dispatcher
+    strcpy(format, "freed %s!");
+    delete[] format;
+  }
+  LogManager::flushMessages();
+
+  std::string log;
+  test_assert(mklog::test::readFile("log.txt", log));
+  test_assert(mklog::test::countOccurrences(log.data(), "\truntime ") ==
+              MESSAGE_COUNT);
+  test_assert(strstr(log.data(), "\truntime 999\n") != nullptr);
+  test_assert(strstr(log.data(), "\tfreed ") == nullptr);
+}
+
+#pragma GCC diagnostic pop
@@ -0,0 +1,167 @@
+/**
+ * @file FileSinkTest.cpp
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Tests of buffered output of text and HTML writers
+ *
+ * @version 0.1
+ * @date 2023-09-22
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include "TestRunner.h"
+#include "TestUtils.h"
+#include "mklog/LogManager.h"
+#include "mklog/Logger.h"
+#include "mklog/writers/HtmlLogWriter.h"
+#include "mklog/writers/TextLogWriter.h"
+
+using mklog::BufferedFileSink;
+using mklog::LogManager;
+using mklog::Logger;
+using mklog::MessageContentType;
+using mklog::MessageSeverity;
+
+static size_t getFileLength(const char* filename)
+{
+  std::string content;
+  test_assert(mklog::test::readFile(filename, content));
+  return content.length();
+}
+
+TEST_CASE(fileSinkFlushesOnSeverity)
+{
+  LogManager::addWriter<mklog::TextLogWriter>()
+      .setFile("log.txt")
+      .setFlushPolicy({.bufferSize    = 64 * 1024,
+                       .maxAgeMs      = 60 * 1000,
+                       .flushSeverity = MessageSeverity::FATAL});
+  LogManager::initLogs();
+
+  Logger logger("sink");
+  logger.LOG_ERROR(MessageContentType::TEXT, "buffered");
+  test_assert(getFileLength("log.txt") == 0);
+
+  logger.LOG_FATAL(MessageContentType::TEXT, "flushed");
+
+  std::string log;
+  test_assert(mklog::test::readFile("log.txt", log));
+  const char* buffered = strstr(log.data(), "\tbuffered\n");
+  const char* flushed  = strstr(log.data(), "\tflushed\n");
+  test_assert(buffered != nullptr && flushed != nullptr);
+  test_assert(buffered < flushed);
+}
+
+TEST_CASE(fileSinkWritesUnbufferedRecordsImmediately)
+{
+  LogManager::addWriter<mklog::TextLogWriter>()
+      .setFile("log.txt")
+      .setFlushPolicy({.bufferSize    = 0,
+                       .maxAgeMs      = 0,
+                       .flushSeverity = MessageSeverity::FATAL});
+  LogManager::initLogs();
+
+  Logger logger("sink");
+  logger.LOG_TRACE(MessageContentType::TEXT, "unbuffered");
+  test_assert(getFileLength("log.txt") > 0);
+}
+
+TEST_CASE(fileSinkFlushesExpiredRecords)
+{
+  LogManager::useAsyncDispatch();
+  LogManager::addWriter<mklog::TextLogWriter>()
+      .setFile("log.txt")
+      .setFlushPolicy({.bufferSize    = 64 * 1024,
+                       .maxAgeMs      = 20,
+                       .flushSeverity = MessageSeverity::FATAL});
+  LogManager::initLogs();
+
+  Logger logger("sink");
+  logger.LOG_INFO(MessageContentType::TEXT, "expiring");
+
+  // Sink timer writes buffer once it is old enough
+  for (int attempt = 0; attempt < 50 && getFileLength("log.txt") == 0;
+       ++attempt)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  test_assert(getFileLength("log.txt") > 0);
+}
+
+TEST_CASE(fileSinkFlushesExpiredRecordsSynchronously)
+{
+  LogManager::addWriter<mklog::TextLogWriter>()
+      .setFile("log.txt")
+      .setFlushPolicy({.bufferSize    = 64 * 1024,
+                       .maxAgeMs      = 20,
+                       .flushSeverity = MessageSeverity::FATAL});
+  LogManager::initLogs();
+
+  Logger logger("sink");
+  logger.LOG_INFO(MessageContentType::TEXT, "expiring");
+  test_assert(getFileLength("log.txt") == 0);
+
+  // No more messages are logged after the first one
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+  std::string log;
+  test_assert(mklog::test::readFile("log.txt", log));
+  test_assert(strstr(log.data(), "\texpiring\n") != nullptr);
+}
+
+TEST_CASE(fileSinkKeepsLargeRecordsInOrder)
+{
+  static constexpr int    MESSAGE_COUNT = 200;
+  static constexpr size_t LARGE_LEN = BufferedFileSink::EXTERNAL_PART_LEN_MIN;
+
+  const int exitCode = mklog::test::runProcess([]() {
+    LogManager::addWriter<mklog::TextLogWriter>().setFile("log.txt");
+    LogManager::addWriter<mklog::HtmlLogWriter>().setFile("log.html");
+    LogManager::initLogs();
+
+    char large[LARGE_LEN + 1] = "";
+    memset(large, 'x', LARGE_LEN);
+
+    Logger logger("sink");
+    for (int i = 0; i < MESSAGE_COUNT; ++i)
+    {
+      // Large content is written from caller memory
+      logger.LOG_INFO(MessageContentType::TEXT, "small %d", i);
+      logger.LOG_INFO(MessageContentType::TEXT, "large %d %s", i,
+                      i % 3 == 0 ? large : "");
+    }
+  });
+  test_assert(exitCode == 0);
+
+  std::string log;
+  test_assert(mklog::test::readFile("log.txt", log));
+
+  const char* cur = log.data();
+  for (int i = 0; i < MESSAGE_COUNT; ++i)
+  {
+    char small[32] = "";
+    snprintf(small, sizeof(small), "\tsmall %d\n", i);
+    cur = strstr(cur, small);
+    test_assert(cur != nullptr);
+
+    char large[32] = "";
+    snprintf(large, sizeof(large), "\tlarge %d ", i);
+    cur = strstr(cur, large);
+    test_assert(cur != nullptr);
+
+    cur += strlen(large);
+    const size_t contentLen = i % 3 == 0 ? LARGE_LEN : 0;
+    test_assert(strspn(cur, "x") == contentLen && cur[contentLen] == '\n');
+  }
+
+  std::string html;
+  test_assert(mklog::test::readFile("log.html", html));
+  test_assert(mklog::test::countOccurrences(html.data(), "small ") ==
+              MESSAGE_COUNT);
+  test_assert(mklog::test::countOccurrences(html.data(), "large ") ==
+              MESSAGE_COUNT);
+}
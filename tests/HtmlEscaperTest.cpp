@@ -0,0 +1,116 @@
+/**
+ * @file HtmlEscaperTest.cpp
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Tests of vectorized HTML escaping
+ *
+ * @version 0.1
+ * @date 2023-09-22
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#include <cstdlib>
+#include <cstring>
+
+#include "TestRunner.h"
+#include "TestUtils.h"
+#include "mklog/LogManager.h"
+#include "mklog/Logger.h"
+#include "mklog/utils/HtmlEscaper.h"
+#include "mklog/writers/HtmlLogWriter.h"
+
+using mklog::LogManager;
+using mklog::Logger;
+using mklog::MessageContentType;
+using mklog::utils::HtmlEscaper;
+using mklog::utils::TextBuffer;
+
+/**
+ * @brief Escape text one character at a time
+ */
+static void escapeReference(TextBuffer& output, const char* text,
+                            size_t length, bool escapeQuotes)
+{
+  for (size_t i = 0; i < length; ++i)
+  {
+    switch (text[i])
+    {
+    case '<': output.append("&lt;", 4);   break;
+    case '>': output.append("&gt;", 4);   break;
+    case '&': output.append("&amp;", 5);  break;
+    case '"':
+      if (escapeQuotes)
+        output.append("&quot;", 6);
+      else
+        output.append('"');
+      break;
+    default:  output.append(text[i]);      break;
+    }
+  }
+}
+
+TEST_CASE(htmlEscaperMatchesScalarEscaping)
+{
+  static constexpr HtmlEscaper::Implementation IMPLEMENTATIONS[] = {
+      HtmlEscaper::Implementation::SCALAR,
+      HtmlEscaper::Implementation::SSE42,
+      HtmlEscaper::Implementation::AVX2,
+      HtmlEscaper::Implementation::AVX512,
+  };
+  static constexpr char ALPHABET[] = "<>&\"'abc \n\0\x80\xff";
+
+  char text[300] = "";
+  srand(12345);
+
+  for (HtmlEscaper::Implementation implementation : IMPLEMENTATIONS)
+  {
+    if (!HtmlEscaper::isSupported(implementation))
+      continue;
+
+    HtmlEscaper::useImplementation(implementation);
+    test_assert(HtmlEscaper::getImplementation() == implementation);
+
+    // Lengths cover partial, single and several blocks of every width
+    for (size_t length = 0; length < sizeof(text); ++length)
+    {
+      for (size_t i = 0; i < length; ++i)
+      {
+        text[i] = ALPHABET[rand() % (sizeof(ALPHABET) - 1)];
+      }
+
+      for (bool escapeQuotes : {false, true})
+      {
+        TextBuffer escaped;
+        TextBuffer expected;
+        escaped.append("prefix", 6);
+        expected.append("prefix", 6);
+
+        HtmlEscaper::append(escaped, text, length, escapeQuotes);
+        escapeReference(expected, text, length, escapeQuotes);
+
+        test_assert(escaped.length() == expected.length());
+        test_assert(memcmp(escaped.data(), expected.data(),
+                           expected.length()) == 0);
+      }
+    }
+  }
+}
+
+TEST_CASE(htmlEscaperEscapesMessageContent)
+{
+  const int exitCode = mklog::test::runProcess([]() {
+    LogManager::addWriter<mklog::HtmlLogWriter>().setFile("log.html");
+    LogManager::initLogs();
+
+    Logger logger("html");
+    logger.LOG_INFO(MessageContentType::TEXT,
+                    "<script>alert(\"a & b\")</script>");
+  });
+  test_assert(exitCode == 0);
+
+  std::string html;
+  test_assert(mklog::test::readFile("log.html", html));
+  test_assert(strstr(html.data(), "&lt;script&gt;alert(\"a &amp; b\")"
+                                  "&lt;/script&gt;") != nullptr);
+  test_assert(strstr(html.data(), "<script>alert") == nullptr);
+}
@@ -0,0 +1,134 @@
+/**
+ * @file LogClockTest.cpp
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Tests of tick-based message timestamps
+ *
+ * @version 0.1
+ * @date 2023-09-22
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <thread>
+
+#include "TestRunner.h"
+#include "TestUtils.h"
+#include "mklog/LogManager.h"
+#include "mklog/Logger.h"
+#include "mklog/utils/LogClock.h"
+#include "mklog/writers/TextLogWriter.h"
+
+using mklog::LogManager;
+using mklog::Logger;
+using mklog::MessageContentType;
+using mklog::utils::LogClock;
+
+/// Allowed difference between converted ticks and system clock
+static constexpr int64_t TOLERANCE_NS = 2 * 1000 * 1000;
+
+static int64_t getClockNs(clockid_t clock)
+{
+  struct timespec time = {};
+  clock_gettime(clock, &time);
+  return (int64_t)time.tv_sec * (int64_t)LogClock::NS_PER_SECOND +
+         time.tv_nsec;
+}
+
+static int64_t toRealtimeNs(LogClock::Ticks ticks)
+{
+  time_t   seconds     = 0;
+  uint32_t nanoseconds = 0;
+  LogClock::toRealtime(ticks, &seconds, &nanoseconds);
+  return (int64_t)seconds * (int64_t)LogClock::NS_PER_SECOND + nanoseconds;
+}
+
+TEST_CASE(logClockConvertsTicksToWallClock)
+{
+  LogClock::calibrate();
+
+  // Samples span calibration refinement
+  for (int sample = 0; sample < 15; ++sample)
+  {
+    const int64_t         beforeNs = getClockNs(CLOCK_REALTIME);
+    const LogClock::Ticks ticks    = LogClock::now();
+    const int64_t         afterNs  = getClockNs(CLOCK_REALTIME);
+
+    const int64_t convertedNs = toRealtimeNs(ticks);
+    test_assert(beforeNs - TOLERANCE_NS <= convertedNs);
+    test_assert(convertedNs <= afterNs + TOLERANCE_NS);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+}
+
+TEST_CASE(logClockMeasuresIntervals)
+{
+  LogClock::calibrate();
+
+  const int64_t         startNs    = getClockNs(CLOCK_MONOTONIC_RAW);
+  const LogClock::Ticks startTicks = LogClock::now();
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  const LogClock::Ticks endTicks = LogClock::now();
+  const int64_t         endNs    = getClockNs(CLOCK_MONOTONIC_RAW);
+
+  const int64_t expectedTicks = (int64_t)LogClock::toTicks(endNs - startNs);
+  const int64_t measuredTicks = (int64_t)(endTicks - startTicks);
+  test_assert(llabs(measuredTicks - expectedTicks) <= expectedTicks / 20);
+}
+
+TEST_CASE(logClockSignalSafeConversionMatches)
+{
+  LogClock::calibrate();
+
+  for (int sample = 0; sample < 1000; ++sample)
+  {
+    const LogClock::Ticks ticks = LogClock::now();
+
+    time_t   signalSafeSeconds     = 0;
+    uint32_t signalSafeNanoseconds = 0;
+    LogClock::toRealtimeSignalSafe(ticks, &signalSafeSeconds,
+                                   &signalSafeNanoseconds);
+
+    time_t   seconds     = 0;
+    uint32_t nanoseconds = 0;
+    LogClock::toRealtime(ticks, &seconds, &nanoseconds);
+
+    test_assert(seconds == signalSafeSeconds);
+    test_assert(nanoseconds == signalSafeNanoseconds);
+  }
+}
+
+TEST_CASE(logClockStampsWrittenMessages)
+{
+  setenv("TZ", "UTC0", 1);
+  tzset();
+
+  LogManager::addWriter<mklog::TextLogWriter>().setFile("log.txt");
+  LogManager::initLogs();
+
+  const int64_t beforeNs = getClockNs(CLOCK_REALTIME);
+  Logger        logger("clock");
+  logger.LOG_INFO(MessageContentType::TEXT, "stamped");
+  const int64_t afterNs = getClockNs(CLOCK_REALTIME);
+  LogManager::flushMessages();
+
+  std::string log;
+  test_assert(mklog::test::readFile("log.txt", log));
+
+  struct tm   time     = {};
+  const char* fraction = strptime(log.data(), "<%Y-%m-%d %H:%M:%S", &time);
+  test_assert(fraction != nullptr && *fraction == '.');
+
+  int64_t microseconds = 0;
+  test_assert(sscanf(fraction, ".%6ld+0000>", &microseconds) == 1);
+
+  const int64_t stampNs =
+      (int64_t)timegm(&time) * (int64_t)LogClock::NS_PER_SECOND +
+      microseconds * 1000;
+  test_assert(beforeNs - TOLERANCE_NS <= stampNs);
+  test_assert(stampNs <= afterNs + TOLERANCE_NS);
+}
@@ -0,0 +1,135 @@
+/**
+ * @file LogQueryTest.cpp
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Tests of text logs searched by `LogQuery` tool using sidecar index
+ *
+ * @version 0.1
+ * @date 2023-09-22
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#include <cstdio>
+#include <cstring>
+
+#include "TestRunner.h"
+#include "TestUtils.h"
+#include "mklog/LogManager.h"
+#include "mklog/Logger.h"
+#include "mklog/writers/TextLogWriter.h"
+
+using mklog::BufferedFileSink;
+using mklog::LogManager;
+using mklog::Logger;
+using mklog::MessageContentType;
+
+static constexpr int MESSAGE_COUNT = 20000;
+
+/// Small chunks, so that index has many entries
+static constexpr BufferedFileSink::IndexPolicy INDEX_POLICY_SMALL = {
+    .chunkSize = 16 * 1024,
+};
+
+/**
+ * @brief Log messages of common and rare loggers and severities to indexed
+ * and plain log files
+ */
+static void logQueriedMessages()
+{
+  LogManager::addWriter<mklog::TextLogWriter>()
+      .setIndexPolicy(INDEX_POLICY_SMALL)
+      .setFile("log.txt");
+  LogManager::addWriter<mklog::TextLogWriter>().setFile("plain.txt");
+  LogManager::initLogs();
+
+  Logger common("common");
+  Logger rare("rare");
+  for (int i = 0; i < MESSAGE_COUNT; ++i)
+  {
+    if (i == 12345)
+      common.LOG_INFO(MessageContentType::TEXT, "message %d needle", i);
+    else if (i % 1000 == 550)
+      common.LOG_ERROR(MessageContentType::TEXT, "message %d", i);
+    else if (i % 100 == 0)
+      rare.LOG_INFO(MessageContentType::TEXT, "message %d", i);
+    else
+      common.LOG_INFO(MessageContentType::TEXT, "message %d", i);
+  }
+}
+
+/**
+ * @brief Run query against indexed and plain logs, check that both return
+ * the same records
+ *
+ * @return Number of matched records
+ */
+static size_t runQuery(const char* arguments)
+{
+  mklog::utils::TextBuffer command;
+  std::string indexed;
+  std::string plain;
+
+  command.appendf("LogQuery log.txt %s 2>/dev/null", arguments);
+  test_assert(mklog::test::runTool(command.data(), &indexed) == 0);
+
+  command.clear();
+  command.appendf("LogQuery plain.txt %s 2>/dev/null", arguments);
+  test_assert(mklog::test::runTool(command.data(), &plain) == 0);
+
+  test_assert(indexed.length() == plain.length());
+  test_assert(memcmp(indexed.data(), plain.data(), plain.length()) == 0);
+
+  return mklog::test::countOccurrences(indexed.data(), "' in '");
+}
+
+TEST_CASE(logQueryFiltersRecords)
+{
+  test_assert(mklog::test::runProcess(&logQueriedMessages) == 0);
+
+  test_assert(runQuery("") == MESSAGE_COUNT);
+  test_assert(runQuery("--logger rare") == MESSAGE_COUNT / 100);
+  test_assert(runQuery("--logger missing") == 0);
+  test_assert(runQuery("--severity error") == MESSAGE_COUNT / 1000);
+  test_assert(runQuery("--severity error --logger rare") == 0);
+  test_assert(runQuery("--text needle") == 1);
+  // Messages 7, 70..79, 700..799 and 7000..7999
+  test_assert(runQuery("--text 'message 7'") == 1111);
+  test_assert(runQuery("--file LogQueryTest.cpp") == MESSAGE_COUNT);
+  test_assert(runQuery("--file Missing.cpp") == 0);
+  test_assert(runQuery("--from 4000000000") == 0);
+  test_assert(runQuery("--to 1") == 0);
+  test_assert(runQuery("--threads 4 --logger rare") == MESSAGE_COUNT / 100);
+
+  std::string output;
+  test_assert(mklog::test::runTool("LogQuery log.txt --text needle", &output) ==
+              0);
+  test_assert(strstr(output.data(), "\tmessage 12345 needle\n") != nullptr);
+}
+
+TEST_CASE(logQuerySkipsChunksByIndex)
+{
+  test_assert(mklog::test::runProcess(&logQueriedMessages) == 0);
+
+  // Summary is written to stderr
+  std::string summary;
+  test_assert(mklog::test::runTool(
+                  "LogQuery log.txt --severity error 2>&1 >/dev/null",
+                  &summary) == 0);
+
+  size_t matchCount   = 0;
+  size_t skippedCount = 0;
+  size_t chunkCount   = 0;
+  test_assert(sscanf(summary.data(),
+                     "%zu records matched, scanned %*f of %*f MB: "
+                     "%zu of %zu chunks",
+                     &matchCount, &skippedCount, &chunkCount) == 3);
+  test_assert(matchCount == MESSAGE_COUNT / 1000);
+  test_assert(chunkCount > 1);
+  test_assert(skippedCount > 0 && skippedCount < chunkCount);
+
+  // Nothing is skipped without index
+  test_assert(mklog::test::runTool(
+                  "LogQuery plain.txt --severity error 2>&1 >/dev/null",
+                  &summary) == 0);
+  test_assert(strstr(summary.data(), " 0 of 0 chunks skipped") != nullptr);
+}
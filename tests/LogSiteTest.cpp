@@ -0,0 +1,110 @@
+/**
+ * @file LogSiteTest.cpp
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Tests of static log site registry
+ *
+ * @version 0.1
+ * @date 2023-09-22
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#include <cstring>
+#include <thread>
+
+#include "TestRunner.h"
+#include "TestUtils.h"
+#include "mklog/LogManager.h"
+#include "mklog/LogSite.h"
+#include "mklog/Logger.h"
+#include "mklog/writers/TextLogWriter.h"
+
+using mklog::LogManager;
+using mklog::LogSite;
+using mklog::LogSiteRegistry;
+using mklog::Logger;
+using mklog::MessageContentType;
+using mklog::MessageSeverity;
+
+TEST_CASE(logSiteIdsAreUniqueAcrossThreads)
+{
+  static constexpr size_t THREAD_COUNT = 4;
+  static constexpr size_t SITE_COUNT   = 300; // More than one chunk in total
+
+  static LogSite::Id ids[THREAD_COUNT][SITE_COUNT] = {};
+
+  std::thread threads[THREAD_COUNT];
+  for (size_t thread = 0; thread < THREAD_COUNT; ++thread)
+  {
+    threads[thread] = std::thread([thread]() {
+      for (size_t i = 0; i < SITE_COUNT; ++i)
+      {
+        ids[thread][i] = LogSiteRegistry::registerSite(
+            {.file     = "thread.cpp",
+             .function = "registerSites",
+             .line     = thread * SITE_COUNT + i,
+             .severity = MessageSeverity::DEBUG,
+             .format   = "site"});
+      }
+    });
+  }
+  for (std::thread& thread : threads)
+  {
+    thread.join();
+  }
+
+  const size_t siteCount = LogSiteRegistry::siteCount();
+  test_assert(siteCount >= THREAD_COUNT * SITE_COUNT);
+
+  bool* const isSeen = new bool[siteCount + 1]();
+  for (size_t thread = 0; thread < THREAD_COUNT; ++thread)
+  {
+    for (size_t i = 0; i < SITE_COUNT; ++i)
+    {
+      const LogSite::Id id = ids[thread][i];
+      test_assert(id != LogSite::ID_NONE && id <= siteCount);
+      test_assert(!isSeen[id]);
+      isSeen[id] = true;
+
+      const LogSite& site = LogSiteRegistry::getSite(id);
+      test_assert(site.line == thread * SITE_COUNT + i);
+      test_assert(strcmp(site.file, "thread.cpp") == 0);
+    }
+  }
+  delete[] isSeen;
+}
+
+TEST_CASE(logSiteIsRegisteredOncePerMacro)
+{
+  LogManager::addWriter<mklog::TextLogWriter>().setFile("log.txt");
+  LogManager::initLogs();
+
+  Logger logger("site");
+
+  const size_t siteCountBefore = LogSiteRegistry::siteCount();
+  size_t       line            = 0;
+  for (int i = 0; i < 3; ++i)
+  {
+    line = __LINE__ + 1;
+    logger.LOG_ERROR(MessageContentType::TEXT, "repeat %d", i);
+  }
+  test_assert(LogSiteRegistry::siteCount() == siteCountBefore + 1);
+
+  const LogSite& site = LogSiteRegistry::getSite(siteCountBefore + 1);
+  test_assert(site.line == line);
+  test_assert(site.severity == MessageSeverity::ERROR);
+  test_assert(strcmp(site.file, "LogSiteTest.cpp") == 0);
+  test_assert(strcmp(site.format, "repeat %d") == 0);
+  LogManager::flushMessages();
+
+  mklog::utils::TextBuffer expected;
+  expected.appendf("[ ERROR ] 'site' in "
+                   "'void logSiteIsRegisteredOncePerMacro()' "
+                   "at 'LogSiteTest.cpp:%zu':\n\trepeat 2\n",
+                   line);
+
+  std::string log;
+  test_assert(mklog::test::readFile("log.txt", log));
+  test_assert(mklog::test::countOccurrences(log.data(), "\trepeat ") == 3);
+  test_assert(strstr(log.data(), expected.data()) != nullptr);
+}
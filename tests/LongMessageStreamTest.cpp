@@ -0,0 +1,131 @@
+/**
+ * @file LongMessageStreamTest.cpp
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Tests of long messages delivered to writers in parts
+ *
+ * @version 0.1
+ * @date 2023-09-22
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#include <cstdio>
+#include <cstring>
+
+#include "TestRunner.h"
+#include "TestUtils.h"
+#include "mklog/LogManager.h"
+#include "mklog/Logger.h"
+#include "mklog/LongMessage.h"
+#include "mklog/writers/TextLogWriter.h"
+
+using mklog::LogManager;
+using mklog::Logger;
+using mklog::MessageContentType;
+
+/// Lines of long message content, several parts in total
+static constexpr int LINE_COUNT = 5000;
+
+/**
+ * @brief Check that log has all numbered lines in order, split into parts
+ * of single long message
+ */
+static void checkStreamedLines(const char* linePrefix)
+{
+  std::string log;
+  test_assert(mklog::test::readFile("log.txt", log));
+
+  char        line[32] = "";
+  const char* cur      = log.data();
+  for (int i = 0; i < LINE_COUNT; ++i)
+  {
+    snprintf(line, sizeof(line), "%s %06d\n", linePrefix, i);
+    cur = strstr(cur, line);
+    test_assert(cur != nullptr);
+  }
+
+  // Message header is the prefix alone
+  snprintf(line, sizeof(line), "%s ", linePrefix);
+  test_assert(mklog::test::countOccurrences(log.data(), line) == LINE_COUNT);
+
+  test_assert(mklog::test::countOccurrences(log.data(), " begin]:\n") == 1);
+  test_assert(mklog::test::countOccurrences(log.data(), " continued]:\n") >=
+              1);
+  test_assert(mklog::test::countOccurrences(log.data(), " end]:\n") == 1);
+}
+
+static void logLongMessage(bool isAsync)
+{
+  if (isAsync)
+  {
+    LogManager::useAsyncDispatch();
+  }
+  LogManager::addWriter<mklog::TextLogWriter>().setFile("log.txt");
+  LogManager::initLogs();
+
+  Logger             logger("stream");
+  mklog::LongMessage message =
+      logger.LOG_LONG_INFO(MessageContentType::TEXT, "built");
+  for (int i = 0; i < LINE_COUNT; ++i)
+  {
+    message.printf("built %06d\n", i);
+  }
+}
+
+TEST_CASE(longMessageStreamSplitsBuiltContent)
+{
+  test_assert(mklog::test::runProcess([]() { logLongMessage(false); }) == 0);
+  checkStreamedLines("built");
+}
+
+TEST_CASE(longMessageStreamSplitsBuiltContentAsync)
+{
+  test_assert(mklog::test::runProcess([]() { logLongMessage(true); }) == 0);
+  checkStreamedLines("built");
+}
+
+TEST_CASE(longMessageStreamSplitsPipedContent)
+{
+  const int exitCode = mklog::test::runProcess([]() {
+    LogManager::addWriter<mklog::TextLogWriter>()
+        .setFile("log.txt")
+        .setSpliceEnabled(false);
+    LogManager::initLogs();
+
+    Logger                logger("stream");
+    LogManager::MessageFd fd =
+        logger.LOG_BEGIN_INFO(MessageContentType::TEXT, "piped");
+    for (int i = 0; i < LINE_COUNT; ++i)
+    {
+      dprintf(fd, "piped %06d\n", i);
+    }
+    logger.endLongMessage(fd);
+  });
+  test_assert(exitCode == 0);
+  checkStreamedLines("piped");
+}
+
+TEST_CASE(longMessageStreamSplitsSingleLine)
+{
+  static constexpr size_t LINE_LEN = 5 * LogManager::LONG_MESSAGE_PART_LEN;
+
+  const int exitCode = mklog::test::runProcess([]() {
+    LogManager::addWriter<mklog::TextLogWriter>().setFile("log.txt");
+    LogManager::initLogs();
+
+    char* const line = new char[LINE_LEN];
+    memset(line, 'Q', LINE_LEN);
+
+    Logger logger("stream");
+    logger.LOG_LONG_INFO(MessageContentType::TEXT, "single line")
+        .append(line, LINE_LEN);
+    delete[] line;
+  });
+  test_assert(exitCode == 0);
+
+  std::string log;
+  test_assert(mklog::test::readFile("log.txt", log));
+  test_assert(mklog::test::countOccurrences(log.data(), "Q") == LINE_LEN);
+  test_assert(mklog::test::countOccurrences(log.data(), " continued]:\n") >=
+              1);
+}
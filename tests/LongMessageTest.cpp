@@ -0,0 +1,116 @@
+/**
+ * @file LongMessageTest.cpp
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Tests of long messages built in memory
+ *
+ * @version 0.1
+ * @date 2023-09-22
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#include <cstring>
+
+#include "TestRunner.h"
+#include "TestUtils.h"
+#include "mklog/LogManager.h"
+#include "mklog/Logger.h"
+#include "mklog/LongMessage.h"
+#include "mklog/LongMessageTable.h"
+#include "mklog/writers/TextLogWriter.h"
+
+using mklog::LogManager;
+using mklog::Logger;
+using mklog::LongMessageTable;
+using mklog::MessageContentType;
+
+static LongMessageTable::Handle openSlot()
+{
+  LongMessageTable::Slot*        slot   = nullptr;
+  const LongMessageTable::Handle handle = LongMessageTable::allocate(&slot);
+  test_assert(handle != LongMessageTable::HANDLE_INVALID && slot != nullptr);
+
+  slot->isOpen.store(true);
+  return handle;
+}
+
+TEST_CASE(longMessageTableRejectsStaleHandles)
+{
+  test_assert(LongMessageTable::find(LongMessageTable::HANDLE_INVALID) ==
+              nullptr);
+
+  const LongMessageTable::Handle first = openSlot();
+  LongMessageTable::Slot* const  slot  = LongMessageTable::find(first);
+  test_assert(slot != nullptr);
+
+  LongMessageTable::release(first);
+  test_assert(LongMessageTable::find(first) == nullptr);
+
+  // Freed slot is reused with new generation
+  const LongMessageTable::Handle second = openSlot();
+  test_assert(second != first);
+  test_assert(LongMessageTable::find(second) == slot);
+  test_assert(LongMessageTable::find(first) == nullptr);
+  LongMessageTable::release(second);
+}
+
+TEST_CASE(longMessageTableGrowsInChunks)
+{
+  static constexpr size_t HANDLE_COUNT = 600;
+
+  LongMessageTable::Handle handles[HANDLE_COUNT] = {};
+  for (size_t i = 0; i < HANDLE_COUNT; ++i)
+  {
+    handles[i] = openSlot();
+  }
+
+  size_t openCount = 0;
+  LongMessageTable::forEachOpen(
+      [&openCount](LongMessageTable::Slot& slot,
+                   LongMessageTable::Handle handle) {
+        test_assert(LongMessageTable::find(handle) == &slot);
+        ++openCount;
+      });
+  test_assert(openCount == HANDLE_COUNT);
+
+  for (size_t i = 0; i < HANDLE_COUNT; i += 2)
+  {
+    LongMessageTable::release(handles[i]);
+  }
+  for (size_t i = 0; i < HANDLE_COUNT; ++i)
+  {
+    test_assert((LongMessageTable::find(handles[i]) == nullptr) ==
+                (i % 2 == 0));
+  }
+}
+
+TEST_CASE(longMessageBuildsContentInMemory)
+{
+  LogManager::addWriter<mklog::TextLogWriter>().setFile("log.txt");
+  LogManager::initLogs();
+
+  Logger logger("long");
+  {
+    mklog::LongMessage first =
+        logger.LOG_LONG_INFO(MessageContentType::TEXT, "first %d", 1);
+    mklog::LongMessage second =
+        logger.LOG_LONG_WARNING(MessageContentType::TEXT, "second");
+    mklog::LongMessage empty =
+        logger.LOG_LONG_ERROR(MessageContentType::TEXT, "empty");
+    test_assert(first.isOpen() && second.isOpen() && empty.isOpen());
+
+    // Messages built at the same time do not mix. Header ends with newline
+    first << "answer " << 42 << ' ' << true;
+    second << "pi " << 3.5;
+    first.printf(", %s", "done");
+    second.append(", tail", 6);
+  }
+  LogManager::flushMessages();
+
+  std::string log;
+  test_assert(mklog::test::readFile("log.txt", log));
+  test_assert(strstr(log.data(), "\tfirst 1\nanswer 42 true, done\n") !=
+              nullptr);
+  test_assert(strstr(log.data(), "\tsecond\npi 3.5, tail\n") != nullptr);
+  test_assert(strstr(log.data(), "empty") == nullptr);
+}
@@ -0,0 +1,110 @@
+/**
+ * @file MappedOutputTest.cpp
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Tests of log files written through memory-mapped extents
+ *
+ * @version 0.1
+ * @date 2023-09-22
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+
+#include "TestRunner.h"
+#include "TestUtils.h"
+#include "mklog/LogManager.h"
+#include "mklog/Logger.h"
+#include "mklog/writers/TextLogWriter.h"
+
+using mklog::BufferedFileSink;
+using mklog::LogManager;
+using mklog::Logger;
+using mklog::MessageContentType;
+
+static constexpr int MESSAGE_COUNT = 20000;
+
+static void logNumberedMessages()
+{
+  Logger logger("mapped");
+  for (int i = 0; i < MESSAGE_COUNT; ++i)
+  {
+    logger.LOG_INFO(MessageContentType::TEXT, "message %d", i);
+  }
+}
+
+/**
+ * @brief Check that log file has no preallocated space left and contains
+ * every numbered message once
+ */
+static void checkMappedLog(const char* filename,
+                           std::string& log)
+{
+  test_assert(mklog::test::readFile(filename, log));
+  test_assert(strlen(log.data()) == log.length());
+  test_assert(mklog::test::countOccurrences(log.data(), "\tmessage ") ==
+              MESSAGE_COUNT);
+  test_assert(strstr(log.data(), "\tmessage 19999\n") != nullptr);
+}
+
+TEST_CASE(mappedOutputMatchesWriteOutput)
+{
+  const int exitCode = mklog::test::runProcess([]() {
+    LogManager::addWriter<mklog::TextLogWriter>().setFile("write.txt");
+    LogManager::addWriter<mklog::TextLogWriter>().setFile(
+        "mapped.txt", BufferedFileSink::OutputMode::MAPPED);
+    LogManager::initLogs();
+
+    logNumberedMessages();
+  });
+  test_assert(exitCode == 0);
+
+  std::string written;
+  std::string mapped;
+  checkMappedLog("write.txt", written);
+  checkMappedLog("mapped.txt", mapped);
+  test_assert(written.length() == mapped.length());
+  test_assert(memcmp(written.data(), mapped.data(), written.length()) == 0);
+}
+
+TEST_CASE(mappedOutputAppendsToExistingFile)
+{
+  static const char EXISTING[] = "existing line\n";
+
+  FILE* const file = fopen("log.txt", "w");
+  test_assert(file != nullptr);
+  fputs(EXISTING, file);
+  fclose(file);
+
+  const int exitCode = mklog::test::runProcess([]() {
+    LogManager::addWriter<mklog::TextLogWriter>().setFile(
+        "log.txt", BufferedFileSink::OutputMode::MAPPED);
+    LogManager::initLogs();
+
+    logNumberedMessages();
+  });
+  test_assert(exitCode == 0);
+
+  std::string log;
+  checkMappedLog("log.txt", log);
+  test_assert(strncmp(log.data(), EXISTING, sizeof(EXISTING) - 1) == 0);
+}
+
+TEST_CASE(mappedOutputTruncatedAfterCrash)
+{
+  const int exitCode = mklog::test::runProcess([]() {
+    LogManager::useAsyncDispatch();
+    LogManager::addWriter<mklog::TextLogWriter>().setFile(
+        "log.txt", BufferedFileSink::OutputMode::MAPPED);
+    LogManager::initLogs();
+
+    logNumberedMessages();
+    raise(SIGSEGV);
+  });
+  test_assert(exitCode == 128 + SIGSEGV);
+
+  std::string log;
+  checkMappedLog("log.txt", log);
+}
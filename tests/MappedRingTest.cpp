@@ -0,0 +1,110 @@
+/**
+ * @file MappedRingTest.cpp
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Tests of records kept in memory-mapped ring after process death
+ *
+ * @version 0.1
+ * @date 2023-09-22
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+
+#include "TestRunner.h"
+#include "TestUtils.h"
+#include "mklog/LogManager.h"
+#include "mklog/Logger.h"
+#include "mklog/utils/MappedRing.h"
+#include "mklog/writers/MappedRingLogWriter.h"
+
+using mklog::LogManager;
+using mklog::Logger;
+using mklog::MessageContentType;
+using mklog::utils::MappedRing;
+using mklog::utils::MappedRingReader;
+
+static void logToRing(size_t capacity, int messageCount)
+{
+  LogManager::addWriter<mklog::MappedRingLogWriter>().setFile("log.ring",
+                                                              capacity);
+  LogManager::initLogs();
+
+  Logger logger("ring");
+  for (int i = 0; i < messageCount; ++i)
+  {
+    logger.LOG_INFO(MessageContentType::TEXT, "message %d", i);
+  }
+}
+
+TEST_CASE(mappedRingSurvivesKill)
+{
+  static constexpr int MESSAGE_COUNT = 100;
+
+  const int exitCode = mklog::test::runProcess([]() {
+    logToRing(MappedRing::CAPACITY_DEFAULT, MESSAGE_COUNT);
+    // No flushing or exit handlers
+    raise(SIGKILL);
+  });
+  test_assert(exitCode == 128 + SIGKILL);
+
+  std::string output;
+  test_assert(mklog::test::runTool("RingRecover log.ring", &output) == 0);
+
+  char        message[32] = "";
+  const char* cur         = output.data();
+  for (int i = 0; i < MESSAGE_COUNT; ++i)
+  {
+    snprintf(message, sizeof(message), "\tmessage %d\n", i);
+    cur = strstr(cur, message);
+    test_assert(cur != nullptr);
+  }
+  test_assert(mklog::test::countOccurrences(output.data(), "\tmessage ") ==
+              MESSAGE_COUNT);
+  test_assert(strstr(output.data(), "[ INFO  ] 'ring' in ") != nullptr);
+
+  // Only last records are printed when count is given
+  test_assert(mklog::test::runTool("RingRecover log.ring 3", &output) == 0);
+  test_assert(mklog::test::countOccurrences(output.data(), "\tmessage ") ==
+              3);
+  test_assert(strstr(output.data(), "\tmessage 96\n") == nullptr);
+  test_assert(strstr(output.data(), "\tmessage 97\n") != nullptr);
+  test_assert(strstr(output.data(), "\tmessage 99\n") != nullptr);
+}
+
+TEST_CASE(mappedRingKeepsNewestRecords)
+{
+  static constexpr int MESSAGE_COUNT = 10000;
+
+  const int exitCode = mklog::test::runProcess([]() {
+    logToRing(MappedRing::CAPACITY_MIN, MESSAGE_COUNT);
+    raise(SIGKILL);
+  });
+  test_assert(exitCode == 128 + SIGKILL);
+
+  MappedRingReader reader;
+  test_assert(reader.open("log.ring"));
+
+  // Ring has wrapped, oldest records are overwritten
+  const size_t recordCount = reader.getRecordCount();
+  test_assert(recordCount > 0 && recordCount < MESSAGE_COUNT);
+
+  char message[32] = "";
+  for (size_t i = 0; i < recordCount; ++i)
+  {
+    const MappedRing::Record& record = reader.getRecord(i);
+    const size_t              number = MESSAGE_COUNT - recordCount + i;
+    if (i > 0)
+    {
+      test_assert(record.sequence == reader.getRecord(i - 1).sequence + 1);
+    }
+
+    snprintf(message, sizeof(message), "message %zu", number);
+    test_assert(record.contentLen == strlen(message));
+    test_assert(strncmp(record.content, message, record.contentLen) == 0);
+  }
+
+  test_assert(!reader.open("missing.ring"));
+}
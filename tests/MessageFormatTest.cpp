@@ -0,0 +1,77 @@
+/**
+ * @file MessageFormatTest.cpp
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Tests of message content formatting by Logger
+ *
+ * @version 0.1
+ * @date 2023-09-22
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#include <cstring>
+#include <cwchar>
+
+#include "TestRunner.h"
+#include "TestUtils.h"
+#include "mklog/LogManager.h"
+#include "mklog/Logger.h"
+#include "mklog/writers/TextLogWriter.h"
+
+using mklog::LogManager;
+using mklog::Logger;
+using mklog::MessageContentType;
+
+/**
+ * @brief Log content of given length, made of repeated letter, and check
+ * that it is written whole
+ */
+static void checkContentOfLength(size_t length, char letter)
+{
+  char* const content = new char[length + 1];
+  memset(content, letter, length);
+  content[length] = '\0';
+
+  Logger logger("format");
+  logger.LOG_INFO(MessageContentType::TEXT, "<%s>", content);
+  LogManager::flushMessages();
+
+  const std::string expected = std::string("\t<") + content + ">\n";
+
+  std::string log;
+  test_assert(mklog::test::readFile("log.txt", log));
+  test_assert(strstr(log.data(), expected.data()) != nullptr);
+
+  delete[] content;
+}
+
+TEST_CASE(formatWritesContentOfAnyLength)
+{
+  LogManager::addWriter<mklog::TextLogWriter>().setFile("log.txt");
+  LogManager::initLogs();
+
+  // Fits into initial buffer, grows it, exceeds its maximum size
+  checkContentOfLength(10, 'a');
+  checkContentOfLength(1000, 'b');
+  checkContentOfLength(10000, 'c');
+  checkContentOfLength(20, 'd');
+}
+
+TEST_CASE(formatReportsInvalidConversion)
+{
+  LogManager::addWriter<mklog::TextLogWriter>().setFile("log.txt");
+  LogManager::initLogs();
+
+  // Not representable in "C" locale
+  const wchar_t wide[] = {0x20AC, 0};
+
+  Logger logger("format");
+  logger.LOG_INFO(MessageContentType::TEXT, "wide %ls", wide);
+  logger.LOG_INFO(MessageContentType::TEXT, "next %d", 42);
+  LogManager::flushMessages();
+
+  std::string log;
+  test_assert(mklog::test::readFile("log.txt", log));
+  test_assert(strstr(log.data(), "\t<format error>\n") != nullptr);
+  test_assert(strstr(log.data(), "\tnext 42\n") != nullptr);
+}
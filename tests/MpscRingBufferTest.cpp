@@ -0,0 +1,133 @@
+/**
+ * @file MpscRingBufferTest.cpp
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Tests of lock-free queue used for asynchronous dispatch
+ *
+ * @version 0.1
+ * @date 2023-09-22
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#include <cstdint>
+#include <thread>
+
+#include "TestRunner.h"
+#include "mklog/utils/MpscRingBuffer.h"
+
+using mklog::utils::MpscRingBuffer;
+
+TEST_CASE(ringBufferKeepsOrderAcrossLaps)
+{
+  static constexpr size_t CAPACITY = 8;
+  MpscRingBuffer<size_t>  queue(CAPACITY);
+
+  size_t value = 0;
+  for (size_t lap = 0; lap < 3; ++lap)
+  {
+    for (size_t i = 0; i < CAPACITY; ++i)
+    {
+      test_assert(queue.tryPush(lap * CAPACITY + i));
+    }
+    test_assert(!queue.tryPush(0));
+
+    for (size_t i = 0; i < CAPACITY; ++i)
+    {
+      test_assert(queue.tryPop(value));
+      test_assert(value == lap * CAPACITY + i);
+    }
+    test_assert(!queue.tryPop(value));
+  }
+
+  test_assert(queue.pushedCount() == 3 * CAPACITY);
+  test_assert(queue.poppedCount() == 3 * CAPACITY);
+}
+
+TEST_CASE(ringBufferListsPendingValues)
+{
+  MpscRingBuffer<int> queue(4);
+  int                 value = 0;
+
+  queue.tryPush(1);
+  queue.tryPush(2);
+  queue.tryPush(3);
+  queue.tryPop(value);
+
+  int sum   = 0;
+  int count = 0;
+  queue.forEachPending([&](int pending) {
+    sum += pending;
+    ++count;
+  });
+
+  test_assert(count == 2);
+  test_assert(sum == 5);
+}
+
+TEST_CASE(ringBufferListsFrontValueUntilPopped)
+{
+  MpscRingBuffer<int> queue(4);
+
+  test_assert(queue.front() == nullptr);
+  queue.tryPush(1);
+  queue.tryPush(2);
+
+  const int* head = queue.front();
+  test_assert(head != nullptr && *head == 1);
+
+  int count = 0;
+  queue.forEachPending([&](int) { ++count; });
+  test_assert(count == 2);
+
+  queue.popFront();
+  test_assert(*queue.front() == 2);
+  test_assert(queue.poppedCount() == 1);
+}
+
+TEST_CASE(ringBufferDeliversEveryValueOnce)
+{
+  static constexpr uint64_t PRODUCER_COUNT = 4;
+  static constexpr uint64_t VALUE_COUNT    = 50000;
+
+  MpscRingBuffer<uint64_t> queue(64);
+  std::thread              producers[PRODUCER_COUNT];
+
+  for (uint64_t producer = 0; producer < PRODUCER_COUNT; ++producer)
+  {
+    producers[producer] = std::thread([&queue, producer]() {
+      for (uint64_t i = 0; i < VALUE_COUNT; ++i)
+      {
+        while (!queue.tryPush(producer << 32 | i))
+        {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  // Values of each producer must arrive in order, without gaps
+  uint64_t nextValue[PRODUCER_COUNT] = {};
+  for (uint64_t popped = 0; popped < PRODUCER_COUNT * VALUE_COUNT;)
+  {
+    uint64_t value = 0;
+    if (!queue.tryPop(value))
+    {
+      std::this_thread::yield();
+      continue;
+    }
+
+    const uint64_t producer = value >> 32;
+    test_assert(producer < PRODUCER_COUNT);
+    test_assert((value & UINT32_MAX) == nextValue[producer]);
+    ++nextValue[producer];
+    ++popped;
+  }
+
+  for (std::thread& producer : producers)
+  {
+    producer.join();
+  }
+
+  uint64_t value = 0;
+  test_assert(!queue.tryPop(value));
+}
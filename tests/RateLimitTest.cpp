@@ -0,0 +1,226 @@
+/**
+ * @file RateLimitTest.cpp
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Tests of per-site rate limiting and suppressed message reports
+ *
+ * @version 0.1
+ * @date 2023-09-22
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+#include "TestRunner.h"
+#include "TestUtils.h"
+#include "mklog/LogManager.h"
+#include "mklog/Logger.h"
+#include "mklog/RateLimiter.h"
+#include "mklog/writers/TextLogWriter.h"
+
+using mklog::LogManager;
+using mklog::Logger;
+using mklog::MessageContentType;
+using mklog::MessageSeverity;
+using mklog::RateLimiter;
+
+static constexpr int MESSAGE_COUNT = 1000;
+
+static constexpr uint32_t BURST = 10;
+
+/// Much fewer messages than issued pass within one second
+static constexpr RateLimiter::Policy POLICY_STRICT = {
+    .messagesPerSecond = 1,
+    .burst             = BURST,
+};
+
+static void setupLimitedLogs(bool isAsync)
+{
+  if (isAsync)
+  {
+    LogManager::useAsyncDispatch();
+  }
+  RateLimiter::setPolicy(POLICY_STRICT);
+  LogManager::addWriter<mklog::TextLogWriter>().setFile("log.txt");
+  LogManager::initLogs();
+}
+
+/**
+ * @brief Sum numbers of messages reported as suppressed in log
+ */
+static size_t sumSuppressed(const char* log)
+{
+  static const char PREFIX[] = "\tsuppressed ";
+
+  size_t sum = 0;
+  for (const char* found = strstr(log, PREFIX); found != nullptr;
+       found             = strstr(found + 1, PREFIX))
+  {
+    sum += strtoull(found + sizeof(PREFIX) - 1, nullptr, 10);
+  }
+  return sum;
+}
+
+/**
+ * @brief Check that messages logged from single site are either written or
+ * reported as suppressed
+ */
+static void checkSuppressed(const char* log, size_t passedCountMax)
+{
+  const size_t passedCount = mklog::test::countOccurrences(log, "\tmessage ");
+  test_assert(BURST <= passedCount && passedCount <= passedCountMax);
+  test_assert(passedCount + sumSuppressed(log) == MESSAGE_COUNT);
+  test_assert(strstr(log, " messages from RateLimitTest.cpp:") !=
+              nullptr);
+}
+
+static void logLimitedMessages(bool isAsync)
+{
+  setupLimitedLogs(isAsync);
+
+  Logger logger("limited");
+  for (int i = 0; i < MESSAGE_COUNT; ++i)
+  {
+    logger.LOG_INFO(MessageContentType::TEXT, "message %d", i);
+  }
+}
+
+TEST_CASE(rateLimitPassesBurst)
+{
+  test_assert(mklog::test::runProcess([]() { logLimitedMessages(false); }) ==
+              0);
+
+  // Site stays quiet after burst, so drops are reported on exit
+  std::string log;
+  test_assert(mklog::test::readFile("log.txt", log));
+  checkSuppressed(log.data(), BURST + 1);
+  test_assert(strstr(log.data(), "] 'mklog' in ") != nullptr);
+}
+
+TEST_CASE(rateLimitPassesBurstAsync)
+{
+  test_assert(mklog::test::runProcess([]() { logLimitedMessages(true); }) ==
+              0);
+
+  std::string log;
+  test_assert(mklog::test::readFile("log.txt", log));
+  checkSuppressed(log.data(), BURST + 1);
+}
+
+TEST_CASE(rateLimitDropsLongMessages)
+{
+  const int exitCode = mklog::test::runProcess([]() {
+    setupLimitedLogs(false);
+
+    Logger logger("limited");
+    for (int i = 0; i < MESSAGE_COUNT; ++i)
+    {
+      mklog::LongMessage message =
+          logger.LOG_LONG_INFO(MessageContentType::TEXT, "message %d", i);
+      if (message.isOpen())
+      {
+        message.printf("content %d\n", i);
+      }
+    }
+  });
+  test_assert(exitCode == 0);
+
+  std::string log;
+  test_assert(mklog::test::readFile("log.txt", log));
+  checkSuppressed(log.data(), BURST + 1);
+  test_assert(mklog::test::countOccurrences(log.data(), "\ncontent ") ==
+              mklog::test::countOccurrences(log.data(), "\tmessage "));
+}
+
+TEST_CASE(rateLimitDropsStreamedMessages)
+{
+  const int exitCode = mklog::test::runProcess([]() {
+    setupLimitedLogs(false);
+
+    Logger logger("limited");
+    for (int i = 0; i < MESSAGE_COUNT; ++i)
+    {
+      LogManager::MessageFd fd =
+          logger.LOG_BEGIN_INFO(MessageContentType::TEXT, "message %d", i);
+      if (fd != LogManager::MESSAGE_FD_INVALID)
+      {
+        dprintf(fd, "content %d\n", i);
+      }
+      logger.endLongMessage(fd);
+    }
+  });
+  test_assert(exitCode == 0);
+
+  std::string log;
+  test_assert(mklog::test::readFile("log.txt", log));
+  checkSuppressed(log.data(), BURST + 1);
+  test_assert(mklog::test::countOccurrences(log.data(), "\ncontent ") ==
+              mklog::test::countOccurrences(log.data(), "\tmessage "));
+}
+
+TEST_CASE(rateLimitReportsBeforeNextMessage)
+{
+  const int exitCode = mklog::test::runProcess([]() {
+    setupLimitedLogs(false);
+
+    Logger logger("limited");
+    for (int i = 0; i < MESSAGE_COUNT; ++i)
+    {
+      logger.LOG_INFO(MessageContentType::TEXT, "message %d", i);
+      if (i == MESSAGE_COUNT / 2)
+      {
+        // Refill one token
+        usleep(1100 * 1000);
+      }
+    }
+  });
+  test_assert(exitCode == 0);
+
+  std::string log;
+  test_assert(mklog::test::readFile("log.txt", log));
+  checkSuppressed(log.data(), BURST + 3);
+
+  // Drops before sleep are reported by logger of site, later ones on exit
+  test_assert(mklog::test::countOccurrences(log.data(), "\tsuppressed ") ==
+              2);
+  test_assert(mklog::test::countOccurrences(log.data(), "] 'mklog' in ") == 1);
+}
+
+TEST_CASE(rateLimitSkipsArgumentsOfDroppedMessages)
+{
+  static int s_evaluatedCount = 0;
+
+  const int exitCode = mklog::test::runProcess([]() {
+    setupLimitedLogs(false);
+
+    Logger logger("limited");
+    for (int i = 0; i < MESSAGE_COUNT; ++i)
+    {
+      logger.LOG_INFO(MessageContentType::TEXT, "message %d",
+                      ++s_evaluatedCount);
+    }
+
+    // Other severities and sites have separate limits
+    RateLimiter::setPolicy(MessageSeverity::ERROR, RateLimiter::POLICY_NONE);
+    for (int i = 0; i < MESSAGE_COUNT; ++i)
+    {
+      logger.LOG_ERROR(MessageContentType::TEXT, "error %d", i);
+    }
+    logger.LOG_INFO(MessageContentType::TEXT, "evaluated %d",
+                    s_evaluatedCount);
+  });
+  test_assert(exitCode == 0);
+
+  std::string log;
+  test_assert(mklog::test::readFile("log.txt", log));
+  test_assert(mklog::test::countOccurrences(log.data(), "\terror ") ==
+              MESSAGE_COUNT);
+
+  char evaluated[32] = "";
+  snprintf(evaluated, sizeof(evaluated), "\tevaluated %zu\n",
+           mklog::test::countOccurrences(log.data(), "\tmessage "));
+  test_assert(strstr(log.data(), evaluated) != nullptr);
+}
@@ -0,0 +1,215 @@
+/**
+ * @file RotationTest.cpp
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Tests of log files rotated into segments
+ *
+ * @version 0.1
+ * @date 2023-09-22
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "TestRunner.h"
+#include "TestUtils.h"
+#include "mklog/LogManager.h"
+#include "mklog/Logger.h"
+#include "mklog/writers/HtmlLogWriter.h"
+#include "mklog/writers/TextLogWriter.h"
+
+using mklog::BufferedFileSink;
+using mklog::LogManager;
+using mklog::Logger;
+using mklog::MessageContentType;
+
+static constexpr int MESSAGE_COUNT = 20000;
+
+static constexpr uint64_t SEGMENT_SIZE = 32 * 1024;
+
+/// Flush often, so that segments stay close to size limit
+static constexpr BufferedFileSink::FlushPolicy FLUSH_POLICY_EAGER = {
+    .bufferSize    = 4096,
+    .maxAgeMs      = 100,
+    .flushSeverity = mklog::MessageSeverity::ERROR,
+};
+
+static void logNumberedMessages()
+{
+  Logger logger("rotation");
+  for (int i = 0; i < MESSAGE_COUNT; ++i)
+  {
+    logger.LOG_INFO(MessageContentType::TEXT, "message %d", i);
+  }
+}
+
+/**
+ * @brief Read log segment, decompressing it if it is gzip file
+ */
+static void readSegment(const char* filename, std::string& content)
+{
+  const size_t nameLen = strlen(filename);
+  if (nameLen < 3 || strcmp(filename + nameLen - 3, ".gz") != 0)
+  {
+    test_assert(mklog::test::readFile(filename, content));
+    return;
+  }
+
+  content.clear();
+  gzFile file = gzopen(filename, "rb");
+  test_assert(file != nullptr);
+
+  char chunk[BUFSIZ] = "";
+  int  readLen       = 0;
+  while ((readLen = gzread(file, chunk, sizeof(chunk))) > 0)
+  {
+    content.append(chunk, (size_t)readLen);
+  }
+
+  test_assert(readLen == 0);
+  gzclose(file);
+}
+
+/**
+ * @brief Check that numbered messages are split between current file and
+ * its rotated segments, each message written exactly once
+ *
+ * @param[in] baseName        File name without extension
+ * @param[in] extension       File extension, including dot
+ * @param[in] messagePrefix   Text preceding message number in record
+ * @param[in] segmentMarker   Text expected once in each rotated segment,
+ *                            may be `nullptr`
+ * @param[in] isCompressed    Rotated segments are expected to be compressed
+ */
+static void checkSegments(const char* baseName, const char* extension,
+                          const char* messagePrefix, const char* segmentMarker,
+                          bool isCompressed)
+{
+  bool* const seen = new bool[MESSAGE_COUNT]();
+
+  DIR* const dir = opendir(".");
+  test_assert(dir != nullptr);
+
+  std::string segment;
+  size_t                   segmentCount    = 0;
+  size_t                   compressedCount = 0;
+  const size_t             baseLen         = strlen(baseName);
+  for (const dirent* entry = readdir(dir); entry != nullptr;
+       entry               = readdir(dir))
+  {
+    if (strncmp(entry->d_name, baseName, baseLen) != 0 ||
+        strstr(entry->d_name, extension) == nullptr)
+      continue;
+
+    readSegment(entry->d_name, segment);
+    ++segmentCount;
+    if (strstr(entry->d_name, ".gz") != nullptr)
+      ++compressedCount;
+
+    const bool isRotated = strcmp(entry->d_name + baseLen, extension) != 0;
+    if (isRotated && segmentMarker != nullptr)
+    {
+      test_assert(mklog::test::countOccurrences(segment.data(),
+                                                segmentMarker) == 1);
+    }
+
+    // Segment never starts or ends in the middle of record
+    test_assert(segment.length() == 0 || segment.data()[0] == '<');
+    test_assert(segment.length() == 0 ||
+                segment.data()[segment.length() - 1] == '\n');
+
+    const size_t prefixLen = strlen(messagePrefix);
+    for (const char* found = strstr(segment.data(), messagePrefix);
+         found != nullptr; found = strstr(found + prefixLen, messagePrefix))
+    {
+      const int number = atoi(found + prefixLen);
+      test_assert(0 <= number && number < MESSAGE_COUNT);
+      test_assert(!seen[number]);
+      seen[number] = true;
+    }
+  }
+  closedir(dir);
+
+  for (int i = 0; i < MESSAGE_COUNT; ++i)
+  {
+    test_assert(seen[i]);
+  }
+  delete[] seen;
+
+  // About one segment per size limit
+  const size_t segmentCountMin = MESSAGE_COUNT * 64 / SEGMENT_SIZE;
+  test_assert(segmentCount >= segmentCountMin);
+  test_assert((compressedCount > 0) == isCompressed);
+}
+
+TEST_CASE(rotationSplitsTextLogBySize)
+{
+  const int exitCode = mklog::test::runProcess([]() {
+    LogManager::addWriter<mklog::TextLogWriter>()
+        .setFlushPolicy(FLUSH_POLICY_EAGER)
+        .setRotationPolicy({
+            .maxSize      = SEGMENT_SIZE,
+            .intervalSec  = 0,
+            .isCompressed = false,
+        })
+        .setFile("log.txt");
+    LogManager::initLogs();
+
+    logNumberedMessages();
+  });
+  test_assert(exitCode == 0);
+  checkSegments("log", ".txt", "\tmessage ", nullptr, false);
+}
+
+TEST_CASE(rotationSplitsHtmlLogBySize)
+{
+  const int exitCode = mklog::test::runProcess([]() {
+    LogManager::useAsyncDispatch();
+    LogManager::addWriter<mklog::HtmlLogWriter>()
+        .setFlushPolicy(FLUSH_POLICY_EAGER)
+        .setRotationPolicy({
+            .maxSize      = SEGMENT_SIZE,
+            .intervalSec  = 0,
+            .isCompressed = false,
+        })
+        .setFile("log.html");
+    LogManager::initLogs();
+
+    logNumberedMessages();
+  });
+  test_assert(exitCode == 0);
+
+  // Every rotated segment is complete document, current file is left open
+  // for appending
+  checkSegments("log", ".html", ">message ", "<body><pre>", false);
+  checkSegments("log", ".html", ">message ", "</pre></body>\n", false);
+}
+
+TEST_CASE(rotationCompressesSegments)
+{
+  const int exitCode = mklog::test::runProcess([]() {
+    LogManager::addWriter<mklog::TextLogWriter>()
+        .setFlushPolicy(FLUSH_POLICY_EAGER)
+        .setRotationPolicy({
+            .maxSize      = SEGMENT_SIZE,
+            .intervalSec  = 0,
+            .isCompressed = true,
+        })
+        .setFile("log.txt");
+    LogManager::initLogs();
+
+    logNumberedMessages();
+
+    // Let compressor finish queued segments
+    usleep(500 * 1000);
+  });
+  test_assert(exitCode == 0);
+
+  // Segments not queued for compression are left as is
+  checkSegments("log", ".txt", "\tmessage ", nullptr, true);
+}
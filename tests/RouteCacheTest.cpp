@@ -0,0 +1,124 @@
+/**
+ * @file RouteCacheTest.cpp
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Tests of routing decisions cached in log sites
+ *
+ * @version 0.1
+ * @date 2023-09-22
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#include <cstring>
+
+#include "TestRunner.h"
+#include "TestUtils.h"
+#include "mklog/LogManager.h"
+#include "mklog/LogRoute.h"
+#include "mklog/LogRoutingRule.h"
+#include "mklog/Logger.h"
+#include "mklog/writers/TextLogWriter.h"
+
+using mklog::LogManager;
+using mklog::LogRoute;
+using mklog::Logger;
+using mklog::MessageContentType;
+using mklog::MessageSeverity;
+
+/**
+ * @brief Route messages of single logger. Cannot be decided per site
+ */
+class LoggerRoutingRule : public mklog::LogRoutingRule
+{
+private:
+  const char* loggerName;
+
+public:
+  explicit LoggerRoutingRule(const char* loggerName) : loggerName(loggerName)
+  {
+  }
+
+  // No copying
+  LoggerRoutingRule(const LoggerRoutingRule&)            = delete;
+  LoggerRoutingRule& operator=(const LoggerRoutingRule&) = delete;
+
+  bool matchMessage(const mklog::LogMessage& message) const override
+  {
+    return strcmp(message.source.logger, loggerName) == 0;
+  }
+};
+
+/**
+ * @brief Issue INFO message from the same log site every time
+ */
+static void logFromSite(Logger& logger, const char* text)
+{
+  logger.LOG_INFO(MessageContentType::TEXT, "%s", text);
+}
+
+/**
+ * @brief Check if log file has message content
+ */
+static bool hasMessage(const char* filename, const char* text)
+{
+  LogManager::flushMessages();
+
+  std::string log;
+  mklog::utils::TextBuffer line;
+  line.appendf("\t%s\n", text);
+
+  return mklog::test::readFile(filename, log) &&
+         strstr(log.data(), line.data()) != nullptr;
+}
+
+TEST_CASE(routeCacheFollowsConfigurationChanges)
+{
+  auto& warnings = LogManager::addWriter<mklog::TextLogWriter>();
+  warnings.setFile("warnings.txt")
+      .setRoute(LogRoute::makeRoute<mklog::SeverityRoutingRule>(
+          MessageSeverity::WARNING));
+  auto& all = LogManager::addWriter<mklog::TextLogWriter>().setFile("all.txt");
+  LogManager::initLogs();
+
+  Logger logger("cache");
+
+  logFromSite(logger, "first");
+  test_assert(hasMessage("all.txt", "first"));
+  test_assert(!hasMessage("warnings.txt", "first"));
+
+  // Changed route invalidates decision cached by the first message
+  warnings.setRoute(LogRoute::makeRoute<mklog::DefaultRoutingRule>());
+  logFromSite(logger, "second");
+  test_assert(hasMessage("warnings.txt", "second"));
+  test_assert(hasMessage("all.txt", "second"));
+
+  LogManager::removeWriter(all);
+  logFromSite(logger, "third");
+  test_assert(hasMessage("warnings.txt", "third"));
+  test_assert(!hasMessage("all.txt", "third"));
+
+  LogManager::addWriter<mklog::TextLogWriter>().setFile("late.txt");
+  logFromSite(logger, "fourth");
+  test_assert(hasMessage("warnings.txt", "fourth"));
+  test_assert(hasMessage("late.txt", "fourth"));
+}
+
+TEST_CASE(routeCacheChecksMessageDependentRoutes)
+{
+  LogManager::addWriter<mklog::TextLogWriter>()
+      .setFile("chosen.txt")
+      .setRoute(LogRoute::makeRoute<LoggerRoutingRule>("chosen"));
+  LogManager::initLogs();
+
+  Logger chosen("chosen");
+  Logger other("other");
+
+  // Both messages come from the same site
+  logFromSite(chosen, "from chosen");
+  logFromSite(other, "from other");
+  logFromSite(chosen, "again from chosen");
+
+  test_assert(hasMessage("chosen.txt", "from chosen"));
+  test_assert(hasMessage("chosen.txt", "again from chosen"));
+  test_assert(!hasMessage("chosen.txt", "from other"));
+}
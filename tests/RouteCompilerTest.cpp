@@ -0,0 +1,152 @@
+/**
+ * @file RouteCompilerTest.cpp
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Tests of route trees compiled into predicate programs
+ *
+ * @version 0.1
+ * @date 2023-09-22
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#include "TestRunner.h"
+#include "mklog/LogRoute.h"
+#include "mklog/LogRoutingRule.h"
+#include "mklog/RouteCompiler.h"
+
+using mklog::CompiledRoute;
+using mklog::LogMessage;
+using mklog::LogRoute;
+using mklog::LogSite;
+using mklog::MessageContentType;
+using mklog::MessageSeverity;
+using mklog::RuleMatch;
+
+/**
+ * @brief Route messages issued from odd lines. Cannot be decided by
+ * severity and content type
+ */
+class OddLineRoutingRule : public mklog::LogRoutingRule
+{
+public:
+  bool matchMessage(const LogMessage& message) const override
+  {
+    return message.source.line % 2 == 1;
+  }
+
+  RuleMatch matchSite(const LogSite& site, MessageContentType) const override
+  {
+    return site.line % 2 == 1 ? RuleMatch::ALWAYS : RuleMatch::NEVER;
+  }
+};
+
+/**
+ * @brief Check that compiled route agrees with route tree on messages with
+ * every severity, content type and line parity
+ */
+static void checkCompiledRoute(const LogRoute& route)
+{
+  CompiledRoute compiled;
+  compiled.compile(route);
+
+  static constexpr int SEVERITY_COUNT =
+      (int)MessageSeverity::MAX_LEVEL + 1;
+  static constexpr int CONTENT_TYPE_COUNT =
+      (int)MessageContentType::MAX_TYPE + 1;
+
+  for (int severity = 0; severity < SEVERITY_COUNT; ++severity)
+  {
+    for (int type = 0; type < CONTENT_TYPE_COUNT; ++type)
+    {
+      LogMessage message = {
+          .severity    = (MessageSeverity)severity,
+          .source      = {.file     = "route.cpp",
+                          .function = "checkCompiledRoute",
+                          .line     = 0,
+                          .logger   = "route"},
+          .contentType = (MessageContentType)type,
+      };
+      const RuleMatch attributeMatch =
+          compiled.matchAttributes(message.severity, message.contentType);
+
+      for (size_t line = 1; line <= 2; ++line)
+      {
+        message.source.line = line;
+
+        const bool isMatched = route.matchMessage(message);
+        test_assert(compiled.matchMessage(message) == isMatched);
+        test_assert(attributeMatch != RuleMatch::ALWAYS || isMatched);
+        test_assert(attributeMatch != RuleMatch::NEVER || !isMatched);
+
+        const LogSite site = {.file     = message.source.file,
+                              .function = message.source.function,
+                              .line     = line,
+                              .severity = message.severity,
+                              .format   = nullptr};
+        const RuleMatch siteMatch =
+            compiled.matchSite(site, message.contentType);
+        test_assert(siteMatch == (isMatched ? RuleMatch::ALWAYS
+                                            : RuleMatch::NEVER));
+      }
+    }
+  }
+}
+
+TEST_CASE(routeCompilerMatchesRouteTrees)
+{
+  const LogRoute warning = LogRoute::makeRoute<mklog::SeverityRoutingRule>(
+      MessageSeverity::WARNING);
+  const LogRoute debug = LogRoute::makeRoute<mklog::SeverityRoutingRule>(
+      MessageSeverity::DEBUG);
+  const LogRoute code = LogRoute::makeRoute<mklog::ContentTypeRoutingRule>(
+      MessageContentType::CODE);
+  const LogRoute text = LogRoute::makeRoute<mklog::ContentTypeRoutingRule>(
+      MessageContentType::TEXT);
+  const LogRoute oddLine = LogRoute::makeRoute<OddLineRoutingRule>();
+  const LogRoute all     = LogRoute::makeRoute<mklog::DefaultRoutingRule>();
+
+  checkCompiledRoute(all);
+  checkCompiledRoute(warning);
+  checkCompiledRoute(oddLine);
+  checkCompiledRoute(!all);
+  checkCompiledRoute(warning && code);
+  checkCompiledRoute(warning || !text);
+  checkCompiledRoute(!(debug && !warning) && (code || text));
+  checkCompiledRoute(oddLine && warning);
+  checkCompiledRoute(oddLine || code);
+  checkCompiledRoute(!oddLine && (debug || code));
+  checkCompiledRoute((oddLine && text) || (!oddLine && !warning));
+  checkCompiledRoute(!(!(oddLine || debug) && !(text && warning)));
+}
+
+TEST_CASE(routeCompilerFoldsAttributeRules)
+{
+  const LogRoute warning = LogRoute::makeRoute<mklog::SeverityRoutingRule>(
+      MessageSeverity::WARNING);
+  const LogRoute code = LogRoute::makeRoute<mklog::ContentTypeRoutingRule>(
+      MessageContentType::CODE);
+
+  // Routes depending only on severity and content type need no program
+  CompiledRoute compiled;
+  compiled.compile((warning && !code) || (!warning && code));
+  test_assert(compiled.matchAttributes(MessageSeverity::ERROR,
+                                       MessageContentType::TEXT) ==
+              RuleMatch::ALWAYS);
+  test_assert(compiled.matchAttributes(MessageSeverity::ERROR,
+                                       MessageContentType::CODE) ==
+              RuleMatch::NEVER);
+  test_assert(compiled.matchAttributes(MessageSeverity::INFO,
+                                       MessageContentType::CODE) ==
+              RuleMatch::ALWAYS);
+
+  for (int severity = 0; severity <= (int)MessageSeverity::MAX_LEVEL;
+       ++severity)
+  {
+    for (int type = 0; type <= (int)MessageContentType::MAX_TYPE; ++type)
+    {
+      test_assert(compiled.matchAttributes((MessageSeverity)severity,
+                                           (MessageContentType)type) !=
+                  RuleMatch::MAYBE);
+    }
+  }
+}
@@ -0,0 +1,186 @@
+/**
+ * @file SamplingTest.cpp
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Tests of sampled logging macros
+ *
+ * @version 0.1
+ * @date 2023-09-22
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <unistd.h>
+
+#include "TestRunner.h"
+#include "TestUtils.h"
+#include "mklog/LogManager.h"
+#include "mklog/LogRoute.h"
+#include "mklog/LogRoutingRule.h"
+#include "mklog/Logger.h"
+#include "mklog/writers/TextLogWriter.h"
+
+using mklog::LogManager;
+using mklog::Logger;
+using mklog::MessageContentType;
+using mklog::MessageSeverity;
+
+static constexpr int OCCURRENCE_COUNT = 1000;
+
+static int s_evaluatedCount = 0;
+
+static int countEvaluation(int value)
+{
+  ++s_evaluatedCount;
+  return value;
+}
+
+/**
+ * @brief Flush messages and read log file
+ */
+static void readLog(std::string& log)
+{
+  LogManager::flushMessages();
+  test_assert(mklog::test::readFile("log.txt", log));
+}
+
+TEST_CASE(samplingLogsEveryNthOccurrence)
+{
+  LogManager::addWriter<mklog::TextLogWriter>().setFile("log.txt");
+  LogManager::initLogs();
+
+  Logger logger("sampled");
+  for (int i = 0; i < OCCURRENCE_COUNT; ++i)
+  {
+    logger.LOG_EVERY_N(INFO, 10, MessageContentType::TEXT, "every %d",
+                       countEvaluation(i));
+  }
+
+  // Period of one passes every occurrence
+  for (int i = 0; i < 5; ++i)
+  {
+    logger.LOG_EVERY_N(INFO, 1, MessageContentType::TEXT, "always %d", i);
+  }
+
+  std::string log;
+  readLog(log);
+  test_assert(s_evaluatedCount == OCCURRENCE_COUNT / 10);
+  test_assert(mklog::test::countOccurrences(log.data(), "\tevery ") ==
+              OCCURRENCE_COUNT / 10);
+  test_assert(strstr(log.data(), "\tevery 0\n") != nullptr);
+  test_assert(strstr(log.data(), "\tevery 10\n") != nullptr);
+  test_assert(strstr(log.data(), "\tevery 990\n") != nullptr);
+  test_assert(strstr(log.data(), "\tevery 5\n") == nullptr);
+  test_assert(mklog::test::countOccurrences(log.data(), "\talways ") == 5);
+}
+
+TEST_CASE(samplingLogsFirstOccurrences)
+{
+  LogManager::addWriter<mklog::TextLogWriter>().setFile("log.txt");
+  LogManager::initLogs();
+
+  Logger logger("sampled");
+  for (int i = 0; i < OCCURRENCE_COUNT; ++i)
+  {
+    logger.LOG_FIRST_N(WARNING, 5, MessageContentType::TEXT, "first %d",
+                       countEvaluation(i));
+  }
+
+  std::string log;
+  readLog(log);
+  test_assert(s_evaluatedCount == 5);
+  test_assert(mklog::test::countOccurrences(log.data(), "\tfirst ") == 5);
+  test_assert(strstr(log.data(), "\tfirst 4\n") != nullptr);
+  test_assert(strstr(log.data(), "\tfirst 5\n") == nullptr);
+}
+
+TEST_CASE(samplingLogsOncePerPeriod)
+{
+  LogManager::addWriter<mklog::TextLogWriter>().setFile("log.txt");
+  LogManager::initLogs();
+
+  // About five periods, message is reached many times in each
+  Logger logger("sampled");
+  for (int i = 0; i < 100; ++i)
+  {
+    logger.LOG_EVERY_T(INFO, 0.2, MessageContentType::TEXT, "periodic %d",
+                       countEvaluation(i));
+    usleep(10 * 1000);
+  }
+
+  std::string log;
+  readLog(log);
+  const size_t loggedCount =
+      mklog::test::countOccurrences(log.data(), "\tperiodic ");
+  test_assert(4 <= loggedCount && loggedCount <= 7);
+  test_assert((size_t)s_evaluatedCount == loggedCount);
+  test_assert(strstr(log.data(), "\tperiodic 0\n") != nullptr);
+  test_assert(strstr(log.data(), "\tperiodic 1\n") == nullptr);
+}
+
+TEST_CASE(samplingCountsSharedSiteAcrossThreads)
+{
+  static constexpr int THREAD_COUNT = 4;
+
+  LogManager::addWriter<mklog::TextLogWriter>().setFile("log.txt");
+  LogManager::initLogs();
+
+  std::thread threads[THREAD_COUNT];
+  for (std::thread& thread : threads)
+  {
+    thread = std::thread([]() {
+      Logger logger("sampled");
+      for (int i = 0; i < OCCURRENCE_COUNT; ++i)
+      {
+        logger.LOG_EVERY_N(INFO, 10, MessageContentType::TEXT, "shared %d",
+                           i);
+      }
+    });
+  }
+  for (std::thread& thread : threads)
+  {
+    thread.join();
+  }
+
+  std::string log;
+  readLog(log);
+  test_assert(mklog::test::countOccurrences(log.data(), "\tshared ") ==
+              THREAD_COUNT * OCCURRENCE_COUNT / 10);
+}
+
+/**
+ * @brief Reach the same `LOG_FIRST_N` site given number of times
+ */
+static void reachFirstSite(Logger& logger, int from, int to)
+{
+  for (int i = from; i < to; ++i)
+  {
+    logger.LOG_FIRST_N(INFO, 3, MessageContentType::TEXT, "counted %d", i);
+  }
+}
+
+TEST_CASE(samplingSkipsRejectedOccurrences)
+{
+  mklog::TextLogWriter& writer =
+      LogManager::addWriter<mklog::TextLogWriter>().setFile("rejected.txt");
+  writer.setRoute(mklog::LogRoute::makeRoute<mklog::SeverityRoutingRule>(
+      MessageSeverity::WARNING));
+  LogManager::initLogs();
+
+  // Occurrences are not counted while no writer accepts message
+  Logger logger("sampled");
+  reachFirstSite(logger, 0, 10);
+
+  auto* accepting = new mklog::TextLogWriter();
+  accepting->setFile("log.txt");
+  LogManager::replaceWriter(writer, accepting);
+  reachFirstSite(logger, 10, 20);
+
+  std::string log;
+  readLog(log);
+  test_assert(mklog::test::countOccurrences(log.data(), "\tcounted ") == 3);
+  test_assert(strstr(log.data(), "\tcounted 10\n") != nullptr);
+  test_assert(strstr(log.data(), "\tcounted 12\n") != nullptr);
+}
@@ -0,0 +1,136 @@
+/**
+ * @file SpliceTest.cpp
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Tests of long message content spliced from pipes into log files
+ *
+ * @version 0.1
+ * @date 2023-09-22
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#include <cstdio>
+#include <cstring>
+
+#include "TestRunner.h"
+#include "TestUtils.h"
+#include "mklog/LogManager.h"
+#include "mklog/Logger.h"
+#include "mklog/writers/HtmlLogWriter.h"
+#include "mklog/writers/TextLogWriter.h"
+
+using mklog::LogManager;
+using mklog::Logger;
+using mklog::MessageContentType;
+
+/// Lines written to long message pipe, several parts in total
+static constexpr int LINE_COUNT = 5000;
+
+/**
+ * @brief Write numbered lines to long message pipe, along with short
+ * message which fits into single part
+ */
+static void logPipedLines()
+{
+  Logger logger("splice");
+
+  LogManager::MessageFd fd =
+      logger.LOG_BEGIN_INFO(MessageContentType::TEXT, "short");
+  dprintf(fd, "short content\n");
+  logger.endLongMessage(fd);
+
+  fd = logger.LOG_BEGIN_INFO(MessageContentType::TEXT, "lines");
+  for (int i = 0; i < LINE_COUNT; ++i)
+  {
+    dprintf(fd, "line %06d\n", i);
+  }
+  logger.endLongMessage(fd);
+}
+
+/**
+ * @brief Check that log file has piped lines in order, each exactly once
+ */
+static void checkPipedLines(const char* filename)
+{
+  std::string log;
+  test_assert(mklog::test::readFile(filename, log));
+  test_assert(strstr(log.data(), "\tshort\nshort content\n") != nullptr);
+
+  char        line[32] = "";
+  const char* cur      = log.data();
+  for (int i = 0; i < LINE_COUNT; ++i)
+  {
+    snprintf(line, sizeof(line), "line %06d\n", i);
+    cur = strstr(cur, line);
+    test_assert(cur != nullptr);
+  }
+  test_assert(mklog::test::countOccurrences(log.data(), "line ") ==
+              LINE_COUNT);
+}
+
+TEST_CASE(spliceMovesPipedContent)
+{
+  const int exitCode = mklog::test::runProcess([]() {
+    LogManager::addWriter<mklog::TextLogWriter>()
+        .setSpliceEnabled(true)
+        .setFile("log.txt");
+    LogManager::initLogs();
+
+    logPipedLines();
+  });
+  test_assert(exitCode == 0);
+  checkPipedLines("log.txt");
+}
+
+TEST_CASE(spliceSharesContentBetweenWriters)
+{
+  const int exitCode = mklog::test::runProcess([]() {
+    // Content is duplicated for the second splicing writer and copied to
+    // memory for HTML writer
+    LogManager::addWriter<mklog::TextLogWriter>()
+        .setSpliceEnabled(true)
+        .setFile("first.txt");
+    LogManager::addWriter<mklog::TextLogWriter>()
+        .setSpliceEnabled(true)
+        .setFile("second.txt");
+    LogManager::addWriter<mklog::HtmlLogWriter>().setFile("log.html");
+    LogManager::initLogs();
+
+    logPipedLines();
+  });
+  test_assert(exitCode == 0);
+  checkPipedLines("first.txt");
+  checkPipedLines("second.txt");
+
+  std::string html;
+  test_assert(mklog::test::readFile("log.html", html));
+  test_assert(mklog::test::countOccurrences(html.data(), "line ") ==
+              LINE_COUNT);
+}
+
+TEST_CASE(spliceKeepsRecordsInOrder)
+{
+  const int exitCode = mklog::test::runProcess([]() {
+    LogManager::addWriter<mklog::TextLogWriter>()
+        .setSpliceEnabled(true)
+        .setFile("log.txt");
+    LogManager::initLogs();
+
+    // Buffered records must be written before spliced content
+    Logger logger("splice");
+    logger.LOG_INFO(MessageContentType::TEXT, "before");
+    logPipedLines();
+    logger.LOG_INFO(MessageContentType::TEXT, "after");
+  });
+  test_assert(exitCode == 0);
+  checkPipedLines("log.txt");
+
+  std::string log;
+  test_assert(mklog::test::readFile("log.txt", log));
+  const char* before = strstr(log.data(), "\tbefore\n");
+  const char* first  = strstr(log.data(), "line 000000\n");
+  const char* last   = strstr(log.data(), "line 004999\n");
+  const char* after  = strstr(log.data(), "\tafter\n");
+  test_assert(before != nullptr && before < first);
+  test_assert(last != nullptr && last < after);
+}
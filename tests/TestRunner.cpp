@@ -0,0 +1,135 @@
+#include "TestRunner.h"
+
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ftw.h>
+#include <libgen.h>
+#include <unistd.h>
+
+#include "TestUtils.h"
+
+namespace mklog
+{
+namespace test
+{
+
+TestCase* TestRegistry::s_first = nullptr;
+TestCase* TestRegistry::s_last  = nullptr;
+
+bool TestRegistry::add(TestCase* testCase)
+{
+  if (s_last != nullptr)
+  {
+    s_last->next = testCase;
+  }
+  else
+  {
+    s_first = testCase;
+  }
+  s_last = testCase;
+
+  return true;
+}
+
+void failAssertion(const char* condition, const char* file, int line,
+                   const char* function)
+{
+  dprintf(STDERR_FILENO,
+          "Failed assertion '%s'\n\tat %s:%d in function '%s'\n", condition,
+          file, line, function);
+  abort();
+}
+
+} // namespace test
+} // namespace mklog
+
+/**
+ * @brief Leave crash signals to LogManager, so that tests see processes
+ * killed by them. Read only by AddressSanitizer builds
+ */
+extern "C" const char* __asan_default_options()
+{
+  return "handle_segv=0:handle_sigbus=0:handle_sigfpe=0:handle_sigill=0";
+}
+
+/// Test process is killed if it runs longer than this
+static constexpr unsigned TEST_TIMEOUT_SEC = 120;
+
+static int removeEntry(const char* path, const struct stat*, int,
+                       struct FTW*)
+{
+  remove(path);
+  return 0;
+}
+
+/**
+ * @brief Run test case in child process inside temporary directory
+ *
+ * @return `true` if test passed, `false` otherwise
+ */
+static bool runTestCase(const mklog::test::TestCase& testCase)
+{
+  char dir[] = "/tmp/meerkat_logs_test_XXXXXX";
+  if (mkdtemp(dir) == nullptr)
+  {
+    perror("mkdtemp");
+    return false;
+  }
+
+  fflush(stdout);
+  const pid_t pid = fork();
+  if (pid == 0)
+  {
+    alarm(TEST_TIMEOUT_SEC);
+    if (chdir(dir) != 0)
+    {
+      _exit(1);
+    }
+
+    testCase.run();
+    exit(0);
+  }
+
+  const int exitCode = mklog::test::waitForProcess(pid);
+  nftw(dir, &removeEntry, 16, FTW_DEPTH | FTW_PHYS);
+
+  return exitCode == 0;
+}
+
+/**
+ * @brief Run all test cases whose names contain the first argument
+ */
+int main(int argc, char** argv)
+{
+  const char* filter = argc > 1 ? argv[1] : "";
+
+  char binaryPath[PATH_MAX] = "";
+  if (realpath(argv[0], binaryPath) != nullptr)
+  {
+    char toolDir[PATH_MAX + 8] = "";
+    snprintf(toolDir, sizeof(toolDir), "%s/tools", dirname(binaryPath));
+    mklog::test::setToolDir(toolDir);
+  }
+
+  size_t testCount   = 0;
+  size_t failedCount = 0;
+  for (const mklog::test::TestCase* testCase =
+           mklog::test::TestRegistry::getFirst();
+       testCase != nullptr; testCase = testCase->next)
+  {
+    if (strstr(testCase->name, filter) == nullptr)
+      continue;
+
+    const bool passed = runTestCase(*testCase);
+    printf("[%s] %s\n", passed ? "  OK  " : " FAIL ", testCase->name);
+
+    ++testCount;
+    if (!passed)
+      ++failedCount;
+  }
+
+  printf("%zu of %zu tests passed\n", testCount - failedCount, testCount);
+  return failedCount == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
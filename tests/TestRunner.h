@@ -0,0 +1,92 @@
+/**
+ * @file TestRunner.h
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Registry of test cases and assertions used by them
+ *
+ * @version 0.1
+ * @date 2023-09-22
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#ifndef __MEERKAT_LOGS_TESTS_TESTRUNNER_H
+#define __MEERKAT_LOGS_TESTS_TESTRUNNER_H
+
+namespace mklog
+{
+namespace test
+{
+
+/**
+ * @brief Test case registered by `TEST_CASE()`. Every test case runs in its
+ * own process, so that it starts with fresh `LogManager`, and inside its
+ * own empty working directory, removed after test
+ */
+struct TestCase
+{
+  const char* name;
+  void (*run)(void);
+  TestCase* next;
+};
+
+/**
+ * @brief List of all test cases, in order of registration
+ */
+class TestRegistry
+{
+private:
+  static TestCase* s_first;
+  static TestCase* s_last;
+
+public:
+  // Forbid construction of static class
+  TestRegistry() = delete;
+
+  /**
+   * @brief Add test case to the end of list
+   *
+   * @param[in] testCase  Test case with static storage duration
+   *
+   * @return `true`
+   */
+  static bool add(TestCase* testCase);
+
+  static TestCase* getFirst() { return s_first; }
+};
+
+/**
+ * @brief Report failed assertion and terminate test process
+ */
+[[noreturn]] void failAssertion(const char* condition, const char* file,
+                                int line, const char* function);
+
+} // namespace test
+} // namespace mklog
+
+/**
+ * @brief Define and register test case function
+ *
+ * @param[in] testName  Test case name, unique within test binary
+ */
+#define TEST_CASE(testName)                                                    \
+  static void                   testName(void);                                \
+  static mklog::test::TestCase  testName##_case = {#testName, &testName,       \
+                                                   nullptr};                   \
+  [[maybe_unused]] static const bool testName##_registered =                   \
+      mklog::test::TestRegistry::add(&testName##_case);                        \
+  static void testName(void)
+
+/**
+ * @brief Fail test case if condition is false
+ */
+#define test_assert(condition)                                                 \
+  do                                                                           \
+  {                                                                            \
+    if (!(condition))                                                          \
+    {                                                                          \
+      mklog::test::failAssertion(#condition, __FILE__, __LINE__,               \
+                                 __PRETTY_FUNCTION__);                         \
+    }                                                                          \
+  } while (0)
+
+#endif /* TestRunner.h */
@@ -0,0 +1,96 @@
+#include "TestUtils.h"
+
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/wait.h>
+
+namespace mklog
+{
+namespace test
+{
+
+static char s_toolDir[PATH_MAX] = ".";
+
+int waitForProcess(pid_t pid)
+{
+  int status = 0;
+  while (waitpid(pid, &status, 0) < 0)
+  {
+    if (errno != EINTR)
+      return -1;
+  }
+
+  if (WIFSIGNALED(status))
+    return 128 + WTERMSIG(status);
+
+  return WEXITSTATUS(status);
+}
+
+bool readFile(const char* filename, std::string& content)
+{
+  content.clear();
+
+  const int fd = open(filename, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return false;
+
+  char    chunk[BUFSIZ] = "";
+  ssize_t readLen       = 0;
+  do
+  {
+    readLen = read(fd, chunk, sizeof(chunk));
+    if (readLen > 0)
+      content.append(chunk, (size_t)readLen);
+  } while (readLen > 0 || (readLen < 0 && errno == EINTR));
+
+  close(fd);
+  return readLen == 0;
+}
+
+size_t countOccurrences(const char* text, const char* pattern)
+{
+  const size_t patternLen = strlen(pattern);
+  size_t       count      = 0;
+
+  for (const char* found = strstr(text, pattern); found != nullptr;
+       found             = strstr(found + patternLen, pattern))
+  {
+    ++count;
+  }
+
+  return count;
+}
+
+void setToolDir(const char* dir)
+{
+  snprintf(s_toolDir, sizeof(s_toolDir), "%s", dir);
+}
+
+int runTool(const char* commandLine, std::string* output)
+{
+  const std::string command = std::string(s_toolDir) + "/" + commandLine;
+
+  fflush(stdout);
+  if (output != nullptr)
+    output->clear();
+
+  FILE* const pipe = popen(command.c_str(), "r");
+  if (pipe == nullptr)
+    return -1;
+
+  char   chunk[BUFSIZ] = "";
+  size_t readLen       = 0;
+  while ((readLen = fread(chunk, 1, sizeof(chunk), pipe)) > 0)
+  {
+    if (output != nullptr)
+      output->append(chunk, readLen);
+  }
+
+  const int status = pclose(pipe);
+  return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+} // namespace test
+} // namespace mklog
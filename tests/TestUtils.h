@@ -0,0 +1,93 @@
+/**
+ * @file TestUtils.h
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Helpers for tests checking written log files
+ *
+ * @version 0.1
+ * @date 2023-09-22
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#ifndef __MEERKAT_LOGS_TESTS_TESTUTILS_H
+#define __MEERKAT_LOGS_TESTS_TESTUTILS_H
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace mklog
+{
+namespace test
+{
+
+/**
+ * @brief Wait for child process to terminate
+ *
+ * @return Exit code of process, 128 plus signal number if it was killed
+ */
+int waitForProcess(pid_t pid);
+
+/**
+ * @brief Run function in child process as if it was the whole program.
+ * Logs started by function are ended when it returns, so that everything
+ * it logged is written once this call returns
+ *
+ * @param[in] function  Function to be called in child process
+ *
+ * @return Exit code of child process, 128 plus signal number if it was
+ *         killed
+ */
+template <typename TFunction>
+int runProcess(TFunction function)
+{
+  fflush(stdout);
+  fflush(stderr);
+
+  const pid_t pid = fork();
+  if (pid == 0)
+  {
+    function();
+    exit(0);
+  }
+
+  return waitForProcess(pid);
+}
+
+/**
+ * @brief Read whole file
+ *
+ * @param[in]  filename   File name
+ * @param[out] content    File content
+ *
+ * @return `false` if file could not be read, `true` otherwise
+ */
+bool readFile(const char* filename, std::string& content);
+
+/**
+ * @brief Count non-overlapping occurrences of pattern in text
+ */
+size_t countOccurrences(const char* text, const char* pattern);
+
+/**
+ * @brief Set directory holding binaries built from `tools/`
+ */
+void setToolDir(const char* dir);
+
+/**
+ * @brief Run tool from `tools/` in current directory
+ *
+ * @param[in]  commandLine  Tool name followed by its arguments
+ * @param[out] output       Standard output of tool. May be null
+ *
+ * @return Exit code of tool
+ */
+int runTool(const char* commandLine, std::string* output);
+
+} // namespace test
+} // namespace mklog
+
+#endif /* TestUtils.h */
@@ -0,0 +1,157 @@
+/**
+ * @file TimestampFormatterTest.cpp
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Tests of cached timestamp rendering
+ *
+ * @version 0.1
+ * @date 2023-09-22
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <thread>
+
+#include "TestRunner.h"
+#include "mklog/utils/TimestampFormatter.h"
+
+using mklog::utils::TimestampFormatter;
+using Precision = TimestampFormatter::Precision;
+
+/// US Eastern time, switching to DST at 2023-03-12 07:00:00 UTC
+static constexpr char   TIMEZONE_DST[]     = "EST5EDT,M3.2.0,M11.1.0";
+static constexpr time_t DST_SWITCH_SECONDS = 1678604400;
+
+/// Fixed offset of +05:30
+static constexpr char TIMEZONE_FIXED[] = "IST-5:30";
+
+static void useTimezone(const char* timezone)
+{
+  setenv("TZ", timezone, 1);
+  tzset();
+}
+
+/**
+ * @brief Render timestamp with `strftime()`
+ */
+static void formatReference(char* buffer, time_t seconds,
+                            uint32_t nanoseconds, Precision precision)
+{
+  struct tm localTime = {};
+  localtime_r(&seconds, &localTime);
+
+  size_t length = strftime(buffer, TimestampFormatter::TIMESTAMP_LEN_MAX,
+                           "%F %H:%M:%S", &localTime);
+  switch (precision)
+  {
+  case Precision::MILLISECONDS:
+    length += sprintf(buffer + length, ".%03u", nanoseconds / 1000000);
+    break;
+  case Precision::MICROSECONDS:
+    length += sprintf(buffer + length, ".%06u", nanoseconds / 1000);
+    break;
+  case Precision::NANOSECONDS:
+    length += sprintf(buffer + length, ".%09u", nanoseconds);
+    break;
+  case Precision::SECONDS:
+  default:
+    break;
+  }
+  strftime(buffer + length, TimestampFormatter::TIMESTAMP_LEN_MAX - length,
+           "%z", &localTime);
+}
+
+static void checkFormat(time_t seconds, uint32_t nanoseconds,
+                        Precision precision)
+{
+  char formatted[TimestampFormatter::TIMESTAMP_LEN_MAX] = "";
+  char expected[TimestampFormatter::TIMESTAMP_LEN_MAX]  = "";
+
+  const size_t length = TimestampFormatter::format(formatted, seconds,
+                                                   nanoseconds, precision);
+  formatReference(expected, seconds, nanoseconds, precision);
+
+  test_assert(length == strlen(formatted));
+  test_assert(strcmp(formatted, expected) == 0);
+}
+
+TEST_CASE(timestampFormatterMatchesStrftime)
+{
+  static constexpr Precision PRECISIONS[] = {
+      Precision::SECONDS,
+      Precision::MILLISECONDS,
+      Precision::MICROSECONDS,
+      Precision::NANOSECONDS,
+  };
+  useTimezone(TIMEZONE_DST);
+
+  // Consecutive seconds reuse cached minute, including DST switch
+  for (time_t seconds = DST_SWITCH_SECONDS - 150;
+       seconds < DST_SWITCH_SECONDS + 150; ++seconds)
+  {
+    for (Precision precision : PRECISIONS)
+    {
+      checkFormat(seconds, 123456789, precision);
+    }
+  }
+
+  // Going back in time must not use cached minute
+  checkFormat(DST_SWITCH_SECONDS - 1, 0, Precision::SECONDS);
+  checkFormat(DST_SWITCH_SECONDS, 999999999, Precision::NANOSECONDS);
+
+  srand(42);
+  for (int i = 0; i < 10000; ++i)
+  {
+    // Years 1970 to about 2100
+    const time_t seconds = (time_t)rand() * 2;
+    checkFormat(seconds, (uint32_t)rand() % 1000000000,
+                PRECISIONS[i % 4]);
+  }
+}
+
+TEST_CASE(timestampFormatterIsThreadSafe)
+{
+  static constexpr int THREAD_COUNT = 4;
+  useTimezone(TIMEZONE_DST);
+
+  std::thread threads[THREAD_COUNT];
+  for (int thread = 0; thread < THREAD_COUNT; ++thread)
+  {
+    // Each thread keeps crossing minutes of its own
+    threads[thread] = std::thread([thread]() {
+      const time_t start = DST_SWITCH_SECONDS + thread * 100000;
+      for (time_t seconds = start; seconds < start + 2000; seconds += 7)
+      {
+        checkFormat(seconds, 5000, Precision::MICROSECONDS);
+      }
+    });
+  }
+  for (std::thread& thread : threads)
+  {
+    thread.join();
+  }
+}
+
+TEST_CASE(timestampFormatterSignalSafeMatchesCached)
+{
+  useTimezone(TIMEZONE_FIXED);
+  TimestampFormatter::captureUtcOffset();
+
+  srand(7);
+  for (int i = 0; i < 10000; ++i)
+  {
+    const time_t   seconds     = (time_t)rand() * 2;
+    const uint32_t nanoseconds = (uint32_t)rand() % 1000000000;
+
+    char cached[TimestampFormatter::TIMESTAMP_LEN_MAX]     = "";
+    char signalSafe[TimestampFormatter::TIMESTAMP_LEN_MAX] = "";
+    TimestampFormatter::format(cached, seconds, nanoseconds,
+                               Precision::MILLISECONDS);
+    TimestampFormatter::formatSignalSafe(signalSafe, seconds, nanoseconds,
+                                         Precision::MILLISECONDS);
+    test_assert(strcmp(cached, signalSafe) == 0);
+  }
+}
@@ -0,0 +1,110 @@
+/**
+ * @file UringOutputTest.cpp
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Tests of log files written asynchronously through io_uring. Output
+ * falls back to `writev()` where io_uring is unavailable, so the same
+ * content is expected either way
+ *
+ * @version 0.1
+ * @date 2023-09-22
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+
+#include "TestRunner.h"
+#include "TestUtils.h"
+#include "mklog/LogManager.h"
+#include "mklog/Logger.h"
+#include "mklog/writers/HtmlLogWriter.h"
+#include "mklog/writers/TextLogWriter.h"
+
+using mklog::BufferedFileSink;
+using mklog::LogManager;
+using mklog::Logger;
+using mklog::MessageContentType;
+
+static constexpr int MESSAGE_COUNT = 20000;
+
+static void logNumberedMessages()
+{
+  Logger logger("uring");
+  for (int i = 0; i < MESSAGE_COUNT; ++i)
+  {
+    logger.LOG_INFO(MessageContentType::TEXT, "message %d", i);
+  }
+}
+
+/**
+ * @brief Check that two files have the same content
+ */
+static void checkSameContent(const char* expectedFile, const char* actualFile)
+{
+  std::string expected;
+  std::string actual;
+  test_assert(mklog::test::readFile(expectedFile, expected));
+  test_assert(mklog::test::readFile(actualFile, actual));
+
+  test_assert(expected.length() == actual.length());
+  test_assert(memcmp(expected.data(), actual.data(), expected.length()) == 0);
+}
+
+/**
+ * @brief Log same messages to files in write mode and in given mode
+ */
+static void compareWithWriteMode(BufferedFileSink::OutputMode mode)
+{
+  const int exitCode = mklog::test::runProcess([mode]() {
+    LogManager::addWriter<mklog::TextLogWriter>().setFile("write.txt");
+    LogManager::addWriter<mklog::TextLogWriter>().setFile("uring.txt", mode);
+    LogManager::addWriter<mklog::HtmlLogWriter>().setFile("write.html");
+    LogManager::addWriter<mklog::HtmlLogWriter>().setFile("uring.html", mode);
+    LogManager::initLogs();
+
+    logNumberedMessages();
+  });
+  test_assert(exitCode == 0);
+
+  checkSameContent("write.txt", "uring.txt");
+  checkSameContent("write.html", "uring.html");
+
+  std::string log;
+  test_assert(mklog::test::readFile("uring.txt", log));
+  test_assert(mklog::test::countOccurrences(log.data(), "\tmessage ") ==
+              MESSAGE_COUNT);
+}
+
+TEST_CASE(uringOutputMatchesWriteOutput)
+{
+  compareWithWriteMode(BufferedFileSink::OutputMode::URING);
+}
+
+TEST_CASE(uringPolledOutputMatchesWriteOutput)
+{
+  compareWithWriteMode(BufferedFileSink::OutputMode::URING_POLLED);
+}
+
+TEST_CASE(uringOutputCompletedAfterCrash)
+{
+  const int exitCode = mklog::test::runProcess([]() {
+    LogManager::useAsyncDispatch();
+    LogManager::addWriter<mklog::TextLogWriter>().setFile(
+        "log.txt", BufferedFileSink::OutputMode::URING);
+    LogManager::initLogs();
+
+    logNumberedMessages();
+    raise(SIGSEGV);
+  });
+  test_assert(exitCode == 128 + SIGSEGV);
+
+  // Crash handler writes after submitted writes, at tracked offsets
+  std::string log;
+  test_assert(mklog::test::readFile("log.txt", log));
+  test_assert(strlen(log.data()) == log.length());
+  test_assert(mklog::test::countOccurrences(log.data(), "\tmessage ") ==
+              MESSAGE_COUNT);
+  test_assert(strstr(log.data(), "\tmessage 19999\n") != nullptr);
+}
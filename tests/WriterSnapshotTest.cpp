@@ -0,0 +1,206 @@
+/**
+ * @file WriterSnapshotTest.cpp
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Tests of epoch-based reclamation and runtime writer changes
+ *
+ * @version 0.1
+ * @date 2023-09-22
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#include <atomic>
+#include <cstdio>
+#include <thread>
+
+#include "TestRunner.h"
+#include "TestUtils.h"
+#include "mklog/LogManager.h"
+#include "mklog/Logger.h"
+#include "mklog/utils/EpochReclaimer.h"
+#include "mklog/writers/TextLogWriter.h"
+
+using mklog::LogManager;
+using mklog::Logger;
+using mklog::MessageContentType;
+using mklog::utils::EpochReclaimer;
+
+static std::atomic<int> s_deletedCount(0);
+
+static void countDeletion(void*) { s_deletedCount.fetch_add(1); }
+
+TEST_CASE(epochReclaimerWaitsForReaders)
+{
+  std::atomic<bool> isReading(false);
+  std::atomic<bool> canLeave(false);
+
+  std::thread reader([&]() {
+    EpochReclaimer::ReadGuard guard;
+    isReading.store(true);
+    while (!canLeave.load())
+    {
+      std::this_thread::yield();
+    }
+  });
+  while (!isReading.load())
+  {
+    std::this_thread::yield();
+  }
+
+  int object = 0;
+  EpochReclaimer::retire(&object, &countDeletion);
+  EpochReclaimer::reclaim();
+  test_assert(s_deletedCount.load() == 0);
+
+  canLeave.store(true);
+  reader.join();
+
+  EpochReclaimer::synchronize();
+  test_assert(s_deletedCount.load() == 1);
+}
+
+/**
+ * @brief Object published to readers. Deleted object is poisoned
+ */
+struct Published
+{
+  static constexpr int MAGIC = 0x5AFE;
+
+  int magic;
+  int version;
+
+  ~Published() { magic = 0; }
+};
+
+TEST_CASE(epochReclaimerKeepsPublishedObjectsAlive)
+{
+  static constexpr int READER_COUNT = 3;
+  static constexpr int VERSION_MAX  = 20000;
+
+  std::atomic<Published*> current(
+      new Published{.magic = Published::MAGIC, .version = 0});
+  std::atomic<bool> isBroken(false);
+
+  std::thread readers[READER_COUNT];
+  for (std::thread& reader : readers)
+  {
+    reader = std::thread([&]() {
+      int lastVersion = 0;
+      while (lastVersion < VERSION_MAX)
+      {
+        EpochReclaimer::ReadGuard guard;
+        const Published* published = current.load();
+        if (published->magic != Published::MAGIC ||
+            published->version < lastVersion)
+        {
+          isBroken.store(true);
+        }
+        lastVersion = published->version;
+      }
+    });
+  }
+
+  for (int version = 1; version <= VERSION_MAX; ++version)
+  {
+    Published* const old = current.exchange(
+        new Published{.magic = Published::MAGIC, .version = version});
+    EpochReclaimer::retire(old);
+  }
+
+  for (std::thread& reader : readers)
+  {
+    reader.join();
+  }
+  test_assert(!isBroken.load());
+
+  EpochReclaimer::synchronize();
+  delete current.load();
+}
+
+/**
+ * @brief Count messages of each thread in log file
+ */
+static void countThreadMessages(const char* filename, int* counts,
+                                int threadCount)
+{
+  std::string log;
+  test_assert(mklog::test::readFile(filename, log));
+
+  for (int thread = 0; thread < threadCount; ++thread)
+  {
+    char prefix[32] = "";
+    snprintf(prefix, sizeof(prefix), "\tthread %d message ", thread);
+    counts[thread] += (int)mklog::test::countOccurrences(log.data(), prefix);
+  }
+}
+
+static void checkWriterReplacement(bool isAsync)
+{
+  static constexpr int THREAD_COUNT  = 4;
+  static constexpr int MESSAGE_COUNT = 3000;
+
+  const int exitCode = mklog::test::runProcess([isAsync]() {
+    if (isAsync)
+    {
+      LogManager::useAsyncDispatch();
+    }
+    auto& first =
+        LogManager::addWriter<mklog::TextLogWriter>().setFile("first.txt");
+    LogManager::initLogs();
+
+    std::atomic<int> startedCount(0);
+    std::thread      threads[THREAD_COUNT];
+    for (int thread = 0; thread < THREAD_COUNT; ++thread)
+    {
+      threads[thread] = std::thread([thread, &startedCount]() {
+        Logger logger("snapshot");
+        for (int i = 0; i < MESSAGE_COUNT; ++i)
+        {
+          logger.LOG_INFO(MessageContentType::TEXT,
+                          "thread %d message %d", thread, i);
+          if (i == 0)
+            startedCount.fetch_add(1);
+        }
+      });
+    }
+    while (startedCount.load() < THREAD_COUNT)
+    {
+      std::this_thread::yield();
+    }
+
+    // Every message goes either to the old or to the new writer
+    auto* second = new mklog::TextLogWriter();
+    second->setFile("second.txt");
+    auto& replaced = LogManager::replaceWriter(first, second);
+
+    auto* third = new mklog::TextLogWriter();
+    third->setFile("third.txt");
+    LogManager::replaceWriter(replaced, third);
+
+    for (std::thread& thread : threads)
+    {
+      thread.join();
+    }
+  });
+  test_assert(exitCode == 0);
+
+  int counts[THREAD_COUNT] = {};
+  countThreadMessages("first.txt", counts, THREAD_COUNT);
+  countThreadMessages("second.txt", counts, THREAD_COUNT);
+  countThreadMessages("third.txt", counts, THREAD_COUNT);
+
+  for (int thread = 0; thread < THREAD_COUNT; ++thread)
+  {
+    test_assert(counts[thread] == MESSAGE_COUNT);
+  }
+}
+
+TEST_CASE(writerSnapshotReplacesWritersWhileLogging)
+{
+  checkWriterReplacement(/* isAsync = */ false);
+}
+
+TEST_CASE(writerSnapshotReplacesWritersWhileLoggingAsync)
+{
+  checkWriterReplacement(/* isAsync = */ true);
+}
@@ -0,0 +1,87 @@
+/**
+ * @file LogDecode.cpp
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Render file of `BinaryLogWriter` as text or HTML log
+ *
+ * @version 0.1
+ * @date 2023-09-17
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "mklog/utils/BinaryLogReader.h"
+#include "mklog/writers/HtmlLogWriter.h"
+#include "mklog/writers/TextLogWriter.h"
+
+/**
+ * @brief Pass all records to writer. Records of content types not
+ * supported by writer are skipped, as writer would do
+ */
+template <typename TWriter>
+static void decodeRecords(mklog::utils::BinaryLogReader& reader,
+                          TWriter&                       writer)
+{
+  mklog::utils::BinaryLogReader::Record record = {};
+  while (reader.readRecord(&record))
+  {
+    writer.writeMessageAt(record.message, record.seconds, record.nanoseconds);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  if (argc < 3 || argc > 4 ||
+      (strcmp(argv[2], "text") != 0 && strcmp(argv[2], "html") != 0))
+  {
+    fprintf(stderr, "Usage: %s <binary log> text|html [output file]\n",
+            argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  mklog::utils::BinaryLogReader reader;
+  if (!reader.open(argv[1]))
+  {
+    fprintf(stderr, "Cannot open '%s'\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+
+  // Output file is appended to, like by writers themselves
+  const char* output  = argc == 4 ? argv[3] : "/dev/stdout";
+  const bool  isText  = strcmp(argv[2], "text") == 0;
+  bool        isValid = false;
+  if (isText)
+  {
+    mklog::TextLogWriter writer;
+    isValid = writer.setFile(output).valid();
+    if (isValid)
+    {
+      decodeRecords(reader, writer);
+    }
+  }
+  else
+  {
+    mklog::HtmlLogWriter writer;
+    isValid = writer.setFile(output).valid();
+    if (isValid)
+    {
+      decodeRecords(reader, writer);
+    }
+  }
+
+  if (!isValid)
+  {
+    fprintf(stderr, "Cannot open '%s' for writing\n", output);
+    return EXIT_FAILURE;
+  }
+
+  if (reader.getSkippedBlockCount() > 0)
+  {
+    fprintf(stderr, "Skipped %zu damaged blocks\n",
+            reader.getSkippedBlockCount());
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,890 @@
+/**
+ * @file LogQuery.cpp
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Search records of text log file in parallel, skipping chunks
+ * excluded by its sparse index
+ *
+ * @version 0.1
+ * @date 2023-09-19
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+#include "mklog/LogMessage.h"
+#include "mklog/utils/LogClock.h"
+#include "mklog/utils/LogIndexFormat.h"
+#include "mklog/utils/SubstringSearch.h"
+#include "mklog/utils/TextBuffer.h"
+
+using mklog::LogMessage;
+using mklog::utils::LogClock;
+using mklog::utils::LogIndexFormat;
+using mklog::utils::SubstringSearch;
+using mklog::utils::TextBuffer;
+
+/**
+ * @brief Longest part of file scanned by one thread at once
+ */
+static constexpr uint64_t PIECE_LEN = 4 * 1024 * 1024;
+
+/**
+ * @brief Number of pieces each thread may scan before output of the
+ * earliest one is written
+ */
+static constexpr size_t PIECES_AHEAD_PER_THREAD = 4;
+
+static constexpr size_t SEVERITY_COUNT =
+    (size_t)LogMessage::Severity::MAX_LEVEL + 1;
+
+static const char* const SEVERITY_NAMES[] = {"trace",   "debug", "info",
+                                             "warning", "error", "fatal"};
+
+/// Severities as written by `TextLogWriter`
+static const char* const SEVERITY_LABELS[] = {" TRACE ", " DEBUG ", " INFO  ",
+                                              "WARNING", " ERROR ", " FATAL "};
+
+static constexpr size_t SEVERITY_LABEL_LEN = 7;
+
+static_assert(sizeof(SEVERITY_NAMES) / sizeof(*SEVERITY_NAMES) ==
+                      SEVERITY_COUNT &&
+                  sizeof(SEVERITY_LABELS) / sizeof(*SEVERITY_LABELS) ==
+                      SEVERITY_COUNT,
+              "Every severity needs a name");
+
+/**
+ * @brief Conditions on selected records, set by command line
+ */
+struct Query
+{
+  uint64_t             fromNs;
+  uint64_t             toNs;
+  LogMessage::Severity minSeverity;
+
+  const char* logger; /// Logger name, `nullptr` for any
+  const char* file;   /// Source file path or its end, `nullptr` for any
+  const char* text;   /// Text contained in record, `nullptr` for any
+  size_t      textLen;
+
+  unsigned threadCount;
+
+  /// Bits of names in index entries
+  uint64_t loggerBits;
+  uint64_t fileBits;
+
+  bool hasHeaderConditions() const
+  {
+    return fromNs != 0 || toNs != UINT64_MAX ||
+           minSeverity != LogMessage::Severity::MIN_LEVEL ||
+           logger != nullptr || file != nullptr;
+  }
+};
+
+/**
+ * @brief Header of parsed record
+ */
+struct Record
+{
+  uint64_t             timeNs;
+  LogMessage::Severity severity;
+  const char*          logger;
+  size_t               loggerLen;
+  const char*          file;
+  size_t               fileLen;
+};
+
+/**
+ * @brief Part of file scanned by one thread. Piece holds records starting
+ * between `begin` and `end`, which lie within selected range of file. Range
+ * boundaries lie between records, other piece boundaries are moved to the
+ * next record start
+ */
+struct Piece
+{
+  uint64_t begin;
+  uint64_t end;
+  uint64_t rangeBegin;
+  uint64_t rangeEnd;
+};
+
+/**
+ * @brief Pieces selected for scanning and statistics of selection
+ */
+struct Selection
+{
+  Piece* pieces;
+  size_t pieceCount;
+  size_t pieceCapacity;
+
+  uint64_t selectedLen;
+  uint64_t unindexedLen;
+  size_t   chunkCount;
+  size_t   skippedChunkCount;
+};
+
+/**
+ * @brief Output of scanned piece. Slot is reused for every
+ * `Scan::slotCount`-th piece
+ */
+struct Slot
+{
+  TextBuffer output;
+  size_t     matchCount;
+  bool       isDone;
+
+  Slot() : output(), matchCount(0), isDone(false) {}
+};
+
+/**
+ * @brief State shared by scanning threads
+ */
+struct Scan
+{
+  const Query* query;
+  const char*  log;
+  const Piece* pieces;
+  size_t       pieceCount;
+  Slot*        slots;
+  size_t       slotCount;
+
+  std::atomic<size_t>     nextPiece;
+  size_t                  printedCount;
+  std::mutex              mutex;
+  std::condition_variable changed;
+
+  Scan(const Query& scanQuery, const char* logData, const Selection& selection)
+      : query(&scanQuery),
+        log(logData),
+        pieces(selection.pieces),
+        pieceCount(selection.pieceCount),
+        slots(new Slot[scanQuery.threadCount * PIECES_AHEAD_PER_THREAD]),
+        slotCount(scanQuery.threadCount * PIECES_AHEAD_PER_THREAD),
+        nextPiece(0),
+        printedCount(0),
+        mutex(),
+        changed()
+  {
+  }
+
+  // No copying
+  Scan(const Scan&)            = delete;
+  Scan& operator=(const Scan&) = delete;
+
+  ~Scan() { delete[] slots; }
+};
+
+static void printUsage(const char* program)
+{
+  fprintf(stderr,
+          "Usage: %s <text log> [--from <seconds>] [--to <seconds>] "
+          "[--severity trace|debug|info|warning|error|fatal] "
+          "[--logger <name>] [--file <source file>] [--text <text>] "
+          "[--threads <count>]\n"
+          "Writes matching records to stdout, times are seconds since Epoch. "
+          "Index '<text log>%s' is used if present\n",
+          program, LogIndexFormat::FILE_SUFFIX);
+}
+
+static bool parseTime(const char* str, uint64_t* timeNs)
+{
+  char*                    end     = nullptr;
+  const unsigned long long seconds = strtoull(str, &end, 10);
+  if (*str == '\0' || *end != '\0')
+  {
+    return false;
+  }
+  *timeNs = (uint64_t)seconds * LogClock::NS_PER_SECOND;
+  return true;
+}
+
+static bool parseSeverity(const char* str, LogMessage::Severity* severity)
+{
+  for (size_t i = 0; i < SEVERITY_COUNT; ++i)
+  {
+    if (strcmp(str, SEVERITY_NAMES[i]) == 0)
+    {
+      *severity = (LogMessage::Severity)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool parseArguments(int argc, char** argv, Query* query)
+{
+  const unsigned cpuCount = std::thread::hardware_concurrency();
+  *query = {.fromNs      = 0,
+            .toNs        = UINT64_MAX,
+            .minSeverity = LogMessage::Severity::MIN_LEVEL,
+            .logger      = nullptr,
+            .file        = nullptr,
+            .text        = nullptr,
+            .textLen     = 0,
+            .threadCount = cpuCount > 0 ? cpuCount : 1,
+            .loggerBits  = 0,
+            .fileBits    = 0};
+
+  for (int i = 2; i < argc; ++i)
+  {
+    const bool hasValue = i + 1 < argc;
+    if (!hasValue)
+    {
+      return false;
+    }
+
+    const char* option = argv[i];
+    const char* value  = argv[++i];
+    if (strcmp(option, "--from") == 0)
+    {
+      if (!parseTime(value, &query->fromNs))
+        return false;
+    }
+    else if (strcmp(option, "--to") == 0)
+    {
+      if (!parseTime(value, &query->toNs))
+        return false;
+      // Whole last second is included
+      query->toNs += LogClock::NS_PER_SECOND - 1;
+    }
+    else if (strcmp(option, "--severity") == 0)
+    {
+      if (!parseSeverity(value, &query->minSeverity))
+        return false;
+    }
+    else if (strcmp(option, "--logger") == 0)
+    {
+      query->logger     = value;
+      query->loggerBits = LogIndexFormat::getNameBits(value, strlen(value));
+    }
+    else if (strcmp(option, "--file") == 0)
+    {
+      // Index knows only base names of source files
+      const char* baseName = LogIndexFormat::getBaseName(value);
+      query->file          = value;
+      query->fileBits =
+          LogIndexFormat::getNameBits(baseName, strlen(baseName));
+    }
+    else if (strcmp(option, "--text") == 0 && *value != '\0')
+    {
+      query->text    = value;
+      query->textLen = strlen(value);
+    }
+    else if (strcmp(option, "--threads") == 0)
+    {
+      query->threadCount = (unsigned)atoi(value);
+      if (query->threadCount == 0)
+        return false;
+    }
+    else
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Convert proleptic Gregorian calendar date to days since Epoch
+ */
+static long getDaysFromCivil(long year, unsigned month, unsigned day)
+{
+  // Count from 0000-03-01, so that leap day is the last day of year
+  year -= month <= 2 ? 1 : 0;
+  const long     era       = (year >= 0 ? year : year - 399) / 400;
+  const unsigned yearOfEra = (unsigned)(year - era * 400);
+  const unsigned dayOfYear =
+      (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+  const unsigned dayOfEra =
+      yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+  return era * 146097 + (long)dayOfEra - 719468;
+}
+
+/**
+ * @brief Read fixed number of decimal digits
+ */
+static bool parseDigits(const char* text, size_t count, unsigned* value)
+{
+  *value = 0;
+  for (size_t i = 0; i < count; ++i)
+  {
+    if (text[i] < '0' || text[i] > '9')
+      return false;
+    *value = *value * 10 + (unsigned)(text[i] - '0');
+  }
+  return true;
+}
+
+/**
+ * @brief Read timestamp written by `TimestampFormatter`, e.g.
+ * "2023-09-19 12:00:00.123+0300"
+ *
+ * @return Length of timestamp, zero if text does not start with one
+ */
+static size_t parseTimestamp(const char* text, size_t length, uint64_t* timeNs)
+{
+  static constexpr char   LAYOUT[]   = "0000-00-00 00:00:00";
+  static constexpr size_t LAYOUT_LEN = sizeof(LAYOUT) - 1;
+  static constexpr size_t ZONE_LEN   = 5;
+
+  if (length < LAYOUT_LEN + ZONE_LEN)
+  {
+    return 0;
+  }
+
+  unsigned year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0;
+  if (!parseDigits(text, 4, &year) || text[4] != '-' ||
+      !parseDigits(text + 5, 2, &month) || text[7] != '-' ||
+      !parseDigits(text + 8, 2, &day) || text[10] != ' ' ||
+      !parseDigits(text + 11, 2, &hour) || text[13] != ':' ||
+      !parseDigits(text + 14, 2, &minute) || text[16] != ':' ||
+      !parseDigits(text + 17, 2, &second))
+  {
+    return 0;
+  }
+
+  size_t   pos         = LAYOUT_LEN;
+  uint32_t nanoseconds = 0;
+  if (text[pos] == '.')
+  {
+    uint32_t scale = LogClock::NS_PER_SECOND;
+    for (++pos; pos < length && text[pos] >= '0' && text[pos] <= '9'; ++pos)
+    {
+      scale /= 10;
+      nanoseconds += (uint32_t)(text[pos] - '0') * scale;
+    }
+  }
+
+  unsigned zoneHours = 0, zoneMinutes = 0;
+  if (length - pos < ZONE_LEN || (text[pos] != '+' && text[pos] != '-') ||
+      !parseDigits(text + pos + 1, 2, &zoneHours) ||
+      !parseDigits(text + pos + 3, 2, &zoneMinutes))
+  {
+    return 0;
+  }
+
+  const long zoneOffset = (long)(zoneHours * 3600 + zoneMinutes * 60);
+  const long seconds =
+      getDaysFromCivil(year, month, day) * 86400 +
+      (long)(hour * 3600 + minute * 60 + second) -
+      (text[pos] == '+' ? zoneOffset : -zoneOffset);
+
+  *timeNs = (uint64_t)seconds * LogClock::NS_PER_SECOND + nanoseconds;
+  return pos + ZONE_LEN;
+}
+
+/**
+ * @brief Check if text starts with record header
+ */
+static bool isRecordStart(const char* text, size_t length)
+{
+  uint64_t timeNs = 0;
+  if (length < 1 || text[0] != '<')
+  {
+    return false;
+  }
+
+  const size_t timeLen = parseTimestamp(text + 1, length - 1, &timeNs);
+  return timeLen > 0 && length - 1 - timeLen >= 3 &&
+         memcmp(text + 1 + timeLen, "> [", 3) == 0;
+}
+
+/**
+ * @brief Parse header written by `TextLogWriter`:
+ * "<time> [severity] 'logger' in 'function' at 'file:line'"
+ *
+ * @return `false` if record has no valid header
+ */
+static bool parseRecord(const char* text, size_t length, Record* record)
+{
+  static constexpr char LOGGER_END[] = "' in '";
+  static constexpr char FILE_START[] = "' at '";
+
+  const char* lineEnd = static_cast<const char*>(memchr(text, '\n', length));
+  const size_t lineLen = lineEnd != nullptr ? (size_t)(lineEnd - text)
+                                            : length;
+  if (lineLen < 1 || text[0] != '<')
+  {
+    return false;
+  }
+
+  const size_t timeLen = parseTimestamp(text + 1, lineLen - 1, &record->timeNs);
+  size_t       pos     = 1 + timeLen;
+  if (timeLen == 0 || lineLen - pos < 3 + SEVERITY_LABEL_LEN + 3 ||
+      memcmp(text + pos, "> [", 3) != 0)
+  {
+    return false;
+  }
+  pos += 3;
+
+  size_t severity = 0;
+  while (severity < SEVERITY_COUNT &&
+         memcmp(text + pos, SEVERITY_LABELS[severity], SEVERITY_LABEL_LEN) != 0)
+  {
+    ++severity;
+  }
+  record->severity = (LogMessage::Severity)severity;
+  pos += SEVERITY_LABEL_LEN;
+  if (memcmp(text + pos, "] '", 3) != 0)
+  {
+    return false;
+  }
+  pos += 3;
+
+  const void* loggerEnd = memmem(text + pos, lineLen - pos, LOGGER_END,
+                                 sizeof(LOGGER_END) - 1);
+  if (loggerEnd == nullptr)
+  {
+    return false;
+  }
+  record->logger    = text + pos;
+  record->loggerLen = (size_t)(static_cast<const char*>(loggerEnd) - text) -
+                      pos;
+  pos += record->loggerLen + sizeof(LOGGER_END) - 1;
+
+  const void* fileStart = memmem(text + pos, lineLen - pos, FILE_START,
+                                 sizeof(FILE_START) - 1);
+  if (fileStart == nullptr)
+  {
+    return false;
+  }
+  pos = (size_t)(static_cast<const char*>(fileStart) - text) +
+        sizeof(FILE_START) - 1;
+
+  // File name is followed by ":line'"
+  const void* fileEnd = memrchr(text + pos, '\'', lineLen - pos);
+  const void* lineSep =
+      fileEnd != nullptr
+          ? memrchr(text + pos, ':',
+                    (size_t)(static_cast<const char*>(fileEnd) - text) - pos)
+          : nullptr;
+  if (lineSep == nullptr)
+  {
+    return false;
+  }
+
+  record->file    = text + pos;
+  record->fileLen = (size_t)(static_cast<const char*>(lineSep) - text) - pos;
+
+  return true;
+}
+
+static bool isNameEqual(const char* name, size_t nameLen, const char* expected)
+{
+  return strlen(expected) == nameLen && memcmp(name, expected, nameLen) == 0;
+}
+
+/**
+ * @brief Check if path is expected path or ends with it after '/'
+ */
+static bool isPathMatching(const char* path, size_t pathLen,
+                           const char* expected)
+{
+  const size_t expectedLen = strlen(expected);
+  if (expectedLen > pathLen)
+  {
+    return false;
+  }
+
+  const size_t prefixLen = pathLen - expectedLen;
+  return (prefixLen == 0 || path[prefixLen - 1] == '/') &&
+         memcmp(path + prefixLen, expected, expectedLen) == 0;
+}
+
+/**
+ * @brief Check record against query. Text condition is checked by caller
+ */
+static bool isRecordMatching(const Query& query, const char* text,
+                             size_t length)
+{
+  Record record = {};
+  if (!parseRecord(text, length, &record))
+  {
+    // Text preceding the first record, e.g. of crashed writer
+    return !query.hasHeaderConditions();
+  }
+
+  return record.timeNs >= query.fromNs && record.timeNs <= query.toNs &&
+         record.severity >= query.minSeverity &&
+         (query.logger == nullptr ||
+          isNameEqual(record.logger, record.loggerLen, query.logger)) &&
+         (query.file == nullptr ||
+          isPathMatching(record.file, record.fileLen, query.file));
+}
+
+/**
+ * @brief Find the first record start after given position
+ *
+ * @param[in] log       Log file content
+ * @param[in] pos       Position from which search starts
+ * @param[in] rangeEnd  End of range in which records are searched
+ *
+ * @return Record start, `rangeEnd` if there is none
+ */
+static uint64_t findNextRecord(const char* log, uint64_t pos,
+                               uint64_t rangeEnd)
+{
+  while (pos < rangeEnd)
+  {
+    const char* newline =
+        static_cast<const char*>(memchr(log + pos, '\n', rangeEnd - pos));
+    if (newline == nullptr)
+      break;
+
+    pos = (uint64_t)(newline - log) + 1;
+    if (isRecordStart(log + pos, rangeEnd - pos))
+      return pos;
+  }
+  return rangeEnd;
+}
+
+/**
+ * @brief Find start of record containing given position
+ *
+ * @param[in] log       Log file content
+ * @param[in] lowest    Record start not after position
+ * @param[in] pos       Position inside record
+ * @param[in] rangeEnd  End of range in which records are searched
+ */
+static uint64_t findRecordStart(const char* log, uint64_t lowest, uint64_t pos,
+                                uint64_t rangeEnd)
+{
+  while (pos > lowest)
+  {
+    const char* newline =
+        static_cast<const char*>(memrchr(log + lowest, '\n', pos - lowest));
+    if (newline == nullptr)
+      break;
+
+    const uint64_t lineStart = (uint64_t)(newline - log) + 1;
+    if (isRecordStart(log + lineStart, rangeEnd - lineStart))
+      return lineStart;
+    pos = (uint64_t)(newline - log);
+  }
+  return lowest;
+}
+
+/**
+ * @brief Move piece boundary to record start
+ */
+static uint64_t alignToRecord(const char* log, const Piece& piece,
+                              uint64_t pos)
+{
+  if (pos == piece.rangeBegin || pos == piece.rangeEnd)
+  {
+    return pos;
+  }
+  return findNextRecord(log, pos - 1, piece.rangeEnd);
+}
+
+/**
+ * @brief Append matching records of piece to output
+ *
+ * @return Number of matching records
+ */
+static size_t scanPiece(const Query& query, const char* log,
+                        const Piece& piece, TextBuffer& output)
+{
+  const uint64_t begin = alignToRecord(log, piece, piece.begin);
+  const uint64_t end   = alignToRecord(log, piece, piece.end);
+
+  size_t   matchCount = 0;
+  uint64_t pos        = begin;
+  while (pos < end)
+  {
+    uint64_t recordStart = pos;
+    uint64_t foundEnd    = pos;
+    if (query.text != nullptr)
+    {
+      // Records without text are skipped at vector speed
+      const size_t found = SubstringSearch::find(log + pos, end - pos,
+                                                 query.text, query.textLen);
+      if (found == SubstringSearch::NOT_FOUND)
+        break;
+      recordStart = findRecordStart(log, pos, pos + found, end);
+      foundEnd    = pos + found + query.textLen;
+    }
+
+    // Text found across record boundary does not match
+    const uint64_t recordEnd = findNextRecord(log, recordStart, end);
+    if (foundEnd <= recordEnd &&
+        isRecordMatching(query, log + recordStart, recordEnd - recordStart))
+    {
+      output.append(log + recordStart, recordEnd - recordStart);
+      ++matchCount;
+    }
+    pos = recordEnd;
+  }
+
+  return matchCount;
+}
+
+/**
+ * @brief Add range of file to selection, splitting it into pieces
+ */
+static void addRange(Selection* selection, uint64_t begin, uint64_t end)
+{
+  selection->selectedLen += end - begin;
+  for (uint64_t pieceBegin = begin; pieceBegin < end; pieceBegin += PIECE_LEN)
+  {
+    if (selection->pieceCount == selection->pieceCapacity)
+    {
+      const size_t newCapacity =
+          selection->pieceCapacity > 0 ? 2 * selection->pieceCapacity : 64;
+      Piece* newPieces = new Piece[newCapacity];
+      if (selection->pieceCount > 0)
+      {
+        memcpy(newPieces, selection->pieces,
+               selection->pieceCount * sizeof(*newPieces));
+      }
+      delete[] selection->pieces;
+      selection->pieces        = newPieces;
+      selection->pieceCapacity = newCapacity;
+    }
+
+    selection->pieces[selection->pieceCount++] = {
+        .begin      = pieceBegin,
+        .end        = end - pieceBegin > PIECE_LEN ? pieceBegin + PIECE_LEN
+                                                   : end,
+        .rangeBegin = begin,
+        .rangeEnd   = end};
+  }
+}
+
+/**
+ * @brief Read whole index file
+ *
+ * @return Allocated content, `nullptr` if there is no index
+ */
+static char* readIndexFile(const char* logName, size_t* length)
+{
+  const size_t logNameLen = strlen(logName);
+  char* const  indexName =
+      new char[logNameLen + sizeof(LogIndexFormat::FILE_SUFFIX)];
+  memcpy(indexName, logName, logNameLen);
+  memcpy(indexName + logNameLen, LogIndexFormat::FILE_SUFFIX,
+         sizeof(LogIndexFormat::FILE_SUFFIX));
+
+  const int fd = open(indexName, O_RDONLY | O_CLOEXEC);
+  delete[] indexName;
+  if (fd < 0)
+  {
+    return nullptr;
+  }
+
+  struct stat fileStat = {};
+  if (fstat(fd, &fileStat) != 0 || fileStat.st_size <= 0)
+  {
+    close(fd);
+    return nullptr;
+  }
+
+  char*  content = new char[(size_t)fileStat.st_size];
+  size_t readLen = 0;
+  while (readLen < (size_t)fileStat.st_size)
+  {
+    const ssize_t result =
+        read(fd, content + readLen, (size_t)fileStat.st_size - readLen);
+    if (result <= 0)
+      break;
+    readLen += (size_t)result;
+  }
+  close(fd);
+
+  *length = readLen;
+  return content;
+}
+
+/**
+ * @brief Select parts of log file which may hold matching records. Chunks
+ * excluded by index are skipped, parts not described by index are kept
+ */
+static void selectPieces(const Query& query, const char* logName,
+                         uint64_t logLen, Selection* selection)
+{
+  *selection = {};
+
+  size_t      indexLen = 0;
+  char* const index    = readIndexFile(logName, &indexLen);
+  if (index == nullptr || indexLen < LogIndexFormat::FILE_HEADER_SIZE ||
+      !LogIndexFormat::decodeFileHeader(index))
+  {
+    delete[] index;
+    selection->unindexedLen = logLen;
+    addRange(selection, 0, logLen);
+    return;
+  }
+
+  // Selected chunks and parts between chunks form ranges ended by skipped
+  // chunks
+  uint64_t covered    = 0; // End of the last chunk
+  uint64_t rangeBegin = 0;
+  for (size_t offset = LogIndexFormat::FILE_HEADER_SIZE;
+       indexLen - offset >= LogIndexFormat::ENTRY_SIZE;
+       offset += LogIndexFormat::ENTRY_SIZE)
+  {
+    LogIndexFormat::Entry entry = {};
+    if (!LogIndexFormat::decodeEntry(index + offset, &entry) ||
+        entry.offset < covered || entry.offset + entry.length > logLen)
+    {
+      continue;
+    }
+
+    ++selection->chunkCount;
+    selection->unindexedLen += entry.offset - covered;
+    covered = entry.offset + entry.length;
+    if (entry.summary.mayContain(query.fromNs, query.toNs, query.minSeverity,
+                                 query.loggerBits, query.fileBits))
+    {
+      continue;
+    }
+
+    ++selection->skippedChunkCount;
+    if (entry.offset > rangeBegin)
+    {
+      addRange(selection, rangeBegin, entry.offset);
+    }
+    rangeBegin = covered;
+  }
+  delete[] index;
+
+  selection->unindexedLen += logLen - covered;
+  if (logLen > rangeBegin)
+  {
+    addRange(selection, rangeBegin, logLen);
+  }
+}
+
+static void scanPieces(Scan* scan)
+{
+  for (;;)
+  {
+    const size_t index =
+        scan->nextPiece.fetch_add(1, std::memory_order_relaxed);
+    if (index >= scan->pieceCount)
+      return;
+
+    Slot& slot = scan->slots[index % scan->slotCount];
+    {
+      // Slot is free once output of its previous piece is written
+      std::unique_lock<std::mutex> lock(scan->mutex);
+      scan->changed.wait(lock, [scan, index]() {
+        return index < scan->printedCount + scan->slotCount;
+      });
+    }
+
+    slot.matchCount = scanPiece(*scan->query, scan->log, scan->pieces[index],
+                                slot.output);
+    {
+      std::lock_guard<std::mutex> lock(scan->mutex);
+      slot.isDone = true;
+    }
+    scan->changed.notify_all();
+  }
+}
+
+/**
+ * @brief Scan pieces in parallel and write matching records in file order
+ *
+ * @return Number of matching records
+ */
+static size_t runScan(const Query& query, const char* log,
+                      const Selection& selection)
+{
+  Scan scan(query, log, selection);
+
+  std::thread* threads = new std::thread[query.threadCount];
+  for (unsigned i = 0; i < query.threadCount; ++i)
+  {
+    threads[i] = std::thread(scanPieces, &scan);
+  }
+
+  size_t matchCount = 0;
+  for (size_t i = 0; i < scan.pieceCount; ++i)
+  {
+    Slot& slot = scan.slots[i % scan.slotCount];
+    {
+      std::unique_lock<std::mutex> lock(scan.mutex);
+      scan.changed.wait(lock, [&slot]() { return slot.isDone; });
+    }
+
+    fwrite(slot.output.data(), 1, slot.output.length(), stdout);
+    matchCount += slot.matchCount;
+    slot.output.clear();
+    {
+      std::lock_guard<std::mutex> lock(scan.mutex);
+      slot.isDone = false;
+      ++scan.printedCount;
+    }
+    scan.changed.notify_all();
+  }
+
+  for (unsigned i = 0; i < query.threadCount; ++i)
+  {
+    threads[i].join();
+  }
+  delete[] threads;
+
+  return matchCount;
+}
+
+int main(int argc, char** argv)
+{
+  Query query = {};
+  if (argc < 2 || !parseArguments(argc, argv, &query))
+  {
+    printUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const int fd = open(argv[1], O_RDONLY | O_CLOEXEC);
+  struct stat fileStat = {};
+  if (fd < 0 || fstat(fd, &fileStat) != 0)
+  {
+    fprintf(stderr, "Cannot open '%s'\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+  const uint64_t logLen = (uint64_t)fileStat.st_size;
+  if (logLen == 0)
+  {
+    close(fd);
+    return EXIT_SUCCESS;
+  }
+
+  void* map = mmap(nullptr, logLen, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+  {
+    fprintf(stderr, "Cannot map '%s'\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+
+  Selection selection = {};
+  selectPieces(query, argv[1], logLen, &selection);
+
+  const size_t matchCount =
+      runScan(query, static_cast<const char*>(map), selection);
+  fflush(stdout);
+
+  constexpr double MB = 1024.0 * 1024.0;
+  fprintf(stderr,
+          "%zu records matched, scanned %.1f of %.1f MB: %zu of %zu chunks "
+          "skipped by index, %.1f MB not indexed\n",
+          matchCount, (double)selection.selectedLen / MB, (double)logLen / MB,
+          selection.skippedChunkCount, selection.chunkCount,
+          (double)selection.unindexedLen / MB);
+
+  delete[] selection.pieces;
+  munmap(map, logLen);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,208 @@
+/**
+ * @file LogUnpack.cpp
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief List or decompress blocks of compressed log file
+ *
+ * @version 0.1
+ * @date 2023-09-18
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "mklog/LogMessage.h"
+#include "mklog/utils/CompressedLogReader.h"
+#include "mklog/utils/LogClock.h"
+#include "mklog/utils/TimestampFormatter.h"
+
+using mklog::LogMessage;
+using mklog::utils::CompressedLogFormat;
+using mklog::utils::CompressedLogReader;
+
+static const char* const SEVERITY_NAMES[] = {"trace",   "debug", "info",
+                                             "warning", "error", "fatal"};
+
+static_assert(sizeof(SEVERITY_NAMES) / sizeof(*SEVERITY_NAMES) ==
+                  CompressedLogFormat::SEVERITY_COUNT,
+              "Every severity needs a name");
+
+/**
+ * @brief Blocks selected by command line
+ */
+struct Filter
+{
+  uint64_t             fromNs;
+  uint64_t             toNs;
+  LogMessage::Severity minSeverity;
+  bool                 isListing;
+};
+
+static void printUsage(const char* program)
+{
+  fprintf(stderr,
+          "Usage: %s <compressed log> [--list] [--from <seconds>] "
+          "[--to <seconds>] [--severity trace|debug|info|warning|error|fatal]\n"
+          "Writes blocks which may contain matching messages to stdout, "
+          "times are seconds since Epoch\n",
+          program);
+}
+
+static bool parseTime(const char* str, uint64_t* timeNs)
+{
+  char*                    end     = nullptr;
+  const unsigned long long seconds = strtoull(str, &end, 10);
+  if (*str == '\0' || *end != '\0')
+  {
+    return false;
+  }
+  *timeNs = (uint64_t)seconds * mklog::utils::LogClock::NS_PER_SECOND;
+  return true;
+}
+
+static bool parseSeverity(const char* str, LogMessage::Severity* severity)
+{
+  for (size_t i = 0; i < CompressedLogFormat::SEVERITY_COUNT; ++i)
+  {
+    if (strcmp(str, SEVERITY_NAMES[i]) == 0)
+    {
+      *severity = (LogMessage::Severity)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool parseArguments(int argc, char** argv, Filter* filter)
+{
+  *filter = {.fromNs      = 0,
+             .toNs        = UINT64_MAX,
+             .minSeverity = LogMessage::Severity::MIN_LEVEL,
+             .isListing   = false};
+
+  for (int i = 2; i < argc; ++i)
+  {
+    const bool hasValue = i + 1 < argc;
+    if (strcmp(argv[i], "--list") == 0)
+    {
+      filter->isListing = true;
+    }
+    else if (strcmp(argv[i], "--from") == 0 && hasValue)
+    {
+      if (!parseTime(argv[++i], &filter->fromNs))
+        return false;
+    }
+    else if (strcmp(argv[i], "--to") == 0 && hasValue)
+    {
+      if (!parseTime(argv[++i], &filter->toNs))
+        return false;
+      // Whole last second is included
+      filter->toNs += mklog::utils::LogClock::NS_PER_SECOND - 1;
+    }
+    else if (strcmp(argv[i], "--severity") == 0 && hasValue)
+    {
+      if (!parseSeverity(argv[++i], &filter->minSeverity))
+        return false;
+    }
+    else
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void formatTime(char* output, uint64_t timeNs)
+{
+  using mklog::utils::LogClock;
+  using mklog::utils::TimestampFormatter;
+
+  TimestampFormatter::format(output, (time_t)(timeNs / LogClock::NS_PER_SECOND),
+                             (uint32_t)(timeNs % LogClock::NS_PER_SECOND),
+                             TimestampFormatter::Precision::MILLISECONDS);
+}
+
+static void printBlock(const CompressedLogReader::Block& block)
+{
+  using mklog::utils::TimestampFormatter;
+
+  const CompressedLogFormat::FrameHeader& header = block.header;
+  printf("%12" PRIu64 " %10" PRIu32 " %10" PRIu32 "  ", block.offset,
+         header.storedLen, header.rawLen);
+
+  if ((header.flags & CompressedLogFormat::FLAG_UNINDEXED) != 0)
+  {
+    printf("written by crash handler\n");
+    return;
+  }
+
+  char first[TimestampFormatter::TIMESTAMP_LEN_MAX + 1] = "";
+  char last[TimestampFormatter::TIMESTAMP_LEN_MAX + 1]  = "";
+  formatTime(first, header.summary.firstTimeNs);
+  formatTime(last, header.summary.lastTimeNs);
+  printf("%s .. %s ", first, last);
+  for (size_t i = 0; i < CompressedLogFormat::SEVERITY_COUNT; ++i)
+  {
+    printf(" %s:%" PRIu32, SEVERITY_NAMES[i],
+           header.summary.severityCounts[i]);
+  }
+  printf("\n");
+}
+
+int main(int argc, char** argv)
+{
+  Filter filter = {};
+  if (argc < 2 || !parseArguments(argc, argv, &filter))
+  {
+    printUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  CompressedLogReader reader;
+  if (!reader.open(argv[1]))
+  {
+    fprintf(stderr, "'%s' is not a compressed log\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+
+  if (filter.isListing)
+  {
+    printf("%12s %10s %10s  %s\n", "offset", "stored", "length", "messages");
+  }
+
+  mklog::utils::TextBuffer content;
+  size_t                   selectedCount = 0;
+  size_t                   damagedCount  = 0;
+  for (size_t i = 0; i < reader.getBlockCount(); ++i)
+  {
+    const CompressedLogReader::Block& block = reader.getBlock(i);
+    if (!block.header.mayContain(filter.fromNs, filter.toNs,
+                                 filter.minSeverity))
+    {
+      continue;
+    }
+    ++selectedCount;
+
+    if (filter.isListing)
+    {
+      printBlock(block);
+      continue;
+    }
+
+    content.clear();
+    if (!reader.readBlock(i, content))
+    {
+      ++damagedCount;
+      continue;
+    }
+    fwrite(content.data(), 1, content.length(), stdout);
+  }
+
+  fprintf(stderr, "%zu of %zu blocks selected (%zu from index), %zu damaged\n",
+          selectedCount, reader.getBlockCount(), reader.getIndexedBlockCount(),
+          damagedCount);
+  return damagedCount == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
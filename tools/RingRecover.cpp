@@ -0,0 +1,108 @@
+/**
+ * @file RingRecover.cpp
+ * @author MeerkatBoss (solodovnikov.ia@phystech.edu)
+ *
+ * @brief Print last records kept in ring file of `MappedRingLogWriter`
+ *
+ * @version 0.1
+ * @date 2023-09-15
+ *
+ * @copyright Copyright MeerkatBoss (c) 2023
+ */
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+
+#include "mklog/LogMessage.h"
+#include "mklog/utils/MappedRing.h"
+#include "mklog/utils/TimestampFormatter.h"
+
+static const char* getSeverityString(mklog::LogMessage::Severity severity)
+{
+  using Severity = mklog::LogMessage::Severity;
+
+  switch (severity)
+  {
+  case Severity::TRACE:   return " TRACE ";
+  case Severity::DEBUG:   return " DEBUG ";
+  case Severity::INFO:    return " INFO  ";
+  case Severity::WARNING: return "WARNING";
+  case Severity::ERROR:   return " ERROR ";
+  case Severity::FATAL:   return " FATAL ";
+  default:                return "UNKNOWN";
+  }
+}
+
+static const char* getPartString(mklog::LogMessage::Part part)
+{
+  using Part = mklog::LogMessage::Part;
+
+  switch (part)
+  {
+  case Part::BEGIN:    return "begin";
+  case Part::CONTINUE: return "continued";
+  case Part::END:      return "end";
+  case Part::WHOLE:
+  default:             return "";
+  }
+}
+
+/**
+ * @brief Print record in the same layout as `TextLogWriter`, prefixed with
+ * its sequence number
+ */
+static void printRecord(const mklog::utils::MappedRing::Record& record)
+{
+  using mklog::utils::TimestampFormatter;
+
+  char time[TimestampFormatter::TIMESTAMP_LEN_MAX + 1] = "";
+  TimestampFormatter::format(time, record.seconds, record.nanoseconds,
+                             TimestampFormatter::Precision::MICROSECONDS);
+
+  printf("%" PRIu64 " <%s> [%s] '%s' in '%s' at '%s:%zu'", record.sequence,
+         time, getSeverityString(record.severity), record.logger,
+         record.function, record.file, record.line);
+  if (record.part != mklog::LogMessage::Part::WHOLE)
+  {
+    printf(" [#%" PRIu32 " %s]", record.longMessageId,
+           getPartString(record.part));
+  }
+  printf(":\n\t%.*s\n", (int)record.contentLen, record.content);
+}
+
+int main(int argc, char** argv)
+{
+  if (argc < 2 || argc > 3)
+  {
+    fprintf(stderr, "Usage: %s <ring file> [record count]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  size_t count = SIZE_MAX;
+  if (argc == 3)
+  {
+    char* end = nullptr;
+    count     = strtoull(argv[2], &end, 10);
+    if (*argv[2] == '\0' || *end != '\0')
+    {
+      fprintf(stderr, "Invalid record count '%s'\n", argv[2]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  mklog::utils::MappedRingReader reader;
+  if (!reader.open(argv[1]))
+  {
+    fprintf(stderr, "'%s' is not a log ring\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+
+  const size_t recordCount = reader.getRecordCount();
+  const size_t first = count < recordCount ? recordCount - count : 0;
+  for (size_t i = first; i < recordCount; ++i)
+  {
+    printRecord(reader.getRecord(i));
+  }
+
+  return EXIT_SUCCESS;
+}